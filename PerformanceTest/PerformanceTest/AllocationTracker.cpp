@@ -0,0 +1,393 @@
+#include "AllocationTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Config.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CALLER_ADDRESS() _ReturnAddress()
+#else
+#define CALLER_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace
+{
+    /* Everything in here runs inside operator new and must not allocate itself */
+
+    struct AtomicCounters
+    {
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> frees{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+
+        AllocationCounters load() const
+        {
+            AllocationCounters counters;
+            counters.allocations = allocations.load(std::memory_order_relaxed);
+            counters.frees = frees.load(std::memory_order_relaxed);
+            counters.bytes = bytes.load(std::memory_order_relaxed);
+            return counters;
+        }
+    };
+
+    struct CallSite
+    {
+        /* Return address of the allocating call, nullptr for the Vulkan driver */
+        const void* address;
+        const char* phase;
+        uint64_t count;
+        uint64_t bytes;
+        /* Allocations since the last FrameAllocationMonitor::beginFrame() */
+        uint64_t frameCount;
+    };
+
+    const uint32_t kMaxCallSites = 256;
+
+    AtomicCounters g_heap;
+    AtomicCounters g_vulkan;
+
+    /* Call sites are only collected during measured frames, where allocations should be rare */
+    std::atomic<bool> g_recordCallSites{ false };
+    std::atomic_flag g_callSiteLock = ATOMIC_FLAG_INIT;
+    CallSite g_callSites[kMaxCallSites];
+    uint32_t g_callSiteCount = 0;
+    uint64_t g_droppedCallSites = 0;
+
+    thread_local const char* t_phase = "untagged";
+
+    void recordCallSite(const void* address, size_t size)
+    {
+        while (g_callSiteLock.test_and_set(std::memory_order_acquire))
+        {
+        }
+
+        CallSite* site = nullptr;
+        for (uint32_t i = 0; i < g_callSiteCount && !site; ++i)
+            if (g_callSites[i].address == address && g_callSites[i].phase == t_phase)
+                site = &g_callSites[i];
+        if (!site && g_callSiteCount < kMaxCallSites)
+        {
+            site = &g_callSites[g_callSiteCount++];
+            *site = { address, t_phase, 0, 0, 0 };
+        }
+        if (site)
+        {
+            ++site->count;
+            ++site->frameCount;
+            site->bytes += size;
+        }
+        else
+        {
+            ++g_droppedCallSites;
+        }
+
+        g_callSiteLock.clear(std::memory_order_release);
+    }
+
+    void countAllocation(AtomicCounters& counters, const void* address, size_t size)
+    {
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (g_recordCallSites.load(std::memory_order_relaxed))
+            recordCallSite(address, size);
+    }
+
+    /* malloc does not take an alignment everywhere, the original pointer and size sit in front of the aligned block */
+    struct AlignedHeader
+    {
+        void* original;
+        size_t size;
+    };
+
+    void* alignedAllocate(size_t size, size_t alignment)
+    {
+        alignment = std::max(alignment, alignof(AlignedHeader));
+        void* original = std::malloc(size + alignment + sizeof(AlignedHeader));
+        if (!original)
+            return nullptr;
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(original) + sizeof(AlignedHeader) + alignment - 1) & ~uintptr_t(alignment - 1);
+        AlignedHeader* header = reinterpret_cast<AlignedHeader*>(aligned) - 1;
+        header->original = original;
+        header->size = size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    AlignedHeader* alignedHeader(void* memory)
+    {
+        return static_cast<AlignedHeader*>(memory) - 1;
+    }
+
+    void alignedFree(void* memory)
+    {
+        if (memory)
+            std::free(alignedHeader(memory)->original);
+    }
+
+    const char* sourceSuffix(const CallSite& site)
+    {
+        return site.address ? "" : " (vulkan driver)";
+    }
+
+    VKAPI_ATTR void* VKAPI_CALL vulkanAllocate(void*, size_t size, size_t alignment, VkSystemAllocationScope)
+    {
+        void* memory = alignedAllocate(size, alignment);
+        if (memory)
+            countAllocation(g_vulkan, nullptr, size);
+        return memory;
+    }
+
+    VKAPI_ATTR void* VKAPI_CALL vulkanReallocate(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+    {
+        if (!original)
+            return vulkanAllocate(userData, size, alignment, scope);
+
+        void* memory = nullptr;
+        if (size > 0)
+        {
+            memory = vulkanAllocate(userData, size, alignment, scope);
+            if (!memory)
+                return nullptr;
+            std::memcpy(memory, original, std::min(size, alignedHeader(original)->size));
+        }
+        g_vulkan.frees.fetch_add(1, std::memory_order_relaxed);
+        alignedFree(original);
+        return memory;
+    }
+
+    VKAPI_ATTR void VKAPI_CALL vulkanFree(void*, void* memory)
+    {
+        if (!memory)
+            return;
+        g_vulkan.frees.fetch_add(1, std::memory_order_relaxed);
+        alignedFree(memory);
+    }
+
+    const VkAllocationCallbacks kVulkanCallbacks = { nullptr, vulkanAllocate, vulkanReallocate, vulkanFree, nullptr, nullptr };
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+namespace
+{
+    void* trackedNew(size_t size, const void* caller)
+    {
+        void* memory = std::malloc(size ? size : 1);
+        if (memory)
+            countAllocation(g_heap, caller, size);
+        return memory;
+    }
+
+    void* trackedAlignedNew(size_t size, std::align_val_t alignment, const void* caller)
+    {
+        void* memory = alignedAllocate(size ? size : 1, size_t(alignment));
+        if (memory)
+            countAllocation(g_heap, caller, size);
+        return memory;
+    }
+
+    void trackedDelete(void* memory)
+    {
+        if (!memory)
+            return;
+        g_heap.frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(memory);
+    }
+
+    void trackedAlignedDelete(void* memory)
+    {
+        if (!memory)
+            return;
+        g_heap.frees.fetch_add(1, std::memory_order_relaxed);
+        alignedFree(memory);
+    }
+}
+
+/* The caller has to be taken in the operators themselves, a helper would report its own caller */
+
+void* operator new(size_t size)
+{
+    if (void* memory = trackedNew(size, CALLER_ADDRESS()))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (void* memory = trackedNew(size, CALLER_ADDRESS()))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedNew(size, CALLER_ADDRESS());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedNew(size, CALLER_ADDRESS());
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* memory = trackedAlignedNew(size, alignment, CALLER_ADDRESS()))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void* memory = trackedAlignedNew(size, alignment, CALLER_ADDRESS()))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return trackedAlignedNew(size, alignment, CALLER_ADDRESS());
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return trackedAlignedNew(size, alignment, CALLER_ADDRESS());
+}
+
+void operator delete(void* memory) noexcept { trackedDelete(memory); }
+void operator delete[](void* memory) noexcept { trackedDelete(memory); }
+void operator delete(void* memory, size_t) noexcept { trackedDelete(memory); }
+void operator delete[](void* memory, size_t) noexcept { trackedDelete(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { trackedDelete(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { trackedDelete(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { trackedAlignedDelete(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { trackedAlignedDelete(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { trackedAlignedDelete(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { trackedAlignedDelete(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedDelete(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { trackedAlignedDelete(memory); }
+
+#endif
+
+bool allocationTrackingEnabled()
+{
+#ifdef TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationCounters heapAllocationCounters()
+{
+    return g_heap.load();
+}
+
+AllocationCounters vulkanAllocationCounters()
+{
+    return g_vulkan.load();
+}
+
+const VkAllocationCallbacks* vulkanHostAllocator()
+{
+    return allocationTrackingEnabled() ? &kVulkanCallbacks : nullptr;
+}
+
+void setAllocationPhase(const char* phase)
+{
+    t_phase = phase;
+}
+
+void FrameAllocationMonitor::beginFrame(const FrameInfo& frame)
+{
+    if (!allocationTrackingEnabled())
+        return;
+
+    while (g_callSiteLock.test_and_set(std::memory_order_acquire))
+    {
+    }
+    for (uint32_t i = 0; i < g_callSiteCount; ++i)
+        g_callSites[i].frameCount = 0;
+    g_callSiteLock.clear(std::memory_order_release);
+
+    g_recordCallSites.store(frame.measured, std::memory_order_relaxed);
+    m_heapStart = heapAllocationCounters();
+    m_vulkanStart = vulkanAllocationCounters();
+}
+
+void FrameAllocationMonitor::endFrame(const FrameInfo& frame)
+{
+    if (!allocationTrackingEnabled() || !frame.measured)
+        return;
+
+    AllocationCounters heap = heapAllocationCounters();
+    AllocationCounters vulkan = vulkanAllocationCounters();
+    g_recordCallSites.store(false, std::memory_order_relaxed);
+
+    uint64_t heapAllocations = heap.allocations - m_heapStart.allocations;
+    m_heapAllocations.add(double(heapAllocations));
+    m_heapBytes.add(double(heap.bytes - m_heapStart.bytes) / 1024.0);
+    uint64_t vulkanAllocations = vulkan.allocations - m_vulkanStart.allocations;
+    m_vulkanAllocations.add(double(vulkanAllocations));
+    m_vulkanBytes.add(double(vulkan.bytes - m_vulkanStart.bytes) / 1024.0);
+
+    /* Driver host allocations through vulkanHostAllocator() count as well, only heap ones have call sites */
+    if (heapAllocations == 0 && vulkanAllocations == 0)
+        return;
+
+    ++m_flaggedFrames;
+    if (m_printedFrames == kMaxPrintedFrames)
+        return;
+    ++m_printedFrames;
+
+    /* Printing allocates, the sites are copied out first */
+    CallSite sites[kMaxCallSites];
+    uint32_t siteCount = 0;
+    while (g_callSiteLock.test_and_set(std::memory_order_acquire))
+    {
+    }
+    for (uint32_t i = 0; i < g_callSiteCount; ++i)
+        if (g_callSites[i].frameCount > 0)
+            sites[siteCount++] = g_callSites[i];
+    g_callSiteLock.clear(std::memory_order_release);
+
+    std::fprintf(stderr, "frame %llu: %llu heap allocations (%llu bytes) and %llu vulkan host allocations (%llu bytes) in a measured frame\n",
+                 (unsigned long long)frame.index, (unsigned long long)heapAllocations, (unsigned long long)(heap.bytes - m_heapStart.bytes),
+                 (unsigned long long)vulkanAllocations, (unsigned long long)(vulkan.bytes - m_vulkanStart.bytes));
+    for (uint32_t i = 0; i < siteCount; ++i)
+        std::fprintf(stderr, "    %llux from %p in %s%s\n", (unsigned long long)sites[i].frameCount, sites[i].address, sites[i].phase,
+                     sourceSuffix(sites[i]));
+}
+
+void FrameAllocationMonitor::report(Report& report) const
+{
+    report.addText("allocation tracking", allocationTrackingEnabled() ? "on" : "off (define TRACK_ALLOCATIONS in Config.h)");
+    if (!allocationTrackingEnabled())
+        return;
+
+    report.addStatistics("heap allocations/frame", m_heapAllocations, "");
+    report.addStatistics("heap allocated/frame", m_heapBytes, "KB");
+    report.addValue("frames with allocations", double(m_flaggedFrames), "");
+    report.addStatistics("vulkan host allocations/frame", m_vulkanAllocations, "");
+    report.addStatistics("vulkan host allocated/frame", m_vulkanBytes, "KB");
+    AllocationCounters vulkan = vulkanAllocationCounters();
+    report.addValue("vulkan host allocations live", double(vulkan.allocations - vulkan.frees), "");
+
+    /* The most frequent call sites of the measured frames, resolve the addresses in the debugger */
+    CallSite sites[kMaxCallSites];
+    uint32_t siteCount = std::min(g_callSiteCount, kMaxCallSites);
+    std::copy(g_callSites, g_callSites + siteCount, sites);
+    std::sort(sites, sites + siteCount, [](const CallSite& a, const CallSite& b) { return a.count > b.count; });
+    for (uint32_t i = 0; i < std::min(siteCount, 8u); ++i)
+    {
+        char name[96];
+        std::snprintf(name, sizeof(name), "allocation site %p %s%s", sites[i].address, sites[i].phase, sourceSuffix(sites[i]));
+        report.addValue(name, double(sites[i].count), "");
+    }
+    if (g_droppedCallSites > 0)
+        report.addValue("allocation sites dropped", double(g_droppedCallSites), "");
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Benchmark.h"
+
+/*
+ * Opt-in heap allocation tracking. With TRACK_ALLOCATIONS defined in Config.h the global
+ * operator new/delete are replaced and the Vulkan driver gets allocation callbacks, without it
+ * all counters stay 0 and vulkanHostAllocator() returns nullptr.
+ */
+
+struct AllocationCounters
+{
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+};
+
+bool allocationTrackingEnabled();
+
+/* operator new and delete of the whole process, all threads */
+AllocationCounters heapAllocationCounters();
+/* Host memory the Vulkan implementation requested through vulkanHostAllocator() */
+AllocationCounters vulkanAllocationCounters();
+
+/* Pass to every vkCreate* and the matching vkDestroy* call, nullptr when tracking is off */
+const VkAllocationCallbacks* vulkanHostAllocator();
+
+/* Tags the following allocations of the calling thread with a phase of the frame, has to be a string literal */
+void setAllocationPhase(const char* phase);
+
+/*
+ * Compares the counters around every iteration of the main loop. Measured frames are expected
+ * to be free of heap and Vulkan host allocations: offending frames are counted, the first few
+ * are printed with the call sites of their heap allocations and the summary lists the most
+ * frequent call sites.
+ */
+class FrameAllocationMonitor
+{
+public:
+    static constexpr uint32_t kMaxPrintedFrames = 5;
+
+    void beginFrame(const FrameInfo& frame);
+    void endFrame(const FrameInfo& frame);
+
+    void report(Report& report) const;
+
+private:
+    AllocationCounters m_heapStart;
+    AllocationCounters m_vulkanStart;
+
+    Statistics m_heapAllocations;
+    Statistics m_heapBytes;
+    Statistics m_vulkanAllocations;
+    Statistics m_vulkanBytes;
+    uint64_t m_flaggedFrames = 0;
+    uint32_t m_printedFrames = 0;
+};
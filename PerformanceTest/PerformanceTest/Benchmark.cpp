@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+
+void fatal(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    std::exit(EXIT_FAILURE);
+}
+
+Options::Options(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0)
+            fatal("Unexpected argument '%s', options have the form --key=value", argv[i]);
+
+        argument = argument.substr(2);
+        size_t separator = argument.find('=');
+        if (separator != std::string::npos)
+            m_values[argument.substr(0, separator)] = argument.substr(separator + 1);
+        else if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
+            m_values[argument] = argv[++i];
+        else
+            m_values[argument] = "1";
+    }
+}
+
+bool Options::has(const std::string& key) const
+{
+    return m_values.find(key) != m_values.end();
+}
+
+std::string Options::getString(const std::string& key, const std::string& fallback) const
+{
+    auto it = m_values.find(key);
+    return it != m_values.end() ? it->second : fallback;
+}
+
+int64_t Options::getInt(const std::string& key, int64_t fallback) const
+{
+    auto it = m_values.find(key);
+    if (it == m_values.end())
+        return fallback;
+
+    char* end = nullptr;
+    long long value = std::strtoll(it->second.c_str(), &end, 0);
+    if (end == it->second.c_str() || *end != '\0')
+        fatal("Option --%s expects an integer, got '%s'", key.c_str(), it->second.c_str());
+    return value;
+}
+
+double Options::getDouble(const std::string& key, double fallback) const
+{
+    auto it = m_values.find(key);
+    if (it == m_values.end())
+        return fallback;
+
+    char* end = nullptr;
+    double value = std::strtod(it->second.c_str(), &end);
+    if (end == it->second.c_str() || *end != '\0')
+        fatal("Option --%s expects a number, got '%s'", key.c_str(), it->second.c_str());
+    return value;
+}
+
+bool Options::getBool(const std::string& key, bool fallback) const
+{
+    auto it = m_values.find(key);
+    if (it == m_values.end())
+        return fallback;
+
+    const std::string& value = it->second;
+    if (value == "1" || value == "true" || value == "on" || value == "yes")
+        return true;
+    if (value == "0" || value == "false" || value == "off" || value == "no")
+        return false;
+    fatal("Option --%s expects a boolean, got '%s'", key.c_str(), value.c_str());
+}
+
+Statistics::Statistics(size_t capacity)
+    : m_capacity(capacity)
+{
+    m_samples.reserve(capacity);
+}
+
+void Statistics::add(double value)
+{
+    if (m_samples.size() < m_capacity)
+        m_samples.push_back(value);
+
+    m_min = m_count ? std::min(m_min, value) : value;
+    m_max = m_count ? std::max(m_max, value) : value;
+    m_sum += value;
+    ++m_count;
+}
+
+void Statistics::clear()
+{
+    m_samples.clear();
+    m_count = 0;
+    m_sum = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+}
+
+double Statistics::percentile(double p) const
+{
+    if (m_samples.empty())
+        return 0.0;
+
+    std::vector<double> sorted = m_samples;
+    size_t index = std::min(sorted.size() - 1, size_t(p / 100.0 * double(sorted.size() - 1) + 0.5));
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void Report::addStatistics(const std::string& name, const Statistics& statistics, const char* unit)
+{
+    if (statistics.count() == 0)
+        return;
+
+    Entry entry;
+    entry.name = name;
+    entry.unit = unit;
+    entry.hasStatistics = true;
+    entry.mean = statistics.mean();
+    entry.median = statistics.percentile(50.0);
+    entry.p99 = statistics.percentile(99.0);
+    entry.min = statistics.min();
+    entry.max = statistics.max();
+    m_entries.push_back(entry);
+}
+
+void Report::addValue(const std::string& name, double value, const char* unit)
+{
+    Entry entry;
+    entry.name = name;
+    entry.unit = unit;
+    entry.value = value;
+    m_entries.push_back(entry);
+}
+
+void Report::addText(const std::string& name, const std::string& text)
+{
+    Entry entry;
+    entry.name = name;
+    entry.text = text;
+    m_entries.push_back(entry);
+}
+
+void Report::print(std::ostream& out) const
+{
+    size_t nameWidth = 8;
+    for (const Entry& entry : m_entries)
+        nameWidth = std::max(nameWidth, entry.name.size());
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(4);
+    for (const Entry& entry : m_entries)
+    {
+        out << std::left << std::setw(int(nameWidth) + 2) << entry.name << std::right;
+        if (!entry.text.empty())
+            out << entry.text;
+        else if (entry.hasStatistics)
+            out << "mean " << std::setw(12) << entry.mean
+                << "  median " << std::setw(12) << entry.median
+                << "  p99 " << std::setw(12) << entry.p99
+                << "  min " << std::setw(12) << entry.min
+                << "  max " << std::setw(12) << entry.max << " " << entry.unit;
+        else
+            out << std::setw(12) << entry.value << " " << entry.unit;
+        out << "\n";
+    }
+    out.flags(flags);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class LinearArena;
+
+/* Prints the message to stderr and terminates the process */
+[[noreturn]] void fatal(const char* format, ...);
+
+/* Command line options in the form --key=value or --key value */
+class Options
+{
+public:
+    Options(int argc, char** argv);
+
+    bool has(const std::string& key) const;
+    std::string getString(const std::string& key, const std::string& fallback) const;
+    int64_t getInt(const std::string& key, int64_t fallback) const;
+    double getDouble(const std::string& key, double fallback) const;
+    bool getBool(const std::string& key, bool fallback) const;
+
+private:
+    std::map<std::string, std::string> m_values;
+};
+
+/* Information about the frame that is currently being recorded */
+struct FrameInfo
+{
+    uint64_t index = 0;
+    /* false during the warmup frames, samples of those frames are discarded */
+    bool measured = false;
+    /* Transient memory of the frame, reset when the frame comes around again, see FrameArenas */
+    LinearArena* arena = nullptr;
+};
+
+/* Streaming sample statistics, percentiles are computed over the first `capacity` samples */
+class Statistics
+{
+public:
+    explicit Statistics(size_t capacity = 4096);
+
+    void add(double value);
+    void clear();
+
+    size_t count() const { return m_count; }
+    double mean() const { return m_count ? m_sum / double(m_count) : 0.0; }
+    double min() const { return m_count ? m_min : 0.0; }
+    double max() const { return m_count ? m_max : 0.0; }
+    double sum() const { return m_sum; }
+    double percentile(double p) const;
+
+private:
+    std::vector<double> m_samples;
+    size_t m_capacity;
+    size_t m_count = 0;
+    double m_sum = 0.0;
+    double m_min = 0.0;
+    double m_max = 0.0;
+};
+
+/* Run summary printed after the measured frames */
+class Report
+{
+public:
+    void addStatistics(const std::string& name, const Statistics& statistics, const char* unit);
+    void addValue(const std::string& name, double value, const char* unit);
+    void addText(const std::string& name, const std::string& text);
+
+    void print(std::ostream& out) const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        std::string unit;
+        std::string text;
+        bool hasStatistics = false;
+        double value = 0.0;
+        double mean = 0.0;
+        double median = 0.0;
+        double p99 = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    std::vector<Entry> m_entries;
+};
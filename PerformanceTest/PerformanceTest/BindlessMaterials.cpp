@@ -0,0 +1,95 @@
+#include "BindlessMaterials.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    MaterialBinding parseBinding(const std::string& binding)
+    {
+        if (binding == "per-draw")
+            return MaterialBinding::PerDraw;
+        if (binding == "bindless")
+            return MaterialBinding::Bindless;
+        if (binding == "array")
+            return MaterialBinding::TextureArray;
+        fatal("Unknown --binding '%s', expected per-draw, bindless or array", binding.c_str());
+    }
+
+    uint32_t packColor(float r, float g, float b)
+    {
+        auto channel = [](float value) { return uint32_t(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return channel(r) | (channel(g) << 8) | (channel(b) << 16) | 0xFF000000u;
+    }
+}
+
+const char* materialBindingName(MaterialBinding binding)
+{
+    switch (binding)
+    {
+    case MaterialBinding::PerDraw: return "per-draw";
+    case MaterialBinding::Bindless: return "bindless";
+    default: return "array";
+    }
+}
+
+BindlessMaterialsScenario::BindlessMaterialsScenario(const Options& options)
+    : m_binding(parseBinding(options.getString("binding", "bindless")))
+{
+    uint32_t drawCount = uint32_t(options.getInt("draws", 10000));
+    m_materialCount = uint32_t(options.getInt("materials", 256));
+    if (drawCount == 0 || m_materialCount < 2)
+        fatal("--draws has to be at least 1 and --materials at least 2");
+
+    /* A grid over the whole framebuffer, neighbouring draws never share a material */
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(drawCount)))));
+    float cell = 2.0f / float(side);
+    m_draws.resize(drawCount);
+    for (uint32_t i = 0; i < drawCount; ++i)
+    {
+        MaterialDrawConstants& draw = m_draws[i];
+        draw.rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        draw.material = i % m_materialCount;
+    }
+
+    std::printf("bindless: %u draws, %u materials, %s binding requested\n", drawCount, m_materialCount, materialBindingName(m_binding));
+}
+
+std::vector<uint32_t> BindlessMaterialsScenario::createTexels() const
+{
+    /* A checker board in a different hue per material, wrong bindings are easy to spot */
+    std::vector<uint32_t> texels(size_t(m_materialCount) * kTextureSize * kTextureSize);
+    for (uint32_t material = 0; material < m_materialCount; ++material)
+    {
+        float hue = float(material) / float(m_materialCount) * 6.0f;
+        float r = std::abs(hue - 3.0f) - 1.0f;
+        float g = 2.0f - std::abs(hue - 2.0f);
+        float b = 2.0f - std::abs(hue - 4.0f);
+        uint32_t bright = packColor(r, g, b);
+        uint32_t dark = packColor(r * 0.5f, g * 0.5f, b * 0.5f);
+
+        uint32_t* layer = texels.data() + size_t(material) * kTextureSize * kTextureSize;
+        for (uint32_t y = 0; y < kTextureSize; ++y)
+            for (uint32_t x = 0; x < kTextureSize; ++x)
+                layer[y * kTextureSize + x] = ((x / 8 + y / 8) & 1) ? bright : dark;
+    }
+    return texels;
+}
+
+void BindlessMaterialsScenario::recordDrawLoop(double milliseconds, bool measured)
+{
+    if (!measured)
+        return;
+    m_drawLoopTimes.add(milliseconds);
+    m_drawTimes.add(milliseconds * 1e6 / double(m_draws.size()));
+}
+
+void BindlessMaterialsScenario::report(Report& report)
+{
+    report.addText("material binding", materialBindingName(m_binding));
+    report.addValue("draws", double(m_draws.size()), "");
+    report.addValue("materials", double(m_materialCount), "");
+    report.addStatistics("cpu draw loop", m_drawLoopTimes, "ms");
+    report.addStatistics("cpu time per draw", m_drawTimes, "ns");
+}
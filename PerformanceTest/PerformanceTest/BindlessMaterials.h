@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "Scenario.h"
+
+enum class MaterialBinding
+{
+    /* One texture binding change per draw */
+    PerDraw,
+    /* ARB_bindless_texture handles or a descriptor indexing array, bound once per frame */
+    Bindless,
+    /* Every material is a layer of one 2D array texture, the fallback without bindless support */
+    TextureArray,
+};
+
+/* Push constants of shaders/materials, same layout as DrawConstants in materials.glsl */
+struct MaterialDrawConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    uint32_t material;
+    uint32_t padding[3];
+};
+
+/*
+ * Backend independent part of the material scenario: --draws small quads, each with a
+ * different material than the draw before it, so the per-draw path has to change the texture
+ * binding every time. The interesting number is the CPU time of the draw loop per draw.
+ */
+class BindlessMaterialsScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kTextureSize = 64;
+
+    BindlessMaterialsScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* kTextureSize^2 RGBA8 texels of every material, one material after the other */
+    std::vector<uint32_t> createTexels() const;
+    void recordDrawLoop(double milliseconds, bool measured);
+
+    /* Set by the backend if the requested binding is not supported */
+    MaterialBinding m_binding;
+    uint32_t m_materialCount;
+    std::vector<MaterialDrawConstants> m_draws;
+
+private:
+    Statistics m_drawLoopTimes;
+    Statistics m_drawTimes;
+};
+
+const char* materialBindingName(MaterialBinding binding);
+
+std::unique_ptr<Scenario> createBindlessMaterialsScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createBindlessMaterialsScenarioVulkan(VulkanContext& context, const Options& options);
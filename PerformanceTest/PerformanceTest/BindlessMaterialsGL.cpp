@@ -0,0 +1,133 @@
+#include "BindlessMaterials.h"
+
+#include <cstdio>
+#include <string>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    class BindlessMaterialsScenarioGL : public BindlessMaterialsScenario
+    {
+    public:
+        BindlessMaterialsScenarioGL(GLContext& context, const Options& options)
+            : BindlessMaterialsScenario(options)
+            , m_context(context)
+        {
+            const GLExtensions& extensions = m_context.extensions();
+            if (m_binding == MaterialBinding::Bindless && !extensions.bindlessTexture)
+            {
+                std::printf("bindless: GL_ARB_bindless_texture is not supported, falling back to a texture array\n");
+                m_binding = MaterialBinding::TextureArray;
+            }
+
+            std::vector<uint32_t> texels = createTexels();
+            GLsizei size = GLsizei(kTextureSize);
+            if (m_binding == MaterialBinding::TextureArray)
+            {
+                m_textures.resize(1);
+                glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, m_textures.data());
+                glTextureStorage3D(m_textures[0], 1, GL_RGBA8, size, size, GLsizei(m_materialCount));
+                glTextureSubImage3D(m_textures[0], 0, 0, 0, 0, size, size, GLsizei(m_materialCount), GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+                setSampling(m_textures[0]);
+            }
+            else
+            {
+                m_textures.resize(m_materialCount);
+                glCreateTextures(GL_TEXTURE_2D, GLsizei(m_materialCount), m_textures.data());
+                for (uint32_t material = 0; material < m_materialCount; ++material)
+                {
+                    glTextureStorage2D(m_textures[material], 1, GL_RGBA8, size, size);
+                    glTextureSubImage2D(m_textures[material], 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE,
+                                        texels.data() + size_t(material) * kTextureSize * kTextureSize);
+                    setSampling(m_textures[material]);
+                }
+            }
+
+            /* Handles are immutable once created, sampler state has to be set before */
+            if (m_binding == MaterialBinding::Bindless)
+            {
+                m_handles.resize(m_materialCount);
+                for (uint32_t material = 0; material < m_materialCount; ++material)
+                {
+                    m_handles[material] = extensions.getTextureHandleARB(m_textures[material]);
+                    extensions.makeTextureHandleResidentARB(m_handles[material]);
+                }
+                m_handleBuffer = createBuffer(GLsizeiptr(m_handles.size() * sizeof(GLuint64)), m_handles.data(), 0);
+            }
+
+            ShaderDefines defines = { { "MATERIAL_COUNT", std::to_string(m_materialCount) } };
+            switch (m_binding)
+            {
+            case MaterialBinding::PerDraw: defines.push_back({ "PER_DRAW", "1" }); break;
+            case MaterialBinding::Bindless: defines.push_back({ "BINDLESS", "1" }); break;
+            default: defines.push_back({ "TEXTURE_ARRAY", "1" }); break;
+            }
+            m_program = createProgram("materials/material.vert", "materials/material.frag", defines);
+
+            /* The quads are generated from gl_VertexID, but core profile draws need a vertex array */
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~BindlessMaterialsScenarioGL() override
+        {
+            for (GLuint64 handle : m_handles)
+                m_context.extensions().makeTextureHandleNonResidentARB(handle);
+            glDeleteProgram(m_program);
+            glDeleteVertexArrays(1, &m_vertexArray);
+            glDeleteBuffers(1, &m_handleBuffer);
+            glDeleteTextures(GLsizei(m_textures.size()), m_textures.data());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_CULL_FACE);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            m_context.profiler().begin("draw");
+            Timer timer;
+            glUseProgram(m_program);
+            glBindVertexArray(m_vertexArray);
+            if (m_binding == MaterialBinding::Bindless)
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_handleBuffer);
+            else if (m_binding == MaterialBinding::TextureArray)
+                glBindTextureUnit(0, m_textures[0]);
+
+            for (const MaterialDrawConstants& draw : m_draws)
+            {
+                if (m_binding == MaterialBinding::PerDraw)
+                    glBindTextureUnit(0, m_textures[draw.material]);
+                m_context.pushConstants(&draw, sizeof(draw));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            recordDrawLoop(timer.elapsedMs(), frame.measured);
+            m_context.profiler().end();
+        }
+
+    private:
+        static void setSampling(GLuint texture)
+        {
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        GLContext& m_context;
+        std::vector<GLuint> m_textures;
+        std::vector<GLuint64> m_handles;
+        GLuint m_handleBuffer = 0;
+        GLuint m_program = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createBindlessMaterialsScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<BindlessMaterialsScenarioGL>(context, options);
+}
@@ -0,0 +1,212 @@
+#include "BindlessMaterials.h"
+
+#include <cstdio>
+#include <string>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    class BindlessMaterialsScenarioVulkan : public BindlessMaterialsScenario
+    {
+    public:
+        BindlessMaterialsScenarioVulkan(VulkanContext& context, const Options& options)
+            : BindlessMaterialsScenario(options)
+            , m_context(context)
+        {
+            if (m_binding == MaterialBinding::Bindless && !m_context.vulkan12Features().descriptorIndexing)
+            {
+                std::printf("bindless: descriptor indexing is not supported, falling back to a texture array\n");
+                m_binding = MaterialBinding::TextureArray;
+            }
+            if (m_binding == MaterialBinding::Bindless)
+            {
+                /* An update-after-bind table counts against its own, usually far larger limits */
+                VkPhysicalDeviceVulkan12Properties properties12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+                VkPhysicalDeviceProperties2 properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+                properties.pNext = &properties12;
+                vkGetPhysicalDeviceProperties2(m_context.physicalDevice(), &properties);
+                if (m_materialCount > properties12.maxPerStageDescriptorUpdateAfterBindSamplers
+                    || m_materialCount > properties12.maxDescriptorSetUpdateAfterBindSampledImages)
+                {
+                    std::printf("bindless: %u materials exceed the update-after-bind limits, falling back to a texture array\n", m_materialCount);
+                    m_binding = MaterialBinding::TextureArray;
+                }
+            }
+
+            createTextures();
+            createDescriptors();
+            createPipeline();
+        }
+
+        ~BindlessMaterialsScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            vkDestroyPipeline(device, m_pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+            for (VulkanImage& texture : m_textures)
+                m_context.destroyImage(texture);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+
+            m_context.profiler().begin(cmd, "draw");
+            Timer timer;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+            if (m_binding != MaterialBinding::PerDraw)
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_sets[0], 0, nullptr);
+
+            for (const MaterialDrawConstants& draw : m_draws)
+            {
+                if (m_binding == MaterialBinding::PerDraw)
+                    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_sets[draw.material], 0, nullptr);
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(draw), &draw);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+            recordDrawLoop(timer.elapsedMs(), frame.measured);
+            m_context.profiler().end(cmd);
+
+            vkCmdEndRenderPass(cmd);
+        }
+
+    private:
+        void createTextures()
+        {
+            std::vector<uint32_t> texels = createTexels();
+            VkDeviceSize materialBytes = VkDeviceSize(kTextureSize) * kTextureSize * sizeof(uint32_t);
+
+            VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            info.imageType = VK_IMAGE_TYPE_2D;
+            info.format = VK_FORMAT_R8G8B8A8_UNORM;
+            info.extent = { kTextureSize, kTextureSize, 1 };
+            info.mipLevels = 1;
+            info.arrayLayers = 1;
+            info.samples = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+            if (m_binding == MaterialBinding::TextureArray)
+            {
+                info.arrayLayers = m_materialCount;
+                m_textures.push_back(m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT));
+                m_context.uploadImage(m_textures[0], texels.data(), materialBytes * m_materialCount);
+            }
+            else
+            {
+                m_textures.resize(m_materialCount);
+                for (uint32_t material = 0; material < m_materialCount; ++material)
+                {
+                    m_textures[material] = m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT);
+                    m_context.uploadImage(m_textures[material], texels.data() + size_t(material) * kTextureSize * kTextureSize, materialBytes);
+                }
+            }
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_NEAREST;
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            VK_CHECK(vkCreateSampler(m_context.device(), &samplerInfo, vulkanHostAllocator(), &m_sampler));
+        }
+
+        void createDescriptors()
+        {
+            std::vector<VkDescriptorImageInfo> images(m_textures.size());
+            for (size_t i = 0; i < m_textures.size(); ++i)
+                images[i] = { m_sampler, m_textures[i].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+            VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            write.dstBinding = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+            if (m_binding == MaterialBinding::Bindless)
+            {
+                /*
+                 * One set for the whole run. Update-after-bind puts the table under the larger
+                 * update-after-bind limits and lets slots be rewritten while the set is bound,
+                 * partially bound lets slots stay empty; here every slot is written before the first draw.
+                 */
+                m_setLayout = m_context.createDescriptorSetLayout(
+                    { { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_materialCount, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } },
+                    VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                    { VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT });
+                m_descriptorPool = m_context.createDescriptorPool(1, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_materialCount } },
+                                                                  VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+                m_sets.push_back(m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout));
+
+                write.dstSet = m_sets[0];
+                write.descriptorCount = m_materialCount;
+                write.pImageInfo = images.data();
+                vkUpdateDescriptorSets(m_context.device(), 1, &write, 0, nullptr);
+                return;
+            }
+
+            /* Per draw: one set per material. Texture array: a single set with one descriptor. */
+            uint32_t setCount = uint32_t(m_textures.size());
+            m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } });
+            m_descriptorPool = m_context.createDescriptorPool(setCount, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount } });
+            m_sets.resize(setCount);
+            for (uint32_t i = 0; i < setCount; ++i)
+            {
+                m_sets[i] = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                write.dstSet = m_sets[i];
+                write.descriptorCount = 1;
+                write.pImageInfo = &images[i];
+                vkUpdateDescriptorSets(m_context.device(), 1, &write, 0, nullptr);
+            }
+        }
+
+        void createPipeline()
+        {
+            ShaderDefines defines = { { "MATERIAL_COUNT", std::to_string(m_materialCount) } };
+            switch (m_binding)
+            {
+            case MaterialBinding::PerDraw: defines.push_back({ "PER_DRAW", "1" }); break;
+            case MaterialBinding::Bindless: defines.push_back({ "BINDLESS", "1" }); break;
+            default: defines.push_back({ "TEXTURE_ARRAY", "1" }); break;
+            }
+
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(MaterialDrawConstants));
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("materials/material.vert", VK_SHADER_STAGE_VERTEX_BIT, defines);
+            desc.fragmentShader = m_context.createShaderModule("materials/material.frag", VK_SHADER_STAGE_FRAGMENT_BIT, defines);
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = false;
+            desc.depthWrite = false;
+            m_pipeline = m_context.createGraphicsPipeline(desc);
+
+            vkDestroyShaderModule(m_context.device(), desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(m_context.device(), desc.fragmentShader, vulkanHostAllocator());
+        }
+
+        VulkanContext& m_context;
+        std::vector<VulkanImage> m_textures;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        /* Indexed by material in the per-draw path, a single set otherwise */
+        std::vector<VkDescriptorSet> m_sets;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_pipeline = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createBindlessMaterialsScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<BindlessMaterialsScenarioVulkan>(context, options);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GLContext.h"
+#include "Scenario.h"
+#include "VulkanContext.h"
+
+/*
+ * Backends of the scenarios whose workload is on the CPU: the GPU only clears the window, in
+ * zone "clear". `Base` is constructed from the options and the window size and does its work
+ * in update().
+ */
+template <typename Base>
+class ClearOnlyScenarioGL : public Base
+{
+public:
+    ClearOnlyScenarioGL(GLContext& context, const Options& options)
+        : Base(options, uint32_t(context.width()), uint32_t(context.height()))
+        , m_context(context)
+    {
+    }
+
+    void render(const FrameInfo& frame) override
+    {
+        m_context.profiler().begin("clear");
+        glClear(GL_COLOR_BUFFER_BIT);
+        m_context.profiler().end();
+    }
+
+private:
+    GLContext& m_context;
+};
+
+template <typename Base>
+class ClearOnlyScenarioVulkan : public Base
+{
+public:
+    ClearOnlyScenarioVulkan(VulkanContext& context, const Options& options)
+        : Base(options, context.swapchainExtent().width, context.swapchainExtent().height)
+        , m_context(context)
+    {
+    }
+
+    void render(const FrameInfo& frame) override
+    {
+        const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        VkCommandBuffer cmd = m_context.commandBuffer();
+        m_context.profiler().begin(cmd, "clear");
+        m_context.beginSwapchainPass(cmd, clearColor);
+        vkCmdEndRenderPass(cmd);
+        m_context.profiler().end(cmd);
+    }
+
+private:
+    VulkanContext& m_context;
+};
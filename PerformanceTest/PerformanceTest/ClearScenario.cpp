@@ -0,0 +1,123 @@
+#include "ClearScenario.h"
+
+#include <cstdio>
+#include <string>
+
+#include "RenderTargetPool.h"
+
+namespace
+{
+    ClearMethod parseMethod(const std::string& method)
+    {
+        if (method == "framebuffer")
+            return ClearMethod::Framebuffer;
+        if (method == "buffer")
+            return ClearMethod::Buffer;
+        if (method == "image")
+            return ClearMethod::Image;
+        if (method == "discard")
+            return ClearMethod::Discard;
+        fatal("Unknown --clear '%s', expected framebuffer, buffer, image or discard", method.c_str());
+    }
+
+    const char* const kTargetNames[3] = { "color", "depth", "stencil" };
+
+    uint32_t parseTargets(const std::string& targets)
+    {
+        uint32_t mask = 0;
+        size_t begin = 0;
+        while (begin <= targets.size())
+        {
+            size_t end = targets.find('+', begin);
+            if (end == std::string::npos)
+                end = targets.size();
+            std::string name = targets.substr(begin, end - begin);
+            uint32_t bit = 0;
+            for (uint32_t i = 0; i < 3; ++i)
+                if (name == kTargetNames[i])
+                    bit = 1u << i;
+            if (!bit)
+                fatal("Unknown --targets '%s', expected color, depth and stencil joined by +", targets.c_str());
+            mask |= bit;
+            begin = end + 1;
+        }
+        return mask;
+    }
+
+    /* Fast clear friendly first, then values no clear value table starts out with */
+    const ClearValues kValues[2] = {
+        { { 0.0f, 0.0f, 0.0f, 0.0f }, 1.0f, 0 },
+        { { 0.3f, 0.6f, 0.2f, 0.7f }, 0.42f, 0x5A },
+    };
+    const char* const kZones[2] = { "clear", "clear arbitrary" };
+
+    /* Arbitrary values taking at least this much longer than 0 and 1 point at a fast clear */
+    constexpr double kFastClearRatio = 1.5;
+
+    double gigabytesPerSecond(uint64_t bytes, double milliseconds)
+    {
+        return milliseconds > 0.0 ? double(bytes) / (milliseconds * 1e-3) * 1e-9 : 0.0;
+    }
+}
+
+ClearScenario::ClearScenario(const Options& options)
+    : m_method(parseMethod(options.getString("clear", "framebuffer")))
+    , m_targets(parseTargets(options.getString("targets", "color")))
+{
+    m_fixedResolution = parseRenderResolution(options.getString("resolution", "window"), m_fixedWidth, m_fixedHeight);
+}
+
+const char* ClearScenario::zone(uint32_t pass)
+{
+    return kZones[pass];
+}
+
+const ClearValues& ClearScenario::values(uint32_t pass)
+{
+    return kValues[pass];
+}
+
+bool ClearScenario::updateSize(uint32_t windowWidth, uint32_t windowHeight)
+{
+    uint32_t width = m_fixedResolution ? m_fixedWidth : windowWidth;
+    uint32_t height = m_fixedResolution ? m_fixedHeight : windowHeight;
+    if (width == m_width && height == m_height)
+        return false;
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void ClearScenario::report(Report& report)
+{
+    std::string targets;
+    for (uint32_t i = 0; i < 3; ++i)
+        if (m_targets & (1u << i))
+            targets += (targets.empty() ? "" : "+") + std::string(kTargetNames[i]);
+    char resolution[32];
+    std::snprintf(resolution, sizeof(resolution), "%ux%u", m_width, m_height);
+
+    /* What the clear logically writes, RGBA8, 32 bit depth and 8 bit stencil */
+    uint64_t texelBytes = (clears(ClearTarget::Color) ? 4 : 0) + (clears(ClearTarget::Depth) ? 4 : 0) + (clears(ClearTarget::Stencil) ? 1 : 0);
+    uint64_t bytes = uint64_t(m_width) * m_height * texelBytes;
+    report.addText("clear method", methodName());
+    report.addText("clear targets", targets);
+    report.addText("clear resolution", resolution);
+    report.addValue("clear bytes", double(bytes) / (1024.0 * 1024.0), "MiB");
+    if (m_method == ClearMethod::Discard)
+    {
+        report.addText("fast clear", "n/a");
+        return;
+    }
+
+    const Statistics* fast = zoneTimes(kZones[0]);
+    const Statistics* arbitrary = zoneTimes(kZones[1]);
+    if (!fast || !arbitrary || fast->mean() <= 0.0)
+        return;
+    double ratio = arbitrary->mean() / fast->mean();
+    report.addValue("clear bandwidth", gigabytesPerSecond(bytes, fast->mean()), "GB/s");
+    report.addValue("clear arbitrary bandwidth", gigabytesPerSecond(bytes, arbitrary->mean()), "GB/s");
+    report.addValue("arbitrary to fast clear time", ratio, "x");
+    /* Equal times do not rule a fast clear out, the hardware may handle arbitrary values as well */
+    report.addText("fast clear", ratio >= kFastClearRatio ? "likely" : "not detected");
+}
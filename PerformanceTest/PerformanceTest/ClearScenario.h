@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Scenario.h"
+
+/* --clear framebuffer|buffer|image|discard */
+enum class ClearMethod
+{
+    /* glClear, on Vulkan VK_ATTACHMENT_LOAD_OP_CLEAR of an otherwise empty render pass */
+    Framebuffer,
+    /* glClearBufferfv and friends, on Vulkan vkCmdClearAttachments inside a render pass that loads */
+    Buffer,
+    /* glClearTexImage, on Vulkan vkCmdClearColorImage and vkCmdClearDepthStencilImage, no framebuffer involved */
+    Image,
+    /* glInvalidateFramebuffer, on Vulkan VK_ATTACHMENT_LOAD_OP_DONT_CARE, the contents become undefined instead of cleared */
+    Discard
+};
+
+/* Bits of --targets */
+enum class ClearTarget : uint32_t
+{
+    Color = 1,
+    Depth = 2,
+    Stencil = 4
+};
+
+/* What the clears write, one set that fast clear hardware usually handles and one it usually does not */
+struct ClearValues
+{
+    float color[4];
+    float depth;
+    uint32_t stencil;
+};
+
+/*
+ * Backend independent part of the clear scenario, the original workload of the benchmark: every
+ * frame clears the --targets color|depth|stencil joined by + (default color) of an offscreen
+ * RGBA8 and depth/stencil framebuffer at --resolution window|720p|1080p|1440p|4k|<w>x<h> with
+ * --clear framebuffer|buffer|image|discard. Depth alone is D32F, stencil alone S8 where
+ * supported and both D32F S8. Each value clear runs twice a frame, zone "clear" with 0 and 1
+ * and zone "clear arbitrary" with values in between. No API says whether the driver fast
+ * clears, the report compares the two instead: fast clears through compression metadata or
+ * clear value tables cover 0 and 1 nearly everywhere, arbitrary values rarely.
+ */
+class ClearScenario : public Scenario
+{
+public:
+    ClearScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    bool clears(ClearTarget target) const { return (m_targets & uint32_t(target)) != 0; }
+    /* Timed clears per frame, discarding has no values to compare */
+    uint32_t passCount() const { return m_method == ClearMethod::Discard ? 1 : 2; }
+    static const char* zone(uint32_t pass);
+    static const ClearValues& values(uint32_t pass);
+    /* Updates the target size, true if it changed and the targets have to be recreated */
+    bool updateSize(uint32_t windowWidth, uint32_t windowHeight);
+    /* Measured GPU times of a zone, nullptr before its first result */
+    virtual const Statistics* zoneTimes(const char* zone) const = 0;
+    /* The calls --clear makes on the backend for the chosen targets */
+    virtual const char* methodName() const = 0;
+
+    ClearMethod m_method;
+    uint32_t m_targets;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+
+private:
+    bool m_fixedResolution;
+    uint32_t m_fixedWidth = 0;
+    uint32_t m_fixedHeight = 0;
+};
+
+std::unique_ptr<Scenario> createClearScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createClearScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,218 @@
+#include "ClearScenario.h"
+
+#include "GLContext.h"
+
+namespace
+{
+    /*
+     * The targets are textures so glClearTexImage can reach them without a framebuffer, the
+     * other methods clear them through one framebuffer. Depth and stencil share a
+     * GL_DEPTH32F_STENCIL8 texture only if both are cleared, glClearTexImage cannot clear one
+     * aspect of it alone. The window is cleared afterwards like before, outside the timed zones.
+     */
+    class ClearScenarioGL : public ClearScenario
+    {
+    public:
+        ClearScenarioGL(GLContext& context, const Options& options)
+            : ClearScenario(options)
+            , m_context(context)
+        {
+            if (clears(ClearTarget::Depth) && clears(ClearTarget::Stencil))
+            {
+                m_depthStencilFormat = GL_DEPTH32F_STENCIL8;
+                m_depthStencilAttachment = GL_DEPTH_STENCIL_ATTACHMENT;
+            }
+            else if (clears(ClearTarget::Depth))
+            {
+                m_depthStencilFormat = GL_DEPTH_COMPONENT32F;
+                m_depthStencilAttachment = GL_DEPTH_ATTACHMENT;
+            }
+            else if (clears(ClearTarget::Stencil))
+            {
+                m_depthStencilFormat = GL_STENCIL_INDEX8;
+                m_depthStencilAttachment = GL_STENCIL_ATTACHMENT;
+            }
+        }
+
+        ~ClearScenarioGL() override
+        {
+            destroyTargets();
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            if (updateSize(uint32_t(m_context.width()), uint32_t(m_context.height())))
+                createTargets();
+
+            /* glClear and glClearBuffer honor the write masks */
+            m_context.state().depthMask(true);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+            glViewport(0, 0, GLsizei(m_width), GLsizei(m_height));
+            for (uint32_t pass = 0; pass < passCount(); ++pass)
+            {
+                m_context.profiler().begin(zone(pass));
+                clear(values(pass));
+                m_context.profiler().end();
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            m_context.profiler().begin("present");
+            glClear(GL_COLOR_BUFFER_BIT);
+            m_context.profiler().end();
+        }
+
+    private:
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        const char* methodName() const override
+        {
+            switch (m_method)
+            {
+            case ClearMethod::Framebuffer:
+                return "glClear";
+            case ClearMethod::Buffer:
+                if (clears(ClearTarget::Depth) && clears(ClearTarget::Stencil))
+                    return clears(ClearTarget::Color) ? "glClearBufferfv/fi" : "glClearBufferfi";
+                if (clears(ClearTarget::Stencil))
+                    return clears(ClearTarget::Color) ? "glClearBufferfv/iv" : "glClearBufferiv";
+                return "glClearBufferfv";
+            case ClearMethod::Image:
+                return "glClearTexImage";
+            case ClearMethod::Discard:
+                return "glInvalidateFramebuffer";
+            }
+            return "glClear";
+        }
+
+        void clear(const ClearValues& values)
+        {
+            bool color = clears(ClearTarget::Color);
+            bool depth = clears(ClearTarget::Depth);
+            bool stencil = clears(ClearTarget::Stencil);
+            switch (m_method)
+            {
+            case ClearMethod::Framebuffer:
+            {
+                GLbitfield mask = 0;
+                if (color)
+                {
+                    glClearColor(values.color[0], values.color[1], values.color[2], values.color[3]);
+                    mask |= GL_COLOR_BUFFER_BIT;
+                }
+                if (depth)
+                {
+                    glClearDepthf(values.depth);
+                    mask |= GL_DEPTH_BUFFER_BIT;
+                }
+                if (stencil)
+                {
+                    glClearStencil(GLint(values.stencil));
+                    mask |= GL_STENCIL_BUFFER_BIT;
+                }
+                glClear(mask);
+                break;
+            }
+            case ClearMethod::Buffer:
+            {
+                GLint stencilValue = GLint(values.stencil);
+                if (color)
+                    glClearBufferfv(GL_COLOR, 0, values.color);
+                if (depth && stencil)
+                    glClearBufferfi(GL_DEPTH_STENCIL, 0, values.depth, stencilValue);
+                else if (depth)
+                    glClearBufferfv(GL_DEPTH, 0, &values.depth);
+                else if (stencil)
+                    glClearBufferiv(GL_STENCIL, 0, &stencilValue);
+                break;
+            }
+            case ClearMethod::Image:
+            {
+                if (color)
+                    glClearTexImage(m_color, 0, GL_RGBA, GL_FLOAT, values.color);
+                if (depth && stencil)
+                {
+                    /* GL_FLOAT_32_UNSIGNED_INT_24_8_REV: the float depth, then the stencil in the low 8 bits of the next word */
+                    struct
+                    {
+                        float depth;
+                        uint32_t stencil;
+                    } packed = { values.depth, values.stencil };
+                    glClearTexImage(m_depthStencil, 0, GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, &packed);
+                }
+                else if (depth)
+                {
+                    glClearTexImage(m_depthStencil, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &values.depth);
+                }
+                else if (stencil)
+                {
+                    uint8_t stencilValue = uint8_t(values.stencil);
+                    glClearTexImage(m_depthStencil, 0, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &stencilValue);
+                }
+                break;
+            }
+            case ClearMethod::Discard:
+            {
+                GLenum attachments[3];
+                GLsizei count = 0;
+                if (color)
+                    attachments[count++] = GL_COLOR_ATTACHMENT0;
+                if (depth)
+                    attachments[count++] = GL_DEPTH_ATTACHMENT;
+                if (stencil)
+                    attachments[count++] = GL_STENCIL_ATTACHMENT;
+                glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments);
+                break;
+            }
+            }
+        }
+
+        void createTargets()
+        {
+            destroyTargets();
+            glCreateFramebuffers(1, &m_framebuffer);
+            if (clears(ClearTarget::Color))
+            {
+                glCreateTextures(GL_TEXTURE_2D, 1, &m_color);
+                glTextureStorage2D(m_color, 1, GL_RGBA8, GLsizei(m_width), GLsizei(m_height));
+                glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_color, 0);
+            }
+            else
+            {
+                glNamedFramebufferDrawBuffer(m_framebuffer, GL_NONE);
+            }
+            if (m_depthStencilFormat != GL_NONE)
+            {
+                glCreateTextures(GL_TEXTURE_2D, 1, &m_depthStencil);
+                glTextureStorage2D(m_depthStencil, 1, m_depthStencilFormat, GLsizei(m_width), GLsizei(m_height));
+                glNamedFramebufferTexture(m_framebuffer, m_depthStencilAttachment, m_depthStencil, 0);
+            }
+            if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                fatal("The clear framebuffer is incomplete");
+        }
+
+        void destroyTargets()
+        {
+            glDeleteFramebuffers(1, &m_framebuffer);
+            glDeleteTextures(1, &m_color);
+            glDeleteTextures(1, &m_depthStencil);
+            m_framebuffer = m_color = m_depthStencil = 0;
+        }
+
+        GLContext& m_context;
+        GLenum m_depthStencilFormat = GL_NONE;
+        GLenum m_depthStencilAttachment = GL_NONE;
+        GLuint m_color = 0;
+        GLuint m_depthStencil = 0;
+        GLuint m_framebuffer = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createClearScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ClearScenarioGL>(context, options);
+}
@@ -0,0 +1,320 @@
+#include "ClearScenario.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderTargetPool.h"
+
+namespace
+{
+    bool supportsDepthStencil(VkPhysicalDevice physicalDevice, VkFormat format)
+    {
+        VkFormatProperties properties = {};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0;
+    }
+
+    /*
+     * Every method but --clear image goes through one render pass whose load ops do the work:
+     * CLEAR for framebuffer, LOAD followed by vkCmdClearAttachments for buffer and DONT_CARE for
+     * discard. The targets stay in their attachment layouts, or in TRANSFER_DST_OPTIMAL for
+     * --clear image, so no timed clear pays for a layout transition. Stencil alone falls back to
+     * a combined format where S8_UINT is not supported, its depth aspect is then loaded.
+     */
+    class ClearScenarioVulkan : public ClearScenario
+    {
+    public:
+        ClearScenarioVulkan(VulkanContext& context, const Options& options)
+            : ClearScenario(options)
+            , m_context(context)
+        {
+            VkPhysicalDevice physicalDevice = m_context.physicalDevice();
+            if (clears(ClearTarget::Depth) && !clears(ClearTarget::Stencil))
+            {
+                m_depthStencilFormat = VK_FORMAT_D32_SFLOAT;
+            }
+            else if (clears(ClearTarget::Stencil))
+            {
+                if (!clears(ClearTarget::Depth) && supportsDepthStencil(physicalDevice, VK_FORMAT_S8_UINT))
+                    m_depthStencilFormat = VK_FORMAT_S8_UINT;
+                else if (supportsDepthStencil(physicalDevice, VK_FORMAT_D32_SFLOAT_S8_UINT))
+                    m_depthStencilFormat = VK_FORMAT_D32_SFLOAT_S8_UINT;
+                else
+                    m_depthStencilFormat = VK_FORMAT_D24_UNORM_S8_UINT;
+            }
+            if (m_depthStencilFormat != VK_FORMAT_S8_UINT && m_depthStencilFormat != VK_FORMAT_UNDEFINED)
+                m_depthStencilAspect |= VK_IMAGE_ASPECT_DEPTH_BIT;
+            if (m_depthStencilFormat != VK_FORMAT_D32_SFLOAT && m_depthStencilFormat != VK_FORMAT_UNDEFINED)
+                m_depthStencilAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+            if (clears(ClearTarget::Depth))
+                m_clearAspect |= VK_IMAGE_ASPECT_DEPTH_BIT;
+            if (clears(ClearTarget::Stencil))
+                m_clearAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+            if (m_method != ClearMethod::Image)
+                createRenderPass();
+        }
+
+        ~ClearScenarioVulkan() override
+        {
+            m_context.waitIdle();
+            destroyTargets();
+            vkDestroyRenderPass(m_context.device(), m_renderPass, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkExtent2D window = m_context.swapchainExtent();
+            if (updateSize(window.width, window.height))
+            {
+                m_context.waitIdle();
+                createTargets();
+            }
+
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            for (uint32_t pass = 0; pass < passCount(); ++pass)
+            {
+                /* The render pass dependency orders the clears of consecutive passes, the transfers need a barrier */
+                if (m_method == ClearMethod::Image)
+                    cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     VK_ACCESS_TRANSFER_WRITE_BIT);
+                m_context.profiler().begin(cmd, zone(pass));
+                if (m_method == ClearMethod::Image)
+                    clearImages(cmd, values(pass));
+                else
+                    clearInRenderPass(cmd, values(pass));
+                m_context.profiler().end(cmd);
+            }
+
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            m_context.profiler().begin(cmd, "present");
+            m_context.beginSwapchainPass(cmd, clearColor);
+            vkCmdEndRenderPass(cmd);
+            m_context.profiler().end(cmd);
+        }
+
+    private:
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        const char* methodName() const override
+        {
+            switch (m_method)
+            {
+            case ClearMethod::Framebuffer:
+                return "VK_ATTACHMENT_LOAD_OP_CLEAR";
+            case ClearMethod::Buffer:
+                return "vkCmdClearAttachments";
+            case ClearMethod::Image:
+                if (!clears(ClearTarget::Color))
+                    return "vkCmdClearDepthStencilImage";
+                return m_clearAspect ? "vkCmdClearColorImage/DepthStencilImage" : "vkCmdClearColorImage";
+            case ClearMethod::Discard:
+                return "VK_ATTACHMENT_LOAD_OP_DONT_CARE";
+            }
+            return "VK_ATTACHMENT_LOAD_OP_CLEAR";
+        }
+
+        void clearImages(VkCommandBuffer cmd, const ClearValues& values)
+        {
+            if (clears(ClearTarget::Color))
+            {
+                VkClearColorValue color;
+                for (uint32_t i = 0; i < 4; ++i)
+                    color.float32[i] = values.color[i];
+                const VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                vkCmdClearColorImage(cmd, m_color.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+            }
+            if (m_clearAspect)
+            {
+                const VkClearDepthStencilValue depthStencil = { values.depth, values.stencil };
+                const VkImageSubresourceRange range = { m_clearAspect, 0, 1, 0, 1 };
+                vkCmdClearDepthStencilImage(cmd, m_depthStencil.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &depthStencil, 1, &range);
+            }
+        }
+
+        /* The load ops clear or discard, --clear buffer loads and clears with vkCmdClearAttachments inside the pass */
+        void clearInRenderPass(VkCommandBuffer cmd, const ClearValues& values)
+        {
+            VkClearValue clearValues[2] = {};
+            uint32_t count = 0;
+            if (clears(ClearTarget::Color))
+            {
+                for (uint32_t i = 0; i < 4; ++i)
+                    clearValues[count].color.float32[i] = values.color[i];
+                ++count;
+            }
+            if (m_depthStencilAspect)
+                clearValues[count++].depthStencil = { values.depth, values.stencil };
+
+            VkRenderPassBeginInfo beginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+            beginInfo.renderPass = m_renderPass;
+            beginInfo.framebuffer = m_framebuffer;
+            beginInfo.renderArea.extent = { m_width, m_height };
+            beginInfo.clearValueCount = count;
+            beginInfo.pClearValues = clearValues;
+            vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            if (m_method == ClearMethod::Buffer)
+            {
+                VkClearAttachment attachments[2];
+                uint32_t attachmentCount = 0;
+                if (clears(ClearTarget::Color))
+                    attachments[attachmentCount++] = { VK_IMAGE_ASPECT_COLOR_BIT, 0, clearValues[0] };
+                if (m_clearAspect)
+                    attachments[attachmentCount++] = { m_clearAspect, 0, clearValues[count - 1] };
+                const VkClearRect rect = { { { 0, 0 }, { m_width, m_height } }, 0, 1 };
+                vkCmdClearAttachments(cmd, attachmentCount, attachments, 1, &rect);
+            }
+            vkCmdEndRenderPass(cmd);
+        }
+
+        /* Color first, then depth/stencil. An aspect that is not cleared is loaded and stored */
+        void createRenderPass()
+        {
+            VkAttachmentLoadOp clearOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            if (m_method == ClearMethod::Buffer)
+                clearOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            else if (m_method == ClearMethod::Discard)
+                clearOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+            VkAttachmentDescription attachments[2] = {};
+            VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+            VkAttachmentReference depthStencilReference = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+            VkSubpassDescription subpass = {};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            uint32_t count = 0;
+            if (clears(ClearTarget::Color))
+            {
+                VkAttachmentDescription& color = attachments[count++];
+                color.format = VulkanRenderTargetPool::format(RenderTargetFormat::RGBA8);
+                color.samples = VK_SAMPLE_COUNT_1_BIT;
+                color.loadOp = clearOp;
+                color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                color.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                color.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                subpass.colorAttachmentCount = 1;
+                subpass.pColorAttachments = &colorReference;
+            }
+            if (m_depthStencilAspect)
+            {
+                bool hasDepth = (m_depthStencilAspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+                bool hasStencil = (m_depthStencilAspect & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+                VkAttachmentDescription& depthStencil = attachments[count];
+                depthStencil.format = m_depthStencilFormat;
+                depthStencil.samples = VK_SAMPLE_COUNT_1_BIT;
+                depthStencil.loadOp = clears(ClearTarget::Depth) ? clearOp : hasDepth ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                depthStencil.storeOp = hasDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                depthStencil.stencilLoadOp = clears(ClearTarget::Stencil) ? clearOp : hasStencil ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                depthStencil.stencilStoreOp = hasStencil ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                depthStencil.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                depthStencil.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                depthStencilReference.attachment = count++;
+                subpass.pDepthStencilAttachment = &depthStencilReference;
+            }
+
+            /* The only other user of the targets is the previous pass clearing them */
+            const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            VkSubpassDependency dependency = {};
+            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependency.dstSubpass = 0;
+            dependency.srcStageMask = stages;
+            dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstStageMask = stages;
+            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+            VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+            info.attachmentCount = count;
+            info.pAttachments = attachments;
+            info.subpassCount = 1;
+            info.pSubpasses = &subpass;
+            info.dependencyCount = 1;
+            info.pDependencies = &dependency;
+            VK_CHECK(vkCreateRenderPass(m_context.device(), &info, vulkanHostAllocator(), &m_renderPass));
+        }
+
+        /* The images, moved once into the layout every clear expects, and the framebuffer */
+        void createTargets()
+        {
+            destroyTargets();
+            bool image = m_method == ClearMethod::Image;
+            VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            info.imageType = VK_IMAGE_TYPE_2D;
+            info.extent = { m_width, m_height, 1 };
+            info.mipLevels = 1;
+            info.arrayLayers = 1;
+            info.samples = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            /*
+             * Transfer-only images get no views, a view needs a usage other than the transfer ones
+             * and adding an attachment usage could change how the driver compresses the image
+             */
+            VkImageView views[2];
+            uint32_t count = 0;
+            if (clears(ClearTarget::Color))
+            {
+                info.format = VulkanRenderTargetPool::format(RenderTargetFormat::RGBA8);
+                info.usage = image ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                m_color = m_context.createImage(info, image ? 0 : VK_IMAGE_ASPECT_COLOR_BIT);
+                views[count++] = m_color.view;
+            }
+            if (m_depthStencilAspect)
+            {
+                info.format = m_depthStencilFormat;
+                info.usage = image ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                m_depthStencil = m_context.createImage(info, image ? 0 : m_depthStencilAspect);
+                views[count++] = m_depthStencil.view;
+            }
+
+            m_context.immediateSubmit([&](VkCommandBuffer cmd) {
+                if (m_color.image)
+                    cmdImageBarrier(cmd, m_color.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                                    image ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+                if (m_depthStencil.image)
+                    cmdImageBarrier(cmd, m_depthStencil.image, m_depthStencilAspect, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                                    image ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            });
+            if (image)
+                return;
+
+            VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+            framebufferInfo.renderPass = m_renderPass;
+            framebufferInfo.attachmentCount = count;
+            framebufferInfo.pAttachments = views;
+            framebufferInfo.width = m_width;
+            framebufferInfo.height = m_height;
+            framebufferInfo.layers = 1;
+            VK_CHECK(vkCreateFramebuffer(m_context.device(), &framebufferInfo, vulkanHostAllocator(), &m_framebuffer));
+        }
+
+        void destroyTargets()
+        {
+            vkDestroyFramebuffer(m_context.device(), m_framebuffer, vulkanHostAllocator());
+            m_framebuffer = VK_NULL_HANDLE;
+            m_context.destroyImage(m_color);
+            m_context.destroyImage(m_depthStencil);
+        }
+
+        VulkanContext& m_context;
+        VkFormat m_depthStencilFormat = VK_FORMAT_UNDEFINED;
+        /* Aspects of the depth/stencil format and the ones --targets clears */
+        VkImageAspectFlags m_depthStencilAspect = 0;
+        VkImageAspectFlags m_clearAspect = 0;
+        VkRenderPass m_renderPass = VK_NULL_HANDLE;
+        VulkanImage m_color;
+        VulkanImage m_depthStencil;
+        VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createClearScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ClearScenarioVulkan>(context, options);
+}
@@ -0,0 +1,148 @@
+#include "Clustered.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Random.h"
+
+namespace
+{
+    ClusteredShading parseShading(const std::string& shading)
+    {
+        if (shading == "forward")
+            return ClusteredShading::Forward;
+        if (shading == "clustered")
+            return ClusteredShading::Clustered;
+        fatal("Unknown --shading '%s', expected forward or clustered", shading.c_str());
+    }
+
+    constexpr float kFovY = 1.0f;
+    constexpr float kNear = 1.0f;
+    /* Beyond the farthest corner of the grid */
+    constexpr float kFar = 120.0f;
+    const Vec3 kEye = { 0.0f, 24.0f, 44.0f };
+}
+
+ClusteredScenario::ClusteredScenario(const Options& options)
+    : m_shading(parseShading(options.getString("shading", "clustered")))
+{
+    int64_t lightCount = options.getInt("lights", 1024);
+    if (lightCount < 1 || lightCount > 100000)
+        fatal("--lights has to be between 1 and 100000");
+    double radius = options.getDouble("light-radius", 3.0);
+    if (radius <= 0.0)
+        fatal("--light-radius has to be positive");
+
+    /* Over the whole grid and a little beyond, radii between half and all of --light-radius */
+    uint32_t state = 0xC1057E4u;
+    float extent = float(kGridSide) + 1.0f;
+    m_lights.resize(size_t(lightCount));
+    for (ClusteredLight& light : m_lights)
+    {
+        light.positionRadius = { extent * (2.0f * randomUnit(state) - 1.0f), 0.5f + 3.5f * randomUnit(state), extent * (2.0f * randomUnit(state) - 1.0f),
+                                 float(radius) * (0.5f + 0.5f * randomUnit(state)) };
+        light.color = { randomUnit(state), randomUnit(state), randomUnit(state), 1.0f };
+    }
+
+    std::printf("clustered: %u lights, %s shading\n", uint32_t(m_lights.size()), m_shading == ClusteredShading::Clustered ? "clustered" : "forward");
+}
+
+void ClusteredScenario::buildGraph(RenderGraph& graph)
+{
+    uint32_t clusters = graph.importBuffer("clusters");
+    bool clustered = m_shading == ClusteredShading::Clustered;
+    if (clustered)
+    {
+        uint32_t cull = addPass("cull", ClusteredPassKind::Cull);
+        graph.write(cull, clusters, RenderGraphAccess::StorageWriteCompute);
+    }
+    uint32_t shade = addPass("shade", ClusteredPassKind::Shade);
+    if (clustered)
+        graph.read(shade, clusters, RenderGraphAccess::StorageReadGraphics);
+    graph.setSideEffect(shade);
+    graph.compile();
+}
+
+Mat4 ClusteredScenario::projection(uint32_t width, uint32_t height) const
+{
+    return perspective(kFovY, float(width) / float(height), kNear, kFar);
+}
+
+Mat4 ClusteredScenario::view() const
+{
+    return lookAt(kEye, { 0.0f, 0.0f, 4.0f }, { 0.0f, 1.0f, 0.0f });
+}
+
+ClusteredConstants ClusteredScenario::constants(const Mat4& matrix, uint32_t width, uint32_t height) const
+{
+    Mat4 proj = projection(width, height);
+    ClusteredConstants constants = {};
+    constants.matrix = matrix;
+    constants.eye = { kEye.x, kEye.y, kEye.z, 1.0f };
+    constants.projection = { proj.at(0, 0), proj.at(1, 1), kNear, kFar };
+    constants.lightCount = uint32_t(m_lights.size());
+    constants.clustersX = kClustersX;
+    constants.clustersY = kClustersY;
+    constants.clustersZ = kClustersZ;
+    constants.gridSide = kGridSide;
+    return constants;
+}
+
+ClusteredConstants ClusteredScenario::cullConstants(uint32_t width, uint32_t height) const
+{
+    return constants(view(), width, height);
+}
+
+ClusteredConstants ClusteredScenario::shadeConstants(uint32_t width, uint32_t height) const
+{
+    return constants(projection(width, height) * view(), width, height);
+}
+
+ShaderDefines ClusteredScenario::shadeDefines() const
+{
+    return { { "CLUSTERED", m_shading == ClusteredShading::Clustered ? "1" : "0" } };
+}
+
+void ClusteredScenario::report(Report& report)
+{
+    report.addValue("lights", double(m_lights.size()), "");
+    report.addText("shading", m_shading == ClusteredShading::Clustered ? "clustered" : "forward");
+    if (m_shading == ClusteredShading::Clustered)
+    {
+        report.addValue("clusters", double(clusterCount()), "");
+        report.addValue("cluster buffer", double(clusterBufferSize()) / (1024.0 * 1024.0), "MiB");
+    }
+}
+
+void ClusteredScenario::reportClusterHits(Report& report, const uint32_t* hitCounts) const
+{
+    uint32_t peak = 0;
+    uint32_t overflowing = 0;
+    uint64_t hits = 0;
+    uint64_t dropped = 0;
+    for (uint32_t i = 0; i < clusterCount(); ++i)
+    {
+        peak = std::max(peak, hitCounts[i]);
+        hits += hitCounts[i];
+        if (hitCounts[i] > kMaxClusterLights)
+        {
+            ++overflowing;
+            dropped += hitCounts[i] - kMaxClusterLights;
+        }
+    }
+    report.addValue("peak cluster lights", double(peak), "");
+    report.addValue("overflowing clusters", double(overflowing), "");
+    report.addValue("dropped cluster lights", hits ? 100.0 * double(dropped) / double(hits) : 0.0, "%");
+    if (overflowing)
+        std::printf("clustered: %u clusters hold more than %u lights, %llu light references were not shaded\n", overflowing,
+                    kMaxClusterLights, (unsigned long long)dropped);
+}
+
+void ClusteredScenario::reportPerLight(Report& report, const Statistics* cullTimes, const Statistics* shadeTimes) const
+{
+    double lights = double(m_lights.size());
+    if (cullTimes)
+        report.addValue("gpu cull per light", cullTimes->mean() * 1000.0 / lights, "us");
+    if (shadeTimes)
+        report.addValue("gpu shade per light", shadeTimes->mean() * 1000.0 / lights, "us");
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "RenderGraph.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Push constants of shaders/clustered, same layout as FrameConstants in clustered.glsl */
+struct ClusteredConstants
+{
+    /* Shading: view projection, culling: view */
+    Mat4 matrix;
+    Vec4 eye;
+    /* x and y scale of the projection, near and far plane */
+    Vec4 projection;
+    uint32_t lightCount;
+    uint32_t clustersX;
+    uint32_t clustersY;
+    uint32_t clustersZ;
+    uint32_t gridSide;
+    uint32_t padding[3];
+};
+
+/* Same layout as Light in clustered.glsl */
+struct ClusteredLight
+{
+    /* xyz world position, w radius */
+    Vec4 positionRadius;
+    Vec4 color;
+};
+
+enum class ClusteredShading
+{
+    /* Every fragment loops over every light */
+    Forward,
+    /* A compute pass bins the lights into clusters, every fragment loops over its cluster's */
+    Clustered
+};
+
+enum class ClusteredPassKind
+{
+    /* Clustered only: bins the lights, writes the cluster buffer */
+    Cull,
+    /* Draws the box grid to the swapchain */
+    Shade
+};
+
+/*
+ * Backend independent part of the clustered lighting scenario: the box grid of the deferred
+ * scenario shaded in one forward pass by --lights n point lights. --shading clustered splits
+ * the view frustum into kClustersX x kClustersY screen tiles times kClustersZ exponentially
+ * spaced depth slices; a compute pass with one workgroup per cluster tests every light against
+ * the cluster's view space box and keeps at most kMaxClusterLights per cluster, the fragment
+ * shader then loops over its cluster's list only. The report counts the lights dropped beyond
+ * that, with them the clustered path shades less than the forward one. --shading forward loops over all lights, the
+ * baseline. The cluster buffer is imported into the backend's RenderGraph, which places the
+ * barrier between culling and shading.
+ */
+class ClusteredScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kClustersX = 16;
+    static constexpr uint32_t kClustersY = 9;
+    static constexpr uint32_t kClustersZ = 24;
+    /* Same as kMaxClusterLights in clustered.glsl */
+    static constexpr uint32_t kMaxClusterLights = 256;
+    static constexpr uint32_t kGridSide = 32;
+
+    explicit ClusteredScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* Adds the passes, called once by the backend's constructor */
+    void buildGraph(RenderGraph& graph);
+    /* Adds a pass of the given kind to the graph with the backend's callback */
+    virtual uint32_t addPass(const char* name, ClusteredPassKind kind) = 0;
+    ClusteredConstants cullConstants(uint32_t width, uint32_t height) const;
+    ClusteredConstants shadeConstants(uint32_t width, uint32_t height) const;
+    ShaderDefines shadeDefines() const;
+    /* Boxes and ground */
+    static uint32_t instanceCount() { return kGridSide * kGridSide + 1; }
+    static constexpr uint32_t clusterCount() { return kClustersX * kClustersY * kClustersZ; }
+    /* Hit counts, then kMaxClusterLights indices per cluster */
+    static uint64_t clusterBufferSize() { return uint64_t(clusterCount()) * (1 + kMaxClusterLights) * sizeof(uint32_t); }
+    /* Adds the GPU times per light of the cull and shade zones, null before their first results */
+    void reportPerLight(Report& report, const Statistics* cullTimes, const Statistics* shadeTimes) const;
+    /* Adds the peak cluster size and the lights dropped beyond kMaxClusterLights from the clusterCount() hit counts of a culled frame */
+    void reportClusterHits(Report& report, const uint32_t* hitCounts) const;
+
+    ClusteredShading m_shading;
+    std::vector<ClusteredLight> m_lights;
+
+private:
+    ClusteredConstants constants(const Mat4& matrix, uint32_t width, uint32_t height) const;
+    Mat4 projection(uint32_t width, uint32_t height) const;
+    Mat4 view() const;
+};
+
+std::unique_ptr<Scenario> createClusteredScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createClusteredScenarioVulkan(VulkanContext& context, const Options& options);
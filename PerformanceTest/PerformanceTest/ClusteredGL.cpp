@@ -0,0 +1,125 @@
+#include "Clustered.h"
+
+#include <vector>
+
+#include "GLContext.h"
+#include "GLRenderGraph.h"
+
+namespace
+{
+    /*
+     * The cull pass is a glDispatchCompute of one workgroup per cluster, the graph puts a
+     * glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT) between it and the shading pass, which
+     * draws to the default framebuffer.
+     */
+    class ClusteredScenarioGL : public ClusteredScenario
+    {
+    public:
+        ClusteredScenarioGL(GLContext& context, const Options& options)
+            : ClusteredScenario(options)
+            , m_context(context)
+            , m_graph(context.state(), RenderTargetPooling::Reuse, RenderGraphBarriers::Minimal)
+        {
+            m_cullProgram = createComputeProgram("clustered/cull.comp");
+            m_shadeProgram = createProgram("clustered/scene.vert", "clustered/scene.frag", shadeDefines());
+            m_lightBuffer = createBuffer(GLsizeiptr(m_lights.size() * sizeof(ClusteredLight)), m_lights.data(), 0);
+            m_clusterBuffer = createBuffer(GLsizeiptr(clusterBufferSize()), nullptr, 0);
+            glCreateVertexArrays(1, &m_vertexArray);
+            buildGraph(m_graph);
+        }
+
+        ~ClusteredScenarioGL() override
+        {
+            glDeleteProgram(m_cullProgram);
+            glDeleteProgram(m_shadeProgram);
+            glDeleteBuffers(1, &m_lightBuffer);
+            glDeleteBuffers(1, &m_clusterBuffer);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_lightBuffer);
+            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_clusterBuffer);
+            state.setBlend(false);
+            m_graph.execute();
+        }
+
+        void report(Report& report) override
+        {
+            ClusteredScenario::report(report);
+            reportPerLight(report, m_context.profiler().zoneTimes("cull"), m_context.profiler().zoneTimes("shade"));
+            if (m_shading == ClusteredShading::Clustered)
+            {
+                /* The scene does not move, the last frame's clusters stand for the whole run */
+                std::vector<uint32_t> hitCounts(clusterCount());
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                glGetNamedBufferSubData(m_clusterBuffer, 0, GLsizeiptr(hitCounts.size() * sizeof(uint32_t)), hitCounts.data());
+                reportClusterHits(report, hitCounts.data());
+            }
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, ClusteredPassKind kind) override
+        {
+            return m_graph.addPass(name, [this, kind] { renderPass(kind); });
+        }
+
+        void renderPass(ClusteredPassKind kind)
+        {
+            GLStateCache& state = m_context.state();
+            uint32_t width = uint32_t(m_context.width());
+            uint32_t height = uint32_t(m_context.height());
+            switch (kind)
+            {
+            case ClusteredPassKind::Cull:
+            {
+                ClusteredConstants constants = cullConstants(width, height);
+                m_context.profiler().begin("cull");
+                state.useProgram(m_cullProgram);
+                m_context.pushConstants(&constants, sizeof(constants));
+                glDispatchCompute(kClustersX, kClustersY, kClustersZ);
+                m_context.profiler().end();
+                break;
+            }
+            case ClusteredPassKind::Shade:
+            {
+                ClusteredConstants constants = shadeConstants(width, height);
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, GLsizei(width), GLsizei(height));
+                state.setDepthTest(true);
+                state.depthFunc(GL_LESS);
+                state.depthMask(true);
+                state.setCullFace(true);
+                glClearColor(0.02f, 0.02f, 0.03f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                m_context.profiler().begin("shade");
+                state.useProgram(m_shadeProgram);
+                m_context.pushConstants(&constants, sizeof(constants));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, GLsizei(instanceCount()));
+                m_context.profiler().end();
+                state.setDepthTest(false);
+                state.setCullFace(false);
+                break;
+            }
+            }
+        }
+
+        GLContext& m_context;
+        GLRenderGraph m_graph;
+        GLuint m_cullProgram = 0;
+        GLuint m_shadeProgram = 0;
+        GLuint m_lightBuffer = 0;
+        GLuint m_clusterBuffer = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createClusteredScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ClusteredScenarioGL>(context, options);
+}
@@ -0,0 +1,166 @@
+#include "Clustered.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderGraph.h"
+
+namespace
+{
+    /*
+     * The cull pass is a vkCmdDispatch of one workgroup per cluster, the graph places a
+     * compute write to fragment shader read barrier on the cluster buffer before the shading
+     * pass and, in the next frame, a read to write barrier before the next dispatch. Both
+     * pipelines share one descriptor set with the light and cluster buffers.
+     */
+    class ClusteredScenarioVulkan : public ClusteredScenario
+    {
+    public:
+        ClusteredScenarioVulkan(VulkanContext& context, const Options& options)
+            : ClusteredScenario(options)
+            , m_context(context)
+            , m_graph(context, RenderTargetPooling::Reuse, RenderGraphBarriers::Minimal)
+        {
+            VkDevice device = m_context.device();
+            m_lightBuffer = m_context.createBuffer(m_lights.size() * sizeof(ClusteredLight), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_lights.data());
+            m_clusterBuffer = m_context.createBuffer(clusterBufferSize(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                     VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+            const VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(ClusteredConstants));
+            m_descriptorPool = m_context.createDescriptorPool(1, { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 } });
+            m_set = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+
+            VkDescriptorBufferInfo buffers[2] = { { m_lightBuffer.buffer, 0, VK_WHOLE_SIZE }, { m_clusterBuffer.buffer, 0, VK_WHOLE_SIZE } };
+            VkWriteDescriptorSet writes[2];
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                writes[i].dstSet = m_set;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pBufferInfo = &buffers[i];
+            }
+            vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+
+            VkShaderModule cullShader = m_context.createShaderModule("clustered/cull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+            m_cullPipeline = m_context.createComputePipeline(m_pipelineLayout, cullShader);
+            vkDestroyShaderModule(device, cullShader, vulkanHostAllocator());
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("clustered/scene.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("clustered/scene.frag", VK_SHADER_STAGE_FRAGMENT_BIT, shadeDefines());
+            m_shadePipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+
+            buildGraph(m_graph);
+        }
+
+        ~ClusteredScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            vkDestroyPipeline(device, m_cullPipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_shadePipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            m_context.destroyBuffer(m_clusterBuffer);
+            m_context.destroyBuffer(m_lightBuffer);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            m_graph.execute(m_context.commandBuffer());
+        }
+
+        void report(Report& report) override
+        {
+            ClusteredScenario::report(report);
+            reportPerLight(report, m_context.profiler().zoneTimes("cull"), m_context.profiler().zoneTimes("shade"));
+            if (m_shading == ClusteredShading::Clustered)
+                readClusterHits(report);
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, ClusteredPassKind kind) override
+        {
+            return m_graph.addPass(name, [this, kind](VkCommandBuffer cmd) { recordPass(cmd, kind); });
+        }
+
+        /* The scene does not move, the last frame's clusters stand for the whole run */
+        void readClusterHits(Report& report)
+        {
+            VkDeviceSize size = clusterCount() * sizeof(uint32_t);
+            VulkanBuffer readback = m_context.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                           VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+            m_context.waitIdle();
+            m_context.immediateSubmit([&](VkCommandBuffer cmd) {
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_ACCESS_TRANSFER_READ_BIT);
+                const VkBufferCopy region = { 0, 0, size };
+                vkCmdCopyBuffer(cmd, m_clusterBuffer.buffer, readback.buffer, 1, &region);
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+            });
+            VK_CHECK(vmaInvalidateAllocation(m_context.allocator(), readback.allocation, 0, VK_WHOLE_SIZE));
+            reportClusterHits(report, static_cast<const uint32_t*>(readback.mapped));
+            m_context.destroyBuffer(readback);
+        }
+
+        void recordPass(VkCommandBuffer cmd, ClusteredPassKind kind)
+        {
+            VkExtent2D extent = m_context.swapchainExtent();
+            switch (kind)
+            {
+            case ClusteredPassKind::Cull:
+            {
+                ClusteredConstants constants = cullConstants(extent.width, extent.height);
+                m_context.profiler().begin(cmd, "cull");
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_set, 0, nullptr);
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+                vkCmdDispatch(cmd, kClustersX, kClustersY, kClustersZ);
+                m_context.profiler().end(cmd);
+                break;
+            }
+            case ClusteredPassKind::Shade:
+            {
+                const float clearColor[4] = { 0.02f, 0.02f, 0.03f, 1.0f };
+                ClusteredConstants constants = shadeConstants(extent.width, extent.height);
+                m_context.beginSwapchainPass(cmd, clearColor);
+                m_context.profiler().begin(cmd, "shade");
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadePipeline);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_set, 0, nullptr);
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+                vkCmdDraw(cmd, 36, instanceCount(), 0, 0);
+                m_context.profiler().end(cmd);
+                vkCmdEndRenderPass(cmd);
+                break;
+            }
+            }
+        }
+
+        VulkanContext& m_context;
+        VulkanRenderGraph m_graph;
+        VulkanBuffer m_lightBuffer;
+        VulkanBuffer m_clusterBuffer;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_set = VK_NULL_HANDLE;
+        VkPipeline m_cullPipeline = VK_NULL_HANDLE;
+        VkPipeline m_shadePipeline = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createClusteredScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ClusteredScenarioVulkan>(context, options);
+}
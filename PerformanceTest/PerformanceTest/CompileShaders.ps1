@@ -0,0 +1,132 @@
+# Compiles the shader variants listed below to SPIR-V for both backends and writes them as
+# constexpr arrays to generated/EmbeddedShaders.inc, which EmbeddedShaders.cpp builds into the
+# executable. Runs as the pre-build step of the project, glslc comes with the Vulkan SDK.
+# A variant is found at runtime by its path and its defines, in the order the code passes them.
+param(
+    [string]$Glslc = "glslc"
+)
+
+$ErrorActionPreference = "Stop"
+Set-Location $PSScriptRoot
+
+$output = "generated/EmbeddedShaders.inc"
+if (Test-Path $output)
+{
+    $built = (Get-Item $output).LastWriteTime
+    $newest = (Get-ChildItem -Recurse -File "shaders", $PSCommandPath | Measure-Object -Property LastWriteTime -Maximum).Maximum
+    if ($newest -le $built)
+    {
+        exit 0
+    }
+}
+
+$variants = New-Object System.Collections.Generic.List[object]
+function Add-Variant([string]$Path, [string[]]$Defines = @())
+{
+    $variants.Add(@{ Path = $Path; Defines = $Defines })
+}
+
+foreach ($path in "culling/cull.comp", "culling/depth_reduce.comp", "culling/instance.vert", "culling/instance.frag",
+                  "descriptors/quad.vert", "descriptors/quad.frag", "permutations/quad.vert",
+                  "specialization/quad.vert", "specialization/lighting.frag", "rendertargets/quad.vert", "rendertargets/scene.frag",
+                  "rendertargets/filter.frag", "rendertargets/composite.frag", "rendertargets/present.frag",
+                  "deferred/gbuffer.vert", "deferred/gbuffer.frag", "deferred/fullscreen.vert", "deferred/present.frag",
+                  "clustered/cull.comp", "clustered/scene.vert", "shadows/shadow.frag", "shadows/scene.vert", "shadows/scene.frag",
+                  "post/fullscreen.vert", "msaa/scene.vert", "msaa/scene.frag", "msaa/fullscreen.vert", "msaa/present.frag")
+{
+    Add-Variant $path
+}
+# --constants uniform is left out, SPIR-V for OpenGL has no default block uniforms
+foreach ($define in "RING=1", "PUSH=1")
+{
+    Add-Variant "drawcalls/quad.vert" $define
+    Add-Variant "drawcalls/quad.frag" $define
+}
+# The specialized variant of the specialization scenario, its constants are set when it is loaded
+Add-Variant "specialization/lighting.frag" "SPECIALIZED=1"
+# --lighting fullscreen|tiled times --subpasses separate|merged of the deferred scenario
+foreach ($tiled in "0", "1")
+{
+    foreach ($subpass in "0", "1")
+    {
+        Add-Variant "deferred/lighting.frag" "TILED=$tiled", "SUBPASS=$subpass"
+    }
+}
+# --shading forward|clustered of the clustered scenario
+Add-Variant "clustered/scene.frag" "CLUSTERED=0"
+Add-Variant "clustered/scene.frag" "CLUSTERED=1"
+# --layered off|on of the shadows scenario, only OpenGL uses the layered variant
+Add-Variant "shadows/shadow.vert" "LAYERED=0"
+Add-Variant "shadows/shadow.vert" "LAYERED=1"
+# Every pass of the post scenario as a draw, the chain passes also as a dispatch for --post compute
+for ($pass = 0; $pass -lt 6; $pass++)
+{
+    Add-Variant "post/post.frag" "PASS=$pass"
+}
+for ($pass = 1; $pass -lt 5; $pass++)
+{
+    Add-Variant "post/post.comp" "PASS=$pass"
+}
+# --resolve compute of the msaa scenario for every --samples above 1 and --format
+foreach ($samples in "2", "4", "8")
+{
+    foreach ($format in "rgba8", "rgba16f", "r11f_g11f_b10f")
+    {
+        Add-Variant "msaa/resolve.comp" "SAMPLES=$samples", "FORMAT=$format"
+    }
+}
+# The default --programs of the state sorting scenario
+for ($i = 0; $i -lt 8; $i++)
+{
+    Add-Variant "statesort/quad.vert" "VARIANT=$i"
+    Add-Variant "statesort/quad.frag" "VARIANT=$i"
+}
+# The fallback and the first 64 variants of the permutation and shader-compile scenarios
+Add-Variant "permutations/quad.vert" "FALLBACK=1"
+Add-Variant "permutations/quad.frag" "FALLBACK=1"
+for ($i = 0; $i -lt 64; $i++)
+{
+    Add-Variant "permutations/quad.vert" "VARIANT=$i"
+    Add-Variant "permutations/quad.frag" "VARIANT=$i"
+}
+
+$targets = @(
+    @{ Vulkan = "true"; Arguments = @("--target-env=vulkan1.2", "-DVULKAN=1") },
+    @{ Vulkan = "false"; Arguments = @("--target-env=opengl4.5") }
+)
+
+New-Item -ItemType Directory -Force -Path "generated" | Out-Null
+$temporary = Join-Path ([System.IO.Path]::GetTempPath()) "PerformanceTestShader.inc"
+# glslc output to array name, identical code is embedded once
+$arrays = @{}
+$text = New-Object System.Text.StringBuilder
+$table = New-Object System.Text.StringBuilder
+[void]$text.AppendLine("// Generated by CompileShaders.ps1, do not edit")
+foreach ($target in $targets)
+{
+    foreach ($variant in $variants)
+    {
+        $defines = @($variant.Defines | ForEach-Object { "-D$_" })
+        $arguments = $target.Arguments + $defines + @("-O", "-mfmt=c", "-o", $temporary, "shaders/$($variant.Path)")
+        & $Glslc @arguments
+        if ($LASTEXITCODE -ne 0)
+        {
+            throw "glslc failed on $($variant.Path) $($variant.Defines -join ' ')"
+        }
+
+        $code = (Get-Content -Raw $temporary).Trim()
+        if (-not $arrays.ContainsKey($code))
+        {
+            $arrays[$code] = "kSpirv$($arrays.Count)"
+            [void]$text.AppendLine("constexpr uint32_t $($arrays[$code])[] = $code;")
+        }
+        $name = $arrays[$code]
+        $key = (@($variant.Path) + $variant.Defines) -join "|"
+        [void]$table.AppendLine("    { `"$key`", $($target.Vulkan), $name, sizeof($name) / sizeof(uint32_t) },")
+    }
+}
+[void]$text.AppendLine("constexpr EmbeddedShader kEmbeddedShaders[] = {")
+[void]$text.Append($table.ToString())
+[void]$text.AppendLine("};")
+Set-Content -Path $output -Value $text.ToString() -NoNewline
+Remove-Item $temporary
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+ * API under test. Define VULKAN_TEST or OPENGL_TEST in the project settings (or here),
+ * OpenGL is used when neither is defined.
+ */
+#if defined(VULKAN_TEST) && defined(OPENGL_TEST)
+#error Define either VULKAN_TEST or OPENGL_TEST, not both
+#endif
+
+#if !defined(VULKAN_TEST) && !defined(OPENGL_TEST)
+#define OPENGL_TEST
+#endif
+
+#ifdef VULKAN_TEST
+#define BACKEND_NAME "Vulkan"
+#else
+#define BACKEND_NAME "OpenGL"
+#endif
+
+/*
+ * Replaces the global operator new/delete and hands VkAllocationCallbacks to the driver to
+ * count every host allocation, see AllocationTracker.h. Costs a few atomics per allocation,
+ * so it is off by default.
+ */
+// #define TRACK_ALLOCATIONS
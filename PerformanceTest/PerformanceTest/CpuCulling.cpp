@@ -0,0 +1,271 @@
+#include "CpuCulling.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "Benchmark.h"
+#include "CpuFeatures.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+void CullingBounds::resize(uint32_t count)
+{
+    centerX.resize(count);
+    centerY.resize(count);
+    centerZ.resize(count);
+    radius.resize(count);
+    extentX.resize(count);
+    extentY.resize(count);
+    extentZ.resize(count);
+}
+
+namespace
+{
+    /* Same test as frustumVisible() in shaders/culling/cull.comp */
+    template <bool Box>
+    bool instanceVisible(const CullingBounds& bounds, const Frustum& frustum, uint32_t i)
+    {
+        for (const Vec4& plane : frustum.planes)
+        {
+            float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+            float radius = Box ? std::fabs(plane.x) * bounds.extentX[i] + std::fabs(plane.y) * bounds.extentY[i] + std::fabs(plane.z) * bounds.extentZ[i]
+                               : bounds.radius[i];
+            if (distance < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    template <bool Box>
+    uint32_t cullScalarRange(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; ++i)
+            if (instanceVisible<Box>(bounds, frustum, i))
+                visible[count++] = i;
+        return count;
+    }
+
+    uint32_t cullScalar(const CullingBounds& bounds, const Frustum& frustum, CullingVolume volume, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        return volume == CullingVolume::Box ? cullScalarRange<true>(bounds, frustum, begin, end, visible)
+                                            : cullScalarRange<false>(bounds, frustum, begin, end, visible);
+    }
+
+#ifdef SIMD_X86
+    template <bool Box>
+    SIMD_TARGET("sse4.1")
+    uint32_t cullSse4Range(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+            absX[p] = _mm_set1_ps(std::fabs(frustum.planes[p].x));
+            absY[p] = _mm_set1_ps(std::fabs(frustum.planes[p].y));
+            absZ[p] = _mm_set1_ps(std::fabs(frustum.planes[p].z));
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x = _mm_load_ps(&bounds.centerX[i]);
+            __m128 y = _mm_load_ps(&bounds.centerY[i]);
+            __m128 z = _mm_load_ps(&bounds.centerZ[i]);
+            __m128 negativeRadius = zero, ex = zero, ey = zero, ez = zero;
+            if (Box)
+            {
+                ex = _mm_load_ps(&bounds.extentX[i]);
+                ey = _mm_load_ps(&bounds.extentY[i]);
+                ez = _mm_load_ps(&bounds.extentZ[i]);
+            }
+            else
+            {
+                negativeRadius = _mm_sub_ps(zero, _mm_load_ps(&bounds.radius[i]));
+            }
+
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                             _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                if (Box)
+                    negativeRadius = _mm_sub_ps(zero, _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            for (unsigned mask = unsigned(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1)
+                visible[count++] = i + lowestBit(mask);
+        }
+        return count + cullScalarRange<Box>(bounds, frustum, i, end, visible + count);
+    }
+
+    uint32_t cullSse4(const CullingBounds& bounds, const Frustum& frustum, CullingVolume volume, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        assert(begin % kCullingBatchAlignment == 0);
+        return volume == CullingVolume::Box ? cullSse4Range<true>(bounds, frustum, begin, end, visible)
+                                            : cullSse4Range<false>(bounds, frustum, begin, end, visible);
+    }
+
+    template <bool Box>
+    SIMD_TARGET("avx2,fma")
+    uint32_t cullAvx2Range(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+            absX[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].x));
+            absY[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].y));
+            absZ[p] = _mm256_set1_ps(std::fabs(frustum.planes[p].z));
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 x = _mm256_load_ps(&bounds.centerX[i]);
+            __m256 y = _mm256_load_ps(&bounds.centerY[i]);
+            __m256 z = _mm256_load_ps(&bounds.centerZ[i]);
+            __m256 negativeRadius = zero, ex = zero, ey = zero, ez = zero;
+            if (Box)
+            {
+                ex = _mm256_load_ps(&bounds.extentX[i]);
+                ey = _mm256_load_ps(&bounds.extentY[i]);
+                ez = _mm256_load_ps(&bounds.extentZ[i]);
+            }
+            else
+            {
+                negativeRadius = _mm256_sub_ps(zero, _mm256_load_ps(&bounds.radius[i]));
+            }
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 distance = _mm256_fmadd_ps(planeX[p], x, _mm256_fmadd_ps(planeY[p], y, _mm256_fmadd_ps(planeZ[p], z, planeW[p])));
+                if (Box)
+                    negativeRadius = _mm256_sub_ps(zero, _mm256_fmadd_ps(absX[p], ex, _mm256_fmadd_ps(absY[p], ey, _mm256_mul_ps(absZ[p], ez))));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+
+            for (unsigned mask = unsigned(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1)
+                visible[count++] = i + lowestBit(mask);
+        }
+        return count + cullScalarRange<Box>(bounds, frustum, i, end, visible + count);
+    }
+
+    uint32_t cullAvx2(const CullingBounds& bounds, const Frustum& frustum, CullingVolume volume, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        assert(begin % kCullingBatchAlignment == 0);
+        return volume == CullingVolume::Box ? cullAvx2Range<true>(bounds, frustum, begin, end, visible)
+                                            : cullAvx2Range<false>(bounds, frustum, begin, end, visible);
+    }
+#endif
+
+#ifdef SIMD_NEON
+    template <bool Box>
+    uint32_t cullNeonRange(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        float32x4_t planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = vdupq_n_f32(frustum.planes[p].x);
+            planeY[p] = vdupq_n_f32(frustum.planes[p].y);
+            planeZ[p] = vdupq_n_f32(frustum.planes[p].z);
+            planeW[p] = vdupq_n_f32(frustum.planes[p].w);
+            absX[p] = vdupq_n_f32(std::fabs(frustum.planes[p].x));
+            absY[p] = vdupq_n_f32(std::fabs(frustum.planes[p].y));
+            absZ[p] = vdupq_n_f32(std::fabs(frustum.planes[p].z));
+        }
+
+        const uint32_t laneBitValues[4] = { 1, 2, 4, 8 };
+        const uint32x4_t laneBits = vld1q_u32(laneBitValues);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            float32x4_t x = vld1q_f32(&bounds.centerX[i]);
+            float32x4_t y = vld1q_f32(&bounds.centerY[i]);
+            float32x4_t z = vld1q_f32(&bounds.centerZ[i]);
+            float32x4_t negativeRadius = zero, ex = zero, ey = zero, ez = zero;
+            if (Box)
+            {
+                ex = vld1q_f32(&bounds.extentX[i]);
+                ey = vld1q_f32(&bounds.extentY[i]);
+                ez = vld1q_f32(&bounds.extentZ[i]);
+            }
+            else
+            {
+                negativeRadius = vnegq_f32(vld1q_f32(&bounds.radius[i]));
+            }
+
+            uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+            for (int p = 0; p < 6; ++p)
+            {
+                float32x4_t distance = vfmaq_f32(vfmaq_f32(vfmaq_f32(planeW[p], planeZ[p], z), planeY[p], y), planeX[p], x);
+                if (Box)
+                    negativeRadius = vnegq_f32(vfmaq_f32(vfmaq_f32(vmulq_f32(absZ[p], ez), absY[p], ey), absX[p], ex));
+                inside = vandq_u32(inside, vcgeq_f32(distance, negativeRadius));
+            }
+
+            for (unsigned mask = vaddvq_u32(vandq_u32(inside, laneBits)); mask != 0; mask &= mask - 1)
+                visible[count++] = i + lowestBit(mask);
+        }
+        return count + cullScalarRange<Box>(bounds, frustum, i, end, visible + count);
+    }
+
+    uint32_t cullNeon(const CullingBounds& bounds, const Frustum& frustum, CullingVolume volume, uint32_t begin, uint32_t end, uint32_t* visible)
+    {
+        return volume == CullingVolume::Box ? cullNeonRange<true>(bounds, frustum, begin, end, visible)
+                                            : cullNeonRange<false>(bounds, frustum, begin, end, visible);
+    }
+#endif
+
+    struct KernelEntry
+    {
+        CullingKernelInfo info;
+        bool (*supported)();
+    };
+
+    /* Widest first, "auto" takes the first supported entry */
+    const KernelEntry kKernels[] = {
+#ifdef SIMD_X86
+        { { "avx2", cullAvx2 }, [] { return cpuFeatures().avx2; } },
+        { { "sse4", cullSse4 }, [] { return cpuFeatures().sse41; } },
+#endif
+#ifdef SIMD_NEON
+        { { "neon", cullNeon }, [] { return cpuFeatures().neon; } },
+#endif
+        { { "scalar", cullScalar }, [] { return true; } },
+    };
+}
+
+CullingKernelInfo selectCullingKernel(const std::string& name)
+{
+    for (const KernelEntry& entry : kKernels)
+    {
+        if (name == "auto" && entry.supported())
+            return entry.info;
+        if (name == entry.info.name)
+        {
+            if (!entry.supported())
+                fatal("The CPU does not support the %s culling kernel", entry.info.name);
+            return entry.info;
+        }
+    }
+    fatal("Unknown culling kernel '%s', expected auto, avx2, sse4, neon or scalar", name.c_str());
+}
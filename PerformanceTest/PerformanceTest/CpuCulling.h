@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "AlignedAllocator.h"
+#include "Math.h"
+
+/*
+ * Structure of arrays copy of the instance bounds for the CPU culling kernels, one lane per
+ * instance so a SIMD register tests 4 or 8 instances against a plane at once.
+ */
+struct CullingBounds
+{
+    AlignedVector<float> centerX;
+    AlignedVector<float> centerY;
+    AlignedVector<float> centerZ;
+    AlignedVector<float> radius;
+    AlignedVector<float> extentX;
+    AlignedVector<float> extentY;
+    AlignedVector<float> extentZ;
+
+    uint32_t size() const { return uint32_t(centerX.size()); }
+    void resize(uint32_t count);
+};
+
+enum class CullingVolume
+{
+    Sphere,
+    /* Axis aligned box, tighter but needs three more loads per instance */
+    Box,
+};
+
+/*
+ * Tests the instances [begin, end) against the frustum and writes the indices of the visible
+ * ones to `visible`, returns their count. `begin` has to be a multiple of kCullingBatchAlignment
+ * for the aligned loads.
+ */
+using CullingKernel = uint32_t (*)(const CullingBounds& bounds, const Frustum& frustum, CullingVolume volume,
+                                   uint32_t begin, uint32_t end, uint32_t* visible);
+
+constexpr uint32_t kCullingBatchAlignment = 16;
+
+struct CullingKernelInfo
+{
+    const char* name;
+    CullingKernel kernel;
+};
+
+/* "auto" picks the widest instruction set the CPU supports, fails for unknown or unsupported names */
+CullingKernelInfo selectCullingKernel(const std::string& name);
@@ -0,0 +1,71 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(SIMD_X86)
+#include <cpuid.h>
+#endif
+
+namespace
+{
+#ifdef SIMD_X86
+    void cpuid(int leaf, int subleaf, int info[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, leaf, subleaf);
+#else
+        unsigned a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        info[0] = int(a);
+        info[1] = int(b);
+        info[2] = int(c);
+        info[3] = int(d);
+#endif
+    }
+
+    unsigned long long xgetbv0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (unsigned long long)edx << 32 | eax;
+#endif
+    }
+#endif
+
+    CpuFeatures detect()
+    {
+        CpuFeatures features;
+#ifdef SIMD_X86
+        int info[4];
+        cpuid(0, 0, info);
+        int maxLeaf = info[0];
+
+        cpuid(1, 0, info);
+        features.sse41 = (info[2] & (1 << 19)) != 0;
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        /* The OS has to save the XMM and YMM state on context switches */
+        bool ymmState = osxsave && (xgetbv0() & 0x6) == 0x6;
+        if (maxLeaf >= 7 && avx && fma && ymmState)
+        {
+            cpuid(7, 0, info);
+            features.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#elif defined(SIMD_NEON)
+        /* Advanced SIMD is mandatory on AArch64 */
+        features.neon = true;
+#endif
+        return features;
+    }
+}
+
+const CpuFeatures& cpuFeatures()
+{
+    static const CpuFeatures features = detect();
+    return features;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define SIMD_NEON 1
+#endif
+
+/*
+ * Kernels for an instruction set above the compiler's baseline are marked with SIMD_TARGET.
+ * MSVC accepts every intrinsic without /arch, GCC and Clang need the target attribute.
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(features)
+#else
+#define SIMD_TARGET(features) __attribute__((target(features)))
+#endif
+
+/* Instruction sets of the executing CPU, queried once with cpuid */
+struct CpuFeatures
+{
+    bool sse41 = false;
+    /* AVX2 together with FMA3 and operating system support for the YMM registers */
+    bool avx2 = false;
+    bool neon = false;
+};
+
+const CpuFeatures& cpuFeatures();
+
+/* Index of the lowest set bit, mask must not be 0 */
+inline unsigned lowestBit(unsigned mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return unsigned(index);
+#else
+    return unsigned(__builtin_ctz(mask));
+#endif
+}
@@ -0,0 +1,251 @@
+#include "Deferred.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Random.h"
+
+namespace
+{
+    DeferredLighting parseLighting(const std::string& lighting)
+    {
+        if (lighting == "fullscreen")
+            return DeferredLighting::Fullscreen;
+        if (lighting == "tiled")
+            return DeferredLighting::Tiled;
+        fatal("Unknown --lighting '%s', expected fullscreen or tiled", lighting.c_str());
+    }
+
+    DeferredSubpasses parseSubpasses(const std::string& subpasses)
+    {
+        if (subpasses == "separate")
+            return DeferredSubpasses::Separate;
+        if (subpasses == "merged")
+            return DeferredSubpasses::Merged;
+        fatal("Unknown --subpasses '%s', expected separate or merged", subpasses.c_str());
+    }
+
+    /* Bytes per pixel of albedo, normal, material and depth */
+    constexpr uint64_t kGBufferTexelBytes = 4 + 8 + 4 + 4;
+}
+
+DeferredScenario::DeferredScenario(const Options& options, bool mergedSupported)
+    : m_lighting(parseLighting(options.getString("lighting", "fullscreen")))
+    , m_subpasses(parseSubpasses(options.getString("subpasses", "separate")))
+{
+    if (m_subpasses == DeferredSubpasses::Merged && !mergedSupported)
+    {
+        std::printf("deferred: subpasses are not supported, falling back to separate passes\n");
+        m_subpasses = DeferredSubpasses::Separate;
+    }
+
+    int64_t lightCount = options.getInt("lights", 256);
+    if (lightCount < 1 || lightCount > 100000)
+        fatal("--lights has to be between 1 and 100000");
+
+    /* Over the whole grid and a little beyond, low enough that most reach the ground */
+    uint32_t state = 0xDEFE44u;
+    float extent = float(kGridSide) + 1.0f;
+    m_lights.resize(size_t(lightCount));
+    for (DeferredLight& light : m_lights)
+    {
+        light.positionRadius = { extent * (2.0f * randomUnit(state) - 1.0f), 0.5f + 3.5f * randomUnit(state), extent * (2.0f * randomUnit(state) - 1.0f),
+                                 3.0f + 5.0f * randomUnit(state) };
+        light.color = { randomUnit(state), randomUnit(state), randomUnit(state), 1.0f };
+    }
+
+    std::printf("deferred: %u lights, %s lighting, %s passes\n", uint32_t(m_lights.size()),
+                m_lighting == DeferredLighting::Tiled ? "tiled" : "fullscreen", m_subpasses == DeferredSubpasses::Merged ? "merged" : "separate");
+}
+
+bool DeferredScenario::updateGraph(RenderGraph& graph, uint32_t width, uint32_t height)
+{
+    if (width == m_width && height == m_height)
+        return false;
+    m_width = width;
+    m_height = height;
+
+    m_eye = { 0.0f, 24.0f, 44.0f };
+    Mat4 projection = perspective(1.0f, float(width) / float(height), 0.5f, 200.0f);
+    m_viewProj = projection * lookAt(m_eye, { 0.0f, 0.0f, 4.0f }, { 0.0f, 1.0f, 0.0f });
+    m_inverseViewProj = inverse(m_viewProj);
+    binLights();
+
+    /* Merged, the G-buffer only lives inside the one render pass and is never stored */
+    bool merged = m_subpasses == DeferredSubpasses::Merged;
+    graph.reset();
+    m_targets.albedo = graph.createTexture("albedo", { width, height, RenderTargetFormat::RGBA8, 1, merged });
+    m_targets.normal = graph.createTexture("normal", { width, height, RenderTargetFormat::RGBA16F, 1, merged });
+    m_targets.material = graph.createTexture("material", { width, height, RenderTargetFormat::RGBA8, 1, merged });
+    m_targets.depth = graph.createTexture("depth", { width, height, RenderTargetFormat::Depth32F, 1, merged });
+    m_targets.lit = graph.createTexture("lit", { width, height, RenderTargetFormat::RGBA16F, 1, false });
+
+    const uint32_t gbuffer[] = { m_targets.albedo, m_targets.normal, m_targets.material };
+    if (merged)
+    {
+        /* Attachment 0 is the lit target, then the G-buffer, the order of the scenario's render pass */
+        uint32_t pass = addPass("deferred", DeferredPassKind::Deferred);
+        graph.setOwnRenderPass(pass);
+        graph.colorAttachment(pass, m_targets.lit);
+        for (uint32_t target : gbuffer)
+            graph.colorAttachment(pass, target);
+        graph.depthAttachment(pass, m_targets.depth);
+    }
+    else
+    {
+        uint32_t fill = addPass("gbuffer", DeferredPassKind::GBuffer);
+        for (uint32_t target : gbuffer)
+            graph.colorAttachment(fill, target);
+        graph.depthAttachment(fill, m_targets.depth);
+
+        uint32_t lighting = addPass("lighting", DeferredPassKind::Lighting);
+        graph.colorAttachment(lighting, m_targets.lit);
+        for (uint32_t target : gbuffer)
+            graph.read(lighting, target, RenderGraphAccess::SampledGraphics);
+        graph.read(lighting, m_targets.depth, RenderGraphAccess::SampledGraphics);
+    }
+
+    uint32_t present = addPass("present", DeferredPassKind::Present);
+    graph.read(present, m_targets.lit, RenderGraphAccess::SampledGraphics);
+    graph.setSideEffect(present);
+    graph.compile();
+    return true;
+}
+
+void DeferredScenario::binLights()
+{
+    m_averageTileLights = 0.0;
+    if (m_lighting != DeferredLighting::Tiled)
+    {
+        m_tilesX = 1;
+        m_tilesY = 1;
+        m_tiles.assign(2, 0);
+        return;
+    }
+
+    /* Tile rows go up from the bottom of the screen like normalized device coordinates, on both backends */
+    m_tilesX = (m_width + kTileSize - 1) / kTileSize;
+    m_tilesY = (m_height + kTileSize - 1) / kTileSize;
+    const uint32_t tileCount = m_tilesX * m_tilesY;
+    const float scaleX = float(m_width) / float(kTileSize);
+    const float scaleY = float(m_height) / float(kTileSize);
+
+    /* Screen rectangle of every light's bounding box in tiles, the whole screen if it reaches behind the camera */
+    struct TileRect
+    {
+        uint32_t x0, y0, x1, y1;
+    };
+    std::vector<TileRect> rects;
+    std::vector<uint32_t> lightIndices;
+    for (uint32_t l = 0; l < m_lights.size(); ++l)
+    {
+        const Vec4& sphere = m_lights[l].positionRadius;
+        float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+        bool behind = false;
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            Vec4 position = { sphere.x + (corner & 1 ? sphere.w : -sphere.w), sphere.y + (corner & 2 ? sphere.w : -sphere.w),
+                              sphere.z + (corner & 4 ? sphere.w : -sphere.w), 1.0f };
+            Vec4 clip = m_viewProj * position;
+            if (clip.w <= 0.5f)
+            {
+                behind = true;
+                break;
+            }
+            minX = std::min(minX, clip.x / clip.w);
+            maxX = std::max(maxX, clip.x / clip.w);
+            minY = std::min(minY, clip.y / clip.w);
+            maxY = std::max(maxY, clip.y / clip.w);
+        }
+        if (behind)
+        {
+            minX = minY = -1.0f;
+            maxX = maxY = 1.0f;
+        }
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            continue;
+
+        auto tile = [](float ndc, float scale, uint32_t count) {
+            float t = (std::min(std::max(ndc, -1.0f), 1.0f) * 0.5f + 0.5f) * scale;
+            return std::min(uint32_t(t), count - 1);
+        };
+        rects.push_back({ tile(minX, scaleX, m_tilesX), tile(minY, scaleY, m_tilesY), tile(maxX, scaleX, m_tilesX), tile(maxY, scaleY, m_tilesY) });
+        lightIndices.push_back(l);
+    }
+
+    /* Counts, offsets behind the tile headers, then the lists */
+    std::vector<uint32_t> counts(tileCount, 0);
+    for (const TileRect& rect : rects)
+        for (uint32_t y = rect.y0; y <= rect.y1; ++y)
+            for (uint32_t x = rect.x0; x <= rect.x1; ++x)
+                ++counts[y * m_tilesX + x];
+
+    m_tiles.assign(tileCount * 2, 0);
+    uint32_t offset = tileCount * 2;
+    for (uint32_t t = 0; t < tileCount; ++t)
+    {
+        m_tiles[t * 2] = offset;
+        offset += counts[t];
+    }
+    m_tiles.resize(offset, 0);
+    for (uint32_t r = 0; r < rects.size(); ++r)
+    {
+        const TileRect& rect = rects[r];
+        for (uint32_t y = rect.y0; y <= rect.y1; ++y)
+            for (uint32_t x = rect.x0; x <= rect.x1; ++x)
+            {
+                uint32_t header = (y * m_tilesX + x) * 2;
+                m_tiles[m_tiles[header] + m_tiles[header + 1]++] = lightIndices[r];
+            }
+    }
+    m_averageTileLights = double(offset - tileCount * 2) / double(tileCount);
+}
+
+DeferredConstants DeferredScenario::gbufferConstants() const
+{
+    DeferredConstants constants = {};
+    constants.matrix = m_viewProj;
+    constants.gridSide = kGridSide;
+    return constants;
+}
+
+DeferredConstants DeferredScenario::lightingConstants() const
+{
+    DeferredConstants constants = {};
+    constants.matrix = m_inverseViewProj;
+    constants.eye = { m_eye.x, m_eye.y, m_eye.z, 1.0f };
+    constants.tileScale = { float(m_width) / float(kTileSize), float(m_height) / float(kTileSize), 0.0f, 0.0f };
+    constants.lightCount = uint32_t(m_lights.size());
+    constants.tilesX = m_tilesX;
+    constants.tilesY = m_tilesY;
+    constants.gridSide = kGridSide;
+    return constants;
+}
+
+ShaderDefines DeferredScenario::lightingDefines() const
+{
+    return { { "TILED", m_lighting == DeferredLighting::Tiled ? "1" : "0" }, { "SUBPASS", m_subpasses == DeferredSubpasses::Merged ? "1" : "0" } };
+}
+
+void DeferredScenario::report(Report& report)
+{
+    uint64_t gbufferBytes = kGBufferTexelBytes * m_width * m_height;
+    report.addValue("lights", double(m_lights.size()), "");
+    report.addText("lighting", m_lighting == DeferredLighting::Tiled ? "tiled" : "fullscreen");
+    report.addText("subpasses", m_subpasses == DeferredSubpasses::Merged ? "merged" : "separate");
+    report.addValue("G-buffer size", double(gbufferBytes) / (1024.0 * 1024.0), "MiB");
+    /*
+     * What the API asks for: separate passes store the G-buffer and sample it back, merged ones
+     * neither load nor store it. A desktop driver may still write it out, the GPU times show it.
+     */
+    uint64_t traffic = m_subpasses == DeferredSubpasses::Merged ? 0 : 2 * gbufferBytes;
+    report.addValue("G-buffer bytes per frame", double(traffic) / (1024.0 * 1024.0), "MiB");
+    if (m_lighting == DeferredLighting::Tiled)
+        report.addValue("lights per tile", m_averageTileLights, "");
+}
+
+void DeferredScenario::reportPerLight(Report& report, const Statistics* lightingTimes) const
+{
+    if (lightingTimes)
+        report.addValue("gpu lighting per light", lightingTimes->mean() * 1000.0 / double(m_lights.size()), "us");
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+#include "RenderGraph.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Push constants of shaders/deferred, same layout as FrameConstants in deferred.glsl */
+struct DeferredConstants
+{
+    /* G-buffer pass: view projection, lighting: its inverse */
+    Mat4 matrix;
+    Vec4 eye;
+    /* xy screen tiles per unit of uv */
+    Vec4 tileScale;
+    uint32_t lightCount;
+    uint32_t tilesX;
+    uint32_t tilesY;
+    uint32_t gridSide;
+};
+
+/* Same layout as Light in deferred.glsl */
+struct DeferredLight
+{
+    /* xyz world position, w radius */
+    Vec4 positionRadius;
+    Vec4 color;
+};
+
+enum class DeferredLighting
+{
+    /* Every pixel loops over every light */
+    Fullscreen,
+    /* Every pixel loops over the lights the CPU binned into its screen tile */
+    Tiled
+};
+
+enum class DeferredSubpasses
+{
+    /* G-buffer and lighting are render passes of their own, lighting samples the stored G-buffer */
+    Separate,
+    /* Vulkan only: one render pass, lighting reads the G-buffer as input attachments and it is never stored */
+    Merged
+};
+
+enum class DeferredPassKind
+{
+    /* Separate: fills albedo, normal, material and depth */
+    GBuffer,
+    /* Separate: lights the G-buffer into the HDR target */
+    Lighting,
+    /* Merged: both subpasses in one render pass of the scenario's own */
+    Deferred,
+    /* Tonemaps the HDR target to the swapchain */
+    Present
+};
+
+/* Graph textures of the frame */
+struct DeferredTargets
+{
+    uint32_t albedo;
+    uint32_t normal;
+    uint32_t material;
+    uint32_t depth;
+    uint32_t lit;
+};
+
+/*
+ * Backend independent part of the deferred shading scenario: a grid of boxes rendered into a
+ * G-buffer (albedo RGBA8, normal RGBA16F, material RGBA8, depth 32F), lit by --lights n point
+ * lights into an RGBA16F target and tonemapped to the swapchain, all through the backend's
+ * RenderGraph. --lighting fullscreen|tiled picks the light loop, --subpasses separate|merged
+ * whether the G-buffer goes through memory between the passes. Camera and lights do not move,
+ * the graph and the light tiles are rebuilt when the window is resized.
+ */
+class DeferredScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kGridSide = 32;
+    /* Pixels per side of a light tile */
+    static constexpr uint32_t kTileSize = 16;
+
+    /* `mergedSupported` is false for backends without subpasses, --subpasses merged falls back to separate there */
+    DeferredScenario(const Options& options, bool mergedSupported);
+
+    void report(Report& report) override;
+
+protected:
+    /* Rebuilds camera, light tiles and graph if the size changed, returns whether it did */
+    bool updateGraph(RenderGraph& graph, uint32_t width, uint32_t height);
+    /* Adds a pass of the given kind to the graph with the backend's callback */
+    virtual uint32_t addPass(const char* name, DeferredPassKind kind) = 0;
+    DeferredConstants gbufferConstants() const;
+    DeferredConstants lightingConstants() const;
+    ShaderDefines lightingDefines() const;
+    /* Boxes and ground */
+    static uint32_t instanceCount() { return kGridSide * kGridSide + 1; }
+    /* Adds the lighting time per light, `lightingTimes` are the GPU times of the lighting zone */
+    void reportPerLight(Report& report, const Statistics* lightingTimes) const;
+
+    DeferredLighting m_lighting;
+    DeferredSubpasses m_subpasses;
+    std::vector<DeferredLight> m_lights;
+    /* Per tile offset and count, then the light lists, see lighting.frag. One empty tile without --lighting tiled */
+    std::vector<uint32_t> m_tiles;
+    DeferredTargets m_targets = {};
+    double m_averageTileLights = 0.0;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+
+private:
+    void binLights();
+
+    Mat4 m_viewProj = Mat4::identity();
+    Mat4 m_inverseViewProj = Mat4::identity();
+    Vec3 m_eye = { 0.0f, 0.0f, 0.0f };
+    uint32_t m_tilesX = 1;
+    uint32_t m_tilesY = 1;
+};
+
+std::unique_ptr<Scenario> createDeferredScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createDeferredScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,131 @@
+#include "Deferred.h"
+
+#include "GLContext.h"
+#include "GLRenderGraph.h"
+
+namespace
+{
+    /*
+     * OpenGL has no subpasses, the G-buffer is always stored by one framebuffer and fetched
+     * from textures by the next. Lights and tiles are shader storage buffers, the tiles are
+     * uploaded again whenever the graph is rebuilt.
+     */
+    class DeferredScenarioGL : public DeferredScenario
+    {
+    public:
+        DeferredScenarioGL(GLContext& context, const Options& options)
+            : DeferredScenario(options, false)
+            , m_context(context)
+            , m_graph(context.state(), RenderTargetPooling::Reuse, RenderGraphBarriers::Minimal)
+        {
+            m_gbuffer = createProgram("deferred/gbuffer.vert", "deferred/gbuffer.frag");
+            m_lightingProgram = createProgram("deferred/fullscreen.vert", "deferred/lighting.frag", lightingDefines());
+            m_present = createProgram("deferred/fullscreen.vert", "deferred/present.frag");
+            m_lightBuffer = createBuffer(GLsizeiptr(m_lights.size() * sizeof(DeferredLight)), m_lights.data(), 0);
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~DeferredScenarioGL() override
+        {
+            glDeleteProgram(m_gbuffer);
+            glDeleteProgram(m_lightingProgram);
+            glDeleteProgram(m_present);
+            glDeleteBuffers(1, &m_lightBuffer);
+            glDeleteBuffers(1, &m_tileBuffer);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            if (updateGraph(m_graph, uint32_t(m_context.width()), uint32_t(m_context.height())))
+            {
+                glDeleteBuffers(1, &m_tileBuffer);
+                m_tileBuffer = createBuffer(GLsizeiptr(m_tiles.size() * sizeof(uint32_t)), m_tiles.data(), 0);
+            }
+
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.setBlend(false);
+            m_graph.execute();
+        }
+
+        void report(Report& report) override
+        {
+            DeferredScenario::report(report);
+            reportPerLight(report, m_context.profiler().zoneTimes("lighting"));
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, DeferredPassKind kind) override
+        {
+            return m_graph.addPass(name, [this, kind] { renderPass(kind); });
+        }
+
+        /* Runs with the pass's framebuffer bound and cleared */
+        void renderPass(DeferredPassKind kind)
+        {
+            GLStateCache& state = m_context.state();
+            switch (kind)
+            {
+            case DeferredPassKind::GBuffer:
+            {
+                DeferredConstants constants = gbufferConstants();
+                m_context.profiler().begin("gbuffer");
+                state.useProgram(m_gbuffer);
+                state.setDepthTest(true);
+                state.depthFunc(GL_LESS);
+                state.depthMask(true);
+                state.setCullFace(true);
+                m_context.pushConstants(&constants, sizeof(constants));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, GLsizei(instanceCount()));
+                state.setDepthTest(false);
+                state.setCullFace(false);
+                m_context.profiler().end();
+                break;
+            }
+            case DeferredPassKind::Lighting:
+            {
+                DeferredConstants constants = lightingConstants();
+                m_context.profiler().begin("lighting");
+                state.useProgram(m_lightingProgram);
+                state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_lightBuffer);
+                state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_tileBuffer);
+                state.bindTextureUnit(2, m_graph.texture(m_targets.albedo));
+                state.bindTextureUnit(3, m_graph.texture(m_targets.normal));
+                state.bindTextureUnit(4, m_graph.texture(m_targets.material));
+                state.bindTextureUnit(5, m_graph.texture(m_targets.depth));
+                m_context.pushConstants(&constants, sizeof(constants));
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                m_context.profiler().end();
+                break;
+            }
+            case DeferredPassKind::Present:
+                m_context.profiler().begin("present");
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, m_context.width(), m_context.height());
+                state.useProgram(m_present);
+                state.bindTextureUnit(0, m_graph.texture(m_targets.lit));
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                m_context.profiler().end();
+                break;
+            case DeferredPassKind::Deferred:
+                break;
+            }
+        }
+
+        GLContext& m_context;
+        GLRenderGraph m_graph;
+        GLuint m_gbuffer = 0;
+        GLuint m_lightingProgram = 0;
+        GLuint m_present = 0;
+        GLuint m_lightBuffer = 0;
+        GLuint m_tileBuffer = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createDeferredScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<DeferredScenarioGL>(context, options);
+}
@@ -0,0 +1,374 @@
+#include "Deferred.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderGraph.h"
+
+namespace
+{
+    /*
+     * --subpasses separate: the G-buffer and lighting passes are render passes of the graph's
+     * pool, the graph transitions the G-buffer to SHADER_READ_ONLY_OPTIMAL in between and the
+     * lighting shader samples it.
+     *
+     * --subpasses merged: one render pass of the scenario's own with two subpasses. The first
+     * fills the G-buffer, the second reads it as input attachments and writes the lit target.
+     * The G-buffer attachments are transient, cleared on load and not stored, so a tiler keeps
+     * them in tile memory and never backs them with memory at all if lazily allocated memory
+     * exists. The graph still transitions them into their attachment layouts, the render pass
+     * starts and ends there.
+     */
+    class DeferredScenarioVulkan : public DeferredScenario
+    {
+    public:
+        DeferredScenarioVulkan(VulkanContext& context, const Options& options)
+            : DeferredScenario(options, true)
+            , m_context(context)
+            , m_graph(context, RenderTargetPooling::Reuse, RenderGraphBarriers::Minimal)
+        {
+            VkDevice device = m_context.device();
+            bool merged = m_subpasses == DeferredSubpasses::Merged;
+            m_lightBuffer = m_context.createBuffer(m_lights.size() * sizeof(DeferredLight), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_lights.data());
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_NEAREST;
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            VK_CHECK(vkCreateSampler(device, &samplerInfo, vulkanHostAllocator(), &m_sampler));
+
+            VkDescriptorType gbufferType = merged ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            m_lightingSetLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 2, gbufferType, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 3, gbufferType, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 4, gbufferType, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 5, gbufferType, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+            });
+            m_presentSetLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+            });
+            m_gbufferLayout = m_context.createPipelineLayout({}, sizeof(DeferredConstants));
+            m_lightingLayout = m_context.createPipelineLayout({ m_lightingSetLayout }, sizeof(DeferredConstants));
+            m_presentLayout = m_context.createPipelineLayout({ m_presentSetLayout }, sizeof(DeferredConstants));
+            m_descriptorPool = m_context.createDescriptorPool(2, {
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5 },
+                { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 4 },
+            });
+
+            /* Only formats and transient flags matter for the render passes, the sizes do not */
+            RenderTargetDesc albedo = { 1, 1, RenderTargetFormat::RGBA8, 1, merged };
+            RenderTargetDesc normal = { 1, 1, RenderTargetFormat::RGBA16F, 1, merged };
+            RenderTargetDesc material = { 1, 1, RenderTargetFormat::RGBA8, 1, merged };
+            RenderTargetDesc depth = { 1, 1, RenderTargetFormat::Depth32F, 1, merged };
+            RenderTargetDesc lit = { 1, 1, RenderTargetFormat::RGBA16F, 1, false };
+            VkRenderPass gbufferPass = VK_NULL_HANDLE;
+            VkRenderPass lightingPass = VK_NULL_HANDLE;
+            if (merged)
+            {
+                createMergedRenderPass({ &lit, &albedo, &normal, &material, &depth });
+                gbufferPass = m_mergedPass;
+                lightingPass = m_mergedPass;
+            }
+            else
+            {
+                gbufferPass = m_graph.targets().renderPass({ albedo, normal, material }, &depth);
+                lightingPass = m_graph.targets().renderPass({ lit });
+            }
+
+            VkShaderModule fullscreen = m_context.createShaderModule("deferred/fullscreen.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            GraphicsPipelineDesc desc;
+            desc.layout = m_gbufferLayout;
+            desc.renderPass = gbufferPass;
+            desc.vertexShader = m_context.createShaderModule("deferred/gbuffer.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("deferred/gbuffer.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.colorAttachmentCount = 3;
+            m_gbuffer = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+
+            desc.layout = m_lightingLayout;
+            desc.renderPass = lightingPass;
+            desc.subpass = merged ? 1 : 0;
+            desc.vertexShader = fullscreen;
+            desc.fragmentShader = m_context.createShaderModule("deferred/lighting.frag", VK_SHADER_STAGE_FRAGMENT_BIT, lightingDefines());
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = false;
+            desc.depthWrite = false;
+            desc.colorAttachmentCount = 1;
+            m_lightingPipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+
+            desc.layout = m_presentLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.subpass = 0;
+            desc.fragmentShader = m_context.createShaderModule("deferred/present.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            m_present = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, fullscreen, vulkanHostAllocator());
+        }
+
+        ~DeferredScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            vkDestroyPipeline(device, m_gbuffer, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_lightingPipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_present, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_gbufferLayout, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_lightingLayout, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_presentLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_lightingSetLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_presentSetLayout, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+            vkDestroyFramebuffer(device, m_framebuffer, vulkanHostAllocator());
+            vkDestroyRenderPass(device, m_mergedPass, vulkanHostAllocator());
+            m_context.destroyBuffer(m_tileBuffer);
+            m_context.destroyBuffer(m_lightBuffer);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkExtent2D extent = m_context.swapchainExtent();
+            if (updateGraph(m_graph, extent.width, extent.height))
+                recreateResources();
+            m_graph.execute(m_context.commandBuffer());
+        }
+
+        void report(Report& report) override
+        {
+            DeferredScenario::report(report);
+            reportPerLight(report, m_context.profiler().zoneTimes("lighting"));
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, DeferredPassKind kind) override
+        {
+            return m_graph.addPass(name, [this, kind](VkCommandBuffer cmd) { recordPass(cmd, kind); });
+        }
+
+        /*
+         * Attachment 0 is the lit target, 1 to 3 the G-buffer colors, 4 depth, the order the
+         * scenario declares them with the graph. Subpass 1 reads the G-buffer in read-only
+         * layouts, the by-region dependency lets a tiler keep both subpasses on one tile.
+         */
+        void createMergedRenderPass(const RenderTargetDesc* const (&descs)[5])
+        {
+            VkAttachmentDescription attachments[5] = {};
+            for (uint32_t i = 0; i < 5; ++i)
+            {
+                VkImageLayout layout = i == 4 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                attachments[i].format = VulkanRenderTargetPool::format(descs[i]->format);
+                attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+                attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                attachments[i].storeOp = i == 0 ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[i].initialLayout = layout;
+                attachments[i].finalLayout = layout;
+            }
+
+            const VkAttachmentReference gbufferColors[3] = {
+                { 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+                { 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+                { 3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+            };
+            const VkAttachmentReference gbufferDepth = { 4, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+            const VkAttachmentReference inputs[4] = {
+                { 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { 2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { 3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { 4, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+            };
+            const VkAttachmentReference litColor = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+            VkSubpassDescription subpasses[2] = {};
+            subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[0].colorAttachmentCount = 3;
+            subpasses[0].pColorAttachments = gbufferColors;
+            subpasses[0].pDepthStencilAttachment = &gbufferDepth;
+            subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[1].inputAttachmentCount = 4;
+            subpasses[1].pInputAttachments = inputs;
+            subpasses[1].colorAttachmentCount = 1;
+            subpasses[1].pColorAttachments = &litColor;
+
+            VkSubpassDependency dependency = {};
+            dependency.srcSubpass = 0;
+            dependency.dstSubpass = 1;
+            dependency.srcStageMask =
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+            dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+            VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+            info.attachmentCount = 5;
+            info.pAttachments = attachments;
+            info.subpassCount = 2;
+            info.pSubpasses = subpasses;
+            info.dependencyCount = 1;
+            info.pDependencies = &dependency;
+            VK_CHECK(vkCreateRenderPass(m_context.device(), &info, vulkanHostAllocator(), &m_mergedPass));
+        }
+
+        /* The tile buffer, the merged framebuffer and the descriptor sets, after the graph was rebuilt */
+        void recreateResources()
+        {
+            VkDevice device = m_context.device();
+            bool merged = m_subpasses == DeferredSubpasses::Merged;
+            m_context.waitIdle();
+            m_context.destroyBuffer(m_tileBuffer);
+            m_tileBuffer = m_context.createBuffer(m_tiles.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_tiles.data());
+
+            const uint32_t gbuffer[4] = { m_targets.albedo, m_targets.normal, m_targets.material, m_targets.depth };
+            if (merged)
+            {
+                vkDestroyFramebuffer(device, m_framebuffer, vulkanHostAllocator());
+                VkImageView views[5] = { m_graph.image(m_targets.lit).view };
+                for (uint32_t i = 0; i < 4; ++i)
+                    views[i + 1] = m_graph.image(gbuffer[i]).view;
+                VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+                framebufferInfo.renderPass = m_mergedPass;
+                framebufferInfo.attachmentCount = 5;
+                framebufferInfo.pAttachments = views;
+                framebufferInfo.width = m_width;
+                framebufferInfo.height = m_height;
+                framebufferInfo.layers = 1;
+                VK_CHECK(vkCreateFramebuffer(device, &framebufferInfo, vulkanHostAllocator(), &m_framebuffer));
+            }
+
+            VK_CHECK(vkResetDescriptorPool(device, m_descriptorPool, 0));
+            m_lightingSet = m_context.allocateDescriptorSet(m_descriptorPool, m_lightingSetLayout);
+            m_presentSet = m_context.allocateDescriptorSet(m_descriptorPool, m_presentSetLayout);
+
+            VkDescriptorBufferInfo buffers[2] = { { m_lightBuffer.buffer, 0, VK_WHOLE_SIZE }, { m_tileBuffer.buffer, 0, VK_WHOLE_SIZE } };
+            VkDescriptorImageInfo images[5];
+            VkWriteDescriptorSet writes[7];
+            for (uint32_t i = 0; i < 7; ++i)
+            {
+                writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                writes[i].dstSet = m_lightingSet;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+            }
+            for (uint32_t i = 0; i < 2; ++i)
+            {
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pBufferInfo = &buffers[i];
+            }
+            const VkImageLayout sampledLayout = VulkanRenderGraph::imageLayout(RenderGraphLayout::ShaderRead);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                if (merged)
+                    images[i] = { VK_NULL_HANDLE, m_graph.image(gbuffer[i]).view,
+                                  i == 3 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+                else
+                    images[i] = { m_sampler, m_graph.image(gbuffer[i]).view, sampledLayout };
+                writes[i + 2].descriptorType = merged ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[i + 2].pImageInfo = &images[i];
+            }
+            images[4] = { m_sampler, m_graph.image(m_targets.lit).view, sampledLayout };
+            writes[6].dstSet = m_presentSet;
+            writes[6].dstBinding = 0;
+            writes[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[6].pImageInfo = &images[4];
+            vkUpdateDescriptorSets(device, 7, writes, 0, nullptr);
+        }
+
+        /* Records inside the render pass the graph began, the merged and present passes begin their own */
+        void recordPass(VkCommandBuffer cmd, DeferredPassKind kind)
+        {
+            switch (kind)
+            {
+            case DeferredPassKind::GBuffer:
+                recordGBuffer(cmd);
+                break;
+            case DeferredPassKind::Lighting:
+                recordLighting(cmd);
+                break;
+            case DeferredPassKind::Deferred:
+            {
+                const VkClearValue clearValues[5] = { {}, {}, {}, {}, { { 1.0f, 0 } } };
+                VkRenderPassBeginInfo beginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+                beginInfo.renderPass = m_mergedPass;
+                beginInfo.framebuffer = m_framebuffer;
+                beginInfo.renderArea.extent = { m_width, m_height };
+                beginInfo.clearValueCount = 5;
+                beginInfo.pClearValues = clearValues;
+                vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+                m_context.setViewport(cmd, { m_width, m_height });
+                recordGBuffer(cmd);
+                vkCmdNextSubpass(cmd, VK_SUBPASS_CONTENTS_INLINE);
+                recordLighting(cmd);
+                vkCmdEndRenderPass(cmd);
+                break;
+            }
+            case DeferredPassKind::Present:
+            {
+                const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                m_context.profiler().begin(cmd, "present");
+                m_context.beginSwapchainPass(cmd, clearColor);
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_present);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_presentLayout, 0, 1, &m_presentSet, 0, nullptr);
+                vkCmdDraw(cmd, 3, 1, 0, 0);
+                vkCmdEndRenderPass(cmd);
+                m_context.profiler().end(cmd);
+                break;
+            }
+            }
+        }
+
+        void recordGBuffer(VkCommandBuffer cmd)
+        {
+            DeferredConstants constants = gbufferConstants();
+            m_context.profiler().begin(cmd, "gbuffer");
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_gbuffer);
+            vkCmdPushConstants(cmd, m_gbufferLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, 36, instanceCount(), 0, 0);
+            m_context.profiler().end(cmd);
+        }
+
+        void recordLighting(VkCommandBuffer cmd)
+        {
+            DeferredConstants constants = lightingConstants();
+            m_context.profiler().begin(cmd, "lighting");
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_lightingPipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_lightingLayout, 0, 1, &m_lightingSet, 0, nullptr);
+            vkCmdPushConstants(cmd, m_lightingLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, 3, 1, 0, 0);
+            m_context.profiler().end(cmd);
+        }
+
+        VulkanContext& m_context;
+        VulkanRenderGraph m_graph;
+        VulkanBuffer m_lightBuffer;
+        VulkanBuffer m_tileBuffer;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_lightingSetLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_presentSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_gbufferLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_lightingLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_presentLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_lightingSet = VK_NULL_HANDLE;
+        VkDescriptorSet m_presentSet = VK_NULL_HANDLE;
+        /* Merged only */
+        VkRenderPass m_mergedPass = VK_NULL_HANDLE;
+        VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+        VkPipeline m_gbuffer = VK_NULL_HANDLE;
+        VkPipeline m_lightingPipeline = VK_NULL_HANDLE;
+        VkPipeline m_present = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createDeferredScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<DeferredScenarioVulkan>(context, options);
+}
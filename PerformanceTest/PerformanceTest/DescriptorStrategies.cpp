@@ -0,0 +1,51 @@
+#include "DescriptorStrategies.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DescriptorScenario::DescriptorScenario(const Options& options, uint32_t uniformAlignment)
+{
+    uint32_t count = uint32_t(options.getInt("draws", 10000));
+    if (count == 0)
+        fatal("--draws has to be at least 1");
+    uint32_t alignment = std::max(1u, uniformAlignment);
+    m_stride = (uint32_t(sizeof(DescriptorDrawUniforms)) + alignment - 1) / alignment * alignment;
+
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(count)))));
+    float cell = 2.0f / float(side);
+    m_uniforms.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_uniforms[i].rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        m_uniforms[i].color = { float(i % side) / float(side), float(i / side) / float(side), 0.5f, 1.0f };
+    }
+}
+
+void DescriptorScenario::writeUniforms(const FrameInfo& frame, uint8_t* destination) const
+{
+    /* Changes every frame, like real per-draw data */
+    float pulse = 0.5f + 0.5f * std::sin(float(frame.index) / 30.0f);
+    for (size_t i = 0; i < m_uniforms.size(); ++i)
+    {
+        DescriptorDrawUniforms uniforms = m_uniforms[i];
+        uniforms.color.z = pulse;
+        std::memcpy(destination + i * m_stride, &uniforms, sizeof(uniforms));
+    }
+}
+
+void DescriptorScenario::recordDrawLoop(double milliseconds, bool measured)
+{
+    if (!measured)
+        return;
+    m_drawLoopTimes.add(milliseconds);
+    m_drawTimes.add(milliseconds * 1e6 / double(drawCount()));
+}
+
+void DescriptorScenario::report(Report& report)
+{
+    report.addValue("draws", double(drawCount()), "");
+    report.addValue("uniform stride", double(m_stride), "B");
+    report.addStatistics("cpu draw loop", m_drawLoopTimes, "ms");
+    report.addStatistics("cpu time per draw", m_drawTimes, "ns");
+}
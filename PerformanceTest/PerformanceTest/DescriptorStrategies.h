@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "Scenario.h"
+
+/* std140 layout of the DrawUniforms block in shaders/descriptors/descriptors.glsl */
+struct DescriptorDrawUniforms
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    Vec4 color;
+};
+
+/*
+ * Backend independent part of the descriptor scenario: --draws quads, each reading its own
+ * range of a per-frame uniform buffer, so the binding has to change for every draw. The
+ * uniforms are written before the draw loop, the loop itself only binds and draws and its CPU
+ * time per draw is the number to compare between the Vulkan strategies and OpenGL.
+ */
+class DescriptorScenario : public Scenario
+{
+public:
+    /* `uniformAlignment` is the backend's minimum uniform buffer offset alignment */
+    DescriptorScenario(const Options& options, uint32_t uniformAlignment);
+
+    void report(Report& report) override;
+
+protected:
+    uint32_t drawCount() const { return uint32_t(m_uniforms.size()); }
+    /* Writes this frame's uniforms of every draw, m_stride bytes apart */
+    void writeUniforms(const FrameInfo& frame, uint8_t* destination) const;
+    void recordDrawLoop(double milliseconds, bool measured);
+
+    /* Distance of two draws' uniforms in the buffer */
+    uint32_t m_stride;
+
+private:
+    std::vector<DescriptorDrawUniforms> m_uniforms;
+    Statistics m_drawLoopTimes;
+    Statistics m_drawTimes;
+};
+
+std::unique_ptr<Scenario> createDescriptorScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createDescriptorScenarioVulkan(VulkanContext& context, const Options& options);
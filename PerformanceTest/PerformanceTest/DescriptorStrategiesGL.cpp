@@ -0,0 +1,83 @@
+#include "DescriptorStrategies.h"
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    GLint uniformBufferAlignment()
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return alignment;
+    }
+
+    /* The OpenGL baseline: one glBindBufferRange per draw into a uniform buffer per frame in flight */
+    class DescriptorScenarioGL : public DescriptorScenario
+    {
+    public:
+        static constexpr uint32_t kFrames = GLContext::kFramesInFlight;
+
+        DescriptorScenarioGL(GLContext& context, const Options& options)
+            : DescriptorScenario(options, uint32_t(uniformBufferAlignment()))
+            , m_context(context)
+            , m_staging(size_t(drawCount()) * m_stride)
+        {
+            for (uint32_t i = 0; i < kFrames; ++i)
+                m_uniformBuffers[i] = createBuffer(GLsizeiptr(m_staging.size()), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            m_program = createProgram("descriptors/quad.vert", "descriptors/quad.frag");
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~DescriptorScenarioGL() override
+        {
+            glDeleteProgram(m_program);
+            glDeleteVertexArrays(1, &m_vertexArray);
+            glDeleteBuffers(GLsizei(kFrames), m_uniformBuffers);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            GLuint buffer = m_uniformBuffers[frame.index % kFrames];
+            writeUniforms(frame, m_staging.data());
+            glNamedBufferSubData(buffer, 0, GLsizeiptr(m_staging.size()), m_staging.data());
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_CULL_FACE);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            m_context.profiler().begin("draw");
+            Timer timer;
+            glUseProgram(m_program);
+            glBindVertexArray(m_vertexArray);
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                glBindBufferRange(GL_UNIFORM_BUFFER, 0, buffer, GLintptr(i) * m_stride, sizeof(DescriptorDrawUniforms));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            recordDrawLoop(timer.elapsedMs(), frame.measured);
+            m_context.profiler().end();
+        }
+
+        void report(Report& report) override
+        {
+            report.addText("descriptor strategy", "bind buffer range");
+            DescriptorScenario::report(report);
+        }
+
+    private:
+        GLContext& m_context;
+        std::vector<uint8_t> m_staging;
+        GLuint m_uniformBuffers[kFrames] = {};
+        GLuint m_program = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createDescriptorScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<DescriptorScenarioGL>(context, options);
+}
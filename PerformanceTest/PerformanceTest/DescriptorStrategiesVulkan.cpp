@@ -0,0 +1,301 @@
+#include "DescriptorStrategies.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    enum class DescriptorStrategy
+    {
+        /* A pool per frame in flight, reset as a whole, one new set per draw */
+        PoolReset,
+        /* Sets created once per distinct binding and looked up by its hash */
+        Cached,
+        /* VK_KHR_push_descriptor, the descriptor is recorded into the command buffer */
+        Push,
+        /* One set per frame in flight, only the dynamic offset changes per draw */
+        Dynamic,
+    };
+
+    DescriptorStrategy parseStrategy(const std::string& strategy)
+    {
+        if (strategy == "pool")
+            return DescriptorStrategy::PoolReset;
+        if (strategy == "cached")
+            return DescriptorStrategy::Cached;
+        if (strategy == "push")
+            return DescriptorStrategy::Push;
+        if (strategy == "dynamic")
+            return DescriptorStrategy::Dynamic;
+        fatal("Unknown --strategy '%s', expected pool, cached, push or dynamic", strategy.c_str());
+    }
+
+    const char* strategyName(DescriptorStrategy strategy)
+    {
+        switch (strategy)
+        {
+        case DescriptorStrategy::PoolReset: return "pool reset";
+        case DescriptorStrategy::Cached: return "cached";
+        case DescriptorStrategy::Push: return "push descriptor";
+        default: return "dynamic offset";
+        }
+    }
+
+    /* FNV-1a over the binding, the struct has no padding */
+    struct BindingHash
+    {
+        size_t operator()(const VkDescriptorBufferInfo& binding) const
+        {
+            uint8_t bytes[sizeof(VkDescriptorBufferInfo)];
+            std::memcpy(bytes, &binding, sizeof(bytes));
+            uint64_t hash = 14695981039346656037ull;
+            for (uint8_t byte : bytes)
+                hash = (hash ^ byte) * 1099511628211ull;
+            return size_t(hash);
+        }
+    };
+
+    struct BindingEqual
+    {
+        bool operator()(const VkDescriptorBufferInfo& a, const VkDescriptorBufferInfo& b) const
+        {
+            return a.buffer == b.buffer && a.offset == b.offset && a.range == b.range;
+        }
+    };
+
+    class DescriptorScenarioVulkan : public DescriptorScenario
+    {
+    public:
+        static constexpr uint32_t kFrames = VulkanContext::kFramesInFlight;
+
+        DescriptorScenarioVulkan(VulkanContext& context, const Options& options)
+            : DescriptorScenario(options, uint32_t(context.properties().limits.minUniformBufferOffsetAlignment))
+            , m_context(context)
+            , m_strategy(parseStrategy(options.getString("strategy", "dynamic")))
+        {
+            if (m_strategy == DescriptorStrategy::Push && !m_context.extensions().pushDescriptor)
+            {
+                std::printf("descriptors: VK_KHR_push_descriptor is not supported, falling back to dynamic offsets\n");
+                m_strategy = DescriptorStrategy::Dynamic;
+            }
+
+            VkDeviceSize bufferSize = VkDeviceSize(drawCount()) * m_stride;
+            for (uint32_t i = 0; i < kFrames; ++i)
+                m_uniformBuffers[i] = context.createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                           VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+            createDescriptors();
+            createPipeline();
+            std::printf("descriptors: %u draws with %s descriptors\n", drawCount(), strategyName(m_strategy));
+        }
+
+        ~DescriptorScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            vkDestroyPipeline(device, m_pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            for (uint32_t i = 0; i < kFrames; ++i)
+            {
+                vkDestroyDescriptorPool(device, m_framePools[i], vulkanHostAllocator());
+                m_context.destroyBuffer(m_uniformBuffers[i]);
+            }
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            uint32_t frameIndex = m_context.frameIndex();
+            const VulkanBuffer& uniforms = m_uniformBuffers[frameIndex];
+            writeUniforms(frame, static_cast<uint8_t*>(uniforms.mapped));
+            /* No-op on host coherent memory, sequential write allocations do not have to be */
+            VK_CHECK(vmaFlushAllocation(m_context.allocator(), uniforms.allocation, 0, VK_WHOLE_SIZE));
+
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "draw");
+
+            Timer timer;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+            switch (m_strategy)
+            {
+            case DescriptorStrategy::PoolReset: drawPoolReset(cmd, uniforms.buffer, frameIndex); break;
+            case DescriptorStrategy::Cached: drawCached(cmd, uniforms.buffer, frame.measured); break;
+            case DescriptorStrategy::Push: drawPush(cmd, uniforms.buffer); break;
+            default: drawDynamic(cmd, frameIndex); break;
+            }
+            recordDrawLoop(timer.elapsedMs(), frame.measured);
+
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+        void report(Report& report) override
+        {
+            report.addText("descriptor strategy", strategyName(m_strategy));
+            DescriptorScenario::report(report);
+            if (m_strategy == DescriptorStrategy::Cached)
+            {
+                report.addValue("descriptor cache sets", double(m_cache.size()), "");
+                report.addValue("descriptor cache misses", double(m_cacheMisses), "");
+            }
+        }
+
+    private:
+        VkDescriptorBufferInfo binding(VkBuffer buffer, uint32_t draw) const
+        {
+            return { buffer, VkDeviceSize(draw) * m_stride, sizeof(DescriptorDrawUniforms) };
+        }
+
+        VkWriteDescriptorSet write(VkDescriptorSet set, const VkDescriptorBufferInfo* buffer) const
+        {
+            VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            write.dstSet = set;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            write.pBufferInfo = buffer;
+            return write;
+        }
+
+        void drawPoolReset(VkCommandBuffer cmd, VkBuffer buffer, uint32_t frameIndex)
+        {
+            /* The fence of this frame slot was waited on, none of the pool's sets is in use anymore */
+            VkDevice device = m_context.device();
+            VK_CHECK(vkResetDescriptorPool(device, m_framePools[frameIndex], 0));
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                VkDescriptorSet set = m_context.allocateDescriptorSet(m_framePools[frameIndex], m_setLayout);
+                VkDescriptorBufferInfo info = binding(buffer, i);
+                VkWriteDescriptorSet update = write(set, &info);
+                vkUpdateDescriptorSets(device, 1, &update, 0, nullptr);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &set, 0, nullptr);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+        }
+
+        void drawCached(VkCommandBuffer cmd, VkBuffer buffer, bool measured)
+        {
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                VkDescriptorBufferInfo info = binding(buffer, i);
+                auto it = m_cache.find(info);
+                if (it == m_cache.end())
+                {
+                    VkDescriptorSet set = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                    VkWriteDescriptorSet update = write(set, &info);
+                    vkUpdateDescriptorSets(m_context.device(), 1, &update, 0, nullptr);
+                    it = m_cache.emplace(info, set).first;
+                    m_cacheMisses += measured ? 1 : 0;
+                }
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &it->second, 0, nullptr);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+        }
+
+        void drawPush(VkCommandBuffer cmd, VkBuffer buffer)
+        {
+            PFN_vkCmdPushDescriptorSetKHR pushDescriptorSet = m_context.extensions().cmdPushDescriptorSetKHR;
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                VkDescriptorBufferInfo info = binding(buffer, i);
+                VkWriteDescriptorSet update = write(VK_NULL_HANDLE, &info);
+                pushDescriptorSet(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &update);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+        }
+
+        void drawDynamic(VkCommandBuffer cmd, uint32_t frameIndex)
+        {
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                uint32_t offset = i * m_stride;
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_dynamicSets[frameIndex], 1, &offset);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+        }
+
+        void createDescriptors()
+        {
+            VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            uint32_t draws = drawCount();
+            switch (m_strategy)
+            {
+            case DescriptorStrategy::PoolReset:
+                m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr } });
+                for (uint32_t i = 0; i < kFrames; ++i)
+                    m_framePools[i] = m_context.createDescriptorPool(draws, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, draws } });
+                break;
+
+            case DescriptorStrategy::Cached:
+                /* Every frame in flight binds its own buffer, that makes kFrames sets per draw in steady state */
+                m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr } });
+                m_descriptorPool = m_context.createDescriptorPool(draws * kFrames, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, draws * kFrames } });
+                m_cache.reserve(size_t(draws) * kFrames);
+                break;
+
+            case DescriptorStrategy::Push:
+                m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr } },
+                                                                  VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR);
+                break;
+
+            case DescriptorStrategy::Dynamic:
+                m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, stages, nullptr } });
+                m_descriptorPool = m_context.createDescriptorPool(kFrames, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, kFrames } });
+                for (uint32_t i = 0; i < kFrames; ++i)
+                {
+                    m_dynamicSets[i] = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                    VkDescriptorBufferInfo info = binding(m_uniformBuffers[i].buffer, 0);
+                    VkWriteDescriptorSet update = write(m_dynamicSets[i], &info);
+                    update.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                    vkUpdateDescriptorSets(m_context.device(), 1, &update, 0, nullptr);
+                }
+                break;
+            }
+        }
+
+        void createPipeline()
+        {
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout });
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("descriptors/quad.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("descriptors/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = false;
+            desc.depthWrite = false;
+            m_pipeline = m_context.createGraphicsPipeline(desc);
+
+            vkDestroyShaderModule(m_context.device(), desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(m_context.device(), desc.fragmentShader, vulkanHostAllocator());
+        }
+
+        VulkanContext& m_context;
+        DescriptorStrategy m_strategy;
+        VulkanBuffer m_uniformBuffers[kFrames];
+
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_pipeline = VK_NULL_HANDLE;
+        /* Cached and dynamic strategies */
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorPool m_framePools[kFrames] = {};
+        VkDescriptorSet m_dynamicSets[kFrames] = {};
+        std::unordered_map<VkDescriptorBufferInfo, VkDescriptorSet, BindingHash, BindingEqual> m_cache;
+        uint64_t m_cacheMisses = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createDescriptorScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<DescriptorScenarioVulkan>(context, options);
+}
@@ -0,0 +1,72 @@
+#include "DrawCalls.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    ConstantUpload parseUpload(const std::string& upload)
+    {
+        if (upload == "ring")
+            return ConstantUpload::Ring;
+        if (upload == "push")
+            return ConstantUpload::Push;
+        if (upload == "uniform")
+            return ConstantUpload::Uniform;
+        fatal("Unknown --constants '%s', expected ring, push or uniform", upload.c_str());
+    }
+}
+
+const char* constantUploadName(ConstantUpload upload)
+{
+    switch (upload)
+    {
+    case ConstantUpload::Ring: return "uniform ring";
+    case ConstantUpload::Push: return "push constants";
+    default: return "glUniform";
+    }
+}
+
+DrawCallScenario::DrawCallScenario(const Options& options)
+    : m_upload(parseUpload(options.getString("constants", "ring")))
+{
+    uint32_t count = uint32_t(options.getInt("draws", 10000));
+    if (count == 0)
+        fatal("--draws has to be at least 1");
+
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(count)))));
+    float cell = 2.0f / float(side);
+    m_draws.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_draws[i].rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        m_draws[i].color = { float(i % side) / float(side), float(i / side) / float(side), 0.0f, 1.0f };
+    }
+
+    std::printf("draw-calls: %u draws, constants through %s\n", count, constantUploadName(m_upload));
+}
+
+void DrawCallScenario::update(const FrameInfo& frame)
+{
+    m_pulse = 0.5f + 0.5f * std::sin(float(frame.index) / 30.0f);
+}
+
+void DrawCallScenario::recordDrawLoop(double milliseconds, uint64_t ringBytes, bool measured)
+{
+    if (!measured)
+        return;
+    m_drawLoopTimes.add(milliseconds);
+    m_drawTimes.add(milliseconds * 1e6 / double(drawCount()));
+    m_ringBytes.add(double(ringBytes) / 1024.0);
+}
+
+void DrawCallScenario::report(Report& report)
+{
+    report.addText("constant upload", constantUploadName(m_upload));
+    report.addValue("draws", double(drawCount()), "");
+    report.addStatistics("cpu draw loop", m_drawLoopTimes, "ms");
+    report.addStatistics("cpu time per draw", m_drawTimes, "ns");
+    if (m_upload == ConstantUpload::Ring)
+        report.addStatistics("uniform ring per frame", m_ringBytes, "KB");
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "Scenario.h"
+
+enum class ConstantUpload
+{
+    /* Suballocated from the context's uniform ring, bound with a dynamic offset or glBindBufferRange */
+    Ring,
+    /* vkCmdPushConstants, on OpenGL the emulation in GLContext::pushConstants */
+    Push,
+    /* glUniform4fv into the program's default block, OpenGL only */
+    Uniform,
+};
+
+/* Per-draw constants, same layout as DrawConstants in shaders/drawcalls/drawcalls.glsl */
+struct DrawCallConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    Vec4 color;
+};
+
+/*
+ * Draw call stress loop: --draws small quads, each with its own constants that change every
+ * frame. The backends differ only in how the constants reach the shader, the CPU time of the
+ * draw loop per draw is the number to compare.
+ */
+class DrawCallScenario : public Scenario
+{
+public:
+    DrawCallScenario(const Options& options);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    uint32_t drawCount() const { return uint32_t(m_draws.size()); }
+
+    DrawCallConstants constants(uint32_t draw) const
+    {
+        DrawCallConstants result = m_draws[draw];
+        result.color.z = m_pulse;
+        return result;
+    }
+
+    /* `ringBytes` is what the frame took from the uniform ring, 0 for the other uploads */
+    void recordDrawLoop(double milliseconds, uint64_t ringBytes, bool measured);
+
+    ConstantUpload m_upload;
+
+private:
+    std::vector<DrawCallConstants> m_draws;
+    float m_pulse = 0.0f;
+
+    Statistics m_drawLoopTimes;
+    Statistics m_drawTimes;
+    Statistics m_ringBytes;
+};
+
+const char* constantUploadName(ConstantUpload upload);
+
+std::unique_ptr<Scenario> createDrawCallScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createDrawCallScenarioVulkan(VulkanContext& context, const Options& options);
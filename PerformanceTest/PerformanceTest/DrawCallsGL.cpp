@@ -0,0 +1,87 @@
+#include "DrawCalls.h"
+
+#include <cstring>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    class DrawCallScenarioGL : public DrawCallScenario
+    {
+    public:
+        DrawCallScenarioGL(GLContext& context, const Options& options)
+            : DrawCallScenario(options)
+            , m_context(context)
+        {
+            const char* define = m_upload == ConstantUpload::Ring ? "RING" : m_upload == ConstantUpload::Push ? "PUSH" : "UNIFORM";
+            m_program = createProgram("drawcalls/quad.vert", "drawcalls/quad.frag", { { define, "1" } });
+            if (m_upload == ConstantUpload::Uniform)
+            {
+                m_rectLocation = glGetUniformLocation(m_program, "draw.rect");
+                m_colorLocation = glGetUniformLocation(m_program, "draw.color");
+            }
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~DrawCallScenarioGL() override
+        {
+            glDeleteProgram(m_program);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_CULL_FACE);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            GLUniformRing& ring = m_context.uniformRing();
+            GLsizeiptr ringStart = ring.used();
+
+            m_context.profiler().begin("draw");
+            Timer timer;
+            glUseProgram(m_program);
+            glBindVertexArray(m_vertexArray);
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                DrawCallConstants draw = constants(i);
+                switch (m_upload)
+                {
+                case ConstantUpload::Ring:
+                {
+                    GLUniformAllocation allocation = ring.allocate(sizeof(draw));
+                    std::memcpy(allocation.data, &draw, sizeof(draw));
+                    glBindBufferRange(GL_UNIFORM_BUFFER, 0, ring.buffer(), allocation.offset, sizeof(draw));
+                    break;
+                }
+                case ConstantUpload::Push:
+                    m_context.pushConstants(&draw, sizeof(draw));
+                    break;
+                default:
+                    glUniform4fv(m_rectLocation, 1, &draw.rect.x);
+                    glUniform4fv(m_colorLocation, 1, &draw.color.x);
+                    break;
+                }
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            recordDrawLoop(timer.elapsedMs(), uint64_t(ring.used() - ringStart), frame.measured);
+            m_context.profiler().end();
+        }
+
+    private:
+        GLContext& m_context;
+        GLuint m_program = 0;
+        GLuint m_vertexArray = 0;
+        GLint m_rectLocation = -1;
+        GLint m_colorLocation = -1;
+    };
+}
+
+std::unique_ptr<Scenario> createDrawCallScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<DrawCallScenarioGL>(context, options);
+}
@@ -0,0 +1,117 @@
+#include "DrawCalls.h"
+
+#include <cstring>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    class DrawCallScenarioVulkan : public DrawCallScenario
+    {
+    public:
+        DrawCallScenarioVulkan(VulkanContext& context, const Options& options)
+            : DrawCallScenario(options)
+            , m_context(context)
+        {
+            if (m_upload == ConstantUpload::Uniform)
+                fatal("--constants uniform is OpenGL only, use ring or push");
+
+            ShaderDefines defines;
+            if (m_upload == ConstantUpload::Ring)
+            {
+                /* A single set over the whole ring, every draw only passes its offset */
+                m_setLayout = context.createDescriptorSetLayout({
+                    { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                });
+                m_descriptorPool = context.createDescriptorPool(1, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 } });
+                m_set = context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+
+                VkDescriptorBufferInfo buffer = { context.uniformRing().buffer(), 0, sizeof(DrawCallConstants) };
+                VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                write.dstSet = m_set;
+                write.dstBinding = 0;
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                write.pBufferInfo = &buffer;
+                vkUpdateDescriptorSets(context.device(), 1, &write, 0, nullptr);
+
+                m_pipelineLayout = context.createPipelineLayout({ m_setLayout });
+                defines.push_back({ "RING", "1" });
+            }
+            else
+            {
+                m_pipelineLayout = context.createPipelineLayout({}, sizeof(DrawCallConstants));
+                defines.push_back({ "PUSH", "1" });
+            }
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = context.swapchainRenderPass();
+            desc.vertexShader = context.createShaderModule("drawcalls/quad.vert", VK_SHADER_STAGE_VERTEX_BIT, defines);
+            desc.fragmentShader = context.createShaderModule("drawcalls/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT, defines);
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = false;
+            desc.depthWrite = false;
+            m_pipeline = context.createGraphicsPipeline(desc);
+
+            vkDestroyShaderModule(context.device(), desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(context.device(), desc.fragmentShader, vulkanHostAllocator());
+        }
+
+        ~DrawCallScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            vkDestroyPipeline(device, m_pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            VulkanUniformRing& ring = m_context.uniformRing();
+            VkDeviceSize ringStart = ring.used();
+
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "draw");
+
+            Timer timer;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+            for (uint32_t i = 0; i < drawCount(); ++i)
+            {
+                DrawCallConstants draw = constants(i);
+                if (m_upload == ConstantUpload::Ring)
+                {
+                    VulkanUniformAllocation allocation = ring.allocate(sizeof(draw));
+                    std::memcpy(allocation.data, &draw, sizeof(draw));
+                    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_set, 1, &allocation.offset);
+                }
+                else
+                    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(draw), &draw);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+            recordDrawLoop(timer.elapsedMs(), uint64_t(ring.used() - ringStart), frame.measured);
+
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+    private:
+        VulkanContext& m_context;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_set = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline m_pipeline = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createDrawCallScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<DrawCallScenarioVulkan>(context, options);
+}
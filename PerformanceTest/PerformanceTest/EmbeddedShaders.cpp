@@ -0,0 +1,42 @@
+#include "ShaderSource.h"
+
+#include <cstring>
+
+namespace
+{
+#if __has_include("generated/EmbeddedShaders.inc")
+#include "generated/EmbeddedShaders.inc"
+    const EmbeddedShader* const kShaders = kEmbeddedShaders;
+    const size_t kShaderCount = sizeof(kEmbeddedShaders) / sizeof(kEmbeddedShaders[0]);
+#else
+    /* Built without the CompileShaders.ps1 pre-build step, every shader is compiled from GLSL */
+    const EmbeddedShader* const kShaders = nullptr;
+    const size_t kShaderCount = 0;
+#endif
+
+    bool g_enabled = true;
+}
+
+void setEmbeddedShadersEnabled(bool enabled)
+{
+    g_enabled = enabled;
+}
+
+bool embeddedShadersEnabled()
+{
+    return g_enabled && kShaderCount > 0;
+}
+
+const EmbeddedShader* findEmbeddedShader(const std::string& path, const ShaderDefines& defines, bool vulkan)
+{
+    if (!g_enabled)
+        return nullptr;
+
+    std::string key = path;
+    for (const auto& define : defines)
+        key += "|" + define.first + "=" + define.second;
+    for (size_t i = 0; i < kShaderCount; ++i)
+        if (kShaders[i].vulkan == vulkan && std::strcmp(kShaders[i].key, key.c_str()) == 0)
+            return &kShaders[i];
+    return nullptr;
+}
@@ -0,0 +1,70 @@
+#include "FrameArena.h"
+
+#include <new>
+
+LinearArena::LinearArena(size_t capacity)
+    : m_memory(static_cast<uint8_t*>(::operator new(capacity, std::align_val_t(64))))
+    , m_capacity(capacity)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    reset();
+    ::operator delete(m_memory, std::align_val_t(64));
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+    ++m_allocationCount;
+    size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= m_capacity)
+    {
+        m_offset = offset + size;
+        return m_memory + offset;
+    }
+
+    void* memory = ::operator new(size, std::align_val_t(alignment));
+    m_overflow.push_back({ memory, alignment });
+    return memory;
+}
+
+void LinearArena::reset()
+{
+    for (const Overflow& overflow : m_overflow)
+        ::operator delete(overflow.memory, std::align_val_t(overflow.alignment));
+    m_overflow.clear();
+    m_offset = 0;
+    m_allocationCount = 0;
+}
+
+FrameArenas::FrameArenas(size_t capacity, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        m_arenas.push_back(std::make_unique<LinearArena>(capacity));
+}
+
+LinearArena& FrameArenas::beginFrame(const FrameInfo& frame)
+{
+    m_current = m_arenas[frame.index % m_arenas.size()].get();
+    m_current->reset();
+    return *m_current;
+}
+
+void FrameArenas::endFrame(const FrameInfo& frame)
+{
+    if (!frame.measured)
+        return;
+    m_usedBytes.add(double(m_current->used()) / 1024.0);
+    m_allocationCounts.add(double(m_current->allocationCount()));
+    m_overflowCount += m_current->overflowCount();
+}
+
+void FrameArenas::report(Report& report) const
+{
+    report.addValue("frame arenas", double(m_arenas.size()), "");
+    report.addValue("frame arena capacity", double(m_arenas[0]->capacity()) / (1024.0 * 1024.0), "MB");
+    report.addStatistics("frame arena used", m_usedBytes, "KB");
+    report.addStatistics("frame arena allocations", m_allocationCounts, "");
+    report.addValue("frame arena heap fallbacks", double(m_overflowCount), "");
+}
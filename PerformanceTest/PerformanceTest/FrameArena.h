@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Benchmark.h"
+
+/*
+ * Bump allocator for data that lives for one frame. Allocating moves an offset, reset() drops
+ * everything at once. Nothing is destructed, so only trivially destructible types fit in.
+ * When the block is full the arena falls back to the heap and counts it, a correctly sized
+ * arena never does that.
+ */
+class LinearArena
+{
+public:
+    explicit LinearArena(size_t capacity);
+    ~LinearArena();
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = 16);
+
+    /* Uninitialized storage for `count` objects of T */
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena memory is never destructed");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16));
+    }
+
+    /* O(1) unless the previous frame overflowed to the heap */
+    void reset();
+
+    size_t capacity() const { return m_capacity; }
+    size_t used() const { return m_offset; }
+    uint32_t allocationCount() const { return m_allocationCount; }
+    /* Allocations since the last reset that did not fit and went to the heap */
+    uint32_t overflowCount() const { return uint32_t(m_overflow.size()); }
+
+private:
+    struct Overflow
+    {
+        void* memory;
+        size_t alignment;
+    };
+
+    uint8_t* m_memory;
+    size_t m_capacity;
+    size_t m_offset = 0;
+    uint32_t m_allocationCount = 0;
+    std::vector<Overflow> m_overflow;
+};
+
+/*
+ * One arena per frame in flight, used round robin: beginFrame() resets the arena of the frame
+ * that was recorded `count` frames ago, so data handed to the backend stays untouched until
+ * that frame is done. Collects per frame usage for the run summary.
+ */
+class FrameArenas
+{
+public:
+    FrameArenas(size_t capacity, uint32_t count);
+
+    LinearArena& beginFrame(const FrameInfo& frame);
+    /* Records the usage of the frame's arena */
+    void endFrame(const FrameInfo& frame);
+
+    void report(Report& report) const;
+
+private:
+    std::vector<std::unique_ptr<LinearArena>> m_arenas;
+    LinearArena* m_current = nullptr;
+
+    Statistics m_usedBytes;
+    Statistics m_allocationCounts;
+    /* Heap fallbacks during the measured frames, has to be 0 */
+    uint64_t m_overflowCount = 0;
+};
@@ -0,0 +1,56 @@
+#include "FrameLatency.h"
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+    double ticksToMs(uint64_t ticks)
+    {
+        return double(ticks) * 1000.0 / double(glfwGetTimerFrequency());
+    }
+}
+
+FrameLatency::FrameLatency(const char* endPoint)
+    : m_endPoint(endPoint)
+{
+}
+
+uint64_t FrameLatency::beginFrame(const FrameInfo& frame)
+{
+    if (m_end - m_begin == kMaxPending)
+    {
+        ++m_begin;
+        ++m_dropped;
+    }
+    m_entries[m_end % kMaxPending] = { glfwGetTimerValue(), frame.measured };
+    return m_end++;
+}
+
+void FrameLatency::completeOldest()
+{
+    uint64_t now = glfwGetTimerValue();
+    const Entry& entry = m_entries[m_begin % kMaxPending];
+    if (entry.measured)
+    {
+        m_latency.add(ticksToMs(now - entry.inputTicks));
+        if (m_lastEndTicks != 0)
+            m_intervals.add(ticksToMs(now - m_lastEndTicks));
+    }
+    m_lastEndTicks = now;
+    ++m_begin;
+}
+
+void FrameLatency::discardPending()
+{
+    m_dropped += m_end - m_begin;
+    m_begin = m_end;
+    m_lastEndTicks = 0;
+}
+
+void FrameLatency::report(Report& report) const
+{
+    report.addText("latency end point", m_endPoint);
+    report.addStatistics("latency", m_latency, "ms");
+    report.addStatistics("frame pacing", m_intervals, "ms");
+    report.addValue("latency dropped frames", double(m_dropped), "");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Benchmark.h"
+
+/*
+ * Input to photon estimate of the backends. A frame starts when the backend begins it, right
+ * after the main loop polled the input, and ends when the backend sees it reach its end
+ * point: on screen with VK_KHR_present_wait, otherwise done on the GPU. The backends poll for
+ * that at the start and the end of every frame without blocking, so an end is seen up to one
+ * frame late and the numbers are an upper bound. The interval between two ends shows the
+ * frame pacing of the present configuration.
+ */
+class FrameLatency
+{
+public:
+    /* More frames than any swapchain queues up, the oldest is dropped on overflow */
+    static constexpr uint32_t kMaxPending = 16;
+
+    /* `endPoint` describes the end point in the report, has to be a string literal */
+    explicit FrameLatency(const char* endPoint);
+
+    /* The frame's input was sampled now, returns the id the backend tracks the frame with */
+    uint64_t beginFrame(const FrameInfo& frame);
+
+    bool pending() const { return m_begin != m_end; }
+    /* Id of the oldest frame that has not reached the end point */
+    uint64_t oldest() const { return m_begin; }
+    /* The oldest frame reached the end point now */
+    void completeOldest();
+    /* The end of the pending frames cannot be observed anymore, e.g. after swapchain recreation */
+    void discardPending();
+
+    void report(Report& report) const;
+
+private:
+    struct Entry
+    {
+        uint64_t inputTicks;
+        bool measured;
+    };
+
+    const char* m_endPoint;
+    Entry m_entries[kMaxPending] = {};
+    /* Pending ids are [m_begin, m_end) */
+    uint64_t m_begin = 0;
+    uint64_t m_end = 0;
+    uint64_t m_lastEndTicks = 0;
+
+    Statistics m_latency;
+    Statistics m_intervals;
+    uint64_t m_dropped = 0;
+};
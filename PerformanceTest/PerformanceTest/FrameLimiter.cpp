@@ -0,0 +1,90 @@
+#include "FrameLimiter.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "GLFW/glfw3.h"
+
+FrameLimiter::FrameLimiter(const Options& options)
+    : m_fps(options.getDouble("fps-limit", 0.0))
+    , m_ticksPerMs(double(glfwGetTimerFrequency()) / 1000.0)
+{
+    if (m_fps < 0.0)
+        fatal("--fps-limit has to be 0 (off) or positive");
+    if (m_fps == 0.0)
+        return;
+    m_periodTicks = uint64_t(double(glfwGetTimerFrequency()) / m_fps);
+
+    /* A first estimate of the sleep overshoot, the frames refine it */
+    for (int i = 0; i < 8; ++i)
+    {
+        uint64_t start = glfwGetTimerValue();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        addSleep(double(glfwGetTimerValue() - start) / m_ticksPerMs);
+    }
+}
+
+void FrameLimiter::wait(const FrameInfo& frame)
+{
+    if (!enabled())
+        return;
+
+    uint64_t now = glfwGetTimerValue();
+    if (m_deadline == 0)
+    {
+        m_deadline = now + m_periodTicks;
+        return;
+    }
+
+    /* Sleep while even an overshooting sleep ends before the deadline */
+    while (now < m_deadline && double(m_deadline - now) / m_ticksPerMs > sleepEstimateMs())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        uint64_t woken = glfwGetTimerValue();
+        addSleep(double(woken - now) / m_ticksPerMs);
+        now = woken;
+    }
+
+    uint64_t spinStart = now;
+    while (now < m_deadline)
+        now = glfwGetTimerValue();
+
+    /* How late the frame was released, the spin overshot or the frame itself took too long */
+    double error = double(now - m_deadline) / m_ticksPerMs;
+    bool missed = now - m_deadline > m_periodTicks;
+    if (frame.measured)
+    {
+        m_errors.add(error);
+        m_spins.add(double(now - spinStart) / m_ticksPerMs);
+        if (missed)
+            ++m_missed;
+    }
+
+    /* A frame that missed a whole period restarts the schedule instead of rushing to catch up */
+    m_deadline = missed ? now + m_periodTicks : m_deadline + m_periodTicks;
+}
+
+void FrameLimiter::addSleep(double milliseconds)
+{
+    ++m_sleepCount;
+    double delta = milliseconds - m_sleepMean;
+    m_sleepMean += delta / double(m_sleepCount);
+    m_sleepM2 += delta * (milliseconds - m_sleepMean);
+}
+
+double FrameLimiter::sleepEstimateMs() const
+{
+    return m_sleepMean + std::sqrt(m_sleepM2 / double(m_sleepCount - 1));
+}
+
+void FrameLimiter::report(Report& report) const
+{
+    report.addValue("fps limit", m_fps, "");
+    if (!enabled())
+        return;
+    report.addStatistics("limiter error", m_errors, "ms");
+    report.addStatistics("limiter spin", m_spins, "ms");
+    report.addValue("limiter sleep estimate", sleepEstimateMs(), "ms");
+    report.addValue("limiter missed frames", double(m_missed), "");
+}
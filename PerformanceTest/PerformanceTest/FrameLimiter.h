@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Benchmark.h"
+
+/*
+ * Caps the frame rate at --fps-limit (0, the default, leaves it uncapped). wait() sleeps in 1 ms
+ * steps while the deadline is further away than a sleep can overshoot and spins on
+ * glfwGetTimerValue() for the rest. The overshoot is learned from every sleep as mean plus one
+ * standard deviation, so the limiter adapts to the timer resolution of the OS. The report shows
+ * how far from the deadline each frame was released.
+ */
+class FrameLimiter
+{
+public:
+    explicit FrameLimiter(const Options& options);
+
+    bool enabled() const { return m_periodTicks != 0; }
+    /* Blocks until the current frame's deadline, called between two frames of the main loop */
+    void wait(const FrameInfo& frame);
+
+    void report(Report& report) const;
+
+private:
+    void addSleep(double milliseconds);
+    double sleepEstimateMs() const;
+
+    double m_fps;
+    uint64_t m_periodTicks = 0;
+    double m_ticksPerMs;
+    /* 0 until the first frame */
+    uint64_t m_deadline = 0;
+
+    /* Welford mean and variance of the observed 1 ms sleeps, seeded in the constructor */
+    uint64_t m_sleepCount = 0;
+    double m_sleepMean = 0.0;
+    double m_sleepM2 = 0.0;
+
+    Statistics m_errors;
+    Statistics m_spins;
+    uint64_t m_missed = 0;
+};
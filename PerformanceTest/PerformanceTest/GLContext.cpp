@@ -0,0 +1,413 @@
+#include "GLContext.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <shaderc/shaderc.hpp>
+
+namespace
+{
+#ifdef _DEBUG
+    void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user)
+    {
+        if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+            return;
+        std::fprintf(stderr, "GL: %s\n", message);
+    }
+#endif
+
+    /* Calls fatal() with the info log if the shader failed to compile */
+    GLuint checkShader(GLuint shader, const std::string& path)
+    {
+        GLint status = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            GLint length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+            std::vector<GLchar> log(size_t(length) + 1);
+            glGetShaderInfoLog(shader, length, nullptr, log.data());
+            fatal("Failed to compile '%s':\n%s", path.c_str(), log.data());
+        }
+        return shader;
+    }
+
+    /* Specialization constant i is set to constants[i] */
+    GLuint specializeShader(GLenum stage, const uint32_t* code, size_t wordCount, const uint32_t* constants, uint32_t constantCount)
+    {
+        std::vector<GLuint> indices(constantCount);
+        for (uint32_t i = 0; i < constantCount; ++i)
+            indices[i] = i;
+
+        GLuint shader = glCreateShader(stage);
+        glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, code, GLsizei(wordCount * sizeof(uint32_t)));
+        glSpecializeShader(shader, "main", constantCount, indices.data(), constants);
+        return shader;
+    }
+
+    shaderc_shader_kind shaderKind(GLenum stage)
+    {
+        switch (stage)
+        {
+        case GL_VERTEX_SHADER: return shaderc_vertex_shader;
+        case GL_FRAGMENT_SHADER: return shaderc_fragment_shader;
+        case GL_COMPUTE_SHADER: return shaderc_compute_shader;
+        case GL_GEOMETRY_SHADER: return shaderc_geometry_shader;
+        default: fatal("Unsupported shader stage 0x%x", unsigned(stage));
+        }
+    }
+
+    GLuint compileShader(GLenum stage, const std::string& path, const ShaderDefines& defines)
+    {
+        /* Embedded SPIR-V skips the GLSL front end, the driver only specializes it */
+        if (const EmbeddedShader* embedded = findEmbeddedShader(path, defines, false))
+            return specializeShader(stage, embedded->code, embedded->wordCount, nullptr, 0);
+
+        std::string source = loadShaderSource(path, defines, false);
+        const GLchar* text = source.c_str();
+
+        GLuint shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &text, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    /* Deletes the shaders, the program keeps the compiled code */
+    GLuint attachAndLink(const GLuint* shaders, uint32_t count, bool retrievableBinary = false)
+    {
+        GLuint program = glCreateProgram();
+        for (uint32_t i = 0; i < count; ++i)
+            glAttachShader(program, shaders[i]);
+        if (retrievableBinary)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            glDetachShader(program, shaders[i]);
+            glDeleteShader(shaders[i]);
+        }
+        return program;
+    }
+}
+
+GLProfiler::GLProfiler()
+{
+    for (FrameQueries& frame : m_frames)
+        glGenQueries(GLsizei(kMaxZones * 2), frame.queries);
+}
+
+GLProfiler::~GLProfiler()
+{
+    for (FrameQueries& frame : m_frames)
+        glDeleteQueries(GLsizei(kMaxZones * 2), frame.queries);
+}
+
+void GLProfiler::beginFrame(const FrameInfo& frame)
+{
+    m_current = uint32_t(frame.index % kLatency);
+    resolve(m_frames[m_current]);
+    m_frames[m_current].measured = frame.measured;
+}
+
+void GLProfiler::begin(const char* zone)
+{
+    FrameQueries& frame = m_frames[m_current];
+    if (m_open != UINT32_MAX || frame.recordCount == kMaxZones)
+        fatal("GLProfiler: zones can not be nested and are limited to %u per frame", kMaxZones);
+
+    m_open = frame.recordCount++;
+    frame.records[m_open] = { zoneIndex(zone), m_open * 2 };
+    glQueryCounter(frame.queries[m_open * 2], GL_TIMESTAMP);
+}
+
+void GLProfiler::end()
+{
+    FrameQueries& frame = m_frames[m_current];
+    glQueryCounter(frame.queries[m_open * 2 + 1], GL_TIMESTAMP);
+    m_open = UINT32_MAX;
+}
+
+void GLProfiler::report(Report& report) const
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        report.addStatistics(std::string("gpu ") + m_zoneNames[i], m_zoneTimes[i], "ms");
+}
+
+const Statistics* GLProfiler::zoneTimes(const char* zone) const
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        if (m_zoneNames[i] == zone || std::strcmp(m_zoneNames[i], zone) == 0)
+            return m_zoneTimes[i].count() ? &m_zoneTimes[i] : nullptr;
+    return nullptr;
+}
+
+uint32_t GLProfiler::zoneIndex(const char* zone)
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        if (m_zoneNames[i] == zone || std::strcmp(m_zoneNames[i], zone) == 0)
+            return i;
+
+    if (m_zoneCount == kMaxZones)
+        fatal("GLProfiler: too many distinct zones");
+    m_zoneNames[m_zoneCount] = zone;
+    return m_zoneCount++;
+}
+
+void GLProfiler::resolve(FrameQueries& frame)
+{
+    for (uint32_t i = 0; i < frame.recordCount; ++i)
+    {
+        /* The queries are kLatency frames old, so this does not block in practice */
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(frame.queries[frame.records[i].query], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[frame.records[i].query + 1], GL_QUERY_RESULT, &end);
+        if (frame.measured)
+            m_zoneTimes[frame.records[i].zone].add(double(end - begin) * 1e-6);
+    }
+    frame.recordCount = 0;
+}
+
+GLUniformRing::GLUniformRing(GLsizeiptr segmentSize, uint32_t segmentCount)
+    : m_segmentSize(segmentSize)
+    , m_fences(segmentCount, nullptr)
+{
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+
+    /* Coherent, writes are visible to the next draw without an explicit flush */
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = segmentSize * GLsizeiptr(segmentCount);
+    m_buffer = createBuffer(size, nullptr, flags);
+    m_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(m_buffer, 0, size, flags));
+    if (!m_mapped)
+        fatal("Failed to map the uniform ring");
+}
+
+GLUniformRing::~GLUniformRing()
+{
+    for (GLsync fence : m_fences)
+        if (fence)
+            glDeleteSync(fence);
+    glUnmapNamedBuffer(m_buffer);
+    glDeleteBuffers(1, &m_buffer);
+}
+
+void GLUniformRing::beginFrame(const FrameInfo& frame)
+{
+    m_segment = uint32_t(frame.index % m_fences.size());
+    GLsync& fence = m_fences[m_segment];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    m_segmentBegin = GLintptr(m_segment) * m_segmentSize;
+    m_head = m_segmentBegin;
+}
+
+void GLUniformRing::endFrame()
+{
+    m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLUniformAllocation GLUniformRing::allocate(GLsizeiptr size)
+{
+    GLintptr offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    if (offset + size > m_segmentBegin + m_segmentSize)
+        fatal("Uniform ring overflow, a frame needs more than %lld bytes", (long long)m_segmentSize);
+    m_head = offset + size;
+    return { m_mapped + offset, offset };
+}
+
+GLContext::GLContext(GLFWwindow* window, const Options& options)
+    : m_window(window)
+    , m_swapInterval(int(options.getInt("swap-interval", 1)))
+    , m_latency("swap done on the gpu")
+{
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        fatal("Failed to load the OpenGL functions");
+    if (!GLAD_GL_VERSION_4_6)
+        fatal("OpenGL 4.6 is required, the context reports %d.%d", GLVersion.major, GLVersion.minor);
+
+#ifdef _DEBUG
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debugCallback, nullptr);
+#endif
+
+    /* Same clip space as Vulkan, see perspective() */
+    glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+    glfwGetFramebufferSize(window, &m_width, &m_height);
+
+    /* Set explicitly, the driver default would decide about vsync otherwise */
+    if (m_swapInterval < 0 && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        std::printf("GLContext: adaptive swap interval is not supported, falling back to 1\n");
+        m_swapInterval = 1;
+    }
+    glfwSwapInterval(m_swapInterval);
+
+    glCreateBuffers(1, &m_pushConstants);
+    glNamedBufferStorage(m_pushConstants, kPushConstantSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kPushConstantBinding, m_pushConstants);
+
+    m_extensions = loadGLExtensions();
+    m_profiler = std::make_unique<GLProfiler>();
+    m_uniformRing = std::make_unique<GLUniformRing>(kUniformRingSize, kFramesInFlight);
+}
+
+GLContext::~GLContext()
+{
+    m_uniformRing.reset();
+    m_profiler.reset();
+    glDeleteBuffers(1, &m_pushConstants);
+    for (GLsync fence : m_swapFences)
+        glDeleteSync(fence);
+}
+
+void GLContext::beginFrame(const FrameInfo& frame)
+{
+    pollLatency();
+    m_latencyFrame = m_latency.beginFrame(frame);
+    /* Left over if the frame that had the slot before was dropped */
+    GLsync& fence = m_swapFences[m_latencyFrame % FrameLatency::kMaxPending];
+    glDeleteSync(fence);
+    fence = nullptr;
+    m_profiler->beginFrame(frame);
+    m_uniformRing->beginFrame(frame);
+    m_state.invalidate();
+}
+
+void GLContext::endFrame()
+{
+    m_uniformRing->endFrame();
+    glfwSwapBuffers(m_window);
+
+    m_swapFences[m_latencyFrame % FrameLatency::kMaxPending] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pollLatency();
+}
+
+void GLContext::waitIdle()
+{
+    glFinish();
+}
+
+void GLContext::pushConstants(const void* data, GLsizeiptr size)
+{
+    if (size > kPushConstantSize)
+        fatal("Push constant block exceeds %d bytes", int(kPushConstantSize));
+    glNamedBufferSubData(m_pushConstants, 0, size, data);
+    m_state.bindBufferBase(GL_UNIFORM_BUFFER, kPushConstantBinding, m_pushConstants);
+}
+
+void GLContext::report(Report& report) const
+{
+    report.addText("renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    report.addValue("swap interval", double(m_swapInterval), "");
+    m_profiler->report(report);
+    m_latency.report(report);
+}
+
+void GLContext::pollLatency()
+{
+    while (m_latency.pending())
+    {
+        GLsync& fence = m_swapFences[m_latency.oldest() % FrameLatency::kMaxPending];
+        /* No fence yet, the oldest frame is the one being recorded */
+        if (!fence)
+            return;
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return;
+        glDeleteSync(fence);
+        fence = nullptr;
+        m_latency.completeOldest();
+    }
+}
+
+GLuint createShader(GLenum stage, const std::string& path, const ShaderDefines& defines)
+{
+    return checkShader(compileShader(stage, path, defines), path);
+}
+
+GLuint createSpecializedShader(GLenum stage, const std::string& path, const ShaderDefines& defines, const uint32_t* constants, uint32_t constantCount)
+{
+    if (const EmbeddedShader* embedded = findEmbeddedShader(path, defines, false))
+        return checkShader(specializeShader(stage, embedded->code, embedded->wordCount, constants, constantCount), path);
+
+    /* Not embedded, shaderc produces the SPIR-V for OpenGL at runtime */
+    shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_opengl, shaderc_env_version_opengl_4_5);
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    std::string source = loadShaderSource(path, defines, false);
+    shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, shaderKind(stage), path.c_str(), options);
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+        fatal("Failed to compile '%s':\n%s", path.c_str(), result.GetErrorMessage().c_str());
+
+    std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+    return checkShader(specializeShader(stage, spirv.data(), spirv.size(), constants, constantCount), path);
+}
+
+GLuint linkProgram(const GLuint* shaders, uint32_t count, bool retrievableBinary)
+{
+    GLuint program = attachAndLink(shaders, count, retrievableBinary);
+    finishProgram(program);
+    return program;
+}
+
+GLuint createProgram(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines)
+{
+    GLuint shaders[] = {
+        createShader(GL_VERTEX_SHADER, vertexPath, defines),
+        createShader(GL_FRAGMENT_SHADER, fragmentPath, defines),
+    };
+    return linkProgram(shaders, 2);
+}
+
+GLuint startProgram(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines)
+{
+    /* Compile errors show up in the program log, the shaders are gone by the time it is checked */
+    GLuint shaders[] = {
+        compileShader(GL_VERTEX_SHADER, vertexPath, defines),
+        compileShader(GL_FRAGMENT_SHADER, fragmentPath, defines),
+    };
+    return attachAndLink(shaders, 2);
+}
+
+bool programCompleted(GLuint program)
+{
+    GLint completed = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+void finishProgram(GLuint program)
+{
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(size_t(length) + 1);
+        glGetProgramInfoLog(program, length, nullptr, log.data());
+        fatal("Failed to link program:\n%s", log.data());
+    }
+}
+
+GLuint createComputeProgram(const std::string& path, const ShaderDefines& defines)
+{
+    GLuint shader = createShader(GL_COMPUTE_SHADER, path, defines);
+    return linkProgram(&shader, 1);
+}
+
+GLuint createBuffer(GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    GLuint buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, data, flags);
+    return buffer;
+}
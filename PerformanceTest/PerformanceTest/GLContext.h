@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLFW/glfw3.h"
+
+#include "Benchmark.h"
+#include "FrameLatency.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "ShaderSource.h"
+
+/* GPU timestamps with glQueryCounter, results are read back a few frames later to avoid stalls */
+class GLProfiler
+{
+public:
+    static constexpr uint32_t kLatency = 4;
+    static constexpr uint32_t kMaxZones = 32;
+
+    GLProfiler();
+    ~GLProfiler();
+
+    void beginFrame(const FrameInfo& frame);
+    void begin(const char* zone);
+    void end();
+
+    void report(Report& report) const;
+    /* Measured times of a zone, nullptr before its first result */
+    const Statistics* zoneTimes(const char* zone) const;
+
+private:
+    struct ZoneRecord
+    {
+        uint32_t zone;
+        uint32_t query;
+    };
+
+    struct FrameQueries
+    {
+        GLuint queries[kMaxZones * 2];
+        ZoneRecord records[kMaxZones];
+        uint32_t recordCount = 0;
+        bool measured = false;
+    };
+
+    uint32_t zoneIndex(const char* zone);
+    void resolve(FrameQueries& frame);
+
+    FrameQueries m_frames[kLatency];
+    uint32_t m_current = 0;
+    uint32_t m_open = UINT32_MAX;
+    const char* m_zoneNames[kMaxZones] = {};
+    Statistics m_zoneTimes[kMaxZones];
+    uint32_t m_zoneCount = 0;
+};
+
+struct GLUniformAllocation
+{
+    void* data;
+    GLintptr offset;
+};
+
+/*
+ * Per-frame uniform data suballocated from one persistently mapped buffer and bound with
+ * glBindBufferRange. Every frame in flight owns a segment, a fence guards its reuse.
+ */
+class GLUniformRing
+{
+public:
+    GLUniformRing(GLsizeiptr segmentSize, uint32_t segmentCount);
+    ~GLUniformRing();
+
+    void beginFrame(const FrameInfo& frame);
+    void endFrame();
+
+    /* Aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, the memory is valid until the end of the frame */
+    GLUniformAllocation allocate(GLsizeiptr size);
+
+    GLuint buffer() const { return m_buffer; }
+    GLint alignment() const { return m_alignment; }
+    /* Bytes allocated in the current frame, including alignment padding */
+    GLsizeiptr used() const { return m_head - m_segmentBegin; }
+
+private:
+    GLuint m_buffer = 0;
+    uint8_t* m_mapped = nullptr;
+    GLsizeiptr m_segmentSize;
+    GLint m_alignment = 256;
+    std::vector<GLsync> m_fences;
+    uint32_t m_segment = 0;
+    GLintptr m_segmentBegin = 0;
+    GLintptr m_head = 0;
+};
+
+/* OpenGL 4.6 core backend, owns the context state shared by all scenarios */
+class GLContext
+{
+public:
+    /* Binding of the uniform block that emulates Vulkan push constants, see common.glsl */
+    static constexpr GLuint kPushConstantBinding = 15;
+    static constexpr GLsizeiptr kPushConstantSize = 128;
+    /* The driver queues frames on its own, two is what the Vulkan backend uses as well */
+    static constexpr uint32_t kFramesInFlight = 2;
+    /* Uniform ring segment of every frame in flight */
+    static constexpr GLsizeiptr kUniformRingSize = 16 * 1024 * 1024;
+
+    /* --swap-interval 1 (default) waits for vertical blank, 0 does not, -1 is adaptive if the driver supports it */
+    GLContext(GLFWwindow* window, const Options& options);
+    ~GLContext();
+
+    GLContext(const GLContext&) = delete;
+    GLContext& operator=(const GLContext&) = delete;
+
+    void beginFrame(const FrameInfo& frame);
+    void endFrame();
+    void waitIdle();
+
+    /* Uploads data to the push constant uniform block for the next draw or dispatch */
+    void pushConstants(const void* data, GLsizeiptr size);
+
+    GLProfiler& profiler() { return *m_profiler; }
+    GLUniformRing& uniformRing() { return *m_uniformRing; }
+    /* Invalidated at the start of every frame */
+    GLStateCache& state() { return m_state; }
+    const GLExtensions& extensions() const { return m_extensions; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    GLFWwindow* window() const { return m_window; }
+
+    void report(Report& report) const;
+
+private:
+    /* Ends the pending frames whose swap fence is signaled */
+    void pollLatency();
+
+    GLFWwindow* m_window;
+    int m_swapInterval = 1;
+    int m_width = 0;
+    int m_height = 0;
+    GLuint m_pushConstants = 0;
+    GLExtensions m_extensions;
+    GLStateCache m_state;
+    std::unique_ptr<GLProfiler> m_profiler;
+    std::unique_ptr<GLUniformRing> m_uniformRing;
+    FrameLatency m_latency;
+    uint64_t m_latencyFrame = 0;
+    /* Fence after the swap of every pending frame, indexed by id % FrameLatency::kMaxPending */
+    GLsync m_swapFences[FrameLatency::kMaxPending] = {};
+};
+
+GLuint createShader(GLenum stage, const std::string& path, const ShaderDefines& defines = {});
+/*
+ * Compiles the shader to SPIR-V, from the embedded variant or with shaderc at runtime, and sets
+ * specialization constant i (constant_id = i) to constants[i] with glSpecializeShader.
+ */
+GLuint createSpecializedShader(GLenum stage, const std::string& path, const ShaderDefines& defines, const uint32_t* constants, uint32_t constantCount);
+/* `retrievableBinary` sets GL_PROGRAM_BINARY_RETRIEVABLE_HINT, without it some drivers report a binary length of 0 */
+GLuint linkProgram(const GLuint* shaders, uint32_t count, bool retrievableBinary = false);
+GLuint createProgram(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = {});
+/*
+ * Compiles and links like createProgram() without waiting for the result. With
+ * KHR_parallel_shader_compile the driver works on the program in the background and
+ * programCompleted() polls it, finishProgram() checks the link status and blocks if it is not
+ * completed yet.
+ */
+GLuint startProgram(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = {});
+bool programCompleted(GLuint program);
+void finishProgram(GLuint program);
+GLuint createComputeProgram(const std::string& path, const ShaderDefines& defines = {});
+GLuint createBuffer(GLsizeiptr size, const void* data, GLbitfield flags);
@@ -0,0 +1,46 @@
+#include "GLExtensions.h"
+
+#include <cstring>
+
+#include "GLFW/glfw3.h"
+
+namespace
+{
+    template <typename Function>
+    bool loadFunction(Function& function, const char* name)
+    {
+        function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+        return function != nullptr;
+    }
+}
+
+bool hasGLExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+        if (std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i))), name) == 0)
+            return true;
+    return false;
+}
+
+GLExtensions loadGLExtensions()
+{
+    GLExtensions extensions;
+
+    if (hasGLExtension("GL_ARB_bindless_texture"))
+    {
+        extensions.bindlessTexture = loadFunction(extensions.getTextureHandleARB, "glGetTextureHandleARB")
+                                  && loadFunction(extensions.makeTextureHandleResidentARB, "glMakeTextureHandleResidentARB")
+                                  && loadFunction(extensions.makeTextureHandleNonResidentARB, "glMakeTextureHandleNonResidentARB");
+    }
+
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        extensions.parallelShaderCompile = loadFunction(extensions.maxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsKHR");
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        extensions.parallelShaderCompile = loadFunction(extensions.maxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsARB");
+
+    extensions.shaderViewportLayerArray = hasGLExtension("GL_ARB_shader_viewport_layer_array");
+
+    return extensions;
+}
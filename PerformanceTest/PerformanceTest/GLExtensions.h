@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/*
+ * Extensions outside the generated glad loader, which only covers OpenGL 4.6 core. The entry
+ * points are loaded through GLFW after the context was created, see GLContext::extensions().
+ */
+
+/* ARB_bindless_texture */
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+/* KHR_parallel_shader_compile, same tokens as the ARB version */
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+struct GLExtensions
+{
+    bool bindlessTexture = false;
+    PFNGLGETTEXTUREHANDLEARBPROC getTextureHandleARB = nullptr;
+    PFNGLMAKETEXTUREHANDLERESIDENTARBPROC makeTextureHandleResidentARB = nullptr;
+    PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC makeTextureHandleNonResidentARB = nullptr;
+
+    /* KHR or ARB_parallel_shader_compile, GL_COMPLETION_STATUS_KHR can be queried when set */
+    bool parallelShaderCompile = false;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreadsKHR = nullptr;
+
+    /* ARB_shader_viewport_layer_array, vertex shaders can write gl_Layer */
+    bool shaderViewportLayerArray = false;
+};
+
+/* Needs a current context */
+bool hasGLExtension(const char* name);
+GLExtensions loadGLExtensions();
@@ -0,0 +1,53 @@
+#include "GLProgramLoader.h"
+
+#include <thread>
+
+#include "Benchmark.h"
+#include "GLContext.h"
+
+GLProgramLoader::GLProgramLoader(const GLExtensions& extensions, bool parallel, uint32_t threads)
+    : m_parallel(parallel)
+{
+    if (m_parallel && !extensions.parallelShaderCompile)
+        fatal("Parallel program loading needs KHR_parallel_shader_compile");
+
+    /* The compiler threads are global state, 0 turns them off for the serial measurement */
+    if (extensions.parallelShaderCompile)
+        extensions.maxShaderCompilerThreadsKHR(m_parallel ? (threads ? threads : 0xFFFFFFFFu) : 0);
+}
+
+uint32_t GLProgramLoader::add(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines)
+{
+    uint32_t index = uint32_t(m_programs.size());
+    if (m_parallel)
+    {
+        m_programs.push_back(startProgram(vertexPath, fragmentPath, defines));
+        m_pending.push_back(index);
+    }
+    else
+        m_programs.push_back(createProgram(vertexPath, fragmentPath, defines));
+    return index;
+}
+
+bool GLProgramLoader::poll()
+{
+    for (size_t i = 0; i < m_pending.size();)
+    {
+        GLuint program = m_programs[m_pending[i]];
+        if (programCompleted(program))
+        {
+            finishProgram(program);
+            m_pending[i] = m_pending.back();
+            m_pending.pop_back();
+        }
+        else
+            ++i;
+    }
+    return m_pending.empty();
+}
+
+void GLProgramLoader::finish()
+{
+    while (!poll())
+        std::this_thread::yield();
+}
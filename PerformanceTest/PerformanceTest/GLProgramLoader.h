@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "ShaderSource.h"
+
+/*
+ * Loads a batch of programs. In parallel mode every program is submitted without waiting and
+ * the driver's compiler threads (glMaxShaderCompilerThreadsKHR) work on them while poll()
+ * checks GL_COMPLETION_STATUS_KHR, so the calling thread only blocks where it chooses to.
+ * Otherwise each add() compiles and links before it returns, the way createProgram() does.
+ */
+class GLProgramLoader
+{
+public:
+    /* Parallel mode needs KHR_parallel_shader_compile, `threads` 0 leaves the count to the driver */
+    GLProgramLoader(const GLExtensions& extensions, bool parallel, uint32_t threads = 0);
+
+    /* Returns the index of the program */
+    uint32_t add(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = {});
+    /* Checks the outstanding programs without blocking, true once all of them are linked */
+    bool poll();
+    /* Polls until all programs are linked */
+    void finish();
+
+    bool parallel() const { return m_parallel; }
+    uint32_t pendingCount() const { return uint32_t(m_pending.size()); }
+    /* The program may still be compiling until poll() returned true */
+    GLuint program(uint32_t index) const { return m_programs[index]; }
+    const std::vector<GLuint>& programs() const { return m_programs; }
+
+private:
+    bool m_parallel;
+    std::vector<GLuint> m_programs;
+    /* Indices of the programs not completed yet */
+    std::vector<uint32_t> m_pending;
+};
@@ -0,0 +1,74 @@
+#include "GLRenderGraph.h"
+
+GLRenderGraph::GLRenderGraph(GLStateCache& state, RenderTargetPooling pooling, RenderGraphBarriers barriers)
+    : RenderGraph(barriers)
+    , m_pool(state, pooling)
+{
+}
+
+uint32_t GLRenderGraph::addPass(const char* name, std::function<void()> callback)
+{
+    /* Drops the callbacks of the passes before the last reset() */
+    m_callbacks.resize(m_passes.size());
+    m_callbacks.push_back(std::move(callback));
+    return RenderGraph::addPass(name);
+}
+
+GLbitfield GLRenderGraph::barrierBits(const Pass& pass) const
+{
+    if (m_barriers == RenderGraphBarriers::Full)
+        return GL_ALL_BARRIER_BITS;
+
+    GLbitfield bits = 0;
+    for (uint32_t b = pass.firstBarrier; b < pass.firstBarrier + pass.barrierCount; ++b)
+    {
+        const Barrier& barrier = m_barrierList[b];
+        if (!(barrier.srcAccesses & renderGraphAccessBit(RenderGraphAccess::StorageWriteCompute)))
+            continue;
+        bool buffer = m_resources[barrier.resource].imported;
+        uint32_t dst = barrier.dstAccesses;
+        if (dst & (renderGraphAccessBit(RenderGraphAccess::SampledGraphics) | renderGraphAccessBit(RenderGraphAccess::SampledCompute)))
+            bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+        if (dst & (renderGraphAccessBit(RenderGraphAccess::StorageReadGraphics) | renderGraphAccessBit(RenderGraphAccess::StorageReadCompute) |
+                   renderGraphAccessBit(RenderGraphAccess::StorageWriteCompute)))
+            bits |= buffer ? GL_SHADER_STORAGE_BARRIER_BIT : GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+        if (dst & (renderGraphAccessBit(RenderGraphAccess::ColorAttachment) | renderGraphAccessBit(RenderGraphAccess::DepthAttachment)))
+            bits |= GL_FRAMEBUFFER_BARRIER_BIT;
+        if (dst & renderGraphAccessBit(RenderGraphAccess::IndirectRead))
+            bits |= GL_COMMAND_BARRIER_BIT;
+    }
+    return bits;
+}
+
+void GLRenderGraph::execute()
+{
+    for (uint32_t p : m_order)
+    {
+        const Pass& pass = m_passes[p];
+        GLbitfield bits = barrierBits(pass);
+        if (bits)
+            glMemoryBarrier(bits);
+
+        bool attachments = !pass.ownRenderPass && (pass.colorCount > 0 || pass.depth != kNoResource);
+        if (attachments)
+        {
+            uint32_t colors[kMaxColorAttachments];
+            for (uint32_t i = 0; i < pass.colorCount; ++i)
+                colors[i] = target(pass.colors[i]);
+            uint32_t depth = pass.depth == kNoResource ? RenderTargetPool::kNoTarget : target(pass.depth);
+            m_pool.beginPass(colors, pass.colorCount, depth, pass.clearColor, loadMask(pass));
+        }
+        m_callbacks[p]();
+        if (attachments)
+            m_pool.endPass();
+    }
+}
+
+void GLRenderGraph::report(Report& report)
+{
+    RenderGraph::report(report);
+    uint32_t calls = 0;
+    for (uint32_t p : m_order)
+        calls += barrierBits(m_passes[p]) ? 1 : 0;
+    report.addValue("glMemoryBarrier calls per frame", double(calls), "");
+}
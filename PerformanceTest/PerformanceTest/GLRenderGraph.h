@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLRenderTargetPool.h"
+#include "RenderGraph.h"
+
+/*
+ * OpenGL execution of a RenderGraph. The driver tracks attachment and texture hazards on its
+ * own, only incoherent shader writes, image stores and SSBO writes, need a glMemoryBarrier
+ * before they are read. The planned barriers are reduced to one call per pass with the bits of
+ * the accesses that follow such a write. --barriers full issues GL_ALL_BARRIER_BITS before
+ * every pass instead.
+ */
+class GLRenderGraph : public RenderGraph
+{
+public:
+    GLRenderGraph(GLStateCache& state, RenderTargetPooling pooling, RenderGraphBarriers barriers);
+
+    /* The callback runs with the attachments bound, cleared or loaded and the viewport set, unless the pass has its own render pass */
+    uint32_t addPass(const char* name, std::function<void()> callback);
+    void execute();
+
+    GLRenderTargetPool& targets() { return m_pool; }
+    /* Texture of a graph texture, 0 for transient ones */
+    GLuint texture(uint32_t texture) const { return m_pool.texture(target(texture)); }
+
+    void report(Report& report) override;
+
+private:
+    RenderTargetPool& pool() override { return m_pool; }
+    GLbitfield barrierBits(const Pass& pass) const;
+
+    GLRenderTargetPool m_pool;
+    std::vector<std::function<void()>> m_callbacks;
+};
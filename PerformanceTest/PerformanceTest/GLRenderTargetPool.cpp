@@ -0,0 +1,216 @@
+#include "GLRenderTargetPool.h"
+
+#include <cstdio>
+
+namespace
+{
+    RenderTargetPooling glPooling(RenderTargetPooling pooling)
+    {
+        if (pooling != RenderTargetPooling::Alias)
+            return pooling;
+        std::printf("render targets: OpenGL can not alias texture memory, falling back to reuse\n");
+        return RenderTargetPooling::Reuse;
+    }
+}
+
+GLRenderTargetPool::GLRenderTargetPool(GLStateCache& state, RenderTargetPooling pooling)
+    : RenderTargetPool(glPooling(pooling))
+    , m_state(state)
+{
+}
+
+GLRenderTargetPool::~GLRenderTargetPool()
+{
+    release();
+}
+
+GLenum GLRenderTargetPool::internalFormat(RenderTargetFormat format)
+{
+    switch (format)
+    {
+    case RenderTargetFormat::RGBA8:
+        return GL_RGBA8;
+    case RenderTargetFormat::RGBA16F:
+        return GL_RGBA16F;
+    case RenderTargetFormat::R11G11B10F:
+        return GL_R11F_G11F_B10F;
+    case RenderTargetFormat::Depth32F:
+        return GL_DEPTH_COMPONENT32F;
+    }
+    return GL_RGBA8;
+}
+
+GLuint GLRenderTargetPool::texture(uint32_t handle) const
+{
+    const Target& physical = target(handle);
+    return physical.renderbuffer ? 0 : physical.name;
+}
+
+GLuint GLRenderTargetPool::framebuffer(std::initializer_list<uint32_t> colors, uint32_t depth)
+{
+    return framebuffer(colors.begin(), uint32_t(colors.size()), depth);
+}
+
+GLuint GLRenderTargetPool::framebuffer(const uint32_t* colors, uint32_t colorCount, uint32_t depth)
+{
+    if (colorCount > Framebuffer::kMaxColors)
+        fatal("Framebuffer with %u color attachments, at most %u are supported", colorCount, Framebuffer::kMaxColors);
+
+    Framebuffer key = {};
+    for (uint32_t i = 0; i < colorCount; ++i)
+        key.colors[key.colorCount++] = m_physical[colors[i]];
+    key.depth = depth == kNoTarget ? kNoTarget : m_physical[depth];
+    for (const Framebuffer& framebuffer : m_framebuffers)
+    {
+        if (framebuffer.colorCount != key.colorCount || framebuffer.depth != key.depth)
+            continue;
+        bool same = true;
+        for (uint32_t i = 0; i < key.colorCount; ++i)
+            same = same && framebuffer.colors[i] == key.colors[i];
+        if (same)
+            return framebuffer.framebuffer;
+    }
+
+    glCreateFramebuffers(1, &key.framebuffer);
+    GLenum drawBuffers[Framebuffer::kMaxColors];
+    for (uint32_t i = 0; i < key.colorCount; ++i)
+    {
+        const Target& color = m_targets[key.colors[i]];
+        if (color.renderbuffer)
+            glNamedFramebufferRenderbuffer(key.framebuffer, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER, color.name);
+        else
+            glNamedFramebufferTexture(key.framebuffer, GL_COLOR_ATTACHMENT0 + i, color.name, 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glNamedFramebufferDrawBuffers(key.framebuffer, GLsizei(key.colorCount), drawBuffers);
+    if (key.depth != kNoTarget)
+    {
+        const Target& depthTarget = m_targets[key.depth];
+        if (depthTarget.renderbuffer)
+            glNamedFramebufferRenderbuffer(key.framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthTarget.name);
+        else
+            glNamedFramebufferTexture(key.framebuffer, GL_DEPTH_ATTACHMENT, depthTarget.name, 0);
+    }
+    if (glCheckNamedFramebufferStatus(key.framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        fatal("render targets: incomplete framebuffer");
+    m_framebuffers.push_back(key);
+    return key.framebuffer;
+}
+
+void GLRenderTargetPool::beginPass(std::initializer_list<uint32_t> colors, uint32_t depth, const float clearColor[4])
+{
+    beginPass(colors.begin(), uint32_t(colors.size()), depth, clearColor, 0);
+}
+
+void GLRenderTargetPool::beginPass(const uint32_t* colors, uint32_t colorCount, uint32_t depth, const float clearColor[4], uint32_t loadMask)
+{
+    m_bound = framebuffer(colors, colorCount, depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_bound);
+
+    const RenderTargetDesc& size = this->desc(colorCount > 0 ? colors[0] : depth);
+    glViewport(0, 0, GLsizei(size.width), GLsizei(size.height));
+
+    m_invalidateCount = 0;
+    for (uint32_t i = 0; i < colorCount; ++i)
+    {
+        if (!(loadMask & (1u << i)))
+            glClearNamedFramebufferfv(m_bound, GL_COLOR, GLint(i), clearColor);
+        if (desc(colors[i]).transient)
+            m_invalidate[m_invalidateCount++] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (depth != kNoTarget)
+    {
+        if (!(loadMask & (1u << colorCount)))
+        {
+            const float clearDepth = 1.0f;
+            m_state.depthMask(true);
+            glClearNamedFramebufferfv(m_bound, GL_DEPTH, 0, &clearDepth);
+        }
+        if (desc(depth).transient)
+            m_invalidate[m_invalidateCount++] = GL_DEPTH_ATTACHMENT;
+    }
+}
+
+void GLRenderTargetPool::endPass()
+{
+    if (m_invalidateCount > 0)
+        glInvalidateNamedFramebufferData(m_bound, GLsizei(m_invalidateCount), m_invalidate);
+    m_invalidateCount = 0;
+}
+
+void GLRenderTargetPool::report(Report& report) const
+{
+    RenderTargetPool::report(report);
+    report.addValue("render target framebuffers", double(m_framebuffers.size()), "");
+}
+
+void GLRenderTargetPool::release()
+{
+    for (const Framebuffer& framebuffer : m_framebuffers)
+        glDeleteFramebuffers(1, &framebuffer.framebuffer);
+    m_framebuffers.clear();
+    for (const Target& target : m_targets)
+    {
+        if (target.renderbuffer)
+            glDeleteRenderbuffers(1, &target.name);
+        else
+            glDeleteTextures(1, &target.name);
+    }
+    m_targets.clear();
+}
+
+RenderTargetPool::Allocation GLRenderTargetPool::create()
+{
+    Allocation allocation;
+    uint32_t count = uint32_t(m_declarations.size());
+    if (m_pooling == RenderTargetPooling::Reuse)
+    {
+        count = assignPhysicalTargets(m_declarations, m_physical);
+    }
+    else
+    {
+        m_physical.resize(m_declarations.size());
+        for (uint32_t i = 0; i < m_declarations.size(); ++i)
+            m_physical[i] = i;
+    }
+
+    /* The first declaration on a physical target describes it, the others have the same desc */
+    m_targets.assign(count, {});
+    std::vector<bool> created(count, false);
+    for (uint32_t i = 0; i < m_declarations.size(); ++i)
+    {
+        const RenderTargetDesc& desc = m_declarations[i].desc;
+        allocation.unpooledBytes += renderTargetSize(desc);
+        uint32_t physical = m_physical[i];
+        if (created[physical])
+            continue;
+        created[physical] = true;
+        allocation.bytes += renderTargetSize(desc);
+
+        Target& target = m_targets[physical];
+        GLenum format = internalFormat(desc.format);
+        if (desc.transient)
+        {
+            target.renderbuffer = true;
+            glCreateRenderbuffers(1, &target.name);
+            glNamedRenderbufferStorageMultisample(target.name, GLsizei(desc.samples > 1 ? desc.samples : 0), format,
+                                                  GLsizei(desc.width), GLsizei(desc.height));
+        }
+        else if (desc.samples > 1)
+        {
+            glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &target.name);
+            glTextureStorage2DMultisample(target.name, GLsizei(desc.samples), format, GLsizei(desc.width), GLsizei(desc.height), GL_TRUE);
+        }
+        else
+        {
+            glCreateTextures(GL_TEXTURE_2D, 1, &target.name);
+            glTextureStorage2D(target.name, 1, format, GLsizei(desc.width), GLsizei(desc.height));
+            glTextureParameteri(target.name, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(target.name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(target.name, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(target.name, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+    }
+    allocation.physicalTargets = count;
+    return allocation;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+#include "RenderTargetPool.h"
+
+/*
+ * OpenGL render targets: textures, transient targets are renderbuffers since they are never
+ * sampled. OpenGL has no way to place two textures in the same memory, --pooling alias falls
+ * back to reuse. Framebuffer objects are cached per attachment combination and live as long as
+ * the targets they were made from, the way an engine reuses its FBOs across frames.
+ */
+class GLRenderTargetPool : public RenderTargetPool
+{
+public:
+    /* Clearing depth goes through `state` to enable depth writes */
+    GLRenderTargetPool(GLStateCache& state, RenderTargetPooling pooling);
+    ~GLRenderTargetPool() override;
+
+    static GLenum internalFormat(RenderTargetFormat format);
+
+    /* 0 for transient targets */
+    GLuint texture(uint32_t handle) const;
+    /* Cached until the next allocation that changes the targets */
+    GLuint framebuffer(std::initializer_list<uint32_t> colors, uint32_t depth = kNoTarget);
+    GLuint framebuffer(const uint32_t* colors, uint32_t colorCount, uint32_t depth);
+
+    /* Binds the framebuffer, sets the viewport to the size of the targets and clears them */
+    void beginPass(std::initializer_list<uint32_t> colors, uint32_t depth, const float clearColor[4]);
+    /* Bit i of `loadMask` keeps color attachment i, bit `colorCount` the depth attachment */
+    void beginPass(const uint32_t* colors, uint32_t colorCount, uint32_t depth, const float clearColor[4], uint32_t loadMask);
+    /* Invalidates the transient attachments of the bound framebuffer, their contents are not needed anymore */
+    void endPass();
+
+    bool sharesMemory(uint32_t a, uint32_t b) const override { return m_physical[a] == m_physical[b]; }
+    void report(Report& report) const override;
+
+private:
+    struct Target
+    {
+        GLuint name = 0;
+        bool renderbuffer = false;
+    };
+
+    struct Framebuffer
+    {
+        static constexpr uint32_t kMaxColors = 8;
+        uint32_t colors[kMaxColors];
+        uint32_t colorCount;
+        uint32_t depth;
+        GLuint framebuffer;
+    };
+
+    void release() override;
+    Allocation create() override;
+    const Target& target(uint32_t handle) const { return m_targets[m_physical[handle]]; }
+
+    GLStateCache& m_state;
+    std::vector<Target> m_targets;
+    /* Physical target of every declaration */
+    std::vector<uint32_t> m_physical;
+    /* Keyed by physical targets, a pass looked up by declarations finds the framebuffer of an earlier pass on the same targets */
+    std::vector<Framebuffer> m_framebuffers;
+    /* Attachments of the framebuffer bound by beginPass() that endPass() invalidates */
+    GLenum m_invalidate[Framebuffer::kMaxColors + 1] = {};
+    uint32_t m_invalidateCount = 0;
+    GLuint m_bound = 0;
+};
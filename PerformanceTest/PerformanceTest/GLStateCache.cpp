@@ -0,0 +1,141 @@
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Benchmark.h"
+
+void GLStateCache::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    invalidate();
+}
+
+void GLStateCache::invalidate()
+{
+    m_programKnown = false;
+    m_vertexArrayKnown = false;
+    std::fill(std::begin(m_texturesKnown), std::end(m_texturesKnown), false);
+    std::fill(std::begin(m_uniformBuffersKnown), std::end(m_uniformBuffersKnown), false);
+    std::fill(std::begin(m_storageBuffersKnown), std::end(m_storageBuffersKnown), false);
+    m_blendKnown = false;
+    m_blendFuncKnown = false;
+    m_depthTestKnown = false;
+    m_depthFuncKnown = false;
+    m_depthMaskKnown = false;
+    m_cullFaceKnown = false;
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (change(m_program, program, m_programKnown))
+        glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (change(m_vertexArray, vertexArray, m_vertexArrayKnown))
+        glBindVertexArray(vertexArray);
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    bool* known = nullptr;
+    BufferBinding* slot = bufferSlot(target, index, known);
+    /* A size of 0 stands for the whole buffer */
+    if (!slot || changeBuffer(*slot, { buffer, 0, 0 }, *known))
+        glBindBufferBase(target, index, buffer);
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    bool* known = nullptr;
+    BufferBinding* slot = bufferSlot(target, index, known);
+    if (!slot || changeBuffer(*slot, { buffer, offset, size }, *known))
+        glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLStateCache::bindTextureUnit(GLuint unit, GLuint texture)
+{
+    if (unit >= kTextureUnits)
+    {
+        ++m_counters.issued;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+    if (change(m_textures[unit], texture, m_texturesKnown[unit]))
+        glBindTextureUnit(unit, texture);
+}
+
+void GLStateCache::setBlend(bool enabled)
+{
+    setCapability(GL_BLEND, enabled, m_blend, m_blendKnown);
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+    if (change(m_blendFunc, std::make_pair(source, destination), m_blendFuncKnown))
+        glBlendFunc(source, destination);
+}
+
+void GLStateCache::setDepthTest(bool enabled)
+{
+    setCapability(GL_DEPTH_TEST, enabled, m_depthTest, m_depthTestKnown);
+}
+
+void GLStateCache::depthFunc(GLenum function)
+{
+    if (change(m_depthFunc, function, m_depthFuncKnown))
+        glDepthFunc(function);
+}
+
+void GLStateCache::depthMask(bool write)
+{
+    if (change(m_depthMask, write, m_depthMaskKnown))
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::setCullFace(bool enabled)
+{
+    setCapability(GL_CULL_FACE, enabled, m_cullFace, m_cullFaceKnown);
+}
+
+bool GLStateCache::changeBuffer(BufferBinding& shadow, const BufferBinding& value, bool& known)
+{
+    if (m_enabled && known && shadow.buffer == value.buffer && shadow.offset == value.offset && shadow.size == value.size)
+    {
+        ++m_counters.skipped;
+        return false;
+    }
+    shadow = value;
+    known = true;
+    ++m_counters.issued;
+    return true;
+}
+
+GLStateCache::BufferBinding* GLStateCache::bufferSlot(GLenum target, GLuint index, bool*& known)
+{
+    /* Untracked targets and indices are always issued */
+    if (index < kBufferBindings && target == GL_UNIFORM_BUFFER)
+    {
+        known = &m_uniformBuffersKnown[index];
+        return &m_uniformBuffers[index];
+    }
+    if (index < kBufferBindings && target == GL_SHADER_STORAGE_BUFFER)
+    {
+        known = &m_storageBuffersKnown[index];
+        return &m_storageBuffers[index];
+    }
+    ++m_counters.issued;
+    return nullptr;
+}
+
+void GLStateCache::setCapability(GLenum capability, bool enabled, bool& shadow, bool& known)
+{
+    if (!change(shadow, enabled, known))
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include <glad/glad.h>
+
+/*
+ * Shadows the GL state that draw loops change most and drops calls that would set the value
+ * that is already current. Only state changed through the cache is tracked: invalidate() after
+ * anything else touched it, GLContext does so at the start of every frame. Disabled, every call
+ * is forwarded, which makes the redundant share of an unsorted draw loop measurable.
+ */
+class GLStateCache
+{
+public:
+    static constexpr uint32_t kTextureUnits = 16;
+    static constexpr uint32_t kBufferBindings = 16;
+
+    struct Counters
+    {
+        uint64_t issued = 0;
+        uint64_t skipped = 0;
+    };
+
+    void setEnabled(bool enabled);
+    bool enabled() const { return m_enabled; }
+    /* Forgets every shadowed value, the next call of each kind is issued */
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    /* GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER bindings, whole buffer */
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    void bindTextureUnit(GLuint unit, GLuint texture);
+
+    void setBlend(bool enabled);
+    void blendFunc(GLenum source, GLenum destination);
+    void setDepthTest(bool enabled);
+    void depthFunc(GLenum function);
+    void depthMask(bool write);
+    void setCullFace(bool enabled);
+
+    const Counters& counters() const { return m_counters; }
+    void resetCounters() { m_counters = {}; }
+
+private:
+    struct BufferBinding
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    /* Returns whether the call has to be issued and updates the shadow value */
+    template <typename T>
+    bool change(T& shadow, const T& value, bool& known)
+    {
+        if (m_enabled && known && shadow == value)
+        {
+            ++m_counters.skipped;
+            return false;
+        }
+        shadow = value;
+        known = true;
+        ++m_counters.issued;
+        return true;
+    }
+
+    bool changeBuffer(BufferBinding& shadow, const BufferBinding& value, bool& known);
+    BufferBinding* bufferSlot(GLenum target, GLuint index, bool*& known);
+    void setCapability(GLenum capability, bool enabled, bool& shadow, bool& known);
+
+    bool m_enabled = true;
+    Counters m_counters;
+
+    GLuint m_program = 0;
+    GLuint m_vertexArray = 0;
+    GLuint m_textures[kTextureUnits] = {};
+    BufferBinding m_uniformBuffers[kBufferBindings] = {};
+    BufferBinding m_storageBuffers[kBufferBindings] = {};
+    bool m_blend = false;
+    /* Source and destination factor */
+    std::pair<GLenum, GLenum> m_blendFunc = { GL_ONE, GL_ZERO };
+    bool m_depthTest = false;
+    GLenum m_depthFunc = GL_LESS;
+    bool m_depthMask = true;
+    bool m_cullFace = false;
+
+    /* Nothing is known until it was set through the cache once */
+    bool m_programKnown = false;
+    bool m_vertexArrayKnown = false;
+    bool m_texturesKnown[kTextureUnits] = {};
+    bool m_uniformBuffersKnown[kBufferBindings] = {};
+    bool m_storageBuffersKnown[kBufferBindings] = {};
+    bool m_blendKnown = false;
+    bool m_blendFuncKnown = false;
+    bool m_depthTestKnown = false;
+    bool m_depthFuncKnown = false;
+    bool m_depthMaskKnown = false;
+    bool m_cullFaceKnown = false;
+};
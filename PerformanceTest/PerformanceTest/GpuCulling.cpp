@@ -0,0 +1,203 @@
+#include "GpuCulling.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Random.h"
+#include "Timer.h"
+
+const float kCubeVertices[8 * 3] = {
+    -1, -1, -1,
+     1, -1, -1,
+    -1,  1, -1,
+     1,  1, -1,
+    -1, -1,  1,
+     1, -1,  1,
+    -1,  1,  1,
+     1,  1,  1,
+};
+
+/* Counter clockwise seen from outside */
+const uint32_t kCubeIndices[36] = {
+    5, 1, 3, 5, 3, 7,
+    0, 4, 6, 0, 6, 2,
+    6, 7, 3, 6, 3, 2,
+    0, 1, 5, 0, 5, 4,
+    4, 5, 7, 4, 7, 6,
+    1, 0, 2, 1, 2, 3,
+};
+
+namespace
+{
+    const float kSpacing = 3.0f;
+
+    uint32_t citySide(uint32_t instanceCount)
+    {
+        return std::max(1u, uint32_t(std::ceil(std::sqrt(double(instanceCount)))));
+    }
+
+    uint32_t floorPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result * 2 <= value)
+            result *= 2;
+        return result;
+    }
+
+    CullingMode parseMode(const std::string& mode)
+    {
+        if (mode == "none")
+            return CullingMode::None;
+        if (mode == "cpu")
+            return CullingMode::Cpu;
+        if (mode == "gpu")
+            return CullingMode::Gpu;
+        fatal("Unknown --culling mode '%s', expected gpu, cpu or none", mode.c_str());
+    }
+
+    const char* modeName(CullingMode mode)
+    {
+        switch (mode)
+        {
+        case CullingMode::None: return "none";
+        case CullingMode::Cpu: return "cpu";
+        default: return "gpu";
+        }
+    }
+
+    CullingVolume parseVolume(const std::string& volume)
+    {
+        if (volume == "sphere")
+            return CullingVolume::Sphere;
+        if (volume == "box")
+            return CullingVolume::Box;
+        fatal("Unknown --cull-volume '%s', expected sphere or box", volume.c_str());
+    }
+}
+
+GpuCullingScenario::GpuCullingScenario(const Options& options, uint32_t width, uint32_t height)
+    : m_mode(parseMode(options.getString("culling", "gpu")))
+    , m_occlusion(options.getBool("occlusion", true))
+    , m_cullVolume(parseVolume(options.getString("cull-volume", "sphere")))
+    , m_cullKernel(selectCullingKernel(options.getString("cull-kernel", "auto")))
+{
+    uint32_t count = uint32_t(options.getInt("instances", 100000));
+    if (count == 0)
+        fatal("--instances has to be at least 1");
+
+    uint32_t side = citySide(count);
+    float offset = float(side) * kSpacing * 0.5f;
+    uint32_t state = 0x9E3779B9u;
+    m_scene.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        /* A unit cube scaled to the box, so the world bounds are the box itself */
+        SceneInstanceDesc desc;
+        desc.scale = { 0.4f + random01(state) * 0.8f, 0.5f + random01(state) * 3.5f, 0.4f + random01(state) * 0.8f };
+        desc.position = { float(i % side) * kSpacing - offset, desc.scale.y, float(i / side) * kSpacing - offset };
+        m_scene.create(desc);
+    }
+    m_scene.updateWorld(selectMathKernels("auto"), 0, count);
+
+    /* The scene never changes, the GPU gets the world bounds once in dense order */
+    const CullingBounds& bounds = m_scene.bounds();
+    m_instances.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_instances[i].center = { bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i], bounds.radius[i] };
+        m_instances[i].extents = { bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i], 0.0f };
+    }
+
+    /* Without culling every instance is drawn through the same visible index indirection */
+    m_visible.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        m_visible[i] = i;
+    m_visibleIndices = m_visible.data();
+    m_visibleCount = count;
+
+    resize(width, height);
+    m_uniforms.instanceCount = count;
+    m_uniforms.occlusionEnabled = m_occlusion ? 1 : 0;
+
+    if (m_mode == CullingMode::Cpu)
+        m_jobs = std::make_unique<JobSystem>(uint32_t(options.getInt("threads", 0)));
+
+    std::printf("gpu-culling: %u instances, culling %s, occlusion %s\n", count, modeName(m_mode),
+                m_mode == CullingMode::Gpu && m_occlusion ? "on" : "off");
+    if (m_jobs)
+        std::printf("gpu-culling: %s kernel on %u threads\n", m_cullKernel.name, m_jobs->threadCount());
+}
+
+void GpuCullingScenario::resize(uint32_t width, uint32_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_pyramidWidth = floorPowerOfTwo(width);
+    m_pyramidHeight = floorPowerOfTwo(height);
+    m_pyramidLevels = 1;
+    while ((std::max(m_pyramidWidth, m_pyramidHeight) >> m_pyramidLevels) > 0)
+        ++m_pyramidLevels;
+    m_uniforms.pyramidSize = { float(m_pyramidWidth), float(m_pyramidHeight), float(m_pyramidLevels), 0.0f };
+}
+
+void GpuCullingScenario::update(const FrameInfo& frame)
+{
+    uint32_t side = citySide(uint32_t(m_instances.size()));
+    float extent = float(side) * kSpacing;
+
+    /* Flies a circle through the streets at roof height, one revolution every ~50 seconds at 60 fps */
+    float angle = float(frame.index) * 0.002f;
+    float radius = extent * 0.3f;
+    Vec3 eye = { std::cos(angle) * radius, 5.0f, std::sin(angle) * radius };
+    Vec3 target = { std::cos(angle + 0.2f) * radius, 3.0f, std::sin(angle + 0.2f) * radius };
+
+    Mat4 projection = perspective(1.0f, float(m_width) / float(m_height), 0.5f, extent * 1.5f);
+    Mat4 viewProj = projection * lookAt(eye, target, { 0.0f, 1.0f, 0.0f });
+    Frustum frustum = extractFrustum(viewProj);
+
+    m_uniforms.prevViewProj = frame.index == 0 ? viewProj : m_uniforms.viewProj;
+    m_uniforms.viewProj = viewProj;
+    for (int i = 0; i < 6; ++i)
+        m_uniforms.frustumPlanes[i] = frustum.planes[i];
+
+    if (m_mode != CullingMode::Cpu)
+        return;
+
+    cullCpu(frustum, frame);
+}
+
+void GpuCullingScenario::cullCpu(const Frustum& frustum, const FrameInfo& frame)
+{
+    Timer timer;
+    uint32_t* visibleIndices = frame.arena->allocate<uint32_t>(m_scene.size());
+    uint32_t visible = m_scene.cull(m_cullKernel, frustum, m_cullVolume, *m_jobs, visibleIndices);
+    m_visibleIndices = visibleIndices;
+    m_visibleCount = visible;
+
+    double time = timer.elapsedMs();
+    if (frame.measured)
+    {
+        m_cpuCullTimes.add(time);
+        /* instances / (ms * 1000) is million instances per second */
+        m_cpuCullRates.add(double(m_scene.size()) / (time * 1000.0 * double(m_jobs->threadCount())));
+    }
+    recordVisibleCount(visible, frame.measured);
+}
+
+void GpuCullingScenario::report(Report& report)
+{
+    if (m_jobs)
+    {
+        report.addText("cpu cull kernel", m_cullKernel.name);
+        report.addValue("cpu cull threads", double(m_jobs->threadCount()), "");
+    }
+    report.addStatistics("cpu cull", m_cpuCullTimes, "ms");
+    report.addStatistics("cpu cull rate/thread", m_cpuCullRates, "M/s");
+    report.addStatistics("visible instances", m_visibleCounts, "");
+}
+
+void GpuCullingScenario::recordVisibleCount(uint32_t count, bool measured)
+{
+    if (measured)
+        m_visibleCounts.add(double(count));
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Math.h"
+#include "Scenario.h"
+#include "Scene.h"
+
+/* A box instance, same layout as `Instance` in shaders/culling/culling.glsl */
+struct CullingInstance
+{
+    /* xyz center, w bounding sphere radius */
+    Vec4 center;
+    /* xyz half extents */
+    Vec4 extents;
+};
+
+/* std140 layout of the CullingUniforms block */
+struct CullingUniforms
+{
+    Mat4 viewProj;
+    /* The depth pyramid was rendered with last frame's camera */
+    Mat4 prevViewProj;
+    Vec4 frustumPlanes[6];
+    /* xy size of pyramid mip 0, z mip count */
+    Vec4 pyramidSize;
+    uint32_t instanceCount;
+    uint32_t occlusionEnabled;
+    uint32_t padding[2];
+};
+
+/* Same layout as VkDrawIndexedIndirectCommand and OpenGL's DrawElementsIndirectCommand */
+struct DrawIndexedIndirectCommand
+{
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+};
+
+/* Push constants of shaders/culling/depth_reduce.comp */
+struct DepthReduceParams
+{
+    int32_t sourceSize[2];
+    int32_t destinationSize[2];
+    int32_t sourceLevel;
+    int32_t padding[3];
+};
+
+enum class CullingMode
+{
+    None,
+    Cpu,
+    Gpu,
+};
+
+extern const float kCubeVertices[8 * 3];
+extern const uint32_t kCubeIndices[36];
+
+/*
+ * Backend independent part of the culling scenario: a city of boxes seen from a camera flying
+ * between them, so large parts of the scene are outside the frustum or hidden behind closer
+ * boxes. The CPU path culls here in update() with a SIMD kernel spread over the job system,
+ * the GPU path in the backend's compute pass.
+ */
+class GpuCullingScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kWorkgroupSize = 64;
+
+    GpuCullingScenario(const Options& options, uint32_t width, uint32_t height);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    void recordVisibleCount(uint32_t count, bool measured);
+    /* Sets the framebuffer size and derives the depth pyramid's size and mip count from it */
+    void resize(uint32_t width, uint32_t height);
+
+    CullingMode m_mode;
+    bool m_occlusion;
+    std::vector<CullingInstance> m_instances;
+    /* Every index into m_instances, the initial content of the visible index buffers */
+    std::vector<uint32_t> m_visible;
+    /* Visible indices of this frame, m_visible or the CPU path's output in the frame arena */
+    const uint32_t* m_visibleIndices = nullptr;
+    uint32_t m_visibleCount = 0;
+    CullingUniforms m_uniforms = {};
+
+    uint32_t m_width;
+    uint32_t m_height;
+    /* Mip 0 of the depth pyramid is the largest power of two not above the framebuffer size */
+    uint32_t m_pyramidWidth;
+    uint32_t m_pyramidHeight;
+    uint32_t m_pyramidLevels;
+
+private:
+    void cullCpu(const Frustum& frustum, const FrameInfo& frame);
+
+    /* Source of the instances, its dense indices are the indices into m_instances */
+    Scene m_scene;
+    CullingVolume m_cullVolume;
+    CullingKernelInfo m_cullKernel;
+    std::unique_ptr<JobSystem> m_jobs;
+
+    Statistics m_cpuCullTimes;
+    /* Million instances per second and thread */
+    Statistics m_cpuCullRates;
+    Statistics m_visibleCounts;
+};
+
+std::unique_ptr<Scenario> createGpuCullingScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createGpuCullingScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,221 @@
+#include "GpuCulling.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "GLContext.h"
+
+namespace
+{
+    class GpuCullingScenarioGL : public GpuCullingScenario
+    {
+    public:
+        static constexpr uint32_t kReadbackLatency = 3;
+
+        GpuCullingScenarioGL(GLContext& context, const Options& options)
+            : GpuCullingScenario(options, uint32_t(context.width()), uint32_t(context.height()))
+            , m_context(context)
+        {
+            GLsizeiptr instanceBytes = GLsizeiptr(m_instances.size() * sizeof(CullingInstance));
+            GLsizeiptr visibleBytes = GLsizeiptr(m_visible.size() * sizeof(uint32_t));
+
+            m_uniformBuffer = createBuffer(sizeof(CullingUniforms), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            m_instanceBuffer = createBuffer(instanceBytes, m_instances.data(), 0);
+            m_visibleBuffer = createBuffer(visibleBytes, m_visible.data(), GL_DYNAMIC_STORAGE_BIT);
+            m_drawBuffer = createBuffer(sizeof(DrawIndexedIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            m_readbackBuffer = createBuffer(sizeof(uint32_t) * kReadbackLatency, nullptr, GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+            m_readback = static_cast<const uint32_t*>(glMapNamedBufferRange(m_readbackBuffer, 0, sizeof(uint32_t) * kReadbackLatency,
+                                                                              GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+
+            m_vertexBuffer = createBuffer(sizeof(kCubeVertices), kCubeVertices, 0);
+            m_indexBuffer = createBuffer(sizeof(kCubeIndices), kCubeIndices, 0);
+            glCreateVertexArrays(1, &m_vertexArray);
+            glVertexArrayVertexBuffer(m_vertexArray, 0, m_vertexBuffer, 0, sizeof(float) * 3);
+            glVertexArrayAttribFormat(m_vertexArray, 0, 3, GL_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribBinding(m_vertexArray, 0, 0);
+            glEnableVertexArrayAttrib(m_vertexArray, 0);
+            glVertexArrayElementBuffer(m_vertexArray, m_indexBuffer);
+
+            /* Offscreen target, the default framebuffer's depth can not be sampled */
+            glCreateTextures(GL_TEXTURE_2D, 1, &m_colorTexture);
+            glTextureStorage2D(m_colorTexture, 1, GL_RGBA8, GLsizei(m_width), GLsizei(m_height));
+            glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+            glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, GLsizei(m_width), GLsizei(m_height));
+            glTextureParameteri(m_depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(m_depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glCreateFramebuffers(1, &m_framebuffer);
+            glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_colorTexture, 0);
+            glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+            if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                fatal("gpu-culling: incomplete framebuffer");
+
+            glCreateTextures(GL_TEXTURE_2D, 1, &m_pyramid);
+            glTextureStorage2D(m_pyramid, GLsizei(m_pyramidLevels), GL_R32F, GLsizei(m_pyramidWidth), GLsizei(m_pyramidHeight));
+            glTextureParameteri(m_pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+            glTextureParameteri(m_pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureParameteri(m_pyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(m_pyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            /* Nothing is occluded until the first frame has been rendered */
+            const float farDepth = 1.0f;
+            for (uint32_t level = 0; level < m_pyramidLevels; ++level)
+                glClearTexImage(m_pyramid, GLint(level), GL_RED, GL_FLOAT, &farDepth);
+
+            m_cullProgram = createComputeProgram("culling/cull.comp");
+            m_reduceProgram = createComputeProgram("culling/depth_reduce.comp");
+            m_drawProgram = createProgram("culling/instance.vert", "culling/instance.frag");
+        }
+
+        ~GpuCullingScenarioGL() override
+        {
+            for (GLsync fence : m_readbackFences)
+                if (fence)
+                    glDeleteSync(fence);
+            glUnmapNamedBuffer(m_readbackBuffer);
+
+            glDeleteProgram(m_cullProgram);
+            glDeleteProgram(m_reduceProgram);
+            glDeleteProgram(m_drawProgram);
+            glDeleteFramebuffers(1, &m_framebuffer);
+            GLuint textures[] = { m_colorTexture, m_depthTexture, m_pyramid };
+            glDeleteTextures(3, textures);
+            glDeleteVertexArrays(1, &m_vertexArray);
+            GLuint buffers[] = { m_uniformBuffer, m_instanceBuffer, m_visibleBuffer, m_drawBuffer, m_readbackBuffer, m_vertexBuffer, m_indexBuffer };
+            glDeleteBuffers(7, buffers);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            GLProfiler& profiler = m_context.profiler();
+
+            glNamedBufferSubData(m_uniformBuffer, 0, sizeof(CullingUniforms), &m_uniforms);
+            glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_uniformBuffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_instanceBuffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_visibleBuffer);
+
+            if (m_mode == CullingMode::Gpu)
+            {
+                profiler.begin("cull");
+                const DrawIndexedIndirectCommand command = { 36, 0, 0, 0, 0 };
+                glNamedBufferSubData(m_drawBuffer, 0, sizeof(command), &command);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_drawBuffer);
+                glBindTextureUnit(4, m_pyramid);
+                glUseProgram(m_cullProgram);
+                glDispatchCompute(GLuint((m_instances.size() + kWorkgroupSize - 1) / kWorkgroupSize), 1, 1);
+                glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+                profiler.end();
+                readVisibleCount(frame);
+            }
+            else if (m_mode == CullingMode::Cpu)
+            {
+                profiler.begin("upload");
+                glNamedBufferSubData(m_visibleBuffer, 0, GLsizeiptr(m_visibleCount * sizeof(uint32_t)), m_visibleIndices);
+                profiler.end();
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+            glViewport(0, 0, GLsizei(m_width), GLsizei(m_height));
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+            glEnable(GL_CULL_FACE);
+            glClearColor(0.55f, 0.65f, 0.8f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            profiler.begin("draw");
+            glUseProgram(m_drawProgram);
+            glBindVertexArray(m_vertexArray);
+            if (m_mode == CullingMode::Gpu)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_drawBuffer);
+                glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+            }
+            else
+                glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr, GLsizei(m_visibleCount));
+            profiler.end();
+
+            /* Unbound before the depth texture is sampled, so the reduction is no feedback loop */
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            if (m_mode == CullingMode::Gpu && m_occlusion)
+            {
+                profiler.begin("depth pyramid");
+                buildDepthPyramid();
+                profiler.end();
+            }
+
+            glBlitNamedFramebuffer(m_framebuffer, 0, 0, 0, GLint(m_width), GLint(m_height), 0, 0, GLint(m_width), GLint(m_height),
+                                   GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+
+    private:
+        void buildDepthPyramid()
+        {
+            glUseProgram(m_reduceProgram);
+            for (uint32_t level = 0; level < m_pyramidLevels; ++level)
+            {
+                DepthReduceParams params = {};
+                params.destinationSize[0] = int32_t(std::max(1u, m_pyramidWidth >> level));
+                params.destinationSize[1] = int32_t(std::max(1u, m_pyramidHeight >> level));
+                if (level == 0)
+                {
+                    params.sourceSize[0] = int32_t(m_width);
+                    params.sourceSize[1] = int32_t(m_height);
+                    glBindTextureUnit(0, m_depthTexture);
+                }
+                else
+                {
+                    params.sourceSize[0] = int32_t(std::max(1u, m_pyramidWidth >> (level - 1)));
+                    params.sourceSize[1] = int32_t(std::max(1u, m_pyramidHeight >> (level - 1)));
+                    params.sourceLevel = int32_t(level - 1);
+                    glBindTextureUnit(0, m_pyramid);
+                }
+
+                glBindImageTexture(1, m_pyramid, GLint(level), GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+                m_context.pushConstants(&params, sizeof(params));
+                glDispatchCompute(GLuint(params.destinationSize[0] + 7) / 8, GLuint(params.destinationSize[1] + 7) / 8, 1);
+                glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            }
+        }
+
+        /* The visible count is only known on the GPU, it is copied out and read kReadbackLatency frames later */
+        void readVisibleCount(const FrameInfo& frame)
+        {
+            uint32_t slot = uint32_t(frame.index % kReadbackLatency);
+            if (m_readbackFences[slot])
+            {
+                glClientWaitSync(m_readbackFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+                glDeleteSync(m_readbackFences[slot]);
+                recordVisibleCount(m_readback[slot], m_readbackMeasured[slot]);
+            }
+
+            glCopyNamedBufferSubData(m_drawBuffer, m_readbackBuffer, offsetof(DrawIndexedIndirectCommand, instanceCount),
+                                     GLintptr(slot * sizeof(uint32_t)), sizeof(uint32_t));
+            m_readbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_readbackMeasured[slot] = frame.measured;
+        }
+
+        GLContext& m_context;
+        GLuint m_uniformBuffer = 0;
+        GLuint m_instanceBuffer = 0;
+        GLuint m_visibleBuffer = 0;
+        GLuint m_drawBuffer = 0;
+        GLuint m_readbackBuffer = 0;
+        const uint32_t* m_readback = nullptr;
+        GLsync m_readbackFences[kReadbackLatency] = {};
+        bool m_readbackMeasured[kReadbackLatency] = {};
+        GLuint m_vertexBuffer = 0;
+        GLuint m_indexBuffer = 0;
+        GLuint m_vertexArray = 0;
+        GLuint m_colorTexture = 0;
+        GLuint m_depthTexture = 0;
+        GLuint m_framebuffer = 0;
+        GLuint m_pyramid = 0;
+        GLuint m_cullProgram = 0;
+        GLuint m_reduceProgram = 0;
+        GLuint m_drawProgram = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createGpuCullingScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<GpuCullingScenarioGL>(context, options);
+}
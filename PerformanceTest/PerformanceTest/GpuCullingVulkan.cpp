@@ -0,0 +1,382 @@
+#include "GpuCulling.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "VulkanContext.h"
+
+namespace
+{
+    class GpuCullingScenarioVulkan : public GpuCullingScenario
+    {
+    public:
+        static constexpr uint32_t kFrames = VulkanContext::kFramesInFlight;
+
+        GpuCullingScenarioVulkan(VulkanContext& context, const Options& options)
+            : GpuCullingScenario(options, context.swapchainExtent().width, context.swapchainExtent().height)
+            , m_context(context)
+        {
+            VkDeviceSize visibleBytes = m_visible.size() * sizeof(uint32_t);
+
+            m_instanceBuffer = context.createBuffer(m_instances.size() * sizeof(CullingInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_instances.data());
+            m_drawBuffer = context.createBuffer(sizeof(DrawIndexedIndirectCommand),
+                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+            m_vertexBuffer = context.createBuffer(sizeof(kCubeVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, kCubeVertices);
+            m_indexBuffer = context.createBuffer(sizeof(kCubeIndices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, kCubeIndices);
+
+            /* The GPU path writes the visible list on the device, the CPU path streams it from the host every frame */
+            if (m_mode == CullingMode::Gpu)
+                m_visibleBuffers[0] = context.createBuffer(visibleBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+            for (uint32_t i = 0; i < kFrames; ++i)
+            {
+                m_uniformBuffers[i] = context.createBuffer(sizeof(CullingUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                           VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+                m_readbackBuffers[i] = context.createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+                if (m_mode != CullingMode::Gpu)
+                {
+                    m_visibleBuffers[i] = context.createBuffer(visibleBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                               VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+                    std::memcpy(m_visibleBuffers[i].mapped, m_visible.data(), size_t(visibleBytes));
+                    VK_CHECK(vmaFlushAllocation(context.allocator(), m_visibleBuffers[i].allocation, 0, VK_WHOLE_SIZE));
+                }
+            }
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_NEAREST;
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+            VK_CHECK(vkCreateSampler(context.device(), &samplerInfo, vulkanHostAllocator(), &m_sampler));
+
+            createDepthPyramid();
+            createPipelines();
+            createDescriptors();
+        }
+
+        ~GpuCullingScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            vkDestroyPipeline(device, m_cullPipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_reducePipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_drawPipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_sceneLayout, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_reduceLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_sceneSetLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_reduceSetLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+
+            destroyDepthPyramid();
+
+            for (uint32_t i = 0; i < kFrames; ++i)
+            {
+                m_context.destroyBuffer(m_uniformBuffers[i]);
+                m_context.destroyBuffer(m_readbackBuffers[i]);
+                m_context.destroyBuffer(m_visibleBuffers[i]);
+            }
+            m_context.destroyBuffer(m_instanceBuffer);
+            m_context.destroyBuffer(m_drawBuffer);
+            m_context.destroyBuffer(m_vertexBuffer);
+            m_context.destroyBuffer(m_indexBuffer);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            /* recreateSwapchain() replaced the depth image the first reduce level samples */
+            VkExtent2D extent = m_context.swapchainExtent();
+            if (m_context.depthImage().view != m_depthView || extent.width != m_width || extent.height != m_height)
+                recreateDepthPyramid(extent);
+
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            VulkanProfiler& profiler = m_context.profiler();
+            uint32_t frameIndex = m_context.frameIndex();
+
+            /* The fence of this frame slot was waited on in beginFrame(), its readback is complete */
+            if (m_readbackPending[frameIndex])
+            {
+                VK_CHECK(vmaInvalidateAllocation(m_context.allocator(), m_readbackBuffers[frameIndex].allocation, 0, VK_WHOLE_SIZE));
+                recordVisibleCount(*static_cast<const uint32_t*>(m_readbackBuffers[frameIndex].mapped), m_readbackMeasured[frameIndex]);
+                m_readbackPending[frameIndex] = false;
+            }
+
+            /* No-op on host coherent memory, sequential write allocations do not have to be */
+            std::memcpy(m_uniformBuffers[frameIndex].mapped, &m_uniforms, sizeof(CullingUniforms));
+            VK_CHECK(vmaFlushAllocation(m_context.allocator(), m_uniformBuffers[frameIndex].allocation, 0, VK_WHOLE_SIZE));
+            if (m_mode == CullingMode::Cpu)
+            {
+                std::memcpy(m_visibleBuffers[frameIndex].mapped, m_visibleIndices, m_visibleCount * sizeof(uint32_t));
+                VK_CHECK(vmaFlushAllocation(m_context.allocator(), m_visibleBuffers[frameIndex].allocation, 0, VK_WHOLE_SIZE));
+            }
+
+            if (m_mode == CullingMode::Gpu)
+            {
+                profiler.begin(cmd, "cull");
+                /* Last frame's draw and readback still read the buffers that are rewritten now */
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+                const DrawIndexedIndirectCommand command = { 36, 0, 0, 0, 0 };
+                vkCmdUpdateBuffer(cmd, m_drawBuffer.buffer, 0, sizeof(command), &command);
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline);
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_sceneLayout, 0, 1, &m_sceneSets[frameIndex], 0, nullptr);
+                vkCmdDispatch(cmd, uint32_t((m_instances.size() + kWorkgroupSize - 1) / kWorkgroupSize), 1, 1);
+
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                                 VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+                VkBufferCopy region = { offsetof(DrawIndexedIndirectCommand, instanceCount), 0, sizeof(uint32_t) };
+                vkCmdCopyBuffer(cmd, m_drawBuffer.buffer, m_readbackBuffers[frameIndex].buffer, 1, &region);
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+                m_readbackPending[frameIndex] = true;
+                m_readbackMeasured[frameIndex] = frame.measured;
+                profiler.end(cmd);
+            }
+
+            const float clearColor[4] = { 0.55f, 0.65f, 0.8f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            profiler.begin(cmd, "draw");
+            VkDeviceSize vertexOffset = 0;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_drawPipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_sceneLayout, 0, 1, &m_sceneSets[frameIndex], 0, nullptr);
+            vkCmdBindVertexBuffers(cmd, 0, 1, &m_vertexBuffer.buffer, &vertexOffset);
+            vkCmdBindIndexBuffer(cmd, m_indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+            if (m_mode == CullingMode::Gpu)
+                vkCmdDrawIndexedIndirect(cmd, m_drawBuffer.buffer, 0, 1, sizeof(DrawIndexedIndirectCommand));
+            else
+                vkCmdDrawIndexed(cmd, 36, m_visibleCount, 0, 0, 0);
+            profiler.end(cmd);
+            vkCmdEndRenderPass(cmd);
+
+            if (m_mode == CullingMode::Gpu && m_occlusion)
+            {
+                profiler.begin(cmd, "depth pyramid");
+                buildDepthPyramid(cmd);
+                profiler.end(cmd);
+            }
+        }
+
+    private:
+        void createDepthPyramid()
+        {
+            VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            info.imageType = VK_IMAGE_TYPE_2D;
+            info.format = VK_FORMAT_R32_SFLOAT;
+            info.extent = { m_pyramidWidth, m_pyramidHeight, 1 };
+            info.mipLevels = m_pyramidLevels;
+            info.arrayLayers = 1;
+            info.samples = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            m_pyramid = m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT);
+
+            m_pyramidLevelViews.resize(m_pyramidLevels);
+            for (uint32_t level = 0; level < m_pyramidLevels; ++level)
+                m_pyramidLevelViews[level] = m_context.createImageView(m_pyramid.image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level, 1);
+
+            /* The pyramid stays in GENERAL, it is sampled and written as storage image. Nothing is occluded until the first frame was rendered. */
+            m_context.immediateSubmit([&](VkCommandBuffer cmd) {
+                cmdImageBarrier(cmd, m_pyramid.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+                VkClearColorValue farDepth = { { 1.0f, 1.0f, 1.0f, 1.0f } };
+                VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+                vkCmdClearColorImage(cmd, m_pyramid.image, VK_IMAGE_LAYOUT_GENERAL, &farDepth, 1, &range);
+                cmdImageBarrier(cmd, m_pyramid.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+            });
+        }
+
+        void destroyDepthPyramid()
+        {
+            for (VkImageView view : m_pyramidLevelViews)
+                vkDestroyImageView(m_context.device(), view, vulkanHostAllocator());
+            m_pyramidLevelViews.clear();
+            m_context.destroyImage(m_pyramid);
+        }
+
+        /* The pyramid's size and mip count follow the swapchain, so the pyramid, the pool and every set are rebuilt */
+        void recreateDepthPyramid(VkExtent2D extent)
+        {
+            m_context.waitIdle();
+            vkDestroyDescriptorPool(m_context.device(), m_descriptorPool, vulkanHostAllocator());
+            destroyDepthPyramid();
+            resize(extent.width, extent.height);
+            createDepthPyramid();
+            createDescriptors();
+        }
+
+        void createPipelines()
+        {
+            VkShaderStageFlags sceneStages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+            m_sceneSetLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, sceneStages, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, sceneStages, nullptr },
+                { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, sceneStages, nullptr },
+                { 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+                { 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            });
+            m_reduceSetLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            });
+            m_sceneLayout = m_context.createPipelineLayout({ m_sceneSetLayout });
+            m_reduceLayout = m_context.createPipelineLayout({ m_reduceSetLayout }, sizeof(DepthReduceParams));
+
+            VkShaderModule cullShader = m_context.createShaderModule("culling/cull.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+            VkShaderModule reduceShader = m_context.createShaderModule("culling/depth_reduce.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+            m_cullPipeline = m_context.createComputePipeline(m_sceneLayout, cullShader);
+            m_reducePipeline = m_context.createComputePipeline(m_reduceLayout, reduceShader);
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_sceneLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("culling/instance.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("culling/instance.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.vertexBindings = { { 0, sizeof(float) * 3, VK_VERTEX_INPUT_RATE_VERTEX } };
+            desc.vertexAttributes = { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+            m_drawPipeline = m_context.createGraphicsPipeline(desc);
+
+            VkDevice device = m_context.device();
+            for (VkShaderModule module : { cullShader, reduceShader, desc.vertexShader, desc.fragmentShader })
+                vkDestroyShaderModule(device, module, vulkanHostAllocator());
+        }
+
+        void createDescriptors()
+        {
+            m_descriptorPool = m_context.createDescriptorPool(kFrames + m_pyramidLevels, {
+                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kFrames },
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, kFrames * 3 },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kFrames + m_pyramidLevels },
+                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_pyramidLevels },
+            });
+
+            VkDevice device = m_context.device();
+            for (uint32_t i = 0; i < kFrames; ++i)
+            {
+                const VulkanBuffer& visible = m_mode == CullingMode::Gpu ? m_visibleBuffers[0] : m_visibleBuffers[i];
+                VkDescriptorBufferInfo buffers[] = {
+                    { m_uniformBuffers[i].buffer, 0, VK_WHOLE_SIZE },
+                    { m_instanceBuffer.buffer, 0, VK_WHOLE_SIZE },
+                    { visible.buffer, 0, VK_WHOLE_SIZE },
+                    { m_drawBuffer.buffer, 0, VK_WHOLE_SIZE },
+                };
+                VkDescriptorImageInfo pyramid = { m_sampler, m_pyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+
+                m_sceneSets[i] = m_context.allocateDescriptorSet(m_descriptorPool, m_sceneSetLayout);
+                VkWriteDescriptorSet writes[5] = {};
+                for (uint32_t binding = 0; binding < 5; ++binding)
+                {
+                    writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                    writes[binding].dstSet = m_sceneSets[i];
+                    writes[binding].dstBinding = binding;
+                    writes[binding].descriptorCount = 1;
+                    writes[binding].descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                    writes[binding].pBufferInfo = binding < 4 ? &buffers[binding] : nullptr;
+                }
+                writes[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[4].pImageInfo = &pyramid;
+                vkUpdateDescriptorSets(device, 5, writes, 0, nullptr);
+            }
+
+            m_depthView = m_context.depthImage().view;
+            m_reduceSets.resize(m_pyramidLevels);
+            for (uint32_t level = 0; level < m_pyramidLevels; ++level)
+            {
+                VkDescriptorImageInfo source = level == 0
+                    ? VkDescriptorImageInfo{ m_sampler, m_depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+                    : VkDescriptorImageInfo{ m_sampler, m_pyramidLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+                VkDescriptorImageInfo destination = { VK_NULL_HANDLE, m_pyramidLevelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+                m_reduceSets[level] = m_context.allocateDescriptorSet(m_descriptorPool, m_reduceSetLayout);
+                VkWriteDescriptorSet writes[2] = {};
+                writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[0].dstSet = m_reduceSets[level];
+                writes[0].dstBinding = 0;
+                writes[0].descriptorCount = 1;
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[0].pImageInfo = &source;
+                writes[1] = writes[0];
+                writes[1].dstBinding = 1;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                writes[1].pImageInfo = &destination;
+                vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+            }
+        }
+
+        void buildDepthPyramid(VkCommandBuffer cmd)
+        {
+            VkImage depth = m_context.depthImage().image;
+            cmdImageBarrier(cmd, depth, VK_IMAGE_ASPECT_DEPTH_BIT,
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            /* This frame's cull pass read the pyramid that is overwritten now */
+            cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_reducePipeline);
+            for (uint32_t level = 0; level < m_pyramidLevels; ++level)
+            {
+                DepthReduceParams params = {};
+                params.destinationSize[0] = int32_t(std::max(1u, m_pyramidWidth >> level));
+                params.destinationSize[1] = int32_t(std::max(1u, m_pyramidHeight >> level));
+                params.sourceSize[0] = int32_t(level == 0 ? m_width : std::max(1u, m_pyramidWidth >> (level - 1)));
+                params.sourceSize[1] = int32_t(level == 0 ? m_height : std::max(1u, m_pyramidHeight >> (level - 1)));
+                /* Every level has its own view, the source is always level 0 of that view */
+                params.sourceLevel = 0;
+
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_reduceLayout, 0, 1, &m_reduceSets[level], 0, nullptr);
+                vkCmdPushConstants(cmd, m_reduceLayout, VK_SHADER_STAGE_ALL, 0, sizeof(params), &params);
+                vkCmdDispatch(cmd, uint32_t(params.destinationSize[0] + 7) / 8, uint32_t(params.destinationSize[1] + 7) / 8, 1);
+                cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            }
+
+            cmdImageBarrier(cmd, depth, VK_IMAGE_ASPECT_DEPTH_BIT,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        }
+
+        VulkanContext& m_context;
+        VulkanBuffer m_instanceBuffer;
+        VulkanBuffer m_drawBuffer;
+        VulkanBuffer m_vertexBuffer;
+        VulkanBuffer m_indexBuffer;
+        VulkanBuffer m_uniformBuffers[kFrames];
+        VulkanBuffer m_visibleBuffers[kFrames];
+        VulkanBuffer m_readbackBuffers[kFrames];
+        bool m_readbackPending[kFrames] = {};
+        bool m_readbackMeasured[kFrames] = {};
+
+        VulkanImage m_pyramid;
+        std::vector<VkImageView> m_pyramidLevelViews;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        /* The swapchain depth view m_reduceSets[0] was written with */
+        VkImageView m_depthView = VK_NULL_HANDLE;
+
+        VkDescriptorSetLayout m_sceneSetLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_reduceSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_sceneLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_reduceLayout = VK_NULL_HANDLE;
+        VkPipeline m_cullPipeline = VK_NULL_HANDLE;
+        VkPipeline m_reducePipeline = VK_NULL_HANDLE;
+        VkPipeline m_drawPipeline = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_sceneSets[kFrames] = {};
+        std::vector<VkDescriptorSet> m_reduceSets;
+    };
+}
+
+std::unique_ptr<Scenario> createGpuCullingScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<GpuCullingScenarioVulkan>(context, options);
+}
@@ -0,0 +1,92 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void JobSystem::run(uint32_t count, uint32_t batchSize, BatchCallback callback, const void* context)
+{
+    if (count == 0)
+        return;
+
+    batchSize = std::max(1u, batchSize);
+    if (m_workers.empty() || count <= batchSize)
+    {
+        callback(context, 0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callback = callback;
+        m_context = context;
+        m_count = count;
+        m_batchSize = batchSize;
+        m_nextBatch.store(0, std::memory_order_relaxed);
+        m_busyWorkers = uint32_t(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runBatches(0);
+
+    /* Workers still read m_callback until they reported back */
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_callback = nullptr;
+    m_context = nullptr;
+}
+
+void JobSystem::workerLoop(uint32_t threadIndex)
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_quit || m_generation != seenGeneration; });
+            if (m_quit)
+                return;
+            seenGeneration = m_generation;
+        }
+
+        runBatches(threadIndex);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last = --m_busyWorkers == 0;
+        }
+        if (last)
+            m_done.notify_one();
+    }
+}
+
+void JobSystem::runBatches(uint32_t threadIndex)
+{
+    uint32_t batchCount = (m_count + m_batchSize - 1) / m_batchSize;
+    for (uint32_t batch = m_nextBatch.fetch_add(1, std::memory_order_relaxed); batch < batchCount;
+         batch = m_nextBatch.fetch_add(1, std::memory_order_relaxed))
+    {
+        uint32_t begin = batch * m_batchSize;
+        m_callback(m_context, begin, std::min(begin + m_batchSize, m_count), threadIndex);
+    }
+}
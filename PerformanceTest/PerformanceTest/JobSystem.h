@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed pool of worker threads for data parallel work. parallelFor() hands out batches of a
+ * range through an atomic counter, the calling thread works on batches as well and returns
+ * once the whole range is processed.
+ */
+class JobSystem
+{
+public:
+    /* 0 uses one thread per hardware thread */
+    explicit JobSystem(uint32_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /* Threads working on a parallelFor(), including the calling thread */
+    uint32_t threadCount() const { return uint32_t(m_workers.size()) + 1; }
+
+    /*
+     * Calls function(begin, end, threadIndex) for every batch, threadIndex is 0 for the calling
+     * thread. The function is only referenced, not copied into a std::function, so a call does
+     * not allocate.
+     */
+    template <typename Function>
+    void parallelFor(uint32_t count, uint32_t batchSize, const Function& function)
+    {
+        run(count, batchSize, [](const void* context, uint32_t begin, uint32_t end, uint32_t threadIndex)
+        {
+            (*static_cast<const Function*>(context))(begin, end, threadIndex);
+        }, &function);
+    }
+
+private:
+    using BatchCallback = void (*)(const void* context, uint32_t begin, uint32_t end, uint32_t threadIndex);
+
+    void run(uint32_t count, uint32_t batchSize, BatchCallback callback, const void* context);
+    void workerLoop(uint32_t threadIndex);
+    void runBatches(uint32_t threadIndex);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    bool m_quit = false;
+
+    BatchCallback m_callback = nullptr;
+    const void* m_context = nullptr;
+    uint32_t m_count = 0;
+    uint32_t m_batchSize = 0;
+    std::atomic<uint32_t> m_nextBatch{ 0 };
+    uint32_t m_busyWorkers = 0;
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+/* 16 byte aligned so a Vec4 maps to one SSE register and matches the std140/std430 vec4 alignment */
+struct alignas(16) Vec4
+{
+    float x, y, z, w;
+};
+
+/* Unit quaternion, w is the real part */
+struct alignas(16) Quat
+{
+    float x, y, z, w;
+};
+
+inline Vec3 operator+(Vec3 a, Vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vec3 operator-(Vec3 a, Vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3 operator*(Vec3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline float dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(Vec3 a, Vec3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline float length(Vec3 a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalize(Vec3 a) { return a * (1.0f / length(a)); }
+
+/* Column major 4x4 matrix, same memory layout as a GLSL mat4 */
+struct alignas(16) Mat4
+{
+    float m[16];
+
+    static Mat4 identity()
+    {
+        return { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+    }
+
+    float& at(int row, int column) { return m[column * 4 + row]; }
+    float at(int row, int column) const { return m[column * 4 + row]; }
+};
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b)
+{
+    Mat4 result;
+    for (int column = 0; column < 4; ++column)
+        for (int row = 0; row < 4; ++row)
+            result.at(row, column) = a.at(row, 0) * b.at(0, column) + a.at(row, 1) * b.at(1, column)
+                                   + a.at(row, 2) * b.at(2, column) + a.at(row, 3) * b.at(3, column);
+    return result;
+}
+
+inline Vec4 operator*(const Mat4& a, Vec4 v)
+{
+    return {
+        a.at(0, 0) * v.x + a.at(0, 1) * v.y + a.at(0, 2) * v.z + a.at(0, 3) * v.w,
+        a.at(1, 0) * v.x + a.at(1, 1) * v.y + a.at(1, 2) * v.z + a.at(1, 3) * v.w,
+        a.at(2, 0) * v.x + a.at(2, 1) * v.y + a.at(2, 2) * v.z + a.at(2, 3) * v.w,
+        a.at(3, 0) * v.x + a.at(3, 1) * v.y + a.at(3, 2) * v.z + a.at(3, 3) * v.w,
+    };
+}
+
+inline Quat axisAngle(Vec3 axis, float angle)
+{
+    float s = std::sin(angle * 0.5f);
+    return { axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+}
+
+/* Translation * rotation * scale, the scalar reference of the batched composeTransforms() */
+inline Mat4 composeTransform(Vec3 translation, Quat rotation, Vec3 scale)
+{
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    Mat4 result = Mat4::identity();
+    result.at(0, 0) = (1.0f - 2.0f * (y * y + z * z)) * scale.x;
+    result.at(1, 0) = 2.0f * (x * y + w * z) * scale.x;
+    result.at(2, 0) = 2.0f * (x * z - w * y) * scale.x;
+    result.at(0, 1) = 2.0f * (x * y - w * z) * scale.y;
+    result.at(1, 1) = (1.0f - 2.0f * (x * x + z * z)) * scale.y;
+    result.at(2, 1) = 2.0f * (y * z + w * x) * scale.y;
+    result.at(0, 2) = 2.0f * (x * z + w * y) * scale.z;
+    result.at(1, 2) = 2.0f * (y * z - w * x) * scale.z;
+    result.at(2, 2) = (1.0f - 2.0f * (x * x + y * y)) * scale.z;
+    result.at(0, 3) = translation.x;
+    result.at(1, 3) = translation.y;
+    result.at(2, 3) = translation.z;
+    return result;
+}
+
+/*
+ * Right handed perspective projection with a [0, 1] depth range. OpenGL is switched to the
+ * same convention with glClipControl and Vulkan flips y with a negative viewport height,
+ * so both backends use identical matrices.
+ */
+inline Mat4 perspective(float fovY, float aspect, float zNear, float zFar)
+{
+    float f = 1.0f / std::tan(fovY * 0.5f);
+    Mat4 result = {};
+    result.at(0, 0) = f / aspect;
+    result.at(1, 1) = f;
+    result.at(2, 2) = zFar / (zNear - zFar);
+    result.at(2, 3) = zNear * zFar / (zNear - zFar);
+    result.at(3, 2) = -1.0f;
+    return result;
+}
+
+/* Right handed orthographic projection with the same [0, 1] depth range as perspective() */
+inline Mat4 orthographic(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+    Mat4 result = Mat4::identity();
+    result.at(0, 0) = 2.0f / (right - left);
+    result.at(1, 1) = 2.0f / (top - bottom);
+    result.at(2, 2) = 1.0f / (zNear - zFar);
+    result.at(0, 3) = -(right + left) / (right - left);
+    result.at(1, 3) = -(top + bottom) / (top - bottom);
+    result.at(2, 3) = zNear / (zNear - zFar);
+    return result;
+}
+
+inline Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up)
+{
+    Vec3 forward = normalize(target - eye);
+    Vec3 side = normalize(cross(forward, up));
+    Vec3 cameraUp = cross(side, forward);
+
+    Mat4 result = Mat4::identity();
+    result.at(0, 0) = side.x;
+    result.at(0, 1) = side.y;
+    result.at(0, 2) = side.z;
+    result.at(1, 0) = cameraUp.x;
+    result.at(1, 1) = cameraUp.y;
+    result.at(1, 2) = cameraUp.z;
+    result.at(2, 0) = -forward.x;
+    result.at(2, 1) = -forward.y;
+    result.at(2, 2) = -forward.z;
+    result.at(0, 3) = -dot(side, eye);
+    result.at(1, 3) = -dot(cameraUp, eye);
+    result.at(2, 3) = dot(forward, eye);
+    return result;
+}
+
+/* General inverse by cofactors, for the inverse view projection of a depth buffer reconstruction */
+inline Mat4 inverse(const Mat4& a)
+{
+    float s0 = a.at(0, 0) * a.at(1, 1) - a.at(1, 0) * a.at(0, 1);
+    float s1 = a.at(0, 0) * a.at(1, 2) - a.at(1, 0) * a.at(0, 2);
+    float s2 = a.at(0, 0) * a.at(1, 3) - a.at(1, 0) * a.at(0, 3);
+    float s3 = a.at(0, 1) * a.at(1, 2) - a.at(1, 1) * a.at(0, 2);
+    float s4 = a.at(0, 1) * a.at(1, 3) - a.at(1, 1) * a.at(0, 3);
+    float s5 = a.at(0, 2) * a.at(1, 3) - a.at(1, 2) * a.at(0, 3);
+    float c5 = a.at(2, 2) * a.at(3, 3) - a.at(3, 2) * a.at(2, 3);
+    float c4 = a.at(2, 1) * a.at(3, 3) - a.at(3, 1) * a.at(2, 3);
+    float c3 = a.at(2, 1) * a.at(3, 2) - a.at(3, 1) * a.at(2, 2);
+    float c2 = a.at(2, 0) * a.at(3, 3) - a.at(3, 0) * a.at(2, 3);
+    float c1 = a.at(2, 0) * a.at(3, 2) - a.at(3, 0) * a.at(2, 2);
+    float c0 = a.at(2, 0) * a.at(3, 1) - a.at(3, 0) * a.at(2, 1);
+    float scale = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    Mat4 result;
+    result.at(0, 0) = (a.at(1, 1) * c5 - a.at(1, 2) * c4 + a.at(1, 3) * c3) * scale;
+    result.at(0, 1) = (-a.at(0, 1) * c5 + a.at(0, 2) * c4 - a.at(0, 3) * c3) * scale;
+    result.at(0, 2) = (a.at(3, 1) * s5 - a.at(3, 2) * s4 + a.at(3, 3) * s3) * scale;
+    result.at(0, 3) = (-a.at(2, 1) * s5 + a.at(2, 2) * s4 - a.at(2, 3) * s3) * scale;
+    result.at(1, 0) = (-a.at(1, 0) * c5 + a.at(1, 2) * c2 - a.at(1, 3) * c1) * scale;
+    result.at(1, 1) = (a.at(0, 0) * c5 - a.at(0, 2) * c2 + a.at(0, 3) * c1) * scale;
+    result.at(1, 2) = (-a.at(3, 0) * s5 + a.at(3, 2) * s2 - a.at(3, 3) * s1) * scale;
+    result.at(1, 3) = (a.at(2, 0) * s5 - a.at(2, 2) * s2 + a.at(2, 3) * s1) * scale;
+    result.at(2, 0) = (a.at(1, 0) * c4 - a.at(1, 1) * c2 + a.at(1, 3) * c0) * scale;
+    result.at(2, 1) = (-a.at(0, 0) * c4 + a.at(0, 1) * c2 - a.at(0, 3) * c0) * scale;
+    result.at(2, 2) = (a.at(3, 0) * s4 - a.at(3, 1) * s2 + a.at(3, 3) * s0) * scale;
+    result.at(2, 3) = (-a.at(2, 0) * s4 + a.at(2, 1) * s2 - a.at(2, 3) * s0) * scale;
+    result.at(3, 0) = (-a.at(1, 0) * c3 + a.at(1, 1) * c1 - a.at(1, 2) * c0) * scale;
+    result.at(3, 1) = (a.at(0, 0) * c3 - a.at(0, 1) * c1 + a.at(0, 2) * c0) * scale;
+    result.at(3, 2) = (-a.at(3, 0) * s3 + a.at(3, 1) * s1 - a.at(3, 2) * s0) * scale;
+    result.at(3, 3) = (a.at(2, 0) * s3 - a.at(2, 1) * s1 + a.at(2, 2) * s0) * scale;
+    return result;
+}
+
+/* Planes as (normal, distance) with the normal pointing inside: dot(n, p) + d >= 0 is inside */
+struct Frustum
+{
+    Vec4 planes[6];
+};
+
+inline Frustum extractFrustum(const Mat4& viewProj)
+{
+    auto row = [&](int r) { return Vec4{ viewProj.at(r, 0), viewProj.at(r, 1), viewProj.at(r, 2), viewProj.at(r, 3) }; };
+    auto add = [](Vec4 a, Vec4 b) { return Vec4{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; };
+    auto sub = [](Vec4 a, Vec4 b) { return Vec4{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; };
+
+    Vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+    Frustum frustum = { { add(r3, r0), sub(r3, r0), add(r3, r1), sub(r3, r1), r2, sub(r3, r2) } };
+    for (Vec4& plane : frustum.planes)
+    {
+        float scale = 1.0f / length(Vec3{ plane.x, plane.y, plane.z });
+        plane = { plane.x * scale, plane.y * scale, plane.z * scale, plane.w * scale };
+    }
+    return frustum;
+}
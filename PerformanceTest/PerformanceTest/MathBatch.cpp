@@ -0,0 +1,440 @@
+#include "MathBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Benchmark.h"
+#include "CpuFeatures.h"
+#include "Random.h"
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+void Mat4Batch::resize(uint32_t count)
+{
+    for (AlignedVector<float>& element : m)
+        element.resize(count);
+}
+
+Mat4 Mat4Batch::get(uint32_t index) const
+{
+    Mat4 result;
+    for (int e = 0; e < 16; ++e)
+        result.m[e] = m[e][index];
+    return result;
+}
+
+void Mat4Batch::set(uint32_t index, const Mat4& matrix)
+{
+    for (int e = 0; e < 16; ++e)
+        m[e][index] = matrix.m[e];
+}
+
+void TransformBatch::resize(uint32_t count)
+{
+    for (AlignedVector<float>* array : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ })
+        array->resize(count);
+}
+
+void TransformBatch::set(uint32_t index, Vec3 position, Quat rotation, Vec3 scale)
+{
+    positionX[index] = position.x;
+    positionY[index] = position.y;
+    positionZ[index] = position.z;
+    rotationX[index] = rotation.x;
+    rotationY[index] = rotation.y;
+    rotationZ[index] = rotation.z;
+    rotationW[index] = rotation.w;
+    scaleX[index] = scale.x;
+    scaleY[index] = scale.y;
+    scaleZ[index] = scale.z;
+}
+
+namespace
+{
+    /* Scalar reference, also handles the tails of the SIMD kernels */
+
+    void multiplyScalar(const Mat4Batch& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            out.set(i, a.get(i) * b.get(i));
+    }
+
+    void multiplyUniformScalar(const Mat4& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            out.set(i, a * b.get(i));
+    }
+
+    void composeTransformsScalar(const TransformBatch& t, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            out.set(i, composeTransform({ t.positionX[i], t.positionY[i], t.positionZ[i] },
+                                        { t.rotationX[i], t.rotationY[i], t.rotationZ[i], t.rotationW[i] },
+                                        { t.scaleX[i], t.scaleY[i], t.scaleZ[i] }));
+    }
+
+    void updateHierarchyScalar(const Mat4Batch& local, const int32_t* parents, Mat4Batch& world, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+            world.set(i, world.get(uint32_t(parents[i])) * local.get(i));
+    }
+
+    const MathKernels kScalarKernels = { "scalar", multiplyScalar, multiplyUniformScalar, composeTransformsScalar, updateHierarchyScalar };
+
+#ifdef SIMD_X86
+    /* SSE4.1, 4 matrices per register */
+
+    SIMD_TARGET("sse4.1")
+    inline void multiply4(const __m128 a[16], const __m128 b[16], __m128 out[16])
+    {
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 4; ++row)
+                out[column * 4 + row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[row], b[column * 4]), _mm_mul_ps(a[4 + row], b[column * 4 + 1])),
+                                                   _mm_add_ps(_mm_mul_ps(a[8 + row], b[column * 4 + 2]), _mm_mul_ps(a[12 + row], b[column * 4 + 3])));
+    }
+
+    SIMD_TARGET("sse4.1")
+    inline void load4(const Mat4Batch& batch, uint32_t index, __m128 out[16])
+    {
+        for (int e = 0; e < 16; ++e)
+            out[e] = _mm_loadu_ps(&batch.m[e][index]);
+    }
+
+    SIMD_TARGET("sse4.1")
+    inline void store4(Mat4Batch& batch, uint32_t index, const __m128 values[16])
+    {
+        for (int e = 0; e < 16; ++e)
+            _mm_storeu_ps(&batch.m[e][index], values[e]);
+    }
+
+    SIMD_TARGET("sse4.1")
+    void multiplySse4(const Mat4Batch& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 va[16], vb[16], result[16];
+            load4(a, i, va);
+            load4(b, i, vb);
+            multiply4(va, vb, result);
+            store4(out, i, result);
+        }
+        multiplyScalar(a, b, out, i, end);
+    }
+
+    SIMD_TARGET("sse4.1")
+    void multiplyUniformSse4(const Mat4& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        __m128 va[16];
+        for (int e = 0; e < 16; ++e)
+            va[e] = _mm_set1_ps(a.m[e]);
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 vb[16], result[16];
+            load4(b, i, vb);
+            multiply4(va, vb, result);
+            store4(out, i, result);
+        }
+        multiplyUniformScalar(a, b, out, i, end);
+    }
+
+    SIMD_TARGET("sse4.1")
+    void composeTransformsSse4(const TransformBatch& t, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&t.rotationX[i]);
+            __m128 y = _mm_loadu_ps(&t.rotationY[i]);
+            __m128 z = _mm_loadu_ps(&t.rotationZ[i]);
+            __m128 w = _mm_loadu_ps(&t.rotationW[i]);
+            __m128 scaleX = _mm_loadu_ps(&t.scaleX[i]);
+            __m128 scaleY = _mm_loadu_ps(&t.scaleY[i]);
+            __m128 scaleZ = _mm_loadu_ps(&t.scaleZ[i]);
+
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            __m128 result[16];
+            result[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX);
+            result[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX);
+            result[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX);
+            result[3] = zero;
+            result[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY);
+            result[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY);
+            result[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY);
+            result[7] = zero;
+            result[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ);
+            result[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ);
+            result[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ);
+            result[11] = zero;
+            result[12] = _mm_loadu_ps(&t.positionX[i]);
+            result[13] = _mm_loadu_ps(&t.positionY[i]);
+            result[14] = _mm_loadu_ps(&t.positionZ[i]);
+            result[15] = one;
+            store4(out, i, result);
+        }
+        composeTransformsScalar(t, out, i, end);
+    }
+
+    SIMD_TARGET("sse4.1")
+    void updateHierarchySse4(const Mat4Batch& local, const int32_t* parents, Mat4Batch& world, uint32_t begin, uint32_t end)
+    {
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            /* SSE has no gather, the parent matrices are assembled lane by lane */
+            const int32_t* p = parents + i;
+            __m128 parent[16], child[16], result[16];
+            for (int e = 0; e < 16; ++e)
+            {
+                const float* element = world.m[e].data();
+                parent[e] = _mm_setr_ps(element[p[0]], element[p[1]], element[p[2]], element[p[3]]);
+            }
+            load4(local, i, child);
+            multiply4(parent, child, result);
+            store4(world, i, result);
+        }
+        updateHierarchyScalar(local, parents, world, i, end);
+    }
+
+    const MathKernels kSse4Kernels = { "sse4", multiplySse4, multiplyUniformSse4, composeTransformsSse4, updateHierarchySse4 };
+
+    /* AVX2 with FMA, 8 matrices per register */
+
+    SIMD_TARGET("avx2,fma")
+    inline void multiply8(const __m256 a[16], const __m256 b[16], __m256 out[16])
+    {
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 4; ++row)
+                out[column * 4 + row] = _mm256_fmadd_ps(a[row], b[column * 4],
+                                        _mm256_fmadd_ps(a[4 + row], b[column * 4 + 1],
+                                        _mm256_fmadd_ps(a[8 + row], b[column * 4 + 2], _mm256_mul_ps(a[12 + row], b[column * 4 + 3]))));
+    }
+
+    SIMD_TARGET("avx2,fma")
+    inline void load8(const Mat4Batch& batch, uint32_t index, __m256 out[16])
+    {
+        for (int e = 0; e < 16; ++e)
+            out[e] = _mm256_loadu_ps(&batch.m[e][index]);
+    }
+
+    SIMD_TARGET("avx2,fma")
+    inline void store8(Mat4Batch& batch, uint32_t index, const __m256 values[16])
+    {
+        for (int e = 0; e < 16; ++e)
+            _mm256_storeu_ps(&batch.m[e][index], values[e]);
+    }
+
+    SIMD_TARGET("avx2,fma")
+    void multiplyAvx2(const Mat4Batch& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 va[16], vb[16], result[16];
+            load8(a, i, va);
+            load8(b, i, vb);
+            multiply8(va, vb, result);
+            store8(out, i, result);
+        }
+        multiplyScalar(a, b, out, i, end);
+    }
+
+    SIMD_TARGET("avx2,fma")
+    void multiplyUniformAvx2(const Mat4& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        __m256 va[16];
+        for (int e = 0; e < 16; ++e)
+            va[e] = _mm256_set1_ps(a.m[e]);
+
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 vb[16], result[16];
+            load8(b, i, vb);
+            multiply8(va, vb, result);
+            store8(out, i, result);
+        }
+        multiplyUniformScalar(a, b, out, i, end);
+    }
+
+    SIMD_TARGET("avx2,fma")
+    void composeTransformsAvx2(const TransformBatch& t, Mat4Batch& out, uint32_t begin, uint32_t end)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 minusTwo = _mm256_set1_ps(-2.0f);
+
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&t.rotationX[i]);
+            __m256 y = _mm256_loadu_ps(&t.rotationY[i]);
+            __m256 z = _mm256_loadu_ps(&t.rotationZ[i]);
+            __m256 w = _mm256_loadu_ps(&t.rotationW[i]);
+            __m256 scaleX = _mm256_loadu_ps(&t.scaleX[i]);
+            __m256 scaleY = _mm256_loadu_ps(&t.scaleY[i]);
+            __m256 scaleZ = _mm256_loadu_ps(&t.scaleZ[i]);
+
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            __m256 result[16];
+            result[0] = _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(yy, zz), one), scaleX);
+            result[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), scaleX);
+            result[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), scaleX);
+            result[3] = zero;
+            result[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), scaleY);
+            result[5] = _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(xx, zz), one), scaleY);
+            result[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), scaleY);
+            result[7] = zero;
+            result[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), scaleZ);
+            result[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), scaleZ);
+            result[10] = _mm256_mul_ps(_mm256_fmadd_ps(minusTwo, _mm256_add_ps(xx, yy), one), scaleZ);
+            result[11] = zero;
+            result[12] = _mm256_loadu_ps(&t.positionX[i]);
+            result[13] = _mm256_loadu_ps(&t.positionY[i]);
+            result[14] = _mm256_loadu_ps(&t.positionZ[i]);
+            result[15] = one;
+            store8(out, i, result);
+        }
+        composeTransformsScalar(t, out, i, end);
+    }
+
+    SIMD_TARGET("avx2,fma")
+    void updateHierarchyAvx2(const Mat4Batch& local, const int32_t* parents, Mat4Batch& world, uint32_t begin, uint32_t end)
+    {
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256i parentIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(parents + i));
+            __m256 parent[16], child[16], result[16];
+            for (int e = 0; e < 16; ++e)
+                parent[e] = _mm256_i32gather_ps(world.m[e].data(), parentIndices, 4);
+            load8(local, i, child);
+            multiply8(parent, child, result);
+            store8(world, i, result);
+        }
+        updateHierarchyScalar(local, parents, world, i, end);
+    }
+
+    const MathKernels kAvx2Kernels = { "avx2", multiplyAvx2, multiplyUniformAvx2, composeTransformsAvx2, updateHierarchyAvx2 };
+#endif
+
+    struct KernelEntry
+    {
+        const MathKernels* kernels;
+        bool (*supported)();
+    };
+
+    /* Widest first, "auto" takes the first supported entry */
+    const KernelEntry kKernels[] = {
+#ifdef SIMD_X86
+        { &kAvx2Kernels, [] { return cpuFeatures().avx2; } },
+        { &kSse4Kernels, [] { return cpuFeatures().sse41; } },
+#endif
+        { &kScalarKernels, [] { return true; } },
+    };
+
+    float maxDifference(const Mat4Batch& a, const Mat4Batch& b)
+    {
+        float difference = 0.0f;
+        for (int e = 0; e < 16; ++e)
+            for (uint32_t i = 0; i < a.size(); ++i)
+                difference = std::max(difference, std::fabs(a.m[e][i] - b.m[e][i]));
+        return difference;
+    }
+}
+
+const MathKernels& selectMathKernels(const std::string& name)
+{
+    for (const KernelEntry& entry : kKernels)
+    {
+        if (name == "auto" && entry.supported())
+            return *entry.kernels;
+        if (name == entry.kernels->name)
+        {
+            if (!entry.supported())
+                fatal("The CPU does not support the %s math kernels", entry.kernels->name);
+            return *entry.kernels;
+        }
+    }
+    fatal("Unknown math kernels '%s', expected auto, avx2, sse4 or scalar", name.c_str());
+}
+
+float verifyMathKernels(const MathKernels& kernels)
+{
+    /* Not a multiple of 8 so the scalar tails run as well */
+    const uint32_t count = 1037;
+    const uint32_t rootCount = 61;
+
+    uint32_t state = 0x12345678u;
+    auto random = [&state](float low, float high)
+    {
+        return low + (high - low) * random01(state);
+    };
+
+    TransformBatch transforms;
+    Mat4Batch a, b;
+    std::vector<int32_t> parents(count);
+    transforms.resize(count);
+    a.resize(count);
+    b.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Vec3 axis = normalize({ random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(0.1f, 1.0f) });
+        transforms.set(i, { random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f) }, axisAngle(axis, random(-3.0f, 3.0f)),
+                       { random(0.5f, 2.0f), random(0.5f, 2.0f), random(0.5f, 2.0f) });
+        Mat4 matrixA, matrixB;
+        for (int e = 0; e < 16; ++e)
+        {
+            matrixA.m[e] = random(-1.0f, 1.0f);
+            matrixB.m[e] = random(-1.0f, 1.0f);
+        }
+        a.set(i, matrixA);
+        b.set(i, matrixB);
+        /* Two levels below the roots, every parent sits in the previous level */
+        parents[i] = i < rootCount ? -1 : i < 300 ? int32_t(random(0.0f, float(rootCount))) : int32_t(random(float(rootCount), 300.0f));
+    }
+    Mat4 uniform = a.get(0);
+
+    auto run = [&](const MathKernels& k, Mat4Batch results[4])
+    {
+        for (int r = 0; r < 4; ++r)
+            results[r].resize(count);
+        k.multiply(a, b, results[0], 0, count);
+        k.multiplyUniform(uniform, b, results[1], 0, count);
+        k.composeTransforms(transforms, results[2], 0, count);
+
+        /* The composed transforms are scaled down so the error does not grow with the hierarchy depth */
+        Mat4Batch local;
+        local.resize(count);
+        kScalarKernels.multiplyUniform(Mat4{ { 0.5f, 0, 0, 0, 0, 0.5f, 0, 0, 0, 0, 0.5f, 0, 0, 0, 0, 1 } }, results[2], local, 0, count);
+        for (uint32_t i = 0; i < rootCount; ++i)
+            results[3].set(i, local.get(i));
+        k.updateHierarchy(local, parents.data(), results[3], rootCount, 300);
+        k.updateHierarchy(local, parents.data(), results[3], 300, count);
+    };
+
+    Mat4Batch expected[4], actual[4];
+    run(kScalarKernels, expected);
+    run(kernels, actual);
+
+    float difference = 0.0f;
+    for (int r = 0; r < 4; ++r)
+        difference = std::max(difference, maxDifference(expected[r], actual[r]));
+    return difference;
+}
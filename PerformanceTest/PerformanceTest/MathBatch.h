@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "AlignedAllocator.h"
+#include "Math.h"
+
+/*
+ * Structure of arrays storage of many matrices: m[e][i] is element e (column * 4 + row, the
+ * Mat4 order) of matrix i, so a SIMD register holds the same element of 4 or 8 matrices.
+ */
+struct Mat4Batch
+{
+    AlignedVector<float> m[16];
+
+    uint32_t size() const { return uint32_t(m[0].size()); }
+    void resize(uint32_t count);
+
+    Mat4 get(uint32_t index) const;
+    void set(uint32_t index, const Mat4& matrix);
+};
+
+/* Translation, rotation and scale of many nodes in structure of arrays layout */
+struct TransformBatch
+{
+    AlignedVector<float> positionX, positionY, positionZ;
+    AlignedVector<float> rotationX, rotationY, rotationZ, rotationW;
+    AlignedVector<float> scaleX, scaleY, scaleZ;
+
+    uint32_t size() const { return uint32_t(positionX.size()); }
+    void resize(uint32_t count);
+
+    void set(uint32_t index, Vec3 position, Quat rotation, Vec3 scale);
+};
+
+/*
+ * Batched kernels, all of them work on the range [begin, end) so the range can be split over
+ * the job system. One set exists per instruction set, see selectMathKernels().
+ */
+struct MathKernels
+{
+    const char* name;
+    /* out[i] = a[i] * b[i] */
+    void (*multiply)(const Mat4Batch& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end);
+    /* out[i] = a * b[i], e.g. the view projection times every model matrix */
+    void (*multiplyUniform)(const Mat4& a, const Mat4Batch& b, Mat4Batch& out, uint32_t begin, uint32_t end);
+    /* out[i] = translation * rotation * scale, see composeTransform() */
+    void (*composeTransforms)(const TransformBatch& transforms, Mat4Batch& out, uint32_t begin, uint32_t end);
+    /*
+     * world[i] = world[parents[i]] * local[i]. The parents of the range have to be computed
+     * already, nodes are sorted by depth and a range never spans two depths.
+     */
+    void (*updateHierarchy)(const Mat4Batch& local, const int32_t* parents, Mat4Batch& world, uint32_t begin, uint32_t end);
+};
+
+/* "auto" picks the widest instruction set the CPU supports, fails for unknown or unsupported names */
+const MathKernels& selectMathKernels(const std::string& name);
+
+/*
+ * Runs every kernel of the set on random data and compares the results with the scalar
+ * reference, returns the largest absolute difference. Used as a startup self check since
+ * the project has no test target.
+ */
+float verifyMathKernels(const MathKernels& kernels);
@@ -0,0 +1,154 @@
+#include "Msaa.h"
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    MsaaResolve parseResolve(const std::string& resolve)
+    {
+        if (resolve == "blit")
+            return MsaaResolve::Blit;
+        if (resolve == "attachment")
+            return MsaaResolve::Attachment;
+        if (resolve == "compute")
+            return MsaaResolve::Compute;
+        fatal("Unknown --resolve '%s', expected blit, attachment or compute", resolve.c_str());
+    }
+
+    RenderTargetFormat parseFormat(const std::string& format)
+    {
+        if (format == "rgba8")
+            return RenderTargetFormat::RGBA8;
+        if (format == "rgba16f")
+            return RenderTargetFormat::RGBA16F;
+        if (format == "r11g11b10f")
+            return RenderTargetFormat::R11G11B10F;
+        fatal("Unknown --format '%s', expected rgba8, rgba16f or r11g11b10f", format.c_str());
+    }
+
+    const char* formatName(RenderTargetFormat format)
+    {
+        switch (format)
+        {
+        case RenderTargetFormat::RGBA8:
+            return "rgba8";
+        case RenderTargetFormat::RGBA16F:
+            return "rgba16f";
+        case RenderTargetFormat::R11G11B10F:
+            return "r11g11b10f";
+        case RenderTargetFormat::Depth32F:
+            return "depth32f";
+        }
+        return "rgba8";
+    }
+
+    /* The image format qualifier of the format in GLSL */
+    const char* glslFormat(RenderTargetFormat format)
+    {
+        switch (format)
+        {
+        case RenderTargetFormat::RGBA16F:
+            return "rgba16f";
+        case RenderTargetFormat::R11G11B10F:
+            return "r11f_g11f_b10f";
+        default:
+            return "rgba8";
+        }
+    }
+}
+
+MsaaScenario::MsaaScenario(const Options& options)
+    : m_resolve(parseResolve(options.getString("resolve", "blit")))
+    , m_format(parseFormat(options.getString("format", "rgba8")))
+{
+    int64_t samples = options.getInt("samples", 4);
+    if (samples != 1 && samples != 2 && samples != 4 && samples != 8)
+        fatal("--samples has to be 1, 2, 4 or 8");
+    m_samples = uint32_t(samples);
+    m_fixedResolution = parseRenderResolution(options.getString("resolution", "window"), m_fixedWidth, m_fixedHeight);
+}
+
+void MsaaScenario::limitSamples(uint32_t supported)
+{
+    uint32_t samples = m_samples;
+    while (samples > 1 && !(supported & samples))
+        samples >>= 1;
+    if (samples != m_samples)
+    {
+        std::printf("msaa: %u samples are not supported, falling back to %u\n", m_samples, samples);
+        m_samples = samples;
+    }
+}
+
+void MsaaScenario::fallBackToBlit(const char* reason)
+{
+    std::printf("msaa: %s, falling back to --resolve blit\n", reason);
+    m_resolve = MsaaResolve::Blit;
+}
+
+bool MsaaScenario::updateSize(uint32_t windowWidth, uint32_t windowHeight)
+{
+    m_windowWidth = windowWidth;
+    m_windowHeight = windowHeight;
+    uint32_t width = m_fixedResolution ? m_fixedWidth : windowWidth;
+    uint32_t height = m_fixedResolution ? m_fixedHeight : windowHeight;
+    if (width == m_width && height == m_height)
+        return false;
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+MsaaConstants MsaaScenario::sceneConstants(const FrameInfo& frame) const
+{
+    /* Float targets get values above 1, so resolving them averages HDR samples */
+    float brightness = m_format == RenderTargetFormat::RGBA8 ? 1.0f : 4.0f;
+    MsaaConstants constants = {};
+    constants.scene = { float(frame.index % 3600) * (6.2831853f / 3600.0f), float(m_width) / float(m_height), brightness, 0.0f };
+    return constants;
+}
+
+MsaaConstants MsaaScenario::presentConstants() const
+{
+    MsaaConstants constants = {};
+    constants.texel = { 0.0f, 0.0f, 1.0f / float(m_windowWidth), 1.0f / float(m_windowHeight) };
+    return constants;
+}
+
+ShaderDefines MsaaScenario::resolveDefines() const
+{
+    return { { "SAMPLES", std::to_string(m_samples) }, { "FORMAT", glslFormat(m_format) } };
+}
+
+void MsaaScenario::report(Report& report)
+{
+    const char* resolve = "none";
+    if (m_samples > 1)
+        resolve = m_resolve == MsaaResolve::Blit ? blitName() : m_resolve == MsaaResolve::Attachment ? "resolve attachment" : "compute";
+    char resolution[32];
+    std::snprintf(resolution, sizeof(resolution), "%ux%u", m_width, m_height);
+
+    RenderTargetDesc color = { m_width, m_height, m_format, m_samples, false };
+    RenderTargetDesc depth = { m_width, m_height, RenderTargetFormat::Depth32F, m_samples, true };
+    RenderTargetDesc resolved = { m_width, m_height, m_format, 1, false };
+    report.addValue("msaa samples", double(m_samples), "");
+    report.addText("msaa format", formatName(m_format));
+    report.addText("msaa resolve", resolve);
+    report.addText("msaa resolution", resolution);
+    report.addValue("msaa color memory", double(renderTargetSize(color)) / (1024.0 * 1024.0), "MiB");
+    report.addValue("msaa depth memory", double(renderTargetSize(depth)) / (1024.0 * 1024.0), "MiB");
+
+    /* With a resolve attachment the resolve is part of the scene zone, the sum compares all strategies */
+    const Statistics* sceneTimes = zoneTimes("scene");
+    const Statistics* resolveTimes = separateResolve() ? zoneTimes("resolve") : nullptr;
+    if (sceneTimes)
+        report.addValue("gpu scene and resolve", sceneTimes->mean() + (resolveTimes ? resolveTimes->mean() : 0.0), "ms");
+    if (resolveTimes && resolveTimes->mean() > 0.0)
+    {
+        double megapixels = double(m_width) * double(m_height) * 1e-6;
+        uint64_t bytes = renderTargetSize(color) + renderTargetSize(resolved);
+        report.addValue("gpu resolve per megapixel", resolveTimes->mean() * 1000.0 / megapixels, "us");
+        report.addValue("resolve bandwidth", double(bytes) / (resolveTimes->mean() * 1e-3) * 1e-9, "GB/s");
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Math.h"
+#include "RenderTargetPool.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Push constants of shaders/msaa, same layout as FrameConstants in msaa.glsl */
+struct MsaaConstants
+{
+    /* x animation phase, y aspect ratio, z brightness of the triangles */
+    Vec4 scene;
+    /* zw texel size of the window for the present pass */
+    Vec4 texel;
+};
+
+/* --resolve blit|attachment|compute */
+enum class MsaaResolve
+{
+    /* glBlitFramebuffer, on Vulkan its counterpart vkCmdResolveImage, after the scene pass */
+    Blit,
+    /* Vulkan only: a resolve attachment of the scene's subpass, the multisampled image is never stored */
+    Attachment,
+    /* A compute shader averaging the samples with texelFetch into a storage image */
+    Compute
+};
+
+/*
+ * Backend independent part of the MSAA scenario: kTriangleCount small rotating triangles drawn
+ * with --samples 1|2|4|8 into a --format rgba8|rgba16f|r11g11b10f target with a depth buffer of
+ * the same sample count at --resolution window|720p|1080p|1440p|4k|<w>x<h>, resolved with
+ * --resolve blit|attachment|compute and scaled to the swapchain. With --samples 1 the scene
+ * renders straight into the resolved target and there is nothing to resolve, the baseline the
+ * other counts are compared against. The backends own their targets and recreate them when the
+ * size changes.
+ */
+class MsaaScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kTriangleCount = 8192;
+    static constexpr uint32_t kWorkgroupSize = 8;
+
+    MsaaScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* Lowers --samples to the highest supported count, bit n of `supported` is set if n samples are */
+    void limitSamples(uint32_t supported);
+    /* Switches to --resolve blit, `reason` says why */
+    void fallBackToBlit(const char* reason);
+    /* Updates the target size, true if it changed and the targets have to be recreated */
+    bool updateSize(uint32_t windowWidth, uint32_t windowHeight);
+    MsaaConstants sceneConstants(const FrameInfo& frame) const;
+    MsaaConstants presentConstants() const;
+    /* SAMPLES and FORMAT of resolve.comp */
+    ShaderDefines resolveDefines() const;
+    /* Whether a resolve pass runs after the scene pass, not with one sample or a resolve attachment */
+    bool separateResolve() const { return m_samples > 1 && m_resolve != MsaaResolve::Attachment; }
+    /* Measured GPU times of a zone, nullptr before its first result */
+    virtual const Statistics* zoneTimes(const char* zone) const = 0;
+    /* What --resolve blit calls on the backend */
+    virtual const char* blitName() const = 0;
+
+    MsaaResolve m_resolve;
+    RenderTargetFormat m_format;
+    uint32_t m_samples;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_windowWidth = 0;
+    uint32_t m_windowHeight = 0;
+
+private:
+    bool m_fixedResolution;
+    uint32_t m_fixedWidth = 0;
+    uint32_t m_fixedHeight = 0;
+};
+
+std::unique_ptr<Scenario> createMsaaScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createMsaaScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,175 @@
+#include "Msaa.h"
+
+#include <algorithm>
+
+#include "GLContext.h"
+#include "GLRenderTargetPool.h"
+
+namespace
+{
+    /*
+     * The multisampled color target is a GL_TEXTURE_2D_MULTISAMPLE so the compute resolve can
+     * texelFetch its samples, the depth buffer a multisampled renderbuffer. --resolve blit is a
+     * glBlitFramebuffer from the scene's framebuffer into the resolved texture's. OpenGL has no
+     * resolve attachments, --resolve attachment falls back to blit.
+     */
+    class MsaaScenarioGL : public MsaaScenario
+    {
+    public:
+        MsaaScenarioGL(GLContext& context, const Options& options)
+            : MsaaScenario(options)
+            , m_context(context)
+        {
+            GLint maxColorSamples = 1, maxSamples = 1;
+            glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxColorSamples);
+            glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+            GLint maxCount = std::min(maxColorSamples, maxSamples);
+            uint32_t supported = 0;
+            for (GLint samples = 1; samples <= maxCount; samples <<= 1)
+                supported |= uint32_t(samples);
+            limitSamples(supported);
+            if (m_resolve == MsaaResolve::Attachment)
+                fallBackToBlit("OpenGL has no resolve attachments");
+
+            m_sceneProgram = createProgram("msaa/scene.vert", "msaa/scene.frag");
+            m_presentProgram = createProgram("msaa/fullscreen.vert", "msaa/present.frag");
+            if (m_resolve == MsaaResolve::Compute && m_samples > 1)
+                m_resolveProgram = createComputeProgram("msaa/resolve.comp", resolveDefines());
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~MsaaScenarioGL() override
+        {
+            destroyTargets();
+            glDeleteProgram(m_sceneProgram);
+            glDeleteProgram(m_presentProgram);
+            glDeleteProgram(m_resolveProgram);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            if (updateSize(uint32_t(m_context.width()), uint32_t(m_context.height())))
+                createTargets();
+
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.setBlend(false);
+            state.setCullFace(false);
+            state.setDepthTest(true);
+            state.depthFunc(GL_LESS);
+            state.depthMask(true);
+
+            const float clearColor[4] = { 0.1f, 0.1f, 0.12f, 1.0f };
+            const float clearDepth = 1.0f;
+            MsaaConstants constants = sceneConstants(frame);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFramebuffer);
+            glViewport(0, 0, GLsizei(m_width), GLsizei(m_height));
+            m_context.profiler().begin("scene");
+            glClearBufferfv(GL_COLOR, 0, clearColor);
+            glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+            state.useProgram(m_sceneProgram);
+            m_context.pushConstants(&constants, sizeof(constants));
+            glDrawArrays(GL_TRIANGLES, 0, GLsizei(kTriangleCount * 3));
+            m_context.profiler().end();
+
+            if (separateResolve())
+            {
+                m_context.profiler().begin("resolve");
+                if (m_resolve == MsaaResolve::Blit)
+                {
+                    glBlitNamedFramebuffer(m_sceneFramebuffer, m_resolvedFramebuffer, 0, 0, GLint(m_width), GLint(m_height), 0, 0, GLint(m_width),
+                                           GLint(m_height), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                }
+                else
+                {
+                    state.useProgram(m_resolveProgram);
+                    state.bindTextureUnit(0, m_multisampled);
+                    glBindImageTexture(1, m_resolved, 0, GL_FALSE, 0, GL_WRITE_ONLY, GLRenderTargetPool::internalFormat(m_format));
+                    glDispatchCompute((m_width + kWorkgroupSize - 1) / kWorkgroupSize, (m_height + kWorkgroupSize - 1) / kWorkgroupSize, 1);
+                    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+                }
+                m_context.profiler().end();
+            }
+
+            constants = presentConstants();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            state.setDepthTest(false);
+            m_context.profiler().begin("present");
+            state.useProgram(m_presentProgram);
+            state.bindTextureUnit(0, m_resolved);
+            m_context.pushConstants(&constants, sizeof(constants));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            m_context.profiler().end();
+        }
+
+    private:
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        const char* blitName() const override
+        {
+            return "glBlitFramebuffer";
+        }
+
+        /* With one sample the scene framebuffer renders into the resolved texture */
+        void createTargets()
+        {
+            destroyTargets();
+            GLenum format = GLRenderTargetPool::internalFormat(m_format);
+            glCreateTextures(GL_TEXTURE_2D, 1, &m_resolved);
+            glTextureStorage2D(m_resolved, 1, format, GLsizei(m_width), GLsizei(m_height));
+            glTextureParameteri(m_resolved, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(m_resolved, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(m_resolved, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(m_resolved, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glCreateFramebuffers(1, &m_resolvedFramebuffer);
+            glNamedFramebufferTexture(m_resolvedFramebuffer, GL_COLOR_ATTACHMENT0, m_resolved, 0);
+
+            GLuint color = m_resolved;
+            if (m_samples > 1)
+            {
+                glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &m_multisampled);
+                glTextureStorage2DMultisample(m_multisampled, GLsizei(m_samples), format, GLsizei(m_width), GLsizei(m_height), GL_TRUE);
+                color = m_multisampled;
+            }
+            glCreateRenderbuffers(1, &m_depth);
+            glNamedRenderbufferStorageMultisample(m_depth, GLsizei(m_samples > 1 ? m_samples : 0), GL_DEPTH_COMPONENT32F, GLsizei(m_width),
+                                                  GLsizei(m_height));
+            glCreateFramebuffers(1, &m_sceneFramebuffer);
+            glNamedFramebufferTexture(m_sceneFramebuffer, GL_COLOR_ATTACHMENT0, color, 0);
+            glNamedFramebufferRenderbuffer(m_sceneFramebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+            if (glCheckNamedFramebufferStatus(m_sceneFramebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                fatal("The MSAA framebuffer with %u samples is incomplete", m_samples);
+        }
+
+        void destroyTargets()
+        {
+            glDeleteFramebuffers(1, &m_sceneFramebuffer);
+            glDeleteFramebuffers(1, &m_resolvedFramebuffer);
+            glDeleteRenderbuffers(1, &m_depth);
+            glDeleteTextures(1, &m_multisampled);
+            glDeleteTextures(1, &m_resolved);
+            m_sceneFramebuffer = m_resolvedFramebuffer = m_depth = m_multisampled = m_resolved = 0;
+        }
+
+        GLContext& m_context;
+        GLuint m_sceneProgram = 0;
+        GLuint m_presentProgram = 0;
+        GLuint m_resolveProgram = 0;
+        GLuint m_vertexArray = 0;
+        GLuint m_multisampled = 0;
+        GLuint m_depth = 0;
+        GLuint m_resolved = 0;
+        GLuint m_sceneFramebuffer = 0;
+        GLuint m_resolvedFramebuffer = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createMsaaScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<MsaaScenarioGL>(context, options);
+}
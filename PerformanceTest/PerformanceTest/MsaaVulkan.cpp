@@ -0,0 +1,401 @@
+#include "Msaa.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderTargetPool.h"
+
+namespace
+{
+    /*
+     * --resolve blit is vkCmdResolveImage, Vulkan's counterpart of a multisampled
+     * glBlitFramebuffer. --resolve attachment adds a resolve attachment to the scene's subpass and
+     * stores nothing of the multisampled image, a tiler resolves on chip. --resolve compute samples
+     * the multisampled image as a sampler2DMS and writes the resolved one as a storage image. The
+     * usage flags of both images only include what the chosen strategy needs, so the driver is free
+     * to compress them.
+     */
+    class MsaaScenarioVulkan : public MsaaScenario
+    {
+    public:
+        MsaaScenarioVulkan(VulkanContext& context, const Options& options)
+            : MsaaScenario(options)
+            , m_context(context)
+        {
+            VkDevice device = m_context.device();
+            const VkPhysicalDeviceLimits& limits = m_context.properties().limits;
+            VkSampleCountFlags supported = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+            if (m_resolve == MsaaResolve::Compute)
+                supported &= limits.sampledImageColorSampleCounts;
+            limitSamples(supported);
+            if (m_resolve == MsaaResolve::Compute && m_format == RenderTargetFormat::R11G11B10F)
+            {
+                /* The format needs both, r11f_g11f_b10f is one of the extended storage image formats */
+                VkFormatProperties properties = {};
+                vkGetPhysicalDeviceFormatProperties(m_context.physicalDevice(), VK_FORMAT_B10G11R11_UFLOAT_PACK32, &properties);
+                if (!(properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) || !m_context.features().shaderStorageImageExtendedFormats)
+                    fallBackToBlit("r11g11b10f storage images are not supported");
+            }
+            VkPhysicalDeviceMemoryProperties memory;
+            vkGetPhysicalDeviceMemoryProperties(m_context.physicalDevice(), &memory);
+            for (uint32_t i = 0; i < memory.memoryTypeCount; ++i)
+                if (memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                    m_transientMemory = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_LINEAR;
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            VK_CHECK(vkCreateSampler(device, &samplerInfo, vulkanHostAllocator(), &m_sampler));
+
+            /* Binding 0 is the multisampled image for the resolve and the resolved image for the present */
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(MsaaConstants));
+            /* Both sets use the layout, so each takes a storage image descriptor even if only the resolve writes one */
+            m_descriptorPool = m_context.createDescriptorPool(2, {
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 },
+            });
+
+            createScenePass();
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_scenePass;
+            desc.vertexShader = m_context.createShaderModule("msaa/scene.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("msaa/scene.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.samples = VkSampleCountFlagBits(m_samples);
+            m_scenePipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("msaa/fullscreen.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("msaa/present.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.depthTest = false;
+            desc.depthWrite = false;
+            desc.samples = VK_SAMPLE_COUNT_1_BIT;
+            m_presentPipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+
+            if (m_resolve == MsaaResolve::Compute && m_samples > 1)
+            {
+                VkShaderModule shader = m_context.createShaderModule("msaa/resolve.comp", VK_SHADER_STAGE_COMPUTE_BIT, resolveDefines());
+                m_resolvePipeline = m_context.createComputePipeline(m_pipelineLayout, shader);
+                vkDestroyShaderModule(device, shader, vulkanHostAllocator());
+            }
+        }
+
+        ~MsaaScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            destroyTargets();
+            vkDestroyPipeline(device, m_scenePipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_presentPipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_resolvePipeline, vulkanHostAllocator());
+            vkDestroyRenderPass(device, m_scenePass, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkExtent2D window = m_context.swapchainExtent();
+            if (updateSize(window.width, window.height))
+            {
+                m_context.waitIdle();
+                createTargets();
+            }
+
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const VkClearValue clearValues[3] = { { { { 0.1f, 0.1f, 0.12f, 1.0f } } }, { { { 1.0f, 0 } } }, {} };
+            VkRenderPassBeginInfo beginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+            beginInfo.renderPass = m_scenePass;
+            beginInfo.framebuffer = m_framebuffer;
+            beginInfo.renderArea.extent = { m_width, m_height };
+            beginInfo.clearValueCount = 3;
+            beginInfo.pClearValues = clearValues;
+
+            MsaaConstants constants = sceneConstants(frame);
+            m_context.profiler().begin(cmd, "scene");
+            vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+            m_context.setViewport(cmd, { m_width, m_height });
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_scenePipeline);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, kTriangleCount * 3, 1, 0, 0);
+            vkCmdEndRenderPass(cmd);
+            m_context.profiler().end(cmd);
+
+            if (separateResolve())
+            {
+                m_context.profiler().begin(cmd, "resolve");
+                if (m_resolve == MsaaResolve::Blit)
+                    recordBlitResolve(cmd);
+                else
+                    recordComputeResolve(cmd);
+                m_context.profiler().end(cmd);
+            }
+
+            constants = presentConstants();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.profiler().begin(cmd, "present");
+            m_context.beginSwapchainPass(cmd, clearColor);
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_presentPipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_presentSet, 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, 3, 1, 0, 0);
+            vkCmdEndRenderPass(cmd);
+            m_context.profiler().end(cmd);
+        }
+
+    private:
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        const char* blitName() const override
+        {
+            return "vkCmdResolveImage";
+        }
+
+        /* The previous contents of the resolved image are overwritten, the present pass of the last frame has to be done reading them */
+        void recordBlitResolve(VkCommandBuffer cmd)
+        {
+            cmdImageBarrier(cmd, m_resolved.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            VkImageResolve region = {};
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.extent = { m_width, m_height, 1 };
+            vkCmdResolveImage(cmd, m_multisampled.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_resolved.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                              &region);
+            cmdImageBarrier(cmd, m_resolved.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        void recordComputeResolve(VkCommandBuffer cmd)
+        {
+            cmdImageBarrier(cmd, m_resolved.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_resolvePipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_resolveSet, 0, nullptr);
+            vkCmdDispatch(cmd, (m_width + kWorkgroupSize - 1) / kWorkgroupSize, (m_height + kWorkgroupSize - 1) / kWorkgroupSize, 1);
+            cmdImageBarrier(cmd, m_resolved.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        /*
+         * Attachment 0 is the multisampled color, or the resolved image with one sample, 1 depth
+         * and 2 the resolve attachment. Color ends in the layout the resolve reads it in, with a
+         * resolve attachment or one sample the resolved image ends ready for the present pass.
+         */
+        void createScenePass()
+        {
+            VkFormat format = VulkanRenderTargetPool::format(m_format);
+            VkSampleCountFlagBits samples = VkSampleCountFlagBits(m_samples);
+            bool attachment = m_resolve == MsaaResolve::Attachment && m_samples > 1;
+
+            VkAttachmentDescription attachments[3] = {};
+            attachments[0].format = format;
+            attachments[0].samples = samples;
+            attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments[0].storeOp = attachment ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+            attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if (separateResolve() && m_resolve == MsaaResolve::Blit)
+                attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            else if (attachment)
+                attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            else
+                attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            attachments[1].format = VK_FORMAT_D32_SFLOAT;
+            attachments[1].samples = samples;
+            attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            attachments[2].format = format;
+            attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+            attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachments[2].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[2].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            for (VkAttachmentDescription& description : attachments)
+            {
+                description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            }
+
+            const VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+            const VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+            const VkAttachmentReference resolveReference = { 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+            VkSubpassDescription subpass = {};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments = &colorReference;
+            subpass.pResolveAttachments = attachment ? &resolveReference : nullptr;
+            subpass.pDepthStencilAttachment = &depthReference;
+
+            /* The targets are not duplicated per frame in flight, the last frame's resolve and present have to be done with them */
+            const VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                                          VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            VkPipelineStageFlags readStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            VkAccessFlags readAccess = VK_ACCESS_SHADER_READ_BIT;
+            if (separateResolve())
+            {
+                readStage = m_resolve == MsaaResolve::Blit ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                readAccess = m_resolve == MsaaResolve::Blit ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_SHADER_READ_BIT;
+            }
+            VkSubpassDependency dependencies[2] = {};
+            dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[0].dstSubpass = 0;
+            dependencies[0].srcStageMask = attachmentStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | readStage;
+            dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependencies[0].dstStageMask = attachmentStages;
+            dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependencies[1].srcSubpass = 0;
+            dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstStageMask = readStage;
+            dependencies[1].dstAccessMask = readAccess;
+
+            VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+            info.attachmentCount = attachment ? 3 : 2;
+            info.pAttachments = attachments;
+            info.subpassCount = 1;
+            info.pSubpasses = &subpass;
+            info.dependencyCount = 2;
+            info.pDependencies = dependencies;
+            VK_CHECK(vkCreateRenderPass(m_context.device(), &info, vulkanHostAllocator(), &m_scenePass));
+        }
+
+        /* The images, the framebuffer and the descriptor sets, after the GPU is done with the old ones */
+        void createTargets()
+        {
+            destroyTargets();
+            VkDevice device = m_context.device();
+            bool attachment = m_resolve == MsaaResolve::Attachment;
+
+            VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            info.imageType = VK_IMAGE_TYPE_2D;
+            info.format = VulkanRenderTargetPool::format(m_format);
+            info.extent = { m_width, m_height, 1 };
+            info.mipLevels = 1;
+            info.arrayLayers = 1;
+            info.samples = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            info.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+            if (!separateResolve())
+                info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            else if (m_resolve == MsaaResolve::Blit)
+                info.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            else
+                info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+            info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            m_resolved = m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT);
+
+            VkImageView views[3] = { m_resolved.view };
+            info.samples = VkSampleCountFlagBits(m_samples);
+            if (m_samples > 1)
+            {
+                /* With a resolve attachment the samples never leave a tiler's on-chip memory */
+                info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                if (attachment)
+                    info.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+                else if (m_resolve == MsaaResolve::Blit)
+                    info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                else
+                    info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+                m_multisampled = m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT, attachment ? m_transientMemory : VMA_MEMORY_USAGE_AUTO);
+                views[0] = m_multisampled.view;
+                views[2] = m_resolved.view;
+            }
+            info.format = VK_FORMAT_D32_SFLOAT;
+            info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            m_depth = m_context.createImage(info, VK_IMAGE_ASPECT_DEPTH_BIT, m_transientMemory);
+            views[1] = m_depth.view;
+
+            VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+            framebufferInfo.renderPass = m_scenePass;
+            framebufferInfo.attachmentCount = attachment && m_samples > 1 ? 3 : 2;
+            framebufferInfo.pAttachments = views;
+            framebufferInfo.width = m_width;
+            framebufferInfo.height = m_height;
+            framebufferInfo.layers = 1;
+            VK_CHECK(vkCreateFramebuffer(device, &framebufferInfo, vulkanHostAllocator(), &m_framebuffer));
+
+            VK_CHECK(vkResetDescriptorPool(device, m_descriptorPool, 0));
+            m_presentSet = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+            VkDescriptorImageInfo images[3] = {
+                { m_sampler, m_resolved.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { m_sampler, m_multisampled.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+                { VK_NULL_HANDLE, m_resolved.view, VK_IMAGE_LAYOUT_GENERAL },
+            };
+            VkWriteDescriptorSet writes[3];
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                writes[i].dstSet = m_presentSet;
+                writes[i].dstBinding = 0;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[i].pImageInfo = &images[i];
+            }
+            uint32_t writeCount = 1;
+            if (m_resolve == MsaaResolve::Compute && m_samples > 1)
+            {
+                m_resolveSet = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                writes[1].dstSet = m_resolveSet;
+                writes[2].dstSet = m_resolveSet;
+                writes[2].dstBinding = 1;
+                writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                writeCount = 3;
+            }
+            vkUpdateDescriptorSets(device, writeCount, writes, 0, nullptr);
+        }
+
+        void destroyTargets()
+        {
+            vkDestroyFramebuffer(m_context.device(), m_framebuffer, vulkanHostAllocator());
+            m_framebuffer = VK_NULL_HANDLE;
+            m_context.destroyImage(m_multisampled);
+            m_context.destroyImage(m_depth);
+            m_context.destroyImage(m_resolved);
+        }
+
+        VulkanContext& m_context;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_presentSet = VK_NULL_HANDLE;
+        VkDescriptorSet m_resolveSet = VK_NULL_HANDLE;
+        VkRenderPass m_scenePass = VK_NULL_HANDLE;
+        VkPipeline m_scenePipeline = VK_NULL_HANDLE;
+        VkPipeline m_presentPipeline = VK_NULL_HANDLE;
+        VkPipeline m_resolvePipeline = VK_NULL_HANDLE;
+        VulkanImage m_multisampled;
+        VulkanImage m_depth;
+        VulkanImage m_resolved;
+        VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+        /* Lazily allocated where the device has such memory, like the render target pool's transient targets */
+        VmaMemoryUsage m_transientMemory = VMA_MEMORY_USAGE_AUTO;
+    };
+}
+
+std::unique_ptr<Scenario> createMsaaScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<MsaaScenarioVulkan>(context, options);
+}
@@ -3,43 +3,165 @@
 
 #include <iostream>
 
-#include "GLFW/glfw3.h"
+#include "Config.h"
+#include "GLContext.h"
+#include "VulkanContext.h"
 
-#include <vulkan/vulkan.h>
+#include "GLFW/glfw3.h"
 
 #include <assert.h>
 
-int main()
+#include "AllocationTracker.h"
+#include "Benchmark.h"
+#include "FrameArena.h"
+#include "FrameLimiter.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+#include "Timer.h"
+
+#ifdef VULKAN_TEST
+using Backend = VulkanContext;
+#else
+using Backend = GLContext;
+#endif
+
+static std::unique_ptr<Scenario> createScenario(const ScenarioEntry& entry, GLContext& context, const Options& options)
+{
+    return entry.createGL(context, options);
+}
+
+static std::unique_ptr<Scenario> createScenario(const ScenarioEntry& entry, VulkanContext& context, const Options& options)
 {
-    
+    return entry.createVulkan(context, options);
+}
+
+int main(int argc, char** argv)
+{
+    Options options(argc, argv);
+    if (options.has("help"))
+    {
+        std::cout << "Usage: PerformanceTest [--scenario name] [--frames n] [--warmup n] [--width n] [--height n] [--frame-arena-mb n] [--spirv on|off] [--fps-limit n]\n"
+                     "                       [--swap-interval 1|0|-1] [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--swapchain-images n] [scenario options]\n";
+        printScenarios();
+        return 0;
+    }
+
+    std::string scenarioName = options.getString("scenario", "clear");
+    const ScenarioEntry* entry = findScenario(scenarioName.c_str());
+    if (!entry)
+    {
+        std::cerr << "Unknown scenario '" << scenarioName << "'\n";
+        printScenarios();
+        return -1;
+    }
+
+    /* 0 runs until the window is closed */
+    uint64_t frameCount = uint64_t(options.getInt("frames", 0));
+    uint64_t warmupFrames = uint64_t(options.getInt("warmup", 60));
+    size_t frameArenaSize = size_t(options.getInt("frame-arena-mb", 64)) * 1024 * 1024;
+    /* Shaders compiled to SPIR-V at build time skip the GLSL compiler, off compiles everything from source */
+    setEmbeddedShadersEnabled(options.getBool("spirv", true));
+
     GLFWwindow* window;
 
     /* Initialize the library */
     if (!glfwInit())
         return -1;
 
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
+    /* A fixed size window, a resize in the middle of a run would invalidate the measurement */
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+#ifdef VULKAN_TEST
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef _DEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+#endif
+
+    /* Create a windowed mode window */
+    window = glfwCreateWindow(int(options.getInt("width", 640)), int(options.getInt("height", 480)), "PerformanceTest", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
         return -1;
     }
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
-
-    /* Loop until the user closes the window */
-    while (!glfwWindowShouldClose(window))
     {
-        /* Render here */
-        glClear(GL_COLOR_BUFFER_BIT);
+        Backend backend(window, options);
+        std::unique_ptr<Scenario> scenario = createScenario(*entry, backend, options);
+        FrameArenas frameArenas(frameArenaSize, Backend::kFramesInFlight);
+        FrameAllocationMonitor allocationMonitor;
+        FrameLimiter limiter(options);
+
+        Statistics frameTimes;
+        Statistics cpuTimes;
+        Timer runTimer;
+        Timer frameTimer;
+
+        /* Loop until the user closes the window or the requested frames are measured */
+        for (uint64_t index = 0; !glfwWindowShouldClose(window) && (frameCount == 0 || index < warmupFrames + frameCount); ++index)
+        {
+            FrameInfo frame;
+            frame.index = index;
+            frame.measured = index >= warmupFrames;
+            allocationMonitor.beginFrame(frame);
+            setAllocationPhase("main loop");
+            frame.arena = &frameArenas.beginFrame(frame);
+            if (index == warmupFrames)
+                runTimer.reset();
+
+            Timer cpuTimer;
+            setAllocationPhase("backend begin");
+            backend.beginFrame(frame);
+            setAllocationPhase("update");
+            scenario->update(frame);
+            setAllocationPhase("render");
+            scenario->render(frame);
+            double cpuTime = cpuTimer.elapsedMs();
+            setAllocationPhase("main loop");
+            frameArenas.endFrame(frame);
+
+            /* Submit, swap front and back buffers */
+            setAllocationPhase("backend end");
+            backend.endFrame();
+
+            /* Before the input poll, so the next frame starts from fresh input */
+            setAllocationPhase("limiter");
+            limiter.wait(frame);
+
+            /* Poll for and process events */
+            setAllocationPhase("events");
+            glfwPollEvents();
+            setAllocationPhase("main loop");
 
-        /* Swap front and back buffers */
-        glfwSwapBuffers(window);
+            if (frame.measured)
+            {
+                cpuTimes.add(cpuTime);
+                frameTimes.add(frameTimer.elapsedMs());
+            }
+            frameTimer.reset();
+            allocationMonitor.endFrame(frame);
+        }
+        setAllocationPhase("shutdown");
+        backend.waitIdle();
+        double runTime = runTimer.elapsedMs();
 
-        /* Poll for and process events */
-        glfwPollEvents();
+        Report report;
+        report.addText("backend", BACKEND_NAME);
+        report.addText("scenario", entry->name);
+        backend.report(report);
+        report.addValue("frames", double(frameTimes.count()), "");
+        report.addValue("fps", frameTimes.count() ? double(frameTimes.count()) * 1000.0 / runTime : 0.0, "");
+        report.addStatistics("frame", frameTimes, "ms");
+        report.addStatistics("cpu record", cpuTimes, "ms");
+        frameArenas.report(report);
+        allocationMonitor.report(report);
+        limiter.report(report);
+        scenario->report(report);
+        report.print(std::cout);
     }
 
     glfwTerminate();
@@ -0,0 +1,55 @@
+#include "Permutations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+PermutationScenario::PermutationScenario(const Options& options)
+{
+    uint32_t count = uint32_t(options.getInt("draws", 2000));
+    m_permutationCount = uint32_t(options.getInt("permutations", 64));
+    m_initialCount = uint32_t(options.getInt("initial", 4));
+    m_interval = uint32_t(options.getInt("interval", 30));
+    m_hitchMs = options.getDouble("hitch-ms", 8.0);
+    if (count == 0 || m_permutationCount == 0 || m_initialCount == 0 || m_interval == 0)
+        fatal("--draws, --permutations, --initial and --interval have to be at least 1");
+    m_initialCount = std::min(m_initialCount, m_permutationCount);
+
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(count)))));
+    float cell = 2.0f / float(side);
+    m_draws.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_draws[i].rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        m_draws[i].color = { 1.0f, 1.0f, 1.0f, 0.5f };
+    }
+
+    std::printf("permutations: %u draws, %u of %u permutations at the start, a new one every %u frames\n", count, m_initialCount,
+                m_permutationCount, m_interval);
+}
+
+void PermutationScenario::update(const FrameInfo& frame)
+{
+    uint64_t introduced = frame.index / m_interval;
+    m_activeCount = uint32_t(std::min<uint64_t>(m_permutationCount, m_initialCount + introduced));
+}
+
+void PermutationScenario::recordFrame(double milliseconds, uint32_t fallbackDraws, bool measured)
+{
+    if (!measured)
+        return;
+    m_renderTimes.add(milliseconds);
+    m_fallbackDraws.add(double(fallbackDraws));
+    if (milliseconds > m_hitchMs)
+        ++m_hitchFrames;
+}
+
+void PermutationScenario::report(Report& report)
+{
+    report.addValue("draws", double(m_draws.size()), "");
+    report.addValue("permutations active", double(m_activeCount), "");
+    report.addStatistics("cpu render", m_renderTimes, "ms");
+    report.addValue("hitch frames", double(m_hitchFrames), "");
+    report.addValue("hitch threshold", m_hitchMs, "ms");
+    report.addStatistics("fallback draws", m_fallbackDraws, "");
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "Scenario.h"
+
+/* Push constants of shaders/permutations, same layout as DrawConstants in permutations.glsl */
+struct PermutationConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    Vec4 color;
+};
+
+/* A material permutation, the fragment shader variant and the blend state */
+struct Permutation
+{
+    uint32_t variant;
+    bool blend;
+};
+
+/*
+ * Backend independent part of the permutation scenario: --draws quads spread over the active
+ * material permutations. The run starts with --initial permutations and brings in a new one
+ * every --interval frames up to --permutations, the way a game streams in new materials. Even
+ * permutations add a shader variant, odd ones the blended state of the variant before. The
+ * backends draw with a fallback until a permutation is compiled or compile it on the spot, the
+ * render times show the hitches either way.
+ */
+class PermutationScenario : public Scenario
+{
+public:
+    PermutationScenario(const Options& options);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    static Permutation permutation(uint32_t index) { return { index / 2, (index & 1) != 0 }; }
+
+    uint32_t variantCount() const { return (m_permutationCount + 1) / 2; }
+    /* The draws of permutation p are [firstDraw(p), firstDraw(p + 1)) */
+    uint32_t firstDraw(uint32_t permutation) const { return uint32_t(uint64_t(m_draws.size()) * permutation / m_activeCount); }
+    void recordFrame(double milliseconds, uint32_t fallbackDraws, bool measured);
+
+    std::vector<PermutationConstants> m_draws;
+    uint32_t m_permutationCount;
+    /* Permutations drawn this frame */
+    uint32_t m_activeCount = 0;
+
+private:
+    uint32_t m_initialCount;
+    uint32_t m_interval;
+    double m_hitchMs;
+
+    Statistics m_renderTimes;
+    Statistics m_fallbackDraws;
+    uint64_t m_hitchFrames = 0;
+};
+
+std::unique_ptr<Scenario> createPermutationScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createPermutationScenarioVulkan(VulkanContext& context, const Options& options);
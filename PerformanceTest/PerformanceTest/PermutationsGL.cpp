@@ -0,0 +1,142 @@
+#include "Permutations.h"
+
+#include <cstdio>
+#include <string>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    bool parseCompile(const std::string& compile)
+    {
+        if (compile == "parallel")
+            return true;
+        if (compile == "sync")
+            return false;
+        fatal("Unknown --compile '%s', expected parallel or sync", compile.c_str());
+    }
+
+    /*
+     * OpenGL compiles a program when it is created, --compile sync blocks the frame that first
+     * needs it. --compile parallel hands it to the driver's compiler threads through
+     * KHR_parallel_shader_compile and draws the fallback until GL_COMPLETION_STATUS_KHR is set.
+     * Either way the driver may still recompile behind the application's back when a program
+     * meets new state, the blended permutations are there to catch that.
+     */
+    class PermutationScenarioGL : public PermutationScenario
+    {
+    public:
+        PermutationScenarioGL(GLContext& context, const Options& options)
+            : PermutationScenario(options)
+            , m_context(context)
+            , m_parallel(parseCompile(options.getString("compile", "parallel")))
+        {
+            if (m_parallel && !m_context.extensions().parallelShaderCompile)
+            {
+                std::printf("permutations: KHR_parallel_shader_compile is not supported, falling back to sync\n");
+                m_parallel = false;
+            }
+            if (m_parallel)
+                m_context.extensions().maxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+            m_fallback = createProgram("permutations/quad.vert", "permutations/quad.frag", { { "FALLBACK", "1" } });
+            m_variants.resize(variantCount());
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~PermutationScenarioGL() override
+        {
+            for (Variant& variant : m_variants)
+                glDeleteProgram(variant.program);
+            glDeleteProgram(m_fallback);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            GLStateCache& state = m_context.state();
+            m_context.profiler().begin("draw");
+            Timer timer;
+            uint32_t fallbackDraws = 0;
+            state.bindVertexArray(m_vertexArray);
+            state.setDepthTest(false);
+            state.setCullFace(false);
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            for (uint32_t p = 0; p < m_activeCount; ++p)
+            {
+                Permutation permutation = PermutationScenario::permutation(p);
+                GLuint program = this->program(permutation.variant);
+                uint32_t begin = firstDraw(p);
+                uint32_t end = firstDraw(p + 1);
+                if (program == m_fallback)
+                    fallbackDraws += end - begin;
+
+                state.useProgram(program);
+                state.setBlend(permutation.blend);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    m_context.pushConstants(&m_draws[i], sizeof(PermutationConstants));
+                    glDrawArrays(GL_TRIANGLES, 0, 6);
+                }
+            }
+            state.setBlend(false);
+            recordFrame(timer.elapsedMs(), fallbackDraws, frame.measured);
+            m_context.profiler().end();
+        }
+
+        void report(Report& report) override
+        {
+            report.addText("compile", m_parallel ? "parallel" : "sync");
+            PermutationScenario::report(report);
+        }
+
+    private:
+        struct Variant
+        {
+            GLuint program = 0;
+            bool ready = false;
+        };
+
+        /* The variant's program once it can be drawn with, the fallback before */
+        GLuint program(uint32_t index)
+        {
+            Variant& variant = m_variants[index];
+            if (variant.ready)
+                return variant.program;
+
+            if (!variant.program)
+            {
+                ShaderDefines defines = { { "VARIANT", std::to_string(index) } };
+                if (!m_parallel)
+                {
+                    variant.program = createProgram("permutations/quad.vert", "permutations/quad.frag", defines);
+                    variant.ready = true;
+                    return variant.program;
+                }
+                variant.program = startProgram("permutations/quad.vert", "permutations/quad.frag", defines);
+            }
+            if (!programCompleted(variant.program))
+                return m_fallback;
+            finishProgram(variant.program);
+            variant.ready = true;
+            return variant.program;
+        }
+
+        GLContext& m_context;
+        bool m_parallel;
+        GLuint m_fallback = 0;
+        std::vector<Variant> m_variants;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createPermutationScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<PermutationScenarioGL>(context, options);
+}
@@ -0,0 +1,118 @@
+#include "Permutations.h"
+
+#include <string>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+#include "VulkanPipelineCache.h"
+
+namespace
+{
+    /*
+     * The shader modules of all variants are created up front, like SPIR-V shipped with the
+     * application. The pipelines are what a new permutation costs on Vulkan, they come from a
+     * VulkanPipelineCache: compiled by --pipeline-threads workers (0 blocks the render thread)
+     * and, with --pipeline-library on, assembled from graphics pipeline libraries.
+     */
+    class PermutationScenarioVulkan : public PermutationScenario
+    {
+    public:
+        PermutationScenarioVulkan(VulkanContext& context, const Options& options)
+            : PermutationScenario(options)
+            , m_context(context)
+            , m_cache(context, uint32_t(options.getInt("pipeline-threads", 2)), options.getBool("pipeline-library", true))
+        {
+            m_pipelineLayout = m_context.createPipelineLayout({}, sizeof(PermutationConstants));
+            m_vertexShader = m_context.createShaderModule("permutations/quad.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            m_fragmentShaders.resize(variantCount());
+            for (uint32_t i = 0; i < variantCount(); ++i)
+                m_fragmentShaders[i] = m_context.createShaderModule("permutations/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT,
+                                                                    { { "VARIANT", std::to_string(i) } });
+
+            m_descs.resize(m_permutationCount);
+            for (uint32_t p = 0; p < m_permutationCount; ++p)
+            {
+                Permutation permutation = PermutationScenario::permutation(p);
+                GraphicsPipelineDesc& desc = m_descs[p];
+                desc.layout = m_pipelineLayout;
+                desc.renderPass = m_context.swapchainRenderPass();
+                desc.vertexShader = m_vertexShader;
+                desc.fragmentShader = m_fragmentShaders[permutation.variant];
+                desc.cullMode = VK_CULL_MODE_NONE;
+                desc.depthTest = false;
+                desc.depthWrite = false;
+                desc.alphaBlend = permutation.blend;
+            }
+
+            GraphicsPipelineDesc fallback = m_descs[0];
+            fallback.fragmentShader = m_context.createShaderModule("permutations/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT, { { "FALLBACK", "1" } });
+            m_fallback = m_context.createGraphicsPipeline(fallback);
+            vkDestroyShaderModule(m_context.device(), fallback.fragmentShader, vulkanHostAllocator());
+        }
+
+        ~PermutationScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            m_cache.waitIdle();
+
+            vkDestroyPipeline(device, m_fallback, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            /* The cache destroys its pipelines after this body, shader modules are not needed by them anymore */
+            vkDestroyShaderModule(device, m_vertexShader, vulkanHostAllocator());
+            for (VkShaderModule module : m_fragmentShaders)
+                vkDestroyShaderModule(device, module, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "draw");
+
+            Timer timer;
+            uint32_t fallbackDraws = 0;
+            for (uint32_t p = 0; p < m_activeCount; ++p)
+            {
+                VkPipeline pipeline = m_cache.get(m_descs[p], m_fallback);
+                uint32_t begin = firstDraw(p);
+                uint32_t end = firstDraw(p + 1);
+                if (pipeline == m_fallback)
+                    fallbackDraws += end - begin;
+
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(PermutationConstants), &m_draws[i]);
+                    vkCmdDraw(cmd, 6, 1, 0, 0);
+                }
+            }
+            recordFrame(timer.elapsedMs(), fallbackDraws, frame.measured);
+
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+        void report(Report& report) override
+        {
+            PermutationScenario::report(report);
+            m_cache.report(report);
+        }
+
+    private:
+        VulkanContext& m_context;
+        VulkanPipelineCache m_cache;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkShaderModule m_vertexShader = VK_NULL_HANDLE;
+        std::vector<VkShaderModule> m_fragmentShaders;
+        /* Indexed by permutation */
+        std::vector<GraphicsPipelineDesc> m_descs;
+        VkPipeline m_fallback = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createPermutationScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<PermutationScenarioVulkan>(context, options);
+}
@@ -0,0 +1,199 @@
+#include "PostChain.h"
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    PostStages parseStages(const std::string& stages)
+    {
+        if (stages == "fragment")
+            return PostStages::Fragment;
+        if (stages == "compute")
+            return PostStages::Compute;
+        fatal("Unknown --post '%s', expected fragment or compute", stages.c_str());
+    }
+
+    /* Luma above the threshold blooms, the scene's spots reach 16 */
+    constexpr float kBloomThreshold = 1.0f;
+    constexpr float kBloomIntensity = 0.1f;
+    constexpr float kExposure = 1.0f;
+
+    /* Level i of the bloom is 1 / 2^i of the resolution, upsample i writes level i */
+    const char* const kDownsampleZones[PostChainScenario::kMaxBloomLevels] = {
+        "bloom down 1", "bloom down 2", "bloom down 3", "bloom down 4", "bloom down 5", "bloom down 6", "bloom down 7", "bloom down 8",
+    };
+    const char* const kUpsampleZones[PostChainScenario::kMaxBloomLevels - 1] = {
+        "bloom up 1", "bloom up 2", "bloom up 3", "bloom up 4", "bloom up 5", "bloom up 6", "bloom up 7",
+    };
+
+    double gigabytesPerSecond(uint64_t bytes, double milliseconds)
+    {
+        return milliseconds > 0.0 ? double(bytes) / (milliseconds * 1e-3) * 1e-9 : 0.0;
+    }
+}
+
+PostChainScenario::PostChainScenario(const Options& options)
+    : m_stages(parseStages(options.getString("post", "fragment")))
+    , m_fxaa(options.getBool("fxaa", true))
+{
+    m_fixedResolution = parseRenderResolution(options.getString("resolution", "window"), m_fixedWidth, m_fixedHeight);
+    int64_t levels = options.getInt("bloom-levels", 6);
+    if (levels < 0 || levels > int64_t(kMaxBloomLevels))
+        fatal("--bloom-levels has to be between 0 and %u", kMaxBloomLevels);
+    m_bloomLevels = uint32_t(levels);
+
+    std::printf("post: %s passes, %u bloom levels, fxaa %s\n", m_stages == PostStages::Compute ? "compute" : "fragment", m_bloomLevels,
+                m_fxaa ? "on" : "off");
+}
+
+RenderTargetPooling PostChainScenario::pooling(const Options& options)
+{
+    return parseRenderTargetPooling(options.getString("pooling", "alias"));
+}
+
+RenderGraphBarriers PostChainScenario::barriers(const Options& options)
+{
+    return parseRenderGraphBarriers(options.getString("barriers", "minimal"));
+}
+
+ShaderDefines PostChainScenario::passDefines(PostPassKind kind)
+{
+    return { { "PASS", std::to_string(uint32_t(kind)) } };
+}
+
+bool PostChainScenario::compute(PostPassKind kind) const
+{
+    return m_stages == PostStages::Compute && kind != PostPassKind::Scene && kind != PostPassKind::Present;
+}
+
+bool PostChainScenario::updateGraph(RenderGraph& graph, uint32_t windowWidth, uint32_t windowHeight)
+{
+    uint32_t width = m_fixedResolution ? m_fixedWidth : windowWidth;
+    uint32_t height = m_fixedResolution ? m_fixedHeight : windowHeight;
+    if (width == m_width && height == m_height && windowWidth == m_windowWidth && windowHeight == m_windowHeight)
+        return false;
+    m_width = width;
+    m_height = height;
+    m_windowWidth = windowWidth;
+    m_windowHeight = windowHeight;
+    graph.reset();
+    m_passes.clear();
+
+    m_activeLevels = m_bloomLevels;
+    while (m_activeLevels > 0 && ((width >> m_activeLevels) == 0 || (height >> m_activeLevels) == 0))
+        --m_activeLevels;
+
+    const uint32_t none = RenderGraph::kNoResource;
+    auto createTarget = [&](const char* name, PostPassKind kind, uint32_t level, RenderTargetFormat format)
+    {
+        RenderTargetDesc desc = { width >> level, height >> level, format, 1, false, compute(kind) };
+        return graph.createTexture(name, desc);
+    };
+    auto addChainPass = [&](PostPassKind kind, const char* zone, uint32_t target, uint32_t source, uint32_t secondSource)
+    {
+        PostPass pass = { kind, target, { source, secondSource == none ? source : secondSource }, {}, zone, 0 };
+        float targetWidth = float(target == none ? windowWidth : graph.desc(target).width);
+        float targetHeight = float(target == none ? windowHeight : graph.desc(target).height);
+        pass.constants.texel = { 0.0f, 0.0f, 1.0f / targetWidth, 1.0f / targetHeight };
+        if (source != none)
+        {
+            const RenderTargetDesc& desc = graph.desc(source);
+            pass.constants.texel.x = 1.0f / float(desc.width);
+            pass.constants.texel.y = 1.0f / float(desc.height);
+        }
+        bool threshold = kind == PostPassKind::Downsample && source == m_passes[0].target;
+        pass.constants.params = { threshold ? kBloomThreshold : 0.0f, m_activeLevels > 0 ? kBloomIntensity : 0.0f, kExposure, 0.0f };
+
+        /* The swapchain is RGBA8 or BGRA8 */
+        pass.bytes = target == none ? uint64_t(windowWidth) * windowHeight * 4 : renderTargetSize(graph.desc(target));
+        if (source != none)
+            pass.bytes += renderTargetSize(graph.desc(source));
+        if (pass.sources[1] != pass.sources[0])
+            pass.bytes += renderTargetSize(graph.desc(pass.sources[1]));
+        m_passes.push_back(pass);
+    };
+
+    uint32_t scene = createTarget("scene", PostPassKind::Scene, 0, RenderTargetFormat::RGBA16F);
+    addChainPass(PostPassKind::Scene, "scene", scene, none, none);
+
+    uint32_t levels[kMaxBloomLevels + 1] = { scene };
+    for (uint32_t level = 1; level <= m_activeLevels; ++level)
+    {
+        levels[level] = createTarget("bloom down", PostPassKind::Downsample, level, RenderTargetFormat::RGBA16F);
+        addChainPass(PostPassKind::Downsample, kDownsampleZones[level - 1], levels[level], levels[level - 1], none);
+    }
+    uint32_t bloom = m_activeLevels > 0 ? levels[m_activeLevels] : none;
+    for (uint32_t level = m_activeLevels; level-- > 1;)
+    {
+        uint32_t target = createTarget("bloom up", PostPassKind::Upsample, level, RenderTargetFormat::RGBA16F);
+        addChainPass(PostPassKind::Upsample, kUpsampleZones[level - 1], target, bloom, levels[level]);
+        bloom = target;
+    }
+
+    uint32_t output = createTarget("tonemapped", PostPassKind::Tonemap, 0, RenderTargetFormat::RGBA8);
+    addChainPass(PostPassKind::Tonemap, "tonemap", output, scene, bloom);
+    if (m_fxaa)
+    {
+        uint32_t antialiased = createTarget("antialiased", PostPassKind::Fxaa, 0, RenderTargetFormat::RGBA8);
+        addChainPass(PostPassKind::Fxaa, "fxaa", antialiased, output, none);
+        output = antialiased;
+    }
+    addChainPass(PostPassKind::Present, "present", none, output, none);
+
+    for (uint32_t p = 0; p < m_passes.size(); ++p)
+    {
+        const PostPass& pass = m_passes[p];
+        uint32_t graphPass = addPass(pass.zone, p);
+        bool dispatch = compute(pass.kind);
+        if (pass.target != none)
+        {
+            if (dispatch)
+                graph.write(graphPass, pass.target, RenderGraphAccess::StorageWriteCompute);
+            else
+                graph.colorAttachment(graphPass, pass.target);
+        }
+        for (uint32_t source : pass.sources)
+            if (source != none)
+                graph.read(graphPass, source, dispatch ? RenderGraphAccess::SampledCompute : RenderGraphAccess::SampledGraphics);
+        /* Draws to the swapchain, which is not part of the graph */
+        if (pass.kind == PostPassKind::Present)
+            graph.setSideEffect(graphPass);
+    }
+    return graph.compile();
+}
+
+void PostChainScenario::report(Report& report)
+{
+    char resolution[32];
+    std::snprintf(resolution, sizeof(resolution), "%ux%u", m_width, m_height);
+    report.addText("post passes", m_stages == PostStages::Compute ? "compute" : "fragment");
+    report.addText("post resolution", resolution);
+    report.addValue("bloom levels", double(m_activeLevels), "");
+    report.addText("fxaa", m_fxaa ? "on" : "off");
+
+    /* The chain proper, without the scene it starts from and the present it ends in */
+    uint64_t chainBytes = 0;
+    double chainMs = 0.0;
+    bool timed = true;
+    for (const PostPass& pass : m_passes)
+    {
+        if (pass.kind == PostPassKind::Scene || pass.kind == PostPassKind::Present)
+            continue;
+        chainBytes += pass.bytes;
+        const Statistics* times = zoneTimes(pass.zone);
+        if (!times)
+        {
+            timed = false;
+            continue;
+        }
+        chainMs += times->mean();
+        report.addValue(std::string(pass.zone) + " bandwidth", gigabytesPerSecond(pass.bytes, times->mean()), "GB/s");
+    }
+    report.addValue("post traffic per frame", double(chainBytes) / (1024.0 * 1024.0), "MiB");
+    if (timed)
+    {
+        report.addValue("gpu post chain", chainMs, "ms");
+        report.addValue("post chain bandwidth", gigabytesPerSecond(chainBytes, chainMs), "GB/s");
+    }
+}
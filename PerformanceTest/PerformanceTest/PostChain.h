@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "RenderGraph.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Push constants of shaders/post, same layout as PassConstants in post.glsl */
+struct PostConstants
+{
+    /* xy texel size of the first source, zw texel size of the target */
+    Vec4 texel;
+    /* x bloom threshold, 0 for no threshold, y bloom intensity, z exposure */
+    Vec4 params;
+};
+
+/* --post fragment|compute */
+enum class PostStages
+{
+    /* Every pass draws a full screen triangle into its target */
+    Fragment,
+    /* Every pass is a dispatch of 8x8 workgroups writing its target as a storage image */
+    Compute
+};
+
+/* Same values as the PASS_ defines of post.glsl */
+enum class PostPassKind : uint32_t
+{
+    /* Procedural HDR input of the chain, always a fragment pass */
+    Scene,
+    /* 13 tap downsample to the next bloom level, the first one applies the bloom threshold */
+    Downsample,
+    /* 3x3 tent upsample of the smaller level added to the level's downsample */
+    Upsample,
+    /* Adds the bloom, exposes and tonemaps into RGBA8 with luma in alpha */
+    Tonemap,
+    Fxaa,
+    /* Scales the result to the swapchain, always a fragment pass */
+    Present,
+    kCount
+};
+
+struct PostPass
+{
+    PostPassKind kind;
+    /* Graph textures, RenderGraph::kNoResource where unused. The second source repeats the first if the pass has only one */
+    uint32_t target;
+    uint32_t sources[2];
+    PostConstants constants;
+    /* Profiler zone of the pass */
+    const char* zone;
+    /* Bytes of every source read once and the target written once */
+    uint64_t bytes;
+};
+
+/*
+ * Backend independent part of the post processing scenario: a procedural HDR image at
+ * --resolution window|720p|1080p|1440p|4k|<w>x<h> goes through a bloom of --bloom-levels n
+ * downsamples and the upsamples back, a tonemap and --fxaa on|off, then is scaled to the
+ * swapchain. --post fragment|compute runs the chain as full screen draws or as compute
+ * dispatches, both through the backend's RenderGraph. Every pass has a profiler zone of its own,
+ * the report adds the bytes each pass moves at least and the bandwidth that makes at its GPU time.
+ */
+class PostChainScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kMaxBloomLevels = 8;
+    static constexpr uint32_t kWorkgroupSize = 8;
+
+    PostChainScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* Rebuilds m_passes and the graph if the window or the chain size changed, true if the targets were recreated */
+    bool updateGraph(RenderGraph& graph, uint32_t windowWidth, uint32_t windowHeight);
+    /* Adds pass `index` of m_passes to the graph with the backend's callback */
+    virtual uint32_t addPass(const char* name, uint32_t index) = 0;
+    /* Measured GPU times of a zone, nullptr before its first result */
+    virtual const Statistics* zoneTimes(const char* zone) const = 0;
+
+    static ShaderDefines passDefines(PostPassKind kind);
+    /* Whether the pass runs as a dispatch, the scene and present passes never do */
+    bool compute(PostPassKind kind) const;
+    static RenderTargetPooling pooling(const Options& options);
+    static RenderGraphBarriers barriers(const Options& options);
+
+    PostStages m_stages;
+    std::vector<PostPass> m_passes;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+
+private:
+    bool m_fxaa;
+    /* --resolution, unless it follows the window */
+    bool m_fixedResolution;
+    uint32_t m_fixedWidth = 0;
+    uint32_t m_fixedHeight = 0;
+    uint32_t m_bloomLevels;
+    /* Levels that fit the resolution, at most m_bloomLevels */
+    uint32_t m_activeLevels = 0;
+    uint32_t m_windowWidth = 0;
+    uint32_t m_windowHeight = 0;
+};
+
+std::unique_ptr<Scenario> createPostChainScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createPostChainScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,111 @@
+#include "PostChain.h"
+
+#include "GLContext.h"
+#include "GLRenderGraph.h"
+
+namespace
+{
+    /*
+     * Targets come from the GLRenderGraph's pool. Fragment passes draw into the framebuffer the
+     * graph bound, compute passes bind their target with glBindImageTexture and dispatch, the
+     * graph puts a glMemoryBarrier for texture fetches between a dispatch and the pass sampling
+     * its target. Only the programs of the chosen --post are built.
+     */
+    class PostChainScenarioGL : public PostChainScenario
+    {
+    public:
+        PostChainScenarioGL(GLContext& context, const Options& options)
+            : PostChainScenario(options)
+            , m_context(context)
+            , m_graph(context.state(), pooling(options), barriers(options))
+        {
+            for (uint32_t k = 0; k < uint32_t(PostPassKind::kCount); ++k)
+            {
+                PostPassKind kind = PostPassKind(k);
+                if (compute(kind))
+                    m_programs[k] = createComputeProgram("post/post.comp", passDefines(kind));
+                else
+                    m_programs[k] = createProgram("post/fullscreen.vert", "post/post.frag", passDefines(kind));
+            }
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~PostChainScenarioGL() override
+        {
+            for (GLuint program : m_programs)
+                glDeleteProgram(program);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            updateGraph(m_graph, uint32_t(m_context.width()), uint32_t(m_context.height()));
+
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.setBlend(false);
+            state.setCullFace(false);
+            state.setDepthTest(false);
+            m_graph.execute();
+        }
+
+        void report(Report& report) override
+        {
+            PostChainScenario::report(report);
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, uint32_t index) override
+        {
+            return m_graph.addPass(name, [this, index] { renderPass(index); });
+        }
+
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        /* Runs with the pass's framebuffer bound unless the pass dispatches */
+        void renderPass(uint32_t p)
+        {
+            GLStateCache& state = m_context.state();
+            const PostPass& pass = m_passes[p];
+            m_context.profiler().begin(pass.zone);
+            if (pass.kind == PostPassKind::Present)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, m_context.width(), m_context.height());
+            }
+            state.useProgram(m_programs[uint32_t(pass.kind)]);
+            if (pass.sources[0] != RenderGraph::kNoResource)
+            {
+                state.bindTextureUnit(0, m_graph.texture(pass.sources[0]));
+                state.bindTextureUnit(1, m_graph.texture(pass.sources[1]));
+            }
+            m_context.pushConstants(&pass.constants, sizeof(pass.constants));
+
+            if (compute(pass.kind))
+            {
+                const RenderTargetDesc& desc = m_graph.desc(pass.target);
+                glBindImageTexture(2, m_graph.texture(pass.target), 0, GL_FALSE, 0, GL_WRITE_ONLY, GLRenderTargetPool::internalFormat(desc.format));
+                glDispatchCompute((desc.width + kWorkgroupSize - 1) / kWorkgroupSize, (desc.height + kWorkgroupSize - 1) / kWorkgroupSize, 1);
+            }
+            else
+            {
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+            m_context.profiler().end();
+        }
+
+        GLContext& m_context;
+        GLRenderGraph m_graph;
+        GLuint m_programs[uint32_t(PostPassKind::kCount)] = {};
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createPostChainScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<PostChainScenarioGL>(context, options);
+}
@@ -0,0 +1,202 @@
+#include "PostChain.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderGraph.h"
+
+namespace
+{
+    /*
+     * Targets, render passes and framebuffers come from the VulkanRenderGraph's pool. Compute
+     * passes write their target as a storage image in GENERAL layout, the graph transitions it
+     * to SHADER_READ_ONLY_OPTIMAL for the pass sampling it, so with --post compute the chain
+     * begins no render pass between the scene and the present. One descriptor set per pass,
+     * rewritten whenever the pool recreated the targets.
+     */
+    class PostChainScenarioVulkan : public PostChainScenario
+    {
+    public:
+        /* Scene, the downsamples and upsamples, tonemap, FXAA and present */
+        static constexpr uint32_t kMaxPasses = 2 * kMaxBloomLevels + 3;
+
+        PostChainScenarioVulkan(VulkanContext& context, const Options& options)
+            : PostChainScenario(options)
+            , m_context(context)
+            , m_graph(context, pooling(options), barriers(options))
+        {
+            VkDevice device = m_context.device();
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_LINEAR;
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            VK_CHECK(vkCreateSampler(device, &samplerInfo, vulkanHostAllocator(), &m_sampler));
+
+            const VkShaderStageFlags sampling = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, sampling, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, sampling, nullptr },
+                { 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(PostConstants));
+            m_descriptorPool = m_context.createDescriptorPool(kMaxPasses, {
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kMaxPasses * 2 },
+                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, kMaxPasses },
+            });
+
+            /* Only formats, sample counts and transient flags matter for the render passes, the sizes do not */
+            RenderTargetDesc hdr = { 1, 1, RenderTargetFormat::RGBA16F, 1, false };
+            RenderTargetDesc ldr = { 1, 1, RenderTargetFormat::RGBA8, 1, false };
+            VulkanRenderTargetPool& pool = m_graph.targets();
+            VkShaderModule vertexShader = m_context.createShaderModule("post/fullscreen.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            for (uint32_t k = 0; k < uint32_t(PostPassKind::kCount); ++k)
+            {
+                PostPassKind kind = PostPassKind(k);
+                if (compute(kind))
+                {
+                    VkShaderModule shader = m_context.createShaderModule("post/post.comp", VK_SHADER_STAGE_COMPUTE_BIT, passDefines(kind));
+                    m_pipelines[k] = m_context.createComputePipeline(m_pipelineLayout, shader);
+                    vkDestroyShaderModule(device, shader, vulkanHostAllocator());
+                    continue;
+                }
+
+                GraphicsPipelineDesc desc;
+                desc.layout = m_pipelineLayout;
+                if (kind == PostPassKind::Present)
+                    desc.renderPass = m_context.swapchainRenderPass();
+                else if (kind == PostPassKind::Tonemap || kind == PostPassKind::Fxaa)
+                    desc.renderPass = pool.renderPass({ ldr });
+                else
+                    desc.renderPass = pool.renderPass({ hdr });
+                desc.vertexShader = vertexShader;
+                desc.fragmentShader = m_context.createShaderModule("post/post.frag", VK_SHADER_STAGE_FRAGMENT_BIT, passDefines(kind));
+                desc.cullMode = VK_CULL_MODE_NONE;
+                desc.depthTest = false;
+                desc.depthWrite = false;
+                m_pipelines[k] = m_context.createGraphicsPipeline(desc);
+                vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+            }
+            vkDestroyShaderModule(device, vertexShader, vulkanHostAllocator());
+        }
+
+        ~PostChainScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            for (VkPipeline pipeline : m_pipelines)
+                vkDestroyPipeline(device, pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkExtent2D extent = m_context.swapchainExtent();
+            if (updateGraph(m_graph, extent.width, extent.height))
+                writeDescriptorSets();
+            m_graph.execute(m_context.commandBuffer());
+        }
+
+        void report(Report& report) override
+        {
+            PostChainScenario::report(report);
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, uint32_t index) override
+        {
+            return m_graph.addPass(name, [this, index](VkCommandBuffer cmd) { recordPass(cmd, index); });
+        }
+
+        const Statistics* zoneTimes(const char* zone) const override
+        {
+            return m_context.profiler().zoneTimes(zone);
+        }
+
+        /* Records inside the render pass the graph began for fragment passes, the present pass begins the swapchain's */
+        void recordPass(VkCommandBuffer cmd, uint32_t p)
+        {
+            const PostPass& pass = m_passes[p];
+            bool dispatch = compute(pass.kind);
+            VkPipelineBindPoint bindPoint = dispatch ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+            m_context.profiler().begin(cmd, pass.zone);
+            if (pass.kind == PostPassKind::Present)
+            {
+                const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                m_context.beginSwapchainPass(cmd, clearColor);
+            }
+            vkCmdBindPipeline(cmd, bindPoint, m_pipelines[uint32_t(pass.kind)]);
+            if (m_sets[p] != VK_NULL_HANDLE)
+                vkCmdBindDescriptorSets(cmd, bindPoint, m_pipelineLayout, 0, 1, &m_sets[p], 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(pass.constants), &pass.constants);
+            if (dispatch)
+            {
+                const RenderTargetDesc& desc = m_graph.desc(pass.target);
+                vkCmdDispatch(cmd, (desc.width + kWorkgroupSize - 1) / kWorkgroupSize, (desc.height + kWorkgroupSize - 1) / kWorkgroupSize, 1);
+            }
+            else
+            {
+                vkCmdDraw(cmd, 3, 1, 0, 0);
+            }
+            if (pass.kind == PostPassKind::Present)
+                vkCmdEndRenderPass(cmd);
+            m_context.profiler().end(cmd);
+        }
+
+        /* The scene pass samples nothing and has no set. The pool waited for the GPU before it recreated the targets */
+        void writeDescriptorSets()
+        {
+            VK_CHECK(vkResetDescriptorPool(m_context.device(), m_descriptorPool, 0));
+            m_sets.assign(m_passes.size(), VK_NULL_HANDLE);
+            for (uint32_t p = 0; p < m_passes.size(); ++p)
+            {
+                const PostPass& pass = m_passes[p];
+                if (pass.sources[0] == RenderGraph::kNoResource)
+                    continue;
+
+                VkDescriptorSet set = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                VkDescriptorImageInfo images[3];
+                VkWriteDescriptorSet writes[3];
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                    writes[i].dstSet = set;
+                    writes[i].dstBinding = i;
+                    writes[i].descriptorCount = 1;
+                    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writes[i].pImageInfo = &images[i];
+                }
+                for (uint32_t i = 0; i < 2; ++i)
+                    images[i] = { m_sampler, m_graph.image(pass.sources[i]).view, VulkanRenderGraph::imageLayout(RenderGraphLayout::ShaderRead) };
+                uint32_t writeCount = 2;
+                if (compute(pass.kind))
+                {
+                    images[2] = { VK_NULL_HANDLE, m_graph.image(pass.target).view, VulkanRenderGraph::imageLayout(RenderGraphLayout::General) };
+                    writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                    writeCount = 3;
+                }
+                vkUpdateDescriptorSets(m_context.device(), writeCount, writes, 0, nullptr);
+                m_sets[p] = set;
+            }
+        }
+
+        VulkanContext& m_context;
+        VulkanRenderGraph m_graph;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        /* Indexed by pass */
+        std::vector<VkDescriptorSet> m_sets;
+        VkPipeline m_pipelines[uint32_t(PostPassKind::kCount)] = {};
+    };
+}
+
+std::unique_ptr<Scenario> createPostChainScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<PostChainScenarioVulkan>(context, options);
+}
@@ -0,0 +1,47 @@
+# Runs a scenario once per present configuration and prints the pacing and latency lines of
+# every report. The backend is compiled in, pass the executable built with VULKAN_TEST as
+# -Api Vulkan and the one built with OPENGL_TEST as -Api OpenGL. Run it from the project
+# directory, the shaders are loaded relative to it.
+param(
+    [Parameter(Mandatory = $true)]
+    [string]$Executable,
+    [ValidateSet("OpenGL", "Vulkan")]
+    [string]$Api = "Vulkan",
+    [string]$Scenario = "clear",
+    [int]$Frames = 600,
+    [int]$Warmup = 120
+)
+
+$ErrorActionPreference = "Stop"
+
+$configs = New-Object System.Collections.Generic.List[object]
+if ($Api -eq "OpenGL")
+{
+    foreach ($interval in 0, 1, -1)
+    {
+        $configs.Add(@("--swap-interval", "$interval"))
+    }
+}
+else
+{
+    foreach ($mode in "immediate", "mailbox", "fifo", "fifo-relaxed")
+    {
+        foreach ($images in 2, 3, 4)
+        {
+            $configs.Add(@("--present-mode", $mode, "--swapchain-images", "$images"))
+        }
+    }
+}
+
+foreach ($config in $configs)
+{
+    Write-Output "== $($config -join ' ')"
+    $arguments = @("--scenario", $Scenario, "--frames", "$Frames", "--warmup", "$Warmup") + $config
+    $report = & $Executable @arguments
+    if ($LASTEXITCODE -ne 0)
+    {
+        throw "$Executable failed with $LASTEXITCODE for $($config -join ' ')"
+    }
+    # Fallback messages and the lines that differ between the configurations
+    $report | Select-String -Pattern "falling back|not supported|^(fps|frame|swap interval|present mode|swapchain images|latency.*|frame pacing) " | ForEach-Object { $_.Line }
+}
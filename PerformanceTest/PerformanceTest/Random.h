@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * xorshift32 for the generated scenes, lights and draws, which have to be identical for both
+ * backends and every run. `state` must not be 0.
+ */
+inline uint32_t random(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/* 16 bits in [0, 1] */
+inline float randomUnit(uint32_t& state)
+{
+    return float(random(state) & 0xFFFF) / float(0xFFFF);
+}
+
+/* 24 bits in [0, 1) */
+inline float random01(uint32_t& state)
+{
+    return float(random(state) & 0xFFFFFF) / float(0x1000000);
+}
@@ -0,0 +1,388 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t kAttachmentAccesses =
+        renderGraphAccessBit(RenderGraphAccess::ColorAttachment) | renderGraphAccessBit(RenderGraphAccess::DepthAttachment);
+}
+
+RenderGraphBarriers parseRenderGraphBarriers(const std::string& name)
+{
+    if (name == "minimal")
+        return RenderGraphBarriers::Minimal;
+    if (name == "full")
+        return RenderGraphBarriers::Full;
+    fatal("Unknown --barriers '%s', expected minimal or full", name.c_str());
+}
+
+RenderGraph::RenderGraph(RenderGraphBarriers barriers)
+    : m_barriers(barriers)
+{
+}
+
+void RenderGraph::reset()
+{
+    m_passes.clear();
+    m_resources.clear();
+    m_order.clear();
+    m_barrierList.clear();
+    m_layoutTransitions = 0;
+}
+
+uint32_t RenderGraph::createTexture(const char* name, const RenderTargetDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.imported = false;
+    resource.desc = desc;
+    m_resources.push_back(resource);
+    return uint32_t(m_resources.size() - 1);
+}
+
+uint32_t RenderGraph::importBuffer(const char* name)
+{
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    m_resources.push_back(resource);
+    return uint32_t(m_resources.size() - 1);
+}
+
+uint32_t RenderGraph::addPass(const char* name)
+{
+    Pass pass;
+    pass.name = name;
+    m_passes.push_back(pass);
+    return uint32_t(m_passes.size() - 1);
+}
+
+void RenderGraph::addUse(uint32_t pass, uint32_t resource, uint32_t accesses)
+{
+    if (resource >= m_resources.size())
+        fatal("Render graph pass '%s' uses an unknown resource", m_passes[pass].name);
+    for (Use& use : m_passes[pass].uses)
+        if (use.resource == resource)
+        {
+            use.accesses |= accesses;
+            return;
+        }
+    m_passes[pass].uses.push_back({ resource, accesses });
+}
+
+void RenderGraph::colorAttachment(uint32_t pass, uint32_t texture, bool load)
+{
+    Pass& target = m_passes[pass];
+    if (m_resources[texture].imported || isDepthFormat(m_resources[texture].desc.format))
+        fatal("Render graph pass '%s': '%s' can not be a color attachment", target.name, m_resources[texture].name);
+    if (target.colorCount == kMaxColorAttachments)
+        fatal("Render graph pass '%s' has more than %u color attachments", target.name, kMaxColorAttachments);
+    if (load)
+        target.colorLoadMask |= 1u << target.colorCount;
+    target.colors[target.colorCount++] = texture;
+    addUse(pass, texture, renderGraphAccessBit(RenderGraphAccess::ColorAttachment));
+}
+
+void RenderGraph::depthAttachment(uint32_t pass, uint32_t texture, bool load)
+{
+    Pass& target = m_passes[pass];
+    if (m_resources[texture].imported || !isDepthFormat(m_resources[texture].desc.format))
+        fatal("Render graph pass '%s': '%s' can not be a depth attachment", target.name, m_resources[texture].name);
+    target.depth = texture;
+    target.depthLoad = load;
+    addUse(pass, texture, renderGraphAccessBit(RenderGraphAccess::DepthAttachment));
+}
+
+void RenderGraph::read(uint32_t pass, uint32_t resource, RenderGraphAccess access)
+{
+    if (renderGraphAccessBit(access) & kRenderGraphWrites)
+        fatal("Render graph pass '%s' reads '%s' with a write access", m_passes[pass].name, m_resources[resource].name);
+    addUse(pass, resource, renderGraphAccessBit(access));
+}
+
+void RenderGraph::write(uint32_t pass, uint32_t resource, RenderGraphAccess access)
+{
+    if (!(renderGraphAccessBit(access) & kRenderGraphWrites) || (renderGraphAccessBit(access) & kAttachmentAccesses))
+        fatal("Render graph pass '%s' writes '%s' with a read or attachment access, attachments go through colorAttachment() and depthAttachment()",
+              m_passes[pass].name, m_resources[resource].name);
+    addUse(pass, resource, renderGraphAccessBit(access));
+}
+
+void RenderGraph::setClearColor(uint32_t pass, float r, float g, float b, float a)
+{
+    float* color = m_passes[pass].clearColor;
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+    color[3] = a;
+}
+
+void RenderGraph::setSideEffect(uint32_t pass)
+{
+    m_passes[pass].sideEffect = true;
+}
+
+void RenderGraph::setOwnRenderPass(uint32_t pass)
+{
+    m_passes[pass].ownRenderPass = true;
+}
+
+RenderGraphLayout RenderGraph::layout(uint32_t accesses)
+{
+    const uint32_t storage = renderGraphAccessBit(RenderGraphAccess::StorageReadGraphics) |
+                             renderGraphAccessBit(RenderGraphAccess::StorageReadCompute) |
+                             renderGraphAccessBit(RenderGraphAccess::StorageWriteCompute);
+    const uint32_t sampled = renderGraphAccessBit(RenderGraphAccess::SampledGraphics) | renderGraphAccessBit(RenderGraphAccess::SampledCompute);
+    /* GENERAL is the only layout that works for everything at once, e.g. an attachment sampled in the same pass */
+    if ((accesses & storage) || ((accesses & kAttachmentAccesses) && (accesses & sampled)))
+        return RenderGraphLayout::General;
+    if (accesses & renderGraphAccessBit(RenderGraphAccess::ColorAttachment))
+        return RenderGraphLayout::ColorAttachment;
+    if (accesses & renderGraphAccessBit(RenderGraphAccess::DepthAttachment))
+        return RenderGraphLayout::DepthAttachment;
+    if (accesses & sampled)
+        return RenderGraphLayout::ShaderRead;
+    return RenderGraphLayout::Undefined;
+}
+
+bool RenderGraph::compile()
+{
+    m_order.clear();
+    m_barrierList.clear();
+    m_layoutTransitions = 0;
+    for (Pass& pass : m_passes)
+    {
+        pass.culled = false;
+        pass.firstBarrier = 0;
+        pass.barrierCount = 0;
+    }
+
+    /* Every texture has to be written by some pass, imported resources keep their contents */
+    std::vector<bool> written(m_resources.size(), false);
+    for (const Pass& pass : m_passes)
+        for (const Use& use : pass.uses)
+            written[use.resource] = written[use.resource] || (use.accesses & kRenderGraphWrites) != 0;
+    for (uint32_t r = 0; r < m_resources.size(); ++r)
+        if (!m_resources[r].imported && !written[r])
+            fatal("Render graph texture '%s' is read but never written", m_resources[r].name);
+
+    sortPasses();
+    cullPasses();
+    bool reallocated = declareTargets();
+    planBarriers();
+    return reallocated;
+}
+
+void RenderGraph::sortPasses()
+{
+    /* Edges from the writers of a resource to the next writer and to every reader */
+    const uint32_t passCount = uint32_t(m_passes.size());
+    std::vector<std::vector<uint32_t>> successors(passCount);
+    std::vector<uint32_t> predecessors(passCount, 0);
+    for (uint32_t r = 0; r < m_resources.size(); ++r)
+    {
+        std::vector<uint32_t> writers;
+        std::vector<uint32_t> readers;
+        for (uint32_t p = 0; p < passCount; ++p)
+            for (const Use& use : m_passes[p].uses)
+                if (use.resource == r)
+                    (use.accesses & kRenderGraphWrites ? writers : readers).push_back(p);
+        for (uint32_t w = 0; w < writers.size(); ++w)
+        {
+            if (w + 1 < writers.size())
+                successors[writers[w]].push_back(writers[w + 1]);
+            for (uint32_t reader : readers)
+                successors[writers[w]].push_back(reader);
+        }
+    }
+    for (const std::vector<uint32_t>& edges : successors)
+        for (uint32_t successor : edges)
+            ++predecessors[successor];
+
+    /* Kahn's algorithm, of the ready passes the one added first goes next */
+    std::vector<bool> done(passCount, false);
+    m_order.reserve(passCount);
+    while (m_order.size() < passCount)
+    {
+        uint32_t next = passCount;
+        for (uint32_t p = 0; p < passCount && next == passCount; ++p)
+            if (!done[p] && predecessors[p] == 0)
+                next = p;
+        if (next == passCount)
+            fatal("Render graph has a cycle, a pass reads what a later pass writes");
+        done[next] = true;
+        m_order.push_back(next);
+        for (uint32_t successor : successors[next])
+            --predecessors[successor];
+    }
+}
+
+void RenderGraph::cullPasses()
+{
+    /* Walk back from the passes with effects outside the graph, a needed resource keeps all its writers */
+    std::vector<bool> needed(m_passes.size(), false);
+    std::vector<bool> neededResources(m_resources.size(), false);
+    for (uint32_t p = 0; p < m_passes.size(); ++p)
+    {
+        needed[p] = m_passes[p].sideEffect;
+        for (const Use& use : m_passes[p].uses)
+            needed[p] = needed[p] || (m_resources[use.resource].imported && (use.accesses & kRenderGraphWrites));
+    }
+    for (auto it = m_order.rbegin(); it != m_order.rend(); ++it)
+    {
+        if (!needed[*it])
+        {
+            for (const Use& use : m_passes[*it].uses)
+                needed[*it] = needed[*it] || (neededResources[use.resource] && (use.accesses & kRenderGraphWrites));
+            if (!needed[*it])
+                continue;
+        }
+        for (const Use& use : m_passes[*it].uses)
+            neededResources[use.resource] = true;
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t p : m_order)
+    {
+        m_passes[p].culled = !needed[p];
+        if (needed[p])
+            order.push_back(p);
+    }
+    m_order.swap(order);
+}
+
+bool RenderGraph::declareTargets()
+{
+    /* Lifetimes in executed passes, the pool's pass indices */
+    const uint32_t kUnused = UINT32_MAX;
+    std::vector<uint32_t> first(m_resources.size(), kUnused);
+    std::vector<uint32_t> last(m_resources.size(), 0);
+    for (uint32_t i = 0; i < m_order.size(); ++i)
+        for (const Use& use : m_passes[m_order[i]].uses)
+        {
+            first[use.resource] = std::min(first[use.resource], i);
+            last[use.resource] = i;
+        }
+
+    RenderTargetPool& targets = pool();
+    targets.beginFrame();
+    for (uint32_t r = 0; r < m_resources.size(); ++r)
+    {
+        Resource& resource = m_resources[r];
+        resource.target = RenderTargetPool::kNoTarget;
+        if (resource.imported || first[r] == kUnused)
+            continue;
+        if (resource.desc.transient && first[r] != last[r])
+            fatal("Render graph texture '%s' is transient but used by more than one pass", resource.name);
+        resource.target = targets.declare(resource.desc, first[r], last[r]);
+    }
+    return targets.allocate();
+}
+
+void RenderGraph::planBarriers()
+{
+    /* What a resource was last used for: the last write and the reads since, and its layout */
+    struct State
+    {
+        bool used;
+        uint32_t writes;
+        uint32_t reads;
+        RenderGraphLayout layout;
+    };
+    std::vector<State> states(m_resources.size(), State{ false, 0, 0, RenderGraphLayout::Undefined });
+    auto forEachUse = [&](auto&& visit) {
+        for (uint32_t p : m_order)
+            for (const Use& use : m_passes[p].uses)
+                visit(p, use, m_resources[use.resource].imported ? RenderGraphLayout::Undefined : layout(use.accesses));
+    };
+
+    /* The state at the end of the frame is where the first use of the next frame starts */
+    forEachUse([&](uint32_t, const Use& use, RenderGraphLayout newLayout) {
+        State& state = states[use.resource];
+        if (use.accesses & kRenderGraphWrites)
+        {
+            state.writes = use.accesses;
+            state.reads = 0;
+        }
+        else
+        {
+            state.reads |= use.accesses;
+        }
+        state.layout = newLayout;
+    });
+    for (uint32_t r = 0; r < m_resources.size(); ++r)
+    {
+        m_resources[r].finalAccesses = states[r].writes | states[r].reads;
+        m_resources[r].finalLayout = states[r].layout;
+        states[r] = State{ false, 0, 0, RenderGraphLayout::Undefined };
+    }
+
+    RenderTargetPool& targets = pool();
+    uint32_t current = UINT32_MAX;
+    forEachUse([&](uint32_t p, const Use& use, RenderGraphLayout newLayout) {
+        Pass& pass = m_passes[p];
+        if (p != current)
+        {
+            current = p;
+            pass.firstBarrier = uint32_t(m_barrierList.size());
+        }
+
+        const Resource& resource = m_resources[use.resource];
+        State& state = states[use.resource];
+        if (!state.used)
+        {
+            /*
+             * A texture starts undefined and waits for everything that last touched its memory,
+             * in this frame for aliased textures or in the frame before for itself
+             */
+            state.used = true;
+            state.writes = resource.finalAccesses;
+            if (!resource.imported)
+                for (const Resource& other : m_resources)
+                    if (!other.imported && other.target != RenderTargetPool::kNoTarget && targets.sharesMemory(resource.target, other.target))
+                        state.writes |= other.finalAccesses;
+        }
+
+        Barrier barrier = { use.resource, 0, use.accesses, state.layout, newLayout };
+        bool needed = state.layout != newLayout;
+        if (use.accesses & kRenderGraphWrites)
+        {
+            /* Write after write and write after read */
+            barrier.srcAccesses = state.writes | state.reads;
+            needed = needed || barrier.srcAccesses != 0;
+            state.writes = use.accesses;
+            state.reads = 0;
+        }
+        else
+        {
+            /* A read only waits for the write, unless the layout changes under earlier reads */
+            barrier.srcAccesses = needed ? state.writes | state.reads : state.writes;
+            needed = needed || ((use.accesses & ~state.reads) && (state.writes & kRenderGraphWrites));
+            state.reads |= use.accesses;
+        }
+        state.layout = newLayout;
+
+        if (needed)
+        {
+            m_barrierList.push_back(barrier);
+            ++pass.barrierCount;
+            if (barrier.oldLayout != barrier.newLayout)
+                ++m_layoutTransitions;
+        }
+    });
+}
+
+void RenderGraph::report(Report& report)
+{
+    uint32_t batches = 0;
+    for (uint32_t p : m_order)
+        batches += m_passes[p].barrierCount > 0 ? 1 : 0;
+    report.addText("render graph barriers", m_barriers == RenderGraphBarriers::Full ? "full" : "minimal");
+    report.addValue("render graph passes", double(m_passes.size()), "");
+    report.addValue("render graph passes culled", double(m_passes.size() - m_order.size()), "");
+    report.addValue("planned barriers per frame", double(m_barrierList.size()), "");
+    report.addValue("planned barrier batches per frame", double(batches), "");
+    report.addValue("layout transitions per frame", double(m_layoutTransitions), "");
+    pool().report(report);
+}
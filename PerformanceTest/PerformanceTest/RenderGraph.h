@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
+
+/* How a pass uses a resource, a pass may use one resource in several ways */
+enum class RenderGraphAccess : uint32_t
+{
+    ColorAttachment,
+    DepthAttachment,
+    SampledGraphics,
+    SampledCompute,
+    StorageReadGraphics,
+    StorageReadCompute,
+    /* Storage image or buffer writes, reads of the same resource included */
+    StorageWriteCompute,
+    IndirectRead,
+    kCount
+};
+
+constexpr uint32_t renderGraphAccessBit(RenderGraphAccess access)
+{
+    return 1u << uint32_t(access);
+}
+
+/* The accesses that modify a resource */
+constexpr uint32_t kRenderGraphWrites = renderGraphAccessBit(RenderGraphAccess::ColorAttachment) |
+                                        renderGraphAccessBit(RenderGraphAccess::DepthAttachment) |
+                                        renderGraphAccessBit(RenderGraphAccess::StorageWriteCompute);
+
+/* The image layout a set of accesses needs, Vulkan maps it to VkImageLayout */
+enum class RenderGraphLayout : uint32_t
+{
+    Undefined,
+    ColorAttachment,
+    DepthAttachment,
+    ShaderRead,
+    General
+};
+
+/* --barriers minimal|full, full waits for everything before every pass like a naive port would */
+enum class RenderGraphBarriers
+{
+    Minimal,
+    Full
+};
+
+RenderGraphBarriers parseRenderGraphBarriers(const std::string& name);
+
+/*
+ * A frame as a graph of passes over resources. Passes declare what they read and write,
+ * compile() then:
+ *   - orders the passes so every reader comes after all writers of what it reads, writers of
+ *     one resource keep the order they were added in, otherwise the order of addPass() is kept,
+ *   - culls passes whose results nothing with a side effect uses,
+ *   - declares the textures with the render target pool, their lifetime is the range of
+ *     executed passes that use them, so the pool can alias or reuse them,
+ *   - plans the barriers: before each pass one batch with only the transitions it needs. A read
+ *     already made visible by an earlier barrier needs none, neither does a pass whose inputs
+ *     were written by nothing on the GPU.
+ *
+ * The first use of a texture in a frame discards it, its barrier waits for the last accesses
+ * of every texture sharing its memory, the one from the frame before included. Imported
+ * buffers keep their contents and wait for their own last access.
+ *
+ * The graph is built once and executed every frame, the scenario rebuilds it when the window
+ * size changes. The backends record the barriers, begin the render passes of the attachments
+ * and call the passes.
+ */
+class RenderGraph
+{
+public:
+    static constexpr uint32_t kMaxColorAttachments = 8;
+    static constexpr uint32_t kNoResource = UINT32_MAX;
+
+    explicit RenderGraph(RenderGraphBarriers barriers);
+    virtual ~RenderGraph() = default;
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    /* Drops all passes and resources, the targets stay with the pool until the next compile() */
+    void reset();
+
+    uint32_t createTexture(const char* name, const RenderTargetDesc& desc);
+    /* A buffer owned by the scenario, passes writing it are never culled */
+    uint32_t importBuffer(const char* name);
+
+    /* Color attachment i is the i-th call, `load` keeps the contents instead of clearing */
+    void colorAttachment(uint32_t pass, uint32_t texture, bool load = false);
+    void depthAttachment(uint32_t pass, uint32_t texture, bool load = false);
+    void read(uint32_t pass, uint32_t resource, RenderGraphAccess access);
+    void write(uint32_t pass, uint32_t resource, RenderGraphAccess access);
+    void setClearColor(uint32_t pass, float r, float g, float b, float a);
+    /* The pass does something outside the graph, e.g. draws to the swapchain, and is never culled */
+    void setSideEffect(uint32_t pass);
+    /*
+     * The pass begins a render pass of its own over its attachments, e.g. one with subpasses.
+     * The graph still puts them into their attachment layouts, the render pass has to start and
+     * end them there.
+     */
+    void setOwnRenderPass(uint32_t pass);
+
+    /* True if the pool recreated the textures, descriptors pointing at them are stale */
+    bool compile();
+
+    RenderGraphBarriers barriers() const { return m_barriers; }
+    uint32_t passCount() const { return uint32_t(m_passes.size()); }
+    uint32_t executedPassCount() const { return uint32_t(m_order.size()); }
+    bool culled(uint32_t pass) const { return m_passes[pass].culled; }
+    /* Pool handle of a texture, RenderTargetPool::kNoTarget if only culled passes used it */
+    uint32_t target(uint32_t texture) const { return m_resources[texture].target; }
+    const RenderTargetDesc& desc(uint32_t texture) const { return m_resources[texture].desc; }
+
+    /* Also reports the pool */
+    virtual void report(Report& report);
+
+protected:
+    struct Use
+    {
+        uint32_t resource;
+        /* RenderGraphAccess bits */
+        uint32_t accesses;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        std::vector<Use> uses;
+        uint32_t colors[kMaxColorAttachments];
+        uint32_t colorCount = 0;
+        uint32_t depth = kNoResource;
+        /* Bit i keeps color attachment i */
+        uint32_t colorLoadMask = 0;
+        bool depthLoad = false;
+        float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        bool sideEffect = false;
+        bool ownRenderPass = false;
+        bool culled = false;
+        /* Range in m_barrierList, planned by compile() */
+        uint32_t firstBarrier = 0;
+        uint32_t barrierCount = 0;
+    };
+
+    struct Resource
+    {
+        const char* name;
+        bool imported;
+        RenderTargetDesc desc;
+        uint32_t target = RenderTargetPool::kNoTarget;
+        /* Accesses since the last write, and the write, at the end of the frame */
+        uint32_t finalAccesses = 0;
+        RenderGraphLayout finalLayout = RenderGraphLayout::Undefined;
+    };
+
+    struct Barrier
+    {
+        uint32_t resource;
+        /* Accesses that have to complete first, 0 if nothing touched the resource */
+        uint32_t srcAccesses;
+        uint32_t dstAccesses;
+        RenderGraphLayout oldLayout;
+        RenderGraphLayout newLayout;
+    };
+
+    static RenderGraphLayout layout(uint32_t accesses);
+    /* The load mask of RenderTargetPool::beginPass(), bit colorCount is the depth attachment */
+    static uint32_t loadMask(const Pass& pass) { return pass.colorLoadMask | (pass.depthLoad ? 1u << pass.colorCount : 0u); }
+
+    /* Added by the backends together with the pass callback */
+    uint32_t addPass(const char* name);
+    virtual RenderTargetPool& pool() = 0;
+
+    RenderGraphBarriers m_barriers;
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    /* Executed passes in execution order */
+    std::vector<uint32_t> m_order;
+    std::vector<Barrier> m_barrierList;
+
+private:
+    void addUse(uint32_t pass, uint32_t resource, uint32_t accesses);
+    void sortPasses();
+    void cullPasses();
+    bool declareTargets();
+    void planBarriers();
+
+    uint32_t m_layoutTransitions = 0;
+};
@@ -0,0 +1,150 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+namespace
+{
+    constexpr uint32_t kRadixBits = 8;
+    constexpr uint32_t kBuckets = 1u << kRadixBits;
+    constexpr uint32_t kPasses = 64 / kRadixBits;
+    /* Fewer keys per chunk and the per-chunk histograms cost more than the parallel scatter gains */
+    constexpr uint32_t kMinChunkSize = 16384;
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t draw;
+    };
+}
+
+uint64_t SortKey::make(bool translucent, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    const uint64_t depthMax = (1ull << kDepthBits) - 1;
+    uint64_t quantized = uint64_t(std::clamp(depth, 0.0f, 1.0f) * float(depthMax));
+    if (translucent)
+        quantized = depthMax - quantized;
+
+    uint64_t key = translucent ? 1 : 0;
+    key = key << kPipelineBits | (pipeline & ((1u << kPipelineBits) - 1));
+    key = key << kMaterialBits | (material & ((1u << kMaterialBits) - 1));
+    key = key << kMeshBits | (mesh & ((1u << kMeshBits) - 1));
+    key = key << kDepthBits | quantized;
+    return key;
+}
+
+const char* sortAlgorithmName(SortAlgorithm algorithm)
+{
+    return algorithm == SortAlgorithm::Radix ? "radix" : "std::sort";
+}
+
+void RenderQueue::begin(LinearArena& arena, uint32_t capacity)
+{
+    m_arena = &arena;
+    m_keys = arena.allocate<uint64_t>(capacity);
+    m_draws = arena.allocate<uint32_t>(capacity);
+    m_scratchKeys = arena.allocate<uint64_t>(capacity);
+    m_scratchDraws = arena.allocate<uint32_t>(capacity);
+    m_count = 0;
+    m_capacity = capacity;
+    m_passCount = 0;
+}
+
+void RenderQueue::sort(SortAlgorithm algorithm, JobSystem* jobs)
+{
+    if (algorithm == SortAlgorithm::Radix)
+        radixSort(jobs);
+    else
+        comparisonSort();
+}
+
+void RenderQueue::radixSort(JobSystem* jobs)
+{
+    m_passCount = 0;
+    if (m_count < 2)
+        return;
+
+    /* Every chunk gets its own histogram, chunks scatter to disjoint ranges so the sort stays stable */
+    uint32_t chunkCount = 1;
+    if (jobs)
+        chunkCount = std::max(1u, std::min(jobs->threadCount() * 2, m_count / kMinChunkSize));
+    uint32_t chunkSize = (m_count + chunkCount - 1) / chunkCount;
+    uint32_t* histograms = m_arena->allocate<uint32_t>(size_t(chunkCount) * kBuckets);
+
+    auto forEachChunk = [&](const auto& function)
+    {
+        if (chunkCount == 1)
+            function(0u);
+        else
+            jobs->parallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+                for (uint32_t chunk = begin; chunk < end; ++chunk)
+                    function(chunk);
+            });
+    };
+
+    for (uint32_t pass = 0; pass < kPasses; ++pass)
+    {
+        uint32_t shift = pass * kRadixBits;
+        const uint64_t* keys = m_keys;
+
+        forEachChunk([&](uint32_t chunk) {
+            uint32_t* histogram = histograms + size_t(chunk) * kBuckets;
+            std::fill(histogram, histogram + kBuckets, 0u);
+            uint32_t end = std::min(m_count, (chunk + 1) * chunkSize);
+            for (uint32_t i = chunk * chunkSize; i < end; ++i)
+                ++histogram[(keys[i] >> shift) & (kBuckets - 1)];
+        });
+
+        /* Bucket major, chunk minor: turns the counts into the scatter offsets of every chunk */
+        uint32_t offset = 0;
+        bool skip = false;
+        for (uint32_t bucket = 0; bucket < kBuckets && !skip; ++bucket)
+        {
+            uint32_t bucketStart = offset;
+            for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                uint32_t& count = histograms[size_t(chunk) * kBuckets + bucket];
+                uint32_t start = offset;
+                offset += count;
+                count = start;
+            }
+            skip = offset - bucketStart == m_count;
+        }
+        if (skip)
+            continue;
+
+        uint64_t* outKeys = m_scratchKeys;
+        uint32_t* outDraws = m_scratchDraws;
+        const uint32_t* draws = m_draws;
+        forEachChunk([&](uint32_t chunk) {
+            uint32_t* offsets = histograms + size_t(chunk) * kBuckets;
+            uint32_t end = std::min(m_count, (chunk + 1) * chunkSize);
+            for (uint32_t i = chunk * chunkSize; i < end; ++i)
+            {
+                uint32_t target = offsets[(keys[i] >> shift) & (kBuckets - 1)]++;
+                outKeys[target] = keys[i];
+                outDraws[target] = draws[i];
+            }
+        });
+
+        std::swap(m_keys, m_scratchKeys);
+        std::swap(m_draws, m_scratchDraws);
+        ++m_passCount;
+    }
+}
+
+void RenderQueue::comparisonSort()
+{
+    m_passCount = 0;
+    SortEntry* entries = m_arena->allocate<SortEntry>(m_count);
+    for (uint32_t i = 0; i < m_count; ++i)
+        entries[i] = { m_keys[i], m_draws[i] };
+    std::sort(entries, entries + m_count, [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+    for (uint32_t i = 0; i < m_count; ++i)
+    {
+        m_keys[i] = entries[i].key;
+        m_draws[i] = entries[i].draw;
+    }
+}
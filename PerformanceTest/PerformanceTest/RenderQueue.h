@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Benchmark.h"
+
+class JobSystem;
+class LinearArena;
+
+/*
+ * Bit layout of a render queue key, most significant field first:
+ *   1 bit translucent, 15 bits pipeline, 16 bits material, 8 bits mesh, 24 bits depth.
+ * Opaque draws come first and are grouped by state, translucent ones are sorted back to front
+ * within a state group by inverting their depth.
+ */
+struct SortKey
+{
+    static constexpr uint32_t kPipelineBits = 15;
+    static constexpr uint32_t kMaterialBits = 16;
+    static constexpr uint32_t kMeshBits = 8;
+    static constexpr uint32_t kDepthBits = 24;
+
+    /* `depth` in [0, 1], values outside are clamped */
+    static uint64_t make(bool translucent, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+};
+
+enum class SortAlgorithm
+{
+    /* LSD radix sort, 8 bits per pass */
+    Radix,
+    /* std::sort, the reference */
+    Comparison,
+};
+
+/*
+ * Draw indices ordered by 64-bit keys. All storage is taken from the frame arena in begin(),
+ * so a queue is filled and sorted every frame without touching the heap.
+ */
+class RenderQueue
+{
+public:
+    /* Reserves room for `capacity` draws in the arena, drops the previous content */
+    void begin(LinearArena& arena, uint32_t capacity);
+
+    void push(uint64_t key, uint32_t draw)
+    {
+        if (m_count == m_capacity)
+            fatal("RenderQueue: more than the %u draws passed to begin()", m_capacity);
+        m_keys[m_count] = key;
+        m_draws[m_count] = draw;
+        ++m_count;
+    }
+
+    /* Stable for Radix. With `jobs` the histograms and the scatter of every pass run in parallel. */
+    void sort(SortAlgorithm algorithm, JobSystem* jobs = nullptr);
+
+    uint32_t size() const { return m_count; }
+    const uint64_t* keys() const { return m_keys; }
+    /* Draw indices in key order after sort() */
+    const uint32_t* draws() const { return m_draws; }
+    /* Radix passes of the last sort, a pass is skipped when all keys share its byte */
+    uint32_t passCount() const { return m_passCount; }
+
+private:
+    void radixSort(JobSystem* jobs);
+    void comparisonSort();
+
+    LinearArena* m_arena = nullptr;
+    uint64_t* m_keys = nullptr;
+    uint32_t* m_draws = nullptr;
+    uint64_t* m_scratchKeys = nullptr;
+    uint32_t* m_scratchDraws = nullptr;
+    uint32_t m_count = 0;
+    uint32_t m_capacity = 0;
+    uint32_t m_passCount = 0;
+};
+
+const char* sortAlgorithmName(SortAlgorithm algorithm);
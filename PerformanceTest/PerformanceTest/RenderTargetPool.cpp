@@ -0,0 +1,215 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+bool isDepthFormat(RenderTargetFormat format)
+{
+    return format == RenderTargetFormat::Depth32F;
+}
+
+uint32_t bytesPerTexel(RenderTargetFormat format)
+{
+    switch (format)
+    {
+    case RenderTargetFormat::RGBA8:
+    case RenderTargetFormat::R11G11B10F:
+    case RenderTargetFormat::Depth32F:
+        return 4;
+    case RenderTargetFormat::RGBA16F:
+        return 8;
+    }
+    return 4;
+}
+
+uint64_t renderTargetSize(const RenderTargetDesc& desc)
+{
+    return uint64_t(desc.width) * desc.height * desc.samples * bytesPerTexel(desc.format);
+}
+
+bool parseRenderResolution(const std::string& name, uint32_t& width, uint32_t& height)
+{
+    struct Preset
+    {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+    const Preset presets[] = { { "720p", 1280, 720 }, { "1080p", 1920, 1080 }, { "1440p", 2560, 1440 }, { "4k", 3840, 2160 }, { "2160p", 3840, 2160 } };
+
+    if (name == "window")
+        return false;
+    for (const Preset& preset : presets)
+        if (name == preset.name)
+        {
+            width = preset.width;
+            height = preset.height;
+            return true;
+        }
+    unsigned w = 0, h = 0;
+    char end = 0;
+    if (std::sscanf(name.c_str(), "%ux%u%c", &w, &h, &end) == 2 && w >= 1 && h >= 1 && w <= 16384 && h <= 16384)
+    {
+        width = w;
+        height = h;
+        return true;
+    }
+    fatal("Unknown --resolution '%s', expected window, 720p, 1080p, 1440p, 4k or <width>x<height>", name.c_str());
+}
+
+RenderTargetPooling parseRenderTargetPooling(const std::string& name)
+{
+    if (name == "alias")
+        return RenderTargetPooling::Alias;
+    if (name == "reuse")
+        return RenderTargetPooling::Reuse;
+    if (name == "none")
+        return RenderTargetPooling::None;
+    fatal("Unknown --pooling '%s', expected alias, reuse or none", name.c_str());
+}
+
+const char* renderTargetPoolingName(RenderTargetPooling pooling)
+{
+    switch (pooling)
+    {
+    case RenderTargetPooling::Alias:
+        return "alias";
+    case RenderTargetPooling::Reuse:
+        return "reuse";
+    case RenderTargetPooling::None:
+        return "none";
+    }
+    return "none";
+}
+
+uint32_t assignPhysicalTargets(const std::vector<RenderTargetDeclaration>& declarations, std::vector<uint32_t>& physical)
+{
+    /* Lifetime of the last declaration placed on each physical target, in declaration order */
+    struct Physical
+    {
+        RenderTargetDesc desc;
+        uint32_t lastPass;
+    };
+    std::vector<uint32_t> order(declarations.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return declarations[a].firstPass < declarations[b].firstPass; });
+
+    std::vector<Physical> targets;
+    physical.assign(declarations.size(), 0);
+    for (uint32_t index : order)
+    {
+        const RenderTargetDeclaration& declaration = declarations[index];
+        uint32_t found = uint32_t(targets.size());
+        for (uint32_t t = 0; t < targets.size(); ++t)
+            if (targets[t].desc == declaration.desc && targets[t].lastPass < declaration.firstPass)
+            {
+                found = t;
+                break;
+            }
+        if (found == targets.size())
+            targets.push_back({ declaration.desc, declaration.lastPass });
+        else
+            targets[found].lastPass = declaration.lastPass;
+        physical[index] = found;
+    }
+    return uint32_t(targets.size());
+}
+
+uint64_t packAliasedRanges(const std::vector<AliasedRange>& ranges, std::vector<uint64_t>& offsets)
+{
+    std::vector<uint32_t> order(ranges.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return ranges[a].size > ranges[b].size; });
+
+    offsets.assign(ranges.size(), 0);
+    std::vector<uint32_t> placed;
+    uint64_t blockSize = 0;
+    for (uint32_t index : order)
+    {
+        const AliasedRange& range = ranges[index];
+        /* The lowest offset is either 0 or right after a range that is alive at the same time */
+        uint64_t best = UINT64_MAX;
+        for (size_t candidate = 0; candidate <= placed.size(); ++candidate)
+        {
+            uint64_t offset = 0;
+            if (candidate < placed.size())
+            {
+                const AliasedRange& other = ranges[placed[candidate]];
+                if (!lifetimesOverlap(range.firstPass, range.lastPass, other.firstPass, other.lastPass))
+                    continue;
+                offset = offsets[placed[candidate]] + other.size;
+            }
+            offset = (offset + range.alignment - 1) / range.alignment * range.alignment;
+            if (offset >= best)
+                continue;
+
+            bool fits = true;
+            for (uint32_t other : placed)
+            {
+                const AliasedRange& o = ranges[other];
+                if (lifetimesOverlap(range.firstPass, range.lastPass, o.firstPass, o.lastPass) && offset < offsets[other] + o.size &&
+                    offsets[other] < offset + range.size)
+                {
+                    fits = false;
+                    break;
+                }
+            }
+            if (fits)
+                best = offset;
+        }
+        offsets[index] = best;
+        blockSize = std::max(blockSize, best + range.size);
+        placed.push_back(index);
+    }
+    return blockSize;
+}
+
+RenderTargetPool::RenderTargetPool(RenderTargetPooling pooling)
+    : m_pooling(pooling)
+{
+}
+
+void RenderTargetPool::beginFrame()
+{
+    m_declarations.clear();
+}
+
+uint32_t RenderTargetPool::declare(const RenderTargetDesc& desc, uint32_t firstPass, uint32_t lastPass)
+{
+    if (desc.width == 0 || desc.height == 0 || firstPass > lastPass)
+        fatal("Render target declared with an empty size or lifetime");
+    m_declarations.push_back({ desc, firstPass, lastPass });
+    return uint32_t(m_declarations.size() - 1);
+}
+
+bool RenderTargetPool::allocate()
+{
+    if (m_valid && m_declarations == m_allocated)
+        return false;
+
+    if (m_valid)
+        release();
+    m_current = create();
+    m_allocated = m_declarations;
+    m_valid = true;
+    ++m_allocations;
+    m_peakBytes = std::max(m_peakBytes, m_current.bytes);
+    m_peakUnpooledBytes = std::max(m_peakUnpooledBytes, m_current.unpooledBytes);
+    return true;
+}
+
+void RenderTargetPool::report(Report& report) const
+{
+    const double mib = 1.0 / (1024.0 * 1024.0);
+    report.addText("render target pooling", renderTargetPoolingName(m_pooling));
+    report.addValue("render targets declared", double(m_allocated.size()), "");
+    report.addValue("render targets physical", double(m_current.physicalTargets), "");
+    if (m_pooling == RenderTargetPooling::Alias)
+        report.addValue("render target memory blocks", double(m_current.blocks), "");
+    report.addValue("render target allocations", double(m_allocations), "");
+    report.addValue("attachment memory", double(m_current.bytes) * mib, "MiB");
+    report.addValue("attachment memory peak", double(m_peakBytes) * mib, "MiB");
+    report.addValue("attachment memory peak unpooled", double(m_peakUnpooledBytes) * mib, "MiB");
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+enum class RenderTargetFormat : uint32_t
+{
+    RGBA8,
+    RGBA16F,
+    R11G11B10F,
+    Depth32F
+};
+
+bool isDepthFormat(RenderTargetFormat format);
+uint32_t bytesPerTexel(RenderTargetFormat format);
+
+struct RenderTargetDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    RenderTargetFormat format = RenderTargetFormat::RGBA8;
+    uint32_t samples = 1;
+    /*
+     * Only written and read as an attachment, or a Vulkan input attachment, inside the pass that
+     * clears it, never sampled. Its contents are dropped at the end of the pass, Vulkan keeps it
+     * in lazily allocated memory where the device has some and OpenGL uses a renderbuffer.
+     */
+    bool transient = false;
+    /* Also written by compute shaders as a storage image, which may cost the target its compression on some GPUs */
+    bool storage = false;
+
+    bool operator==(const RenderTargetDesc& other) const
+    {
+        return width == other.width && height == other.height && format == other.format && samples == other.samples &&
+               transient == other.transient && storage == other.storage;
+    }
+    bool operator!=(const RenderTargetDesc& other) const { return !(*this == other); }
+};
+
+/* Texels times samples, what the target costs at least without compression metadata or padding */
+uint64_t renderTargetSize(const RenderTargetDesc& desc);
+
+/*
+ * --resolution window|720p|1080p|1440p|4k|<width>x<height>, the size offscreen targets are
+ * rendered at. Returns false for window, the targets then follow the window size.
+ */
+bool parseRenderResolution(const std::string& name, uint32_t& width, uint32_t& height);
+
+enum class RenderTargetPooling
+{
+    /* Vulkan only: targets with disjoint lifetimes share memory, whatever their description */
+    Alias,
+    /* Targets with the same description and disjoint lifetimes share one texture or image */
+    Reuse,
+    /* Every declaration gets a target of its own */
+    None
+};
+
+/* alias, reuse or none */
+RenderTargetPooling parseRenderTargetPooling(const std::string& name);
+const char* renderTargetPoolingName(RenderTargetPooling pooling);
+
+/* A target needed from pass firstPass to pass lastPass, both inclusive */
+struct RenderTargetDeclaration
+{
+    RenderTargetDesc desc;
+    uint32_t firstPass;
+    uint32_t lastPass;
+
+    bool operator==(const RenderTargetDeclaration& other) const
+    {
+        return desc == other.desc && firstPass == other.firstPass && lastPass == other.lastPass;
+    }
+};
+
+inline bool lifetimesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+{
+    return firstA <= lastB && firstB <= lastA;
+}
+
+/*
+ * Maps every declaration to a physical target, declarations with the same description and
+ * disjoint lifetimes share one. Returns the number of physical targets.
+ */
+uint32_t assignPhysicalTargets(const std::vector<RenderTargetDeclaration>& declarations, std::vector<uint32_t>& physical);
+
+/* A memory range to place in an aliased block, see packAliasedRanges() */
+struct AliasedRange
+{
+    uint64_t size;
+    uint64_t alignment;
+    uint32_t firstPass;
+    uint32_t lastPass;
+};
+
+/*
+ * Places the ranges in one memory block so that ranges with overlapping lifetimes never share a
+ * byte. Greedy, largest range first at the lowest offset that fits. Returns the block size.
+ */
+uint64_t packAliasedRanges(const std::vector<AliasedRange>& ranges, std::vector<uint64_t>& offsets);
+
+/*
+ * Hands out render targets by description. Every frame the passes declare what they need and
+ * for how long with declare(), allocate() then plans and creates the targets, but only when the
+ * declarations differ from the last allocation: an unchanged frame graph reuses the targets of
+ * the frame before without creating or allocating anything. The backends implement the
+ * creation, this class the declarations and the bookkeeping for the report.
+ */
+class RenderTargetPool
+{
+public:
+    static constexpr uint32_t kNoTarget = UINT32_MAX;
+
+    explicit RenderTargetPool(RenderTargetPooling pooling);
+    virtual ~RenderTargetPool() = default;
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    /* Starts the declarations of a frame */
+    void beginFrame();
+    /* Returns the handle of the target, valid for the frame */
+    uint32_t declare(const RenderTargetDesc& desc, uint32_t firstPass, uint32_t lastPass);
+    /* True if the targets were recreated, everything made from the old ones is stale */
+    bool allocate();
+
+    RenderTargetPooling pooling() const { return m_pooling; }
+    const RenderTargetDesc& desc(uint32_t handle) const { return m_declarations[handle].desc; }
+    /* Whether the two targets of the current allocation may occupy the same memory */
+    virtual bool sharesMemory(uint32_t a, uint32_t b) const = 0;
+
+    virtual void report(Report& report) const;
+
+protected:
+    struct Allocation
+    {
+        uint32_t physicalTargets = 0;
+        /* Memory blocks shared by aliased targets */
+        uint32_t blocks = 0;
+        uint64_t bytes = 0;
+        /* What the same declarations cost with a target each */
+        uint64_t unpooledBytes = 0;
+    };
+
+    /* Destroys the targets, the GPU must be done with them */
+    virtual void release() = 0;
+    /* Creates the targets of m_declarations */
+    virtual Allocation create() = 0;
+
+    RenderTargetPooling m_pooling;
+    std::vector<RenderTargetDeclaration> m_declarations;
+
+private:
+    std::vector<RenderTargetDeclaration> m_allocated;
+    bool m_valid = false;
+    Allocation m_current;
+    uint64_t m_peakBytes = 0;
+    uint64_t m_peakUnpooledBytes = 0;
+    uint64_t m_allocations = 0;
+};
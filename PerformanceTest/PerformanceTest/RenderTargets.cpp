@@ -0,0 +1,100 @@
+#include "RenderTargets.h"
+
+#include <algorithm>
+#include <cstdio>
+
+RenderTargetScenario::RenderTargetScenario(const Options& options)
+{
+    m_chain = uint32_t(options.getInt("chain", 6));
+    uint32_t quadCount = uint32_t(options.getInt("quads", 64));
+    if (m_chain == 0 || quadCount == 0)
+        fatal("--chain and --quads have to be at least 1");
+
+    /* Overlapping quads at different depths, so the transient depth buffer has work to do */
+    m_quads.resize(quadCount);
+    for (uint32_t i = 0; i < quadCount; ++i)
+    {
+        float t = float(i) / float(quadCount);
+        float x = -1.0f + 1.6f * float((i * 7) % quadCount) / float(quadCount);
+        float y = -1.0f + 1.6f * float((i * 13) % quadCount) / float(quadCount);
+        m_quads[i].rect = { x, y, 0.4f, 0.4f };
+        m_quads[i].params = { 0.2f + 0.8f * t, 0.5f, 1.0f - 0.8f * t, float((i * 5) % quadCount) / float(quadCount) };
+    }
+
+    std::printf("render-targets: %u quads, %u filter passes\n", quadCount, m_chain);
+}
+
+RenderTargetPooling RenderTargetScenario::pooling(const Options& options)
+{
+    return parseRenderTargetPooling(options.getString("pooling", "alias"));
+}
+
+RenderGraphBarriers RenderTargetScenario::barriers(const Options& options)
+{
+    return parseRenderGraphBarriers(options.getString("barriers", "minimal"));
+}
+
+bool RenderTargetScenario::updateGraph(RenderGraph& graph, uint32_t width, uint32_t height)
+{
+    if (width == m_width && height == m_height)
+        return false;
+    m_width = width;
+    m_height = height;
+    graph.reset();
+    m_passes.clear();
+
+    RenderTargetDesc sceneColor = { width, height, RenderTargetFormat::RGBA16F, 1, false };
+    RenderTargetDesc sceneDepth = { width, height, RenderTargetFormat::Depth32F, 1, true };
+    uint32_t color = graph.createTexture("scene color", sceneColor);
+    uint32_t depth = graph.createTexture("scene depth", sceneDepth);
+    m_passes.push_back({ RenderTargetPassKind::Scene, color, depth, { RenderGraph::kNoResource, RenderGraph::kNoResource } });
+
+    /* Half, quarter and eighth resolution in turn, targets of the same size are three passes apart */
+    uint32_t previous = color;
+    for (uint32_t i = 1; i <= m_chain; ++i)
+    {
+        uint32_t shift = 1 + (i - 1) % 3;
+        RenderTargetDesc desc = { std::max(1u, width >> shift), std::max(1u, height >> shift), RenderTargetFormat::RGBA16F, 1, false };
+        uint32_t target = graph.createTexture("filter", desc);
+        m_passes.push_back({ RenderTargetPassKind::Filter, target, RenderGraph::kNoResource, { previous, previous } });
+        previous = target;
+    }
+
+    RenderTargetDesc compositeDesc = { width, height, RenderTargetFormat::RGBA8, 1, false };
+    uint32_t output = graph.createTexture("composite", compositeDesc);
+    m_passes.push_back({ RenderTargetPassKind::Composite, output, RenderGraph::kNoResource, { color, previous } });
+    m_passes.push_back({ RenderTargetPassKind::Present, RenderGraph::kNoResource, RenderGraph::kNoResource, { output, output } });
+
+    const char* names[] = { "scene", "filter", "composite", "present" };
+    for (uint32_t p = 0; p < m_passes.size(); ++p)
+    {
+        const RenderTargetPass& pass = m_passes[p];
+        uint32_t graphPass = addPass(names[uint32_t(pass.kind)], p);
+        graph.setClearColor(graphPass, 0.0f, 0.0f, 0.0f, 1.0f);
+        if (pass.color != RenderGraph::kNoResource)
+            graph.colorAttachment(graphPass, pass.color);
+        if (pass.depth != RenderGraph::kNoResource)
+            graph.depthAttachment(graphPass, pass.depth);
+        for (uint32_t source : pass.sources)
+            if (source != RenderGraph::kNoResource)
+                graph.read(graphPass, source, RenderGraphAccess::SampledGraphics);
+        /* Draws to the swapchain, which is not part of the graph */
+        if (pass.kind == RenderTargetPassKind::Present)
+            graph.setSideEffect(graphPass);
+    }
+    return graph.compile();
+}
+
+RenderTargetConstants RenderTargetScenario::fullscreen(const RenderTargetDesc& source)
+{
+    RenderTargetConstants constants;
+    constants.rect = { -1.0f, -1.0f, 2.0f, 2.0f };
+    constants.params = { 1.0f / float(source.width), 1.0f / float(source.height), 0.0f, 0.0f };
+    return constants;
+}
+
+void RenderTargetScenario::report(Report& report)
+{
+    report.addValue("quads", double(m_quads.size()), "");
+    report.addValue("filter passes", double(m_chain), "");
+}
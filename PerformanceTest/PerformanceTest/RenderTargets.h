@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "RenderGraph.h"
+#include "Scenario.h"
+
+/* Push constants of shaders/rendertargets, same layout as PassConstants in rendertargets.glsl */
+struct RenderTargetConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    /* Scene quads: rgb color, w depth. Filters: xy texel size of the source */
+    Vec4 params;
+};
+
+enum class RenderTargetPassKind
+{
+    /* Draws the quads into an RGBA16F target with a transient depth buffer */
+    Scene,
+    /* Downsamples or blurs `sources[0]` into a smaller RGBA16F target */
+    Filter,
+    /* Adds the filtered glow to the scene and tonemaps into RGBA8 */
+    Composite,
+    /* Copies the composite to the swapchain */
+    Present
+};
+
+struct RenderTargetPass
+{
+    RenderTargetPassKind kind;
+    /* Graph textures, RenderGraph::kNoResource where unused */
+    uint32_t color;
+    uint32_t depth;
+    uint32_t sources[2];
+};
+
+/*
+ * Backend independent part of the render target scenario: a frame of --chain filter passes
+ * between a scene pass and a composite, each reading the target of the pass before, the way a
+ * bloom or depth of field chain does. The passes run through the backend's RenderGraph, which
+ * places the barriers and layout transitions, --barriers full replaces them with waits for
+ * everything. The graph declares the targets with its RenderTargetPool, --pooling
+ * alias|reuse|none decides how many targets and how much memory that takes, the report has the
+ * peak next to what a target per declaration would cost. The graph is rebuilt when the window is
+ * resized, the pool then recreates its targets.
+ */
+class RenderTargetScenario : public Scenario
+{
+public:
+    RenderTargetScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* Rebuilds m_passes and the graph if the size changed, true if the targets were recreated */
+    bool updateGraph(RenderGraph& graph, uint32_t width, uint32_t height);
+    /* Adds pass `index` of m_passes to the graph with the backend's callback */
+    virtual uint32_t addPass(const char* name, uint32_t index) = 0;
+    /* Constants of a full target quad reading a source of the given size */
+    static RenderTargetConstants fullscreen(const RenderTargetDesc& source);
+
+    static RenderTargetPooling pooling(const Options& options);
+    static RenderGraphBarriers barriers(const Options& options);
+
+    uint32_t m_chain;
+    std::vector<RenderTargetConstants> m_quads;
+    std::vector<RenderTargetPass> m_passes;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+};
+
+std::unique_ptr<Scenario> createRenderTargetScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createRenderTargetScenarioVulkan(VulkanContext& context, const Options& options);
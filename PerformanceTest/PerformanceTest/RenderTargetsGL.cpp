@@ -0,0 +1,129 @@
+#include "RenderTargets.h"
+
+#include "GLContext.h"
+#include "GLRenderGraph.h"
+
+namespace
+{
+    /*
+     * Textures and framebuffer objects come from the GLRenderGraph's pool, the transient depth
+     * buffer is a renderbuffer invalidated after the scene pass. --pooling alias is not
+     * available on OpenGL and falls back to reuse, the driver decides on its own where the
+     * textures live. No pass writes from a shader, so the graph needs no glMemoryBarrier unless
+     * --barriers full asks for them.
+     */
+    class RenderTargetScenarioGL : public RenderTargetScenario
+    {
+    public:
+        RenderTargetScenarioGL(GLContext& context, const Options& options)
+            : RenderTargetScenario(options)
+            , m_context(context)
+            , m_graph(context.state(), pooling(options), barriers(options))
+        {
+            m_scene = createProgram("rendertargets/quad.vert", "rendertargets/scene.frag");
+            m_filter = createProgram("rendertargets/quad.vert", "rendertargets/filter.frag");
+            m_composite = createProgram("rendertargets/quad.vert", "rendertargets/composite.frag");
+            m_present = createProgram("rendertargets/quad.vert", "rendertargets/present.frag");
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~RenderTargetScenarioGL() override
+        {
+            glDeleteProgram(m_scene);
+            glDeleteProgram(m_filter);
+            glDeleteProgram(m_composite);
+            glDeleteProgram(m_present);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            updateGraph(m_graph, uint32_t(m_context.width()), uint32_t(m_context.height()));
+
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.setBlend(false);
+            state.setCullFace(false);
+            m_graph.execute();
+        }
+
+        void report(Report& report) override
+        {
+            RenderTargetScenario::report(report);
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, uint32_t index) override
+        {
+            return m_graph.addPass(name, [this, index] { renderPass(index); });
+        }
+
+        /* Runs with the pass's framebuffer bound and cleared */
+        void renderPass(uint32_t p)
+        {
+            GLStateCache& state = m_context.state();
+            const RenderTargetPass& pass = m_passes[p];
+            switch (pass.kind)
+            {
+            case RenderTargetPassKind::Scene:
+                m_context.profiler().begin("scene");
+                state.useProgram(m_scene);
+                state.setDepthTest(true);
+                state.depthFunc(GL_LESS);
+                state.depthMask(true);
+                for (const RenderTargetConstants& quad : m_quads)
+                {
+                    m_context.pushConstants(&quad, sizeof(quad));
+                    glDrawArrays(GL_TRIANGLES, 0, 6);
+                }
+                state.setDepthTest(false);
+                m_context.profiler().end();
+                break;
+            case RenderTargetPassKind::Filter:
+                if (p == 1)
+                    m_context.profiler().begin("filter chain");
+                draw(m_filter, pass);
+                if (p == m_chain)
+                    m_context.profiler().end();
+                break;
+            case RenderTargetPassKind::Composite:
+                m_context.profiler().begin("composite");
+                draw(m_composite, pass);
+                m_context.profiler().end();
+                break;
+            case RenderTargetPassKind::Present:
+                m_context.profiler().begin("present");
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, m_context.width(), m_context.height());
+                draw(m_present, pass);
+                m_context.profiler().end();
+                break;
+            }
+        }
+
+        void draw(GLuint program, const RenderTargetPass& pass)
+        {
+            GLStateCache& state = m_context.state();
+            state.useProgram(program);
+            state.bindTextureUnit(0, m_graph.texture(pass.sources[0]));
+            state.bindTextureUnit(1, m_graph.texture(pass.sources[1]));
+            RenderTargetConstants constants = fullscreen(m_graph.desc(pass.sources[0]));
+            m_context.pushConstants(&constants, sizeof(constants));
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+
+        GLContext& m_context;
+        GLRenderGraph m_graph;
+        GLuint m_scene = 0;
+        GLuint m_filter = 0;
+        GLuint m_composite = 0;
+        GLuint m_present = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createRenderTargetScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<RenderTargetScenarioGL>(context, options);
+}
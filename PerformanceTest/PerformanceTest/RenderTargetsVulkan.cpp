@@ -0,0 +1,195 @@
+#include "RenderTargets.h"
+
+#include "VulkanContext.h"
+#include "VulkanRenderGraph.h"
+
+namespace
+{
+    /*
+     * Images, render passes and framebuffers come from the VulkanRenderGraph's pool, the graph
+     * transitions the images between the passes. The descriptor sets of the passes point at the
+     * pool's images and are rewritten whenever the pool recreated them, a pool reset and one
+     * write per pass.
+     */
+    class RenderTargetScenarioVulkan : public RenderTargetScenario
+    {
+    public:
+        RenderTargetScenarioVulkan(VulkanContext& context, const Options& options)
+            : RenderTargetScenario(options)
+            , m_context(context)
+            , m_graph(context, pooling(options), barriers(options))
+        {
+            VkDevice device = m_context.device();
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_LINEAR;
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            VK_CHECK(vkCreateSampler(device, &samplerInfo, vulkanHostAllocator(), &m_sampler));
+
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(RenderTargetConstants));
+            /* Every pass but the scene pass samples */
+            uint32_t setCount = m_chain + 2;
+            m_descriptorPool = m_context.createDescriptorPool(setCount, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount * 2 } });
+
+            /* Only formats, sample counts and transient flags matter for the render passes, the sizes do not */
+            RenderTargetDesc hdr = { 1, 1, RenderTargetFormat::RGBA16F, 1, false };
+            RenderTargetDesc depth = { 1, 1, RenderTargetFormat::Depth32F, 1, true };
+            RenderTargetDesc ldr = { 1, 1, RenderTargetFormat::RGBA8, 1, false };
+            VulkanRenderTargetPool& pool = m_graph.targets();
+            VkShaderModule vertexShader = m_context.createShaderModule("rendertargets/quad.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            m_scene = createPipeline(vertexShader, "rendertargets/scene.frag", pool.renderPass({ hdr }, &depth), true);
+            m_filter = createPipeline(vertexShader, "rendertargets/filter.frag", pool.renderPass({ hdr }), false);
+            m_composite = createPipeline(vertexShader, "rendertargets/composite.frag", pool.renderPass({ ldr }), false);
+            m_present = createPipeline(vertexShader, "rendertargets/present.frag", m_context.swapchainRenderPass(), false);
+            vkDestroyShaderModule(device, vertexShader, vulkanHostAllocator());
+        }
+
+        ~RenderTargetScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            vkDestroyPipeline(device, m_scene, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_filter, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_composite, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_present, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkExtent2D extent = m_context.swapchainExtent();
+            if (updateGraph(m_graph, extent.width, extent.height))
+                writeDescriptorSets();
+            m_graph.execute(m_context.commandBuffer());
+        }
+
+        void report(Report& report) override
+        {
+            RenderTargetScenario::report(report);
+            m_graph.report(report);
+        }
+
+    private:
+        uint32_t addPass(const char* name, uint32_t index) override
+        {
+            return m_graph.addPass(name, [this, index](VkCommandBuffer cmd) { recordPass(cmd, index); });
+        }
+
+        /* Records inside the render pass the graph began, the present pass begins the swapchain's */
+        void recordPass(VkCommandBuffer cmd, uint32_t p)
+        {
+            const RenderTargetPass& pass = m_passes[p];
+            switch (pass.kind)
+            {
+            case RenderTargetPassKind::Scene:
+                m_context.profiler().begin(cmd, "scene");
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_scene);
+                for (const RenderTargetConstants& quad : m_quads)
+                {
+                    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(quad), &quad);
+                    vkCmdDraw(cmd, 6, 1, 0, 0);
+                }
+                m_context.profiler().end(cmd);
+                break;
+            case RenderTargetPassKind::Filter:
+                if (p == 1)
+                    m_context.profiler().begin(cmd, "filter chain");
+                draw(cmd, m_filter, p);
+                if (p == m_chain)
+                    m_context.profiler().end(cmd);
+                break;
+            case RenderTargetPassKind::Composite:
+                m_context.profiler().begin(cmd, "composite");
+                draw(cmd, m_composite, p);
+                m_context.profiler().end(cmd);
+                break;
+            case RenderTargetPassKind::Present:
+            {
+                const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                m_context.profiler().begin(cmd, "present");
+                m_context.beginSwapchainPass(cmd, clearColor);
+                draw(cmd, m_present, p);
+                vkCmdEndRenderPass(cmd);
+                m_context.profiler().end(cmd);
+                break;
+            }
+            }
+        }
+
+        VkPipeline createPipeline(VkShaderModule vertexShader, const char* fragmentPath, VkRenderPass renderPass, bool depth)
+        {
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = renderPass;
+            desc.vertexShader = vertexShader;
+            desc.fragmentShader = m_context.createShaderModule(fragmentPath, VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = depth;
+            desc.depthWrite = depth;
+            VkPipeline pipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(m_context.device(), desc.fragmentShader, vulkanHostAllocator());
+            return pipeline;
+        }
+
+        /* One set per pass after the scene pass, indexed by pass - 1. The pool waited for the GPU before it recreated the targets */
+        void writeDescriptorSets()
+        {
+            VK_CHECK(vkResetDescriptorPool(m_context.device(), m_descriptorPool, 0));
+            m_sets.resize(m_passes.size() - 1);
+            for (uint32_t p = 1; p < m_passes.size(); ++p)
+            {
+                VkDescriptorSet set = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                VkDescriptorImageInfo images[2];
+                VkWriteDescriptorSet writes[2];
+                for (uint32_t i = 0; i < 2; ++i)
+                {
+                    images[i] = { m_sampler, m_graph.image(m_passes[p].sources[i]).view, VulkanRenderGraph::imageLayout(RenderGraphLayout::ShaderRead) };
+                    writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                    writes[i].dstSet = set;
+                    writes[i].dstBinding = i;
+                    writes[i].descriptorCount = 1;
+                    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    writes[i].pImageInfo = &images[i];
+                }
+                vkUpdateDescriptorSets(m_context.device(), 2, writes, 0, nullptr);
+                m_sets[p - 1] = set;
+            }
+        }
+
+        void draw(VkCommandBuffer cmd, VkPipeline pipeline, uint32_t pass)
+        {
+            RenderTargetConstants constants = fullscreen(m_graph.desc(m_passes[pass].sources[0]));
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_sets[pass - 1], 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, 6, 1, 0, 0);
+        }
+
+        VulkanContext& m_context;
+        VulkanRenderGraph m_graph;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> m_sets;
+        VkPipeline m_scene = VK_NULL_HANDLE;
+        VkPipeline m_filter = VK_NULL_HANDLE;
+        VkPipeline m_composite = VK_NULL_HANDLE;
+        VkPipeline m_present = VK_NULL_HANDLE;
+    };
+}
+
+std::unique_ptr<Scenario> createRenderTargetScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<RenderTargetScenarioVulkan>(context, options);
+}
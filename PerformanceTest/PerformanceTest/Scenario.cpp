@@ -0,0 +1,60 @@
+#include "Scenario.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "BindlessMaterials.h"
+#include "ClearScenario.h"
+#include "Clustered.h"
+#include "Deferred.h"
+#include "DescriptorStrategies.h"
+#include "DrawCalls.h"
+#include "GpuCulling.h"
+#include "Msaa.h"
+#include "Permutations.h"
+#include "PostChain.h"
+#include "RenderTargets.h"
+#include "SceneScenario.h"
+#include "ShaderCompile.h"
+#include "Shadows.h"
+#include "Specialization.h"
+#include "StateSort.h"
+#include "TransformScenario.h"
+
+namespace
+{
+    const ScenarioEntry kScenarios[] = {
+        { "clear", "Clears --targets color+depth+stencil at --resolution with --clear framebuffer|buffer|image|discard", createClearScenarioGL, createClearScenarioVulkan },
+        { "gpu-culling", "Frustum and Hi-Z occlusion culling of --instances boxes, --culling gpu|cpu|none", createGpuCullingScenarioGL, createGpuCullingScenarioVulkan },
+        { "transforms", "Animates and propagates a --instances node hierarchy with the batched SIMD math kernels", createTransformScenarioGL, createTransformScenarioVulkan },
+        { "scene", "Churns, updates, culls and batches a --instances structure of arrays scene", createSceneScenarioGL, createSceneScenarioVulkan },
+        { "bindless", "Changes the material of every one of --draws quads, --binding bindless|per-draw|array", createBindlessMaterialsScenarioGL, createBindlessMaterialsScenarioVulkan },
+        { "descriptors", "Rebinds per-draw uniforms for --draws quads, Vulkan --strategy pool|cached|push|dynamic", createDescriptorScenarioGL, createDescriptorScenarioVulkan },
+        { "draw-calls", "Draw call stress loop with per-draw constants, --constants ring|push|uniform", createDrawCallScenarioGL, createDrawCallScenarioVulkan },
+        { "state-sort", "Draws with random program, texture, mesh and blend state, --order sorted|submission, --sort radix|std, --state-cache on|off", createStateSortScenarioGL, createStateSortScenarioVulkan },
+        { "permutations", "Brings in new material permutations mid-run, Vulkan --pipeline-threads n --pipeline-library on|off, OpenGL --compile parallel|sync", createPermutationScenarioGL, createPermutationScenarioVulkan },
+        { "shader-compile", "Compiles --variants programs at startup, --parallel-compile on|off", createShaderCompileScenarioGL, createShaderCompileScenarioVulkan },
+        { "specialization", "Shades with light count, sample count and unroll factor configs, --shader specialized|branching", createSpecializationScenarioGL, createSpecializationScenarioVulkan },
+        { "render-targets", "Scene, --chain filter passes and composite through the render graph, --pooling alias|reuse|none, --barriers minimal|full", createRenderTargetScenarioGL, createRenderTargetScenarioVulkan },
+        { "deferred", "G-buffer and --lights n point lights, --lighting fullscreen|tiled, Vulkan --subpasses separate|merged", createDeferredScenarioGL, createDeferredScenarioVulkan },
+        { "clustered", "Forward shading with --lights n up to 100000 of --light-radius r, --shading clustered|forward", createClusteredScenarioGL, createClusteredScenarioVulkan },
+        { "shadows", "4 cascaded shadow maps over --instances n boxes, --shadow-size n, --threads n, OpenGL --layered on|off", createShadowScenarioGL, createShadowScenarioVulkan },
+        { "post", "Bloom, tonemap and FXAA at --resolution window|720p|1080p|1440p|4k, --post fragment|compute, --bloom-levels n, --fxaa on|off", createPostChainScenarioGL, createPostChainScenarioVulkan },
+        { "msaa", "Triangles with --samples 1|2|4|8 in --format rgba8|rgba16f|r11g11b10f at --resolution, --resolve blit|attachment|compute", createMsaaScenarioGL, createMsaaScenarioVulkan },
+    };
+}
+
+const ScenarioEntry* findScenario(const char* name)
+{
+    for (const ScenarioEntry& entry : kScenarios)
+        if (std::strcmp(entry.name, name) == 0)
+            return &entry;
+    return nullptr;
+}
+
+void printScenarios()
+{
+    std::printf("Scenarios:\n");
+    for (const ScenarioEntry& entry : kScenarios)
+        std::printf("  %-24s %s\n", entry.name, entry.description);
+}
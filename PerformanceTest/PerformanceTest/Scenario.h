@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+
+#include "Benchmark.h"
+
+class GLContext;
+class VulkanContext;
+
+/*
+ * A benchmark workload. Each scenario is implemented once per backend against the same
+ * scene data and shaders, the main loop drives both implementations identically.
+ */
+class Scenario
+{
+public:
+    virtual ~Scenario() = default;
+
+    /* CPU side work of the frame (simulation, culling, draw list building) */
+    virtual void update(const FrameInfo& frame) {}
+    /* Records the API work of the frame, called between the backend's beginFrame() and endFrame() */
+    virtual void render(const FrameInfo& frame) = 0;
+    /* Adds the scenario specific results to the run summary */
+    virtual void report(Report& report) {}
+};
+
+using GLScenarioFactory = std::unique_ptr<Scenario> (*)(GLContext& context, const Options& options);
+using VulkanScenarioFactory = std::unique_ptr<Scenario> (*)(VulkanContext& context, const Options& options);
+
+struct ScenarioEntry
+{
+    const char* name;
+    const char* description;
+    GLScenarioFactory createGL;
+    VulkanScenarioFactory createVulkan;
+};
+
+const ScenarioEntry* findScenario(const char* name);
+void printScenarios();
@@ -0,0 +1,199 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Benchmark.h"
+
+template <typename Function>
+void Scene::forEachArray(Function function)
+{
+    for (AlignedVector<float>* array : { &m_transforms.positionX, &m_transforms.positionY, &m_transforms.positionZ,
+                                         &m_transforms.rotationX, &m_transforms.rotationY, &m_transforms.rotationZ, &m_transforms.rotationW,
+                                         &m_transforms.scaleX, &m_transforms.scaleY, &m_transforms.scaleZ })
+        function(*array);
+    for (AlignedVector<float>& array : m_world.m)
+        function(array);
+    for (CullingBounds* bounds : { &m_localBounds, &m_bounds })
+        for (AlignedVector<float>* array : { &bounds->centerX, &bounds->centerY, &bounds->centerZ, &bounds->radius,
+                                             &bounds->extentX, &bounds->extentY, &bounds->extentZ })
+            function(*array);
+    for (AlignedVector<uint32_t>* array : { &m_meshIds, &m_materialIds, &m_denseToSlot })
+        function(*array);
+}
+
+void Scene::reserve(uint32_t count)
+{
+    forEachArray([count](auto& array) { array.reserve(count); });
+    m_slots.reserve(count);
+}
+
+SceneHandle Scene::create(const SceneInstanceDesc& desc)
+{
+    uint32_t slot = m_freeSlot;
+    if (slot != ~0u)
+    {
+        m_freeSlot = m_slots[slot].index;
+    }
+    else
+    {
+        slot = uint32_t(m_slots.size());
+        m_slots.push_back({ 0, 1 });
+    }
+
+    uint32_t index = size();
+    forEachArray([](auto& array) { array.emplace_back(); });
+    m_slots[slot].index = index;
+    m_denseToSlot[index] = slot;
+
+    m_transforms.set(index, desc.position, desc.rotation, desc.scale);
+    m_localBounds.centerX[index] = desc.boundsCenter.x;
+    m_localBounds.centerY[index] = desc.boundsCenter.y;
+    m_localBounds.centerZ[index] = desc.boundsCenter.z;
+    m_localBounds.extentX[index] = desc.boundsExtents.x;
+    m_localBounds.extentY[index] = desc.boundsExtents.y;
+    m_localBounds.extentZ[index] = desc.boundsExtents.z;
+    m_meshIds[index] = desc.meshId;
+    m_materialIds[index] = desc.materialId;
+    m_meshCount = std::max(m_meshCount, desc.meshId + 1);
+    m_materialCount = std::max(m_materialCount, desc.materialId + 1);
+
+    return { slot, m_slots[slot].generation };
+}
+
+void Scene::destroy(SceneHandle handle)
+{
+    uint32_t index = denseIndex(handle);
+    uint32_t last = size() - 1;
+    forEachArray([index, last](auto& array)
+    {
+        array[index] = array[last];
+        array.pop_back();
+    });
+    if (index != last)
+        m_slots[m_denseToSlot[index]].index = index;
+
+    Slot& slot = m_slots[handle.slot];
+    ++slot.generation;
+    slot.index = m_freeSlot;
+    m_freeSlot = handle.slot;
+}
+
+bool Scene::alive(SceneHandle handle) const
+{
+    return handle.slot < m_slots.size() && m_slots[handle.slot].generation == handle.generation;
+}
+
+uint32_t Scene::denseIndex(SceneHandle handle) const
+{
+    if (!alive(handle))
+        fatal("Scene: handle %u/%u does not refer to a live instance", handle.slot, handle.generation);
+    return m_slots[handle.slot].index;
+}
+
+void Scene::setTransform(SceneHandle handle, Vec3 position, Quat rotation, Vec3 scale)
+{
+    m_transforms.set(denseIndex(handle), position, rotation, scale);
+}
+
+void Scene::setMaterial(SceneHandle handle, uint32_t materialId)
+{
+    m_materialIds[denseIndex(handle)] = materialId;
+    m_materialCount = std::max(m_materialCount, materialId + 1);
+}
+
+void Scene::updateWorld(const MathKernels& kernels, uint32_t begin, uint32_t end)
+{
+    kernels.composeTransforms(m_transforms, m_world, begin, end);
+
+    /*
+     * Box transformed to world space and enclosed in an axis aligned box again: the center goes
+     * through the matrix, the extents through its absolute upper 3x3
+     */
+    const float* const m[16] = { m_world.m[0].data(), m_world.m[1].data(), m_world.m[2].data(), m_world.m[3].data(),
+                                 m_world.m[4].data(), m_world.m[5].data(), m_world.m[6].data(), m_world.m[7].data(),
+                                 m_world.m[8].data(), m_world.m[9].data(), m_world.m[10].data(), m_world.m[11].data(),
+                                 m_world.m[12].data(), m_world.m[13].data(), m_world.m[14].data(), m_world.m[15].data() };
+    const float* localX = m_localBounds.centerX.data();
+    const float* localY = m_localBounds.centerY.data();
+    const float* localZ = m_localBounds.centerZ.data();
+    const float* localExtentX = m_localBounds.extentX.data();
+    const float* localExtentY = m_localBounds.extentY.data();
+    const float* localExtentZ = m_localBounds.extentZ.data();
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        m_bounds.centerX[i] = m[0][i] * localX[i] + m[4][i] * localY[i] + m[8][i] * localZ[i] + m[12][i];
+        m_bounds.centerY[i] = m[1][i] * localX[i] + m[5][i] * localY[i] + m[9][i] * localZ[i] + m[13][i];
+        m_bounds.centerZ[i] = m[2][i] * localX[i] + m[6][i] * localY[i] + m[10][i] * localZ[i] + m[14][i];
+        float extentX = std::fabs(m[0][i]) * localExtentX[i] + std::fabs(m[4][i]) * localExtentY[i] + std::fabs(m[8][i]) * localExtentZ[i];
+        float extentY = std::fabs(m[1][i]) * localExtentX[i] + std::fabs(m[5][i]) * localExtentY[i] + std::fabs(m[9][i]) * localExtentZ[i];
+        float extentZ = std::fabs(m[2][i]) * localExtentX[i] + std::fabs(m[6][i]) * localExtentY[i] + std::fabs(m[10][i]) * localExtentZ[i];
+        m_bounds.extentX[i] = extentX;
+        m_bounds.extentY[i] = extentY;
+        m_bounds.extentZ[i] = extentZ;
+        m_bounds.radius[i] = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+    }
+}
+
+uint32_t Scene::cull(const CullingKernelInfo& kernel, const Frustum& frustum, CullingVolume volume, JobSystem& jobs,
+                     uint32_t* visible)
+{
+    uint32_t count = size();
+    m_batchCounts.resize((count + kBatchSize - 1) / kBatchSize);
+
+    jobs.parallelFor(count, kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        m_batchCounts[begin / kBatchSize] = kernel.kernel(m_bounds, frustum, volume, begin, end, visible + begin);
+    });
+
+    /* Closes the gaps between the batches, cheap next to the plane tests since most instances are culled */
+    uint32_t visibleCount = 0;
+    for (uint32_t batch = 0; batch < uint32_t(m_batchCounts.size()); ++batch)
+    {
+        if (batch * kBatchSize != visibleCount)
+            std::memmove(visible + visibleCount, visible + batch * kBatchSize, m_batchCounts[batch] * sizeof(uint32_t));
+        visibleCount += m_batchCounts[batch];
+    }
+    return visibleCount;
+}
+
+DrawList Scene::buildDrawList(const uint32_t* visible, uint32_t count, LinearArena& arena) const
+{
+    /* Counts per mesh and material, then turns the counts into the start offsets of the batches */
+    uint32_t keyCount = m_meshCount * m_materialCount;
+    uint32_t* offsets = arena.allocate<uint32_t>(keyCount);
+    uint32_t* keys = arena.allocate<uint32_t>(count);
+    std::fill(offsets, offsets + keyCount, 0u);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t key = m_meshIds[visible[i]] * m_materialCount + m_materialIds[visible[i]];
+        keys[i] = key;
+        ++offsets[key];
+    }
+
+    DrawBatch* batches = arena.allocate<DrawBatch>(std::min(keyCount, count));
+    uint32_t batchCount = 0;
+    uint32_t first = 0;
+    for (uint32_t key = 0; key < keyCount; ++key)
+    {
+        uint32_t instanceCount = offsets[key];
+        if (instanceCount == 0)
+            continue;
+        batches[batchCount++] = { key / m_materialCount, key % m_materialCount, first, instanceCount };
+        offsets[key] = first;
+        first += instanceCount;
+    }
+
+    /* Stable, the instances of a batch stay in ascending dense order */
+    uint32_t* instances = arena.allocate<uint32_t>(count);
+    for (uint32_t i = 0; i < count; ++i)
+        instances[offsets[keys[i]]++] = visible[i];
+
+    DrawList drawList;
+    drawList.batches = batches;
+    drawList.batchCount = batchCount;
+    drawList.instances = instances;
+    drawList.instanceCount = count;
+    return drawList;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "CpuCulling.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MathBatch.h"
+
+/*
+ * Stable reference to a scene instance. The slot stays the same for the lifetime of the
+ * instance, the generation tells a destroyed instance apart from a later one reusing the slot.
+ */
+struct SceneHandle
+{
+    uint32_t slot = ~0u;
+    uint32_t generation = 0;
+};
+
+struct SceneInstanceDesc
+{
+    Vec3 position = { 0.0f, 0.0f, 0.0f };
+    Quat rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+    Vec3 scale = { 1.0f, 1.0f, 1.0f };
+    /* Local space bounding box */
+    Vec3 boundsCenter = { 0.0f, 0.0f, 0.0f };
+    Vec3 boundsExtents = { 1.0f, 1.0f, 1.0f };
+    uint32_t meshId = 0;
+    uint32_t materialId = 0;
+};
+
+/* Instances of one mesh and material, a single instanced draw */
+struct DrawBatch
+{
+    uint32_t meshId;
+    uint32_t materialId;
+    /* Range of DrawList::instances */
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+/* Lives in a frame arena, see Scene::buildDrawList() */
+struct DrawList
+{
+    const DrawBatch* batches = nullptr;
+    uint32_t batchCount = 0;
+    /* Dense instance indices grouped by batch */
+    const uint32_t* instances = nullptr;
+    uint32_t instanceCount = 0;
+};
+
+/*
+ * Renderable instances in structure of arrays pools. Live instances are packed densely at
+ * [0, size()), destroy() moves the last instance into the hole, so every pass over the scene
+ * streams linearly through the arrays no matter how much the scene changed. Handles point to
+ * a slot that knows the current dense index, free slots form a list threaded through the slots.
+ */
+class Scene
+{
+public:
+    /* Instances per job, a multiple of kCullingBatchAlignment */
+    static constexpr uint32_t kBatchSize = 16384;
+
+    void reserve(uint32_t count);
+
+    SceneHandle create(const SceneInstanceDesc& desc);
+    void destroy(SceneHandle handle);
+    bool alive(SceneHandle handle) const;
+
+    void setTransform(SceneHandle handle, Vec3 position, Quat rotation, Vec3 scale);
+    void setMaterial(SceneHandle handle, uint32_t materialId);
+
+    uint32_t size() const { return uint32_t(m_denseToSlot.size()); }
+    /* Changes whenever an instance behind it is destroyed, only valid until the next destroy() */
+    uint32_t denseIndex(SceneHandle handle) const;
+
+    /* Composes the world matrices and world bounds of the dense range [begin, end) */
+    void updateWorld(const MathKernels& kernels, uint32_t begin, uint32_t end);
+
+    /*
+     * Culls the whole scene on the job system, writes the dense indices of the visible
+     * instances to the front of `visible` in ascending order and returns their count.
+     * `visible` needs room for size() indices.
+     */
+    uint32_t cull(const CullingKernelInfo& kernel, const Frustum& frustum, CullingVolume volume, JobSystem& jobs,
+                  uint32_t* visible);
+
+    /*
+     * Groups the visible instances by mesh and material with a counting sort. The list and
+     * the scratch memory of the sort come from `arena`.
+     */
+    DrawList buildDrawList(const uint32_t* visible, uint32_t count, LinearArena& arena) const;
+
+    uint32_t meshCount() const { return m_meshCount; }
+    uint32_t materialCount() const { return m_materialCount; }
+
+    /* Dense arrays, all indexed by the dense index */
+    TransformBatch& transforms() { return m_transforms; }
+    const TransformBatch& transforms() const { return m_transforms; }
+    const Mat4Batch& world() const { return m_world; }
+    const CullingBounds& bounds() const { return m_bounds; }
+    const AlignedVector<uint32_t>& meshIds() const { return m_meshIds; }
+    const AlignedVector<uint32_t>& materialIds() const { return m_materialIds; }
+
+private:
+    struct Slot
+    {
+        /* Dense index while alive, next free slot while free */
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    /* Calls function(array) for every dense array */
+    template <typename Function>
+    void forEachArray(Function function);
+
+    TransformBatch m_transforms;
+    Mat4Batch m_world;
+    /* Local space boxes, radius unused */
+    CullingBounds m_localBounds;
+    /* World space, updated by updateWorld() */
+    CullingBounds m_bounds;
+    AlignedVector<uint32_t> m_meshIds;
+    AlignedVector<uint32_t> m_materialIds;
+    AlignedVector<uint32_t> m_denseToSlot;
+
+    std::vector<Slot> m_slots;
+    uint32_t m_freeSlot = ~0u;
+    uint32_t m_meshCount = 0;
+    uint32_t m_materialCount = 0;
+
+    /* Visible count of every batch of cull() */
+    std::vector<uint32_t> m_batchCounts;
+};
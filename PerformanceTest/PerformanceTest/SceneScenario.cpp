@@ -0,0 +1,137 @@
+#include "SceneScenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "ClearOnlyScenario.h"
+#include "Random.h"
+#include "Timer.h"
+
+namespace
+{
+    const float kSpacing = 3.0f;
+
+    uint32_t gridSide(uint32_t instanceCount)
+    {
+        return std::max(1u, uint32_t(std::ceil(std::sqrt(double(instanceCount)))));
+    }
+}
+
+SceneScenario::SceneScenario(const Options& options, uint32_t width, uint32_t height)
+    : m_kernels(selectMathKernels(options.getString("math-kernels", "auto")))
+    , m_cullKernel(selectCullingKernel(options.getString("cull-kernel", "auto")))
+    , m_jobs(uint32_t(options.getInt("threads", 0)))
+    , m_aspect(float(width) / float(height))
+{
+    uint32_t count = uint32_t(options.getInt("instances", 1000000));
+    m_churn = uint32_t(options.getInt("churn", 1000));
+    m_moving = uint32_t(options.getInt("moving", 10000));
+    m_meshes = uint32_t(options.getInt("meshes", 4));
+    m_materials = uint32_t(options.getInt("materials", 16));
+    if (count == 0 || m_meshes == 0 || m_materials == 0)
+        fatal("--instances, --meshes and --materials have to be at least 1");
+    m_churn = std::min(m_churn, count);
+    m_moving = std::min(m_moving, count);
+
+    m_scene.reserve(count);
+    m_handles.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        m_handles[i] = m_scene.create(randomInstance(i));
+
+    std::printf("scene: %u instances, %u meshes, %u materials, churn %u, moving %u, %s/%s kernels on %u threads\n", count, m_meshes,
+                m_materials, m_churn, m_moving, m_kernels.name, m_cullKernel.name, m_jobs.threadCount());
+}
+
+SceneInstanceDesc SceneScenario::randomInstance(uint32_t gridIndex)
+{
+    uint32_t side = gridSide(uint32_t(m_handles.size()));
+    float offset = float(side) * kSpacing * 0.5f;
+
+    SceneInstanceDesc desc;
+    float height = 0.5f + randomUnit(m_state) * 2.0f;
+    desc.position = { float(gridIndex % side) * kSpacing - offset, height, float(gridIndex / side) * kSpacing - offset };
+    desc.rotation = axisAngle({ 0.0f, 1.0f, 0.0f }, randomUnit(m_state) * 6.2831853f);
+    desc.scale = { 0.5f, height, 0.5f };
+    desc.meshId = random(m_state) % m_meshes;
+    desc.materialId = random(m_state) % m_materials;
+    return desc;
+}
+
+void SceneScenario::update(const FrameInfo& frame)
+{
+    uint32_t count = uint32_t(m_handles.size());
+
+    /* Structural changes and the few instances touched by gameplay go through the handles */
+    Timer churnTimer;
+    for (uint32_t i = 0; i < m_churn; ++i)
+    {
+        uint32_t gridIndex = random(m_state) % count;
+        m_scene.destroy(m_handles[gridIndex]);
+        m_handles[gridIndex] = m_scene.create(randomInstance(gridIndex));
+    }
+    float time = float(frame.index) / 60.0f;
+    TransformBatch& transforms = m_scene.transforms();
+    for (uint32_t i = 0; i < m_moving; ++i)
+    {
+        uint32_t index = m_scene.denseIndex(m_handles[i]);
+        Vec3 position = { transforms.positionX[index], transforms.positionY[index], transforms.positionZ[index] };
+        position.y = transforms.scaleY[index] + 0.5f + 0.5f * std::sin(time + float(i));
+        m_scene.setTransform(m_handles[i], position, axisAngle({ 0.0f, 1.0f, 0.0f }, time), { 0.5f, transforms.scaleY[index], 0.5f });
+    }
+    double churnTime = churnTimer.elapsedMs();
+
+    /* Everything else streams over the dense arrays */
+    Timer updateTimer;
+    m_jobs.parallelFor(m_scene.size(), Scene::kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        m_scene.updateWorld(m_kernels, begin, end);
+    });
+    double updateTime = updateTimer.elapsedMs();
+
+    float extent = float(gridSide(count)) * kSpacing;
+    Mat4 viewProj = perspective(1.0f, m_aspect, 0.5f, extent * 1.5f)
+                  * lookAt({ -extent * 0.5f, extent * 0.25f, -extent * 0.5f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+
+    Timer cullTimer;
+    uint32_t* visibleIndices = frame.arena->allocate<uint32_t>(m_scene.size());
+    uint32_t visible = m_scene.cull(m_cullKernel, extractFrustum(viewProj), CullingVolume::Sphere, m_jobs, visibleIndices);
+    double cullTime = cullTimer.elapsedMs();
+
+    Timer drawListTimer;
+    m_drawList = m_scene.buildDrawList(visibleIndices, visible, *frame.arena);
+    double drawListTime = drawListTimer.elapsedMs();
+
+    if (frame.measured)
+    {
+        m_churnTimes.add(churnTime);
+        m_updateTimes.add(updateTime);
+        m_cullTimes.add(cullTime);
+        m_drawListTimes.add(drawListTime);
+        m_visibleCounts.add(double(visible));
+        m_batchCounts.add(double(m_drawList.batchCount));
+    }
+}
+
+void SceneScenario::report(Report& report)
+{
+    report.addText("math kernels", m_kernels.name);
+    report.addText("cpu cull kernel", m_cullKernel.name);
+    report.addValue("cpu threads", double(m_jobs.threadCount()), "");
+    report.addStatistics("cpu churn", m_churnTimes, "ms");
+    report.addStatistics("cpu scene update", m_updateTimes, "ms");
+    report.addStatistics("cpu cull", m_cullTimes, "ms");
+    report.addStatistics("cpu draw list", m_drawListTimes, "ms");
+    report.addStatistics("visible instances", m_visibleCounts, "");
+    report.addStatistics("draw batches", m_batchCounts, "");
+}
+
+std::unique_ptr<Scenario> createSceneScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ClearOnlyScenarioGL<SceneScenario>>(context, options);
+}
+
+std::unique_ptr<Scenario> createSceneScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ClearOnlyScenarioVulkan<SceneScenario>>(context, options);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Scenario.h"
+#include "Scene.h"
+
+/*
+ * CPU side of a changing scene: every frame instances are destroyed and created, some move,
+ * then the whole scene is updated, culled and turned into a draw list by streaming over the
+ * dense arrays of the Scene. The GPU only clears, the interesting numbers are the CPU times.
+ */
+class SceneScenario : public Scenario
+{
+public:
+    SceneScenario(const Options& options, uint32_t width, uint32_t height);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    Scene m_scene;
+    /* Visible dense indices grouped by mesh and material, in the frame arena of the current frame */
+    DrawList m_drawList;
+
+private:
+    SceneInstanceDesc randomInstance(uint32_t gridIndex);
+
+    const MathKernels& m_kernels;
+    CullingKernelInfo m_cullKernel;
+    JobSystem m_jobs;
+    float m_aspect;
+    uint32_t m_churn;
+    uint32_t m_moving;
+    uint32_t m_meshes;
+    uint32_t m_materials;
+    uint32_t m_state = 0x6C8E9CF5u;
+
+    /* Handle of the instance at every grid position, churn replaces them in place */
+    std::vector<SceneHandle> m_handles;
+
+    Statistics m_churnTimes;
+    Statistics m_updateTimes;
+    Statistics m_cullTimes;
+    Statistics m_drawListTimes;
+    Statistics m_visibleCounts;
+    Statistics m_batchCounts;
+};
+
+std::unique_ptr<Scenario> createSceneScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createSceneScenarioVulkan(VulkanContext& context, const Options& options);
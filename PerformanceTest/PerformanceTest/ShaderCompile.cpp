@@ -0,0 +1,58 @@
+#include "ShaderCompile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "GLFW/glfw3.h"
+
+ShaderCompileScenario::ShaderCompileScenario(const Options& options, bool vulkan)
+    : m_variantCount(uint32_t(options.getInt("variants", 300)))
+    , m_parallel(options.getBool("parallel-compile", true))
+    , m_threadCount(uint32_t(options.getInt("compile-threads", 0)))
+    , m_vulkan(vulkan)
+{
+    if (m_variantCount == 0)
+        fatal("--variants has to be at least 1");
+    if (options.getBool("cold", true))
+        m_salt = glfwGetTimerValue();
+    for (uint32_t i = 0; i < m_variantCount; ++i)
+        if (findEmbeddedShader("permutations/quad.frag", { { "VARIANT", std::to_string(i) } }, vulkan))
+            ++m_embeddedCount;
+
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(m_variantCount)))));
+    float cell = 2.0f / float(side);
+    m_draws.resize(m_variantCount);
+    for (uint32_t i = 0; i < m_variantCount; ++i)
+    {
+        m_draws[i].rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        m_draws[i].color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    }
+}
+
+ShaderDefines ShaderCompileScenario::variantDefines(uint32_t variant) const
+{
+    ShaderDefines defines = { { "VARIANT", std::to_string(variant) } };
+    if (!findEmbeddedShader("permutations/quad.frag", defines, m_vulkan))
+        defines.push_back({ "SALT", std::to_string(m_salt) });
+    return defines;
+}
+
+void ShaderCompileScenario::recordStartup(double blockedMs, double totalMs)
+{
+    m_blockedMs = blockedMs;
+    m_startupMs = totalMs;
+    std::printf("shader-compile: %u variants (%u from SPIR-V) in %.1f ms, %s\n", m_variantCount, m_embeddedCount, totalMs,
+                m_parallel ? "parallel" : "serial");
+}
+
+void ShaderCompileScenario::report(Report& report)
+{
+    report.addText("parallel compile", m_parallel ? "on" : "off");
+    report.addValue("variants", double(m_variantCount), "");
+    report.addValue("variants from SPIR-V", double(m_embeddedCount), "");
+    report.addValue("startup compile", m_startupMs, "ms");
+    report.addValue("startup blocked", m_blockedMs, "ms");
+    report.addValue("startup per variant", m_startupMs / double(m_variantCount), "ms");
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Permutations.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/*
+ * Startup shader compilation: --variants material variants of shaders/permutations are
+ * compiled while the scenario is created, --parallel-compile on|off selects between the
+ * parallel and the serial path of each backend. The frames only draw one quad per variant to
+ * show they are usable, the numbers of interest are the startup times in the report.
+ */
+class ShaderCompileScenario : public Scenario
+{
+public:
+    ShaderCompileScenario(const Options& options, bool vulkan);
+
+    void report(Report& report) override;
+
+protected:
+    /*
+     * With --cold on (default) the defines carry a value unique to the run, so the source text
+     * differs from earlier runs and the driver's shader cache cannot answer the compile.
+     * Variants embedded as SPIR-V keep their plain defines, compare --spirv on and off for the
+     * cost of the GLSL front end.
+     */
+    ShaderDefines variantDefines(uint32_t variant) const;
+    /* `blockedMs` is the time the loading thread could not do anything else */
+    void recordStartup(double blockedMs, double totalMs);
+
+    uint32_t m_variantCount;
+    bool m_parallel;
+    /* 0 lets the backend choose */
+    uint32_t m_threadCount;
+    /* One quad per variant */
+    std::vector<PermutationConstants> m_draws;
+
+private:
+    uint64_t m_salt = 0;
+    bool m_vulkan;
+    uint32_t m_embeddedCount = 0;
+    double m_blockedMs = 0.0;
+    double m_startupMs = 0.0;
+};
+
+std::unique_ptr<Scenario> createShaderCompileScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createShaderCompileScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,88 @@
+#include "ShaderCompile.h"
+
+#include <cstdio>
+
+#include "GLContext.h"
+#include "GLProgramLoader.h"
+#include "Timer.h"
+
+namespace
+{
+    /* One GL context, so the only parallelism is the driver's own through KHR_parallel_shader_compile */
+    class ShaderCompileScenarioGL : public ShaderCompileScenario
+    {
+    public:
+        ShaderCompileScenarioGL(GLContext& context, const Options& options)
+            : ShaderCompileScenario(options, false)
+            , m_context(context)
+        {
+            const GLExtensions& extensions = m_context.extensions();
+            if (m_parallel && !extensions.parallelShaderCompile)
+            {
+                std::printf("shader-compile: KHR_parallel_shader_compile is not supported, falling back to serial compiles\n");
+                m_parallel = false;
+            }
+
+            GLProgramLoader loader(extensions, m_parallel, m_threadCount);
+            if (extensions.parallelShaderCompile)
+                glGetIntegerv(GL_MAX_SHADER_COMPILER_THREADS_KHR, &m_compilerThreads);
+
+            Timer timer;
+            for (uint32_t i = 0; i < m_variantCount; ++i)
+                loader.add("permutations/quad.vert", "permutations/quad.frag", variantDefines(i));
+            double submitted = timer.elapsedMs();
+            loader.finish();
+            double total = timer.elapsedMs();
+            /* The serial path blocks in every add(), the parallel one could do other work while the driver compiles */
+            recordStartup(m_parallel ? submitted : total, total);
+
+            m_programs = loader.programs();
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~ShaderCompileScenarioGL() override
+        {
+            for (GLuint program : m_programs)
+                glDeleteProgram(program);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            GLStateCache& state = m_context.state();
+            m_context.profiler().begin("draw");
+            state.bindVertexArray(m_vertexArray);
+            state.setDepthTest(false);
+            state.setCullFace(false);
+            for (uint32_t i = 0; i < m_variantCount; ++i)
+            {
+                state.useProgram(m_programs[i]);
+                m_context.pushConstants(&m_draws[i], sizeof(PermutationConstants));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+            m_context.profiler().end();
+        }
+
+        void report(Report& report) override
+        {
+            ShaderCompileScenario::report(report);
+            report.addValue("driver compiler threads", double(m_compilerThreads), "");
+        }
+
+    private:
+        GLContext& m_context;
+        GLint m_compilerThreads = 0;
+        std::vector<GLuint> m_programs;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createShaderCompileScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ShaderCompileScenarioGL>(context, options);
+}
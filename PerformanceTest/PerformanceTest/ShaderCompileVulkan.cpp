@@ -0,0 +1,96 @@
+#include "ShaderCompile.h"
+
+#include "JobSystem.h"
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    /*
+     * Vulkan compiles on any thread: GLSL to SPIR-V, the shader module and the pipeline of each
+     * variant are one job, spread over a JobSystem with --parallel-compile on.
+     */
+    class ShaderCompileScenarioVulkan : public ShaderCompileScenario
+    {
+    public:
+        ShaderCompileScenarioVulkan(VulkanContext& context, const Options& options)
+            : ShaderCompileScenario(options, true)
+            , m_context(context)
+        {
+            m_pipelineLayout = m_context.createPipelineLayout({}, sizeof(PermutationConstants));
+            m_pipelines.resize(m_variantCount);
+
+            Timer timer;
+            VkShaderModule vertexShader = m_context.createShaderModule("permutations/quad.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            auto compile = [&](uint32_t begin, uint32_t end, uint32_t)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    GraphicsPipelineDesc desc;
+                    desc.layout = m_pipelineLayout;
+                    desc.renderPass = m_context.swapchainRenderPass();
+                    desc.vertexShader = vertexShader;
+                    desc.fragmentShader = m_context.createShaderModule("permutations/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT, variantDefines(i));
+                    desc.cullMode = VK_CULL_MODE_NONE;
+                    desc.depthTest = false;
+                    desc.depthWrite = false;
+                    m_pipelines[i] = m_context.createGraphicsPipeline(desc);
+                    vkDestroyShaderModule(m_context.device(), desc.fragmentShader, vulkanHostAllocator());
+                }
+            };
+            if (m_parallel)
+            {
+                JobSystem jobs(m_threadCount);
+                m_compileThreads = jobs.threadCount();
+                jobs.parallelFor(m_variantCount, 1, compile);
+            }
+            else
+                compile(0, m_variantCount, 0);
+            vkDestroyShaderModule(m_context.device(), vertexShader, vulkanHostAllocator());
+            double total = timer.elapsedMs();
+            recordStartup(total, total);
+        }
+
+        ~ShaderCompileScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            for (VkPipeline pipeline : m_pipelines)
+                vkDestroyPipeline(device, pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "draw");
+            for (uint32_t i = 0; i < m_variantCount; ++i)
+            {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[i]);
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(PermutationConstants), &m_draws[i]);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+            }
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+        void report(Report& report) override
+        {
+            ShaderCompileScenario::report(report);
+            report.addValue("compile threads", double(m_compileThreads), "");
+        }
+
+    private:
+        VulkanContext& m_context;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        std::vector<VkPipeline> m_pipelines;
+        uint32_t m_compileThreads = 1;
+    };
+}
+
+std::unique_ptr<Scenario> createShaderCompileScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ShaderCompileScenarioVulkan>(context, options);
+}
@@ -0,0 +1,73 @@
+#include "ShaderSource.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "Benchmark.h"
+
+namespace
+{
+    const char* kShaderDirectory = "shaders/";
+
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            fatal("Failed to open shader '%s'", path.c_str());
+
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    std::string directoryOf(const std::string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    void appendResolved(const std::string& path, std::string& out, int depth)
+    {
+        if (depth > 16)
+            fatal("Shader include depth exceeded in '%s'", path.c_str());
+
+        std::istringstream source(readFile(path));
+        std::string line;
+        while (std::getline(source, line))
+        {
+            size_t begin = line.find_first_not_of(" \t");
+            if (begin != std::string::npos && line.compare(begin, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', begin);
+                size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                if (close == std::string::npos)
+                    fatal("Malformed #include in '%s': %s", path.c_str(), line.c_str());
+
+                appendResolved(directoryOf(path) + line.substr(open + 1, close - open - 1), out, depth + 1);
+                continue;
+            }
+            out += line;
+            out += '\n';
+        }
+    }
+}
+
+std::string loadShaderSource(const std::string& path, const ShaderDefines& defines, bool vulkan)
+{
+    std::string resolved;
+    appendResolved(kShaderDirectory + path, resolved, 0);
+
+    std::string preamble;
+    if (vulkan)
+        preamble += "#define VULKAN 1\n";
+    for (const auto& define : defines)
+        preamble += "#define " + define.first + " " + define.second + "\n";
+
+    /* #version has to stay the first statement of the shader */
+    size_t version = resolved.find("#version");
+    if (version == std::string::npos)
+        fatal("Shader '%s' has no #version directive", path.c_str());
+    size_t lineEnd = resolved.find('\n', version);
+    resolved.insert(lineEnd == std::string::npos ? resolved.size() : lineEnd + 1, preamble);
+    return resolved;
+}
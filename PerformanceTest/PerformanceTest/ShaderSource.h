@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Preprocessor definitions injected after the #version line */
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+/*
+ * Loads a GLSL file from the shader directory and resolves #include "file" directives relative
+ * to the including file, so both backends compile the exact same source. VULKAN is defined for
+ * the Vulkan backend, the shaders use it to select binding and builtin syntax.
+ */
+std::string loadShaderSource(const std::string& path, const ShaderDefines& defines, bool vulkan);
+
+/* SPIR-V of a shader variant, compiled at build time by CompileShaders.ps1 */
+struct EmbeddedShader
+{
+    /* Path in the shader directory, then |NAME=VALUE for every define in ShaderDefines order */
+    const char* key;
+    /* For Vulkan 1.2 with VULKAN defined, otherwise for OpenGL 4.6 through glSpecializeShader */
+    bool vulkan;
+    const uint32_t* code;
+    size_t wordCount;
+};
+
+/* --spirv off, every shader is compiled from GLSL at runtime */
+void setEmbeddedShadersEnabled(bool enabled);
+/* false as well when the build had no generated shaders */
+bool embeddedShadersEnabled();
+/* nullptr if the variant was not embedded, the caller compiles the GLSL source then */
+const EmbeddedShader* findEmbeddedShader(const std::string& path, const ShaderDefines& defines, bool vulkan);
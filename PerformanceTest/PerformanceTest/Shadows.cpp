@@ -0,0 +1,198 @@
+#include "Shadows.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Random.h"
+#include "Timer.h"
+
+namespace
+{
+    constexpr float kFovY = 1.0f;
+    constexpr float kNear = 0.5f;
+    constexpr float kSpacing = 3.0f;
+    /* Cascades end at most this far from the camera, the rest of the view is unshadowed */
+    constexpr float kShadowDistance = 150.0f;
+    /* Practical split scheme, between uniform (0) and logarithmic (1) split distances */
+    constexpr float kSplitLambda = 0.75f;
+    /* How far towards the light from a cascade's bounding sphere casters still cast into it */
+    constexpr float kCasterMargin = 30.0f;
+    const Vec3 kUp = { 0.0f, 1.0f, 0.0f };
+    const Vec3 kLightDirection = normalize(Vec3{ 0.4f, -1.0f, 0.3f });
+}
+
+const char* const ShadowScenario::kCascadeZones[kCascadeCount] = { "cascade 0", "cascade 1", "cascade 2", "cascade 3" };
+
+ShadowScenario::ShadowScenario(const Options& options, uint32_t width, uint32_t height, bool layeredSupported)
+    : m_shadowSize(uint32_t(options.getInt("shadow-size", 2048)))
+    , m_layered(options.getBool("layered", false))
+    , m_jobs(uint32_t(options.getInt("threads", 0)))
+    , m_cullKernel(selectCullingKernel(options.getString("cull-kernel", "auto")))
+    , m_aspect(float(width) / float(height))
+{
+    if (m_shadowSize < 256 || m_shadowSize > 16384)
+        fatal("--shadow-size has to be between 256 and 16384");
+    if (m_layered && !layeredSupported)
+    {
+        std::printf("shadows: layered rendering is not supported, falling back to one pass per cascade\n");
+        m_layered = false;
+    }
+
+    int64_t count = options.getInt("instances", 16384);
+    if (count < 2 || count > (1 << 20))
+        fatal("--instances has to be between 2 and %d", 1 << 20);
+
+    /* Instance 0 is the ground, the others stand on a square grid */
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(count - 1))));
+    m_extent = float(side) * kSpacing * 0.5f;
+    m_instances.resize(size_t(count));
+    m_instances[0] = { { 0.0f, -0.5f, 0.0f, 0.0f }, { m_extent + kSpacing, 0.5f, m_extent + kSpacing, 0.0f } };
+    uint32_t state = 0x5AD0u;
+    for (uint32_t i = 1; i < m_instances.size(); ++i)
+    {
+        uint32_t cell = i - 1;
+        float height = 1.0f + 7.0f * randomUnit(state);
+        float width = 0.4f + 0.8f * randomUnit(state);
+        float x = (float(cell % side) - 0.5f * float(side - 1)) * kSpacing;
+        float z = (float(cell / side) - 0.5f * float(side - 1)) * kSpacing;
+        m_instances[i] = { { x, 0.5f * height, z, 0.0f }, { width, 0.5f * height, width, 0.0f } };
+    }
+
+    m_bounds.resize(uint32_t(count));
+    for (uint32_t i = 0; i < m_instances.size(); ++i)
+    {
+        const ShadowInstance& instance = m_instances[i];
+        m_bounds.centerX[i] = instance.center.x;
+        m_bounds.centerY[i] = instance.center.y;
+        m_bounds.centerZ[i] = instance.center.z;
+        m_bounds.extentX[i] = instance.extents.x;
+        m_bounds.extentY[i] = instance.extents.y;
+        m_bounds.extentZ[i] = instance.extents.z;
+        m_bounds.radius[i] = length(Vec3{ instance.extents.x, instance.extents.y, instance.extents.z });
+    }
+    for (std::vector<uint32_t>& casters : m_casters)
+        casters.resize(m_instances.size());
+
+    std::printf("shadows: %u boxes, %u cascades of %ux%u, %s, %s kernel on %u threads\n", uint32_t(m_instances.size()), kCascadeCount, m_shadowSize,
+                m_shadowSize, m_layered ? "layered" : "one pass per cascade", m_cullKernel.name, m_jobs.threadCount());
+}
+
+void ShadowScenario::update(const FrameInfo& frame)
+{
+    /* Circles above the boxes looking along the circle, one revolution every ~50 seconds at 60 fps */
+    float angle = float(frame.index) * 0.002f;
+    float radius = m_extent * 0.5f;
+    m_eye = { std::cos(angle) * radius, 12.0f, std::sin(angle) * radius };
+    Vec3 target = { std::cos(angle + 0.3f) * radius, 4.0f, std::sin(angle + 0.3f) * radius };
+    m_forward = normalize(target - m_eye);
+    m_viewProj = perspective(kFovY, m_aspect, kNear, m_extent * 2.0f) * lookAt(m_eye, target, kUp);
+
+    float shadowDistance = std::min(kShadowDistance, m_extent * 2.0f);
+    float nearDepth = kNear;
+    float* splits = &m_cascades.splits.x;
+    for (uint32_t c = 0; c < kCascadeCount; ++c)
+    {
+        float p = float(c + 1) / float(kCascadeCount);
+        float logarithmic = kNear * std::pow(shadowDistance / kNear, p);
+        float uniform = kNear + (shadowDistance - kNear) * p;
+        splits[c] = kSplitLambda * logarithmic + (1.0f - kSplitLambda) * uniform;
+        fitCascade(c, nearDepth, splits[c]);
+        nearDepth = splits[c];
+    }
+
+    /* One job per cascade, each tests every box against its light frustum */
+    Timer timer;
+    m_jobs.parallelFor(kCascadeCount, 1, [this](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t c = begin; c < end; ++c)
+            m_casterCounts[c] = m_cullKernel.kernel(m_bounds, extractFrustum(m_cascades.viewProj[c]), CullingVolume::Box, 0, m_bounds.size(),
+                                                    m_casters[c].data());
+    });
+    if (frame.measured)
+    {
+        m_cullTimes.add(timer.elapsedMs());
+        uint32_t total = 0;
+        for (uint32_t count : m_casterCounts)
+            total += count;
+        m_casterTotals.add(double(total));
+    }
+}
+
+/* Orthographic light projection around the bounding sphere of the view frustum between the two depths */
+void ShadowScenario::fitCascade(uint32_t cascade, float nearDepth, float farDepth)
+{
+    float tanY = std::tan(kFovY * 0.5f);
+    float tanX = tanY * m_aspect;
+    Vec3 right = normalize(cross(m_forward, kUp));
+    Vec3 up = cross(right, m_forward);
+
+    Vec3 corners[8];
+    Vec3 center = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        float depth = i & 4 ? farDepth : nearDepth;
+        float x = (i & 1 ? 1.0f : -1.0f) * depth * tanX;
+        float y = (i & 2 ? 1.0f : -1.0f) * depth * tanY;
+        corners[i] = m_eye + m_forward * depth + right * x + up * y;
+        center = center + corners[i] * 0.125f;
+    }
+    float radius = 0.0f;
+    for (const Vec3& corner : corners)
+        radius = std::max(radius, length(corner - center));
+    /* A sphere rather than a tight box keeps the texel size constant while the camera turns */
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    Mat4 view = lookAt(center - kLightDirection * (radius + kCasterMargin), center, kUp);
+    Mat4 viewProj = orthographic(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + kCasterMargin) * view;
+
+    /* Moves the projection by less than a texel so the world origin lands on one, the shadow edges do not crawl */
+    Vec4 origin = viewProj * Vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+    float texels = float(m_shadowSize) * 0.5f;
+    float x = origin.x * texels;
+    float y = origin.y * texels;
+    viewProj.at(0, 3) += (std::round(x) - x) / texels;
+    viewProj.at(1, 3) += (std::round(y) - y) / texels;
+    m_cascades.viewProj[cascade] = viewProj;
+}
+
+ShadowConstants ShadowScenario::sceneConstants() const
+{
+    ShadowConstants constants = {};
+    constants.viewProj = m_viewProj;
+    constants.eye = { m_eye.x, m_eye.y, m_eye.z, 1.0f };
+    constants.lightDirection = { kLightDirection.x, kLightDirection.y, kLightDirection.z, 0.0f };
+    return constants;
+}
+
+ShadowConstants ShadowScenario::cascadeConstants(uint32_t cascade) const
+{
+    ShadowConstants constants = sceneConstants();
+    constants.cascade = cascade;
+    return constants;
+}
+
+ShaderDefines ShadowScenario::shadowDefines() const
+{
+    return { { "LAYERED", m_layered ? "1" : "0" } };
+}
+
+void ShadowScenario::addRecordTime(double ms, const FrameInfo& frame)
+{
+    if (frame.measured)
+        m_recordTimes.add(ms);
+}
+
+void ShadowScenario::report(Report& report)
+{
+    report.addValue("boxes", double(m_instances.size()), "");
+    report.addValue("cascades", double(kCascadeCount), "");
+    report.addValue("shadow map size", double(m_shadowSize), "px");
+    report.addValue("shadow map memory", double(m_shadowSize) * double(m_shadowSize) * 4.0 * kCascadeCount / (1024.0 * 1024.0), "MiB");
+    report.addText("shadow passes", m_layered ? "layered" : "one per cascade");
+    report.addText("cpu cull kernel", m_cullKernel.name);
+    report.addValue("threads", double(m_jobs.threadCount()), "");
+    report.addStatistics("cpu cascade cull", m_cullTimes, "ms");
+    report.addStatistics("cpu shadow record", m_recordTimes, "ms");
+    report.addStatistics("shadow casters", m_casterTotals, "");
+}
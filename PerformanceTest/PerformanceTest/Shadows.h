@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CpuCulling.h"
+#include "JobSystem.h"
+#include "Math.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Same layout as Instance in shaders/shadows/shadows.glsl */
+struct ShadowInstance
+{
+    Vec4 center;
+    Vec4 extents;
+};
+
+/* Push constants of shaders/shadows, same layout as FrameConstants in shadows.glsl */
+struct ShadowConstants
+{
+    Mat4 viewProj;
+    Vec4 eye;
+    /* xyz direction the light travels in */
+    Vec4 lightDirection;
+    uint32_t cascade;
+    uint32_t padding[3];
+};
+
+/* std140 layout of the Cascades block */
+struct ShadowCascades
+{
+    Mat4 viewProj[4];
+    /* View depth where each cascade ends */
+    Vec4 splits;
+};
+
+/*
+ * Backend independent part of the cascaded shadow map scenario: a field of --instances n boxes
+ * under a sun, seen from a camera circling above them. Every frame update() splits the view
+ * frustum into kCascadeCount cascades, fits a texel snapped orthographic light projection
+ * around each and culls the boxes against each cascade's light frustum, one job per cascade.
+ * The backends render every cascade depth only into one layer of a --shadow-size texture
+ * array, one draw per culled box, and shade the boxes with it.
+ */
+class ShadowScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kCascadeCount = 4;
+
+    /* `layeredSupported` is false for backends without a layered path, --layered on falls back to one pass per cascade there */
+    ShadowScenario(const Options& options, uint32_t width, uint32_t height, bool layeredSupported);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    ShadowConstants sceneConstants() const;
+    ShadowConstants cascadeConstants(uint32_t cascade) const;
+    ShaderDefines shadowDefines() const;
+    uint32_t instanceCount() const { return uint32_t(m_instances.size()); }
+    /* Boxes culled into a cascade this frame, ascending */
+    const uint32_t* casters(uint32_t cascade) const { return m_casters[cascade].data(); }
+    uint32_t casterCount(uint32_t cascade) const { return m_casterCounts[cascade]; }
+    /* Adds the CPU time of recording or issuing the shadow passes */
+    void addRecordTime(double ms, const FrameInfo& frame);
+
+    /* Profiler zone of every cascade */
+    static const char* const kCascadeZones[kCascadeCount];
+
+    uint32_t m_shadowSize;
+    bool m_layered;
+    std::vector<ShadowInstance> m_instances;
+    ShadowCascades m_cascades = {};
+    JobSystem m_jobs;
+
+private:
+    void fitCascade(uint32_t cascade, float nearDepth, float farDepth);
+
+    CullingKernelInfo m_cullKernel;
+    CullingBounds m_bounds;
+    std::vector<uint32_t> m_casters[kCascadeCount];
+    uint32_t m_casterCounts[kCascadeCount] = {};
+    float m_aspect;
+    float m_extent;
+    Vec3 m_eye = { 0.0f, 0.0f, 0.0f };
+    Vec3 m_forward = { 0.0f, 0.0f, -1.0f };
+    Mat4 m_viewProj = Mat4::identity();
+    Statistics m_cullTimes;
+    Statistics m_recordTimes;
+    Statistics m_casterTotals;
+};
+
+std::unique_ptr<Scenario> createShadowScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createShadowScenarioVulkan(VulkanContext& context, const Options& options);
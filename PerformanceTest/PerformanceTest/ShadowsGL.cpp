@@ -0,0 +1,168 @@
+#include "Shadows.h"
+
+#include <algorithm>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    /*
+     * The cascades are layers of one GL_TEXTURE_2D_ARRAY. By default every cascade is a pass
+     * of its own through a framebuffer on its layer. --layered on attaches the whole array
+     * and renders all cascades in one pass: a box is drawn once per cascade it was culled
+     * into, as instances of one draw whose vertex shader writes gl_Layer, which needs
+     * ARB_shader_viewport_layer_array. A box culled into cascades 0 and 2 also lands in 1,
+     * the range is what one draw covers.
+     */
+    class ShadowScenarioGL : public ShadowScenario
+    {
+    public:
+        ShadowScenarioGL(GLContext& context, const Options& options)
+            : ShadowScenario(options, uint32_t(context.width()), uint32_t(context.height()), context.extensions().shaderViewportLayerArray)
+            , m_context(context)
+        {
+            m_shadowProgram = createProgram("shadows/shadow.vert", "shadows/shadow.frag", shadowDefines());
+            m_sceneProgram = createProgram("shadows/scene.vert", "shadows/scene.frag");
+            m_instanceBuffer = createBuffer(GLsizeiptr(m_instances.size() * sizeof(ShadowInstance)), m_instances.data(), 0);
+            m_cascadeBuffer = createBuffer(sizeof(ShadowCascades), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            glCreateVertexArrays(1, &m_vertexArray);
+
+            glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_shadowMap);
+            glTextureStorage3D(m_shadowMap, 1, GL_DEPTH_COMPONENT32F, GLsizei(m_shadowSize), GLsizei(m_shadowSize), kCascadeCount);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTextureParameteri(m_shadowMap, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+            uint32_t framebufferCount = m_layered ? 1 : kCascadeCount;
+            glCreateFramebuffers(GLsizei(framebufferCount), m_framebuffers);
+            for (uint32_t c = 0; c < framebufferCount; ++c)
+            {
+                if (m_layered)
+                    glNamedFramebufferTexture(m_framebuffers[c], GL_DEPTH_ATTACHMENT, m_shadowMap, 0);
+                else
+                    glNamedFramebufferTextureLayer(m_framebuffers[c], GL_DEPTH_ATTACHMENT, m_shadowMap, 0, GLint(c));
+                glNamedFramebufferDrawBuffer(m_framebuffers[c], GL_NONE);
+                glNamedFramebufferReadBuffer(m_framebuffers[c], GL_NONE);
+                if (glCheckNamedFramebufferStatus(m_framebuffers[c], GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                    fatal("Shadow framebuffer is incomplete");
+            }
+            if (m_layered)
+            {
+                m_firstCascade.resize(m_instances.size());
+                m_lastCascade.resize(m_instances.size());
+            }
+        }
+
+        ~ShadowScenarioGL() override
+        {
+            glDeleteProgram(m_shadowProgram);
+            glDeleteProgram(m_sceneProgram);
+            glDeleteBuffers(1, &m_instanceBuffer);
+            glDeleteBuffers(1, &m_cascadeBuffer);
+            glDeleteVertexArrays(1, &m_vertexArray);
+            glDeleteTextures(1, &m_shadowMap);
+            glDeleteFramebuffers(m_layered ? 1 : GLsizei(kCascadeCount), m_framebuffers);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            GLStateCache& state = m_context.state();
+            glNamedBufferSubData(m_cascadeBuffer, 0, sizeof(ShadowCascades), &m_cascades);
+            state.bindVertexArray(m_vertexArray);
+            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instanceBuffer);
+            state.bindBufferBase(GL_UNIFORM_BUFFER, 1, m_cascadeBuffer);
+            state.setBlend(false);
+            state.setDepthTest(true);
+            state.depthFunc(GL_LESS);
+            state.depthMask(true);
+            state.setCullFace(true);
+
+            Timer timer;
+            glViewport(0, 0, GLsizei(m_shadowSize), GLsizei(m_shadowSize));
+            state.useProgram(m_shadowProgram);
+            if (m_layered)
+                renderLayered();
+            else
+                for (uint32_t c = 0; c < kCascadeCount; ++c)
+                    renderCascade(c);
+            addRecordTime(timer.elapsedMs(), frame);
+
+            ShadowConstants constants = sceneConstants();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glClearColor(0.55f, 0.65f, 0.8f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            m_context.profiler().begin("scene");
+            state.useProgram(m_sceneProgram);
+            state.bindTextureUnit(2, m_shadowMap);
+            m_context.pushConstants(&constants, sizeof(constants));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, GLsizei(instanceCount()));
+            m_context.profiler().end();
+            state.setDepthTest(false);
+            state.setCullFace(false);
+        }
+
+    private:
+        void renderCascade(uint32_t cascade)
+        {
+            const float depth = 1.0f;
+            ShadowConstants constants = cascadeConstants(cascade);
+            m_context.profiler().begin(kCascadeZones[cascade]);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[cascade]);
+            glClearNamedFramebufferfv(m_framebuffers[cascade], GL_DEPTH, 0, &depth);
+            m_context.pushConstants(&constants, sizeof(constants));
+            const uint32_t* casters = this->casters(cascade);
+            for (uint32_t i = 0; i < casterCount(cascade); ++i)
+                glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 36, 1, casters[i]);
+            m_context.profiler().end();
+        }
+
+        /* Instance index box * 4 + cascade, one draw per box over the range of cascades it was culled into */
+        void renderLayered()
+        {
+            std::fill(m_firstCascade.begin(), m_firstCascade.end(), uint8_t(kCascadeCount));
+            std::fill(m_lastCascade.begin(), m_lastCascade.end(), uint8_t(0));
+            for (uint32_t c = 0; c < kCascadeCount; ++c)
+            {
+                const uint32_t* casters = this->casters(c);
+                for (uint32_t i = 0; i < casterCount(c); ++i)
+                {
+                    m_firstCascade[casters[i]] = std::min(m_firstCascade[casters[i]], uint8_t(c));
+                    m_lastCascade[casters[i]] = uint8_t(c);
+                }
+            }
+
+            const float depth = 1.0f;
+            ShadowConstants constants = cascadeConstants(0);
+            m_context.profiler().begin("cascades");
+            glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[0]);
+            glClearNamedFramebufferfv(m_framebuffers[0], GL_DEPTH, 0, &depth);
+            m_context.pushConstants(&constants, sizeof(constants));
+            for (uint32_t i = 0; i < instanceCount(); ++i)
+                if (m_firstCascade[i] < kCascadeCount)
+                    glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 36, m_lastCascade[i] - m_firstCascade[i] + 1, i * kCascadeCount + m_firstCascade[i]);
+            m_context.profiler().end();
+        }
+
+        GLContext& m_context;
+        GLuint m_shadowProgram = 0;
+        GLuint m_sceneProgram = 0;
+        GLuint m_instanceBuffer = 0;
+        GLuint m_cascadeBuffer = 0;
+        GLuint m_vertexArray = 0;
+        GLuint m_shadowMap = 0;
+        /* One per cascade, only the first with --layered on */
+        GLuint m_framebuffers[kCascadeCount] = {};
+        std::vector<uint8_t> m_firstCascade;
+        std::vector<uint8_t> m_lastCascade;
+    };
+}
+
+std::unique_ptr<Scenario> createShadowScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ShadowScenarioGL>(context, options);
+}
@@ -0,0 +1,305 @@
+#include "Shadows.h"
+
+#include <cstring>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    /*
+     * Every cascade is a render pass on its layer of one depth image array, its draws live in
+     * a secondary command buffer. The job system records the kCascadeCount secondaries in
+     * parallel, each from a command pool of its own per frame in flight so no two threads
+     * share a pool, and the primary command buffer only executes them. --threads 1 records
+     * them one after the other for comparison. The shadow pipeline has no fragment shader.
+     */
+    class ShadowScenarioVulkan : public ShadowScenario
+    {
+    public:
+        ShadowScenarioVulkan(VulkanContext& context, const Options& options)
+            : ShadowScenario(options, context.swapchainExtent().width, context.swapchainExtent().height, false)
+            , m_context(context)
+        {
+            VkDevice device = m_context.device();
+            m_instanceBuffer = m_context.createBuffer(m_instances.size() * sizeof(ShadowInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_instances.data());
+            for (VulkanBuffer& buffer : m_cascadeBuffers)
+                buffer = m_context.createBuffer(sizeof(ShadowCascades), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+                                                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+            createShadowTargets();
+            createDescriptors();
+            createPipelines();
+
+            VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = m_context.queueFamily();
+            for (uint32_t f = 0; f < VulkanContext::kFramesInFlight; ++f)
+                for (uint32_t c = 0; c < kCascadeCount; ++c)
+                {
+                    VK_CHECK(vkCreateCommandPool(device, &poolInfo, vulkanHostAllocator(), &m_commandPools[f][c]));
+                    VkCommandBufferAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+                    allocateInfo.commandPool = m_commandPools[f][c];
+                    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                    allocateInfo.commandBufferCount = 1;
+                    VK_CHECK(vkAllocateCommandBuffers(device, &allocateInfo, &m_secondaries[f][c]));
+                }
+        }
+
+        ~ShadowScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+            for (uint32_t f = 0; f < VulkanContext::kFramesInFlight; ++f)
+                for (uint32_t c = 0; c < kCascadeCount; ++c)
+                    vkDestroyCommandPool(device, m_commandPools[f][c], vulkanHostAllocator());
+            vkDestroyPipeline(device, m_shadowPipeline, vulkanHostAllocator());
+            vkDestroyPipeline(device, m_scenePipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+            for (uint32_t c = 0; c < kCascadeCount; ++c)
+            {
+                vkDestroyFramebuffer(device, m_framebuffers[c], vulkanHostAllocator());
+                vkDestroyImageView(device, m_layerViews[c], vulkanHostAllocator());
+            }
+            vkDestroyRenderPass(device, m_shadowPass, vulkanHostAllocator());
+            m_context.destroyImage(m_shadowMap);
+            for (VulkanBuffer& buffer : m_cascadeBuffers)
+                m_context.destroyBuffer(buffer);
+            m_context.destroyBuffer(m_instanceBuffer);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            uint32_t frameIndex = m_context.frameIndex();
+            std::memcpy(m_cascadeBuffers[frameIndex].mapped, &m_cascades, sizeof(ShadowCascades));
+            VK_CHECK(vmaFlushAllocation(m_context.allocator(), m_cascadeBuffers[frameIndex].allocation, 0, VK_WHOLE_SIZE));
+
+            Timer timer;
+            m_jobs.parallelFor(kCascadeCount, 1, [this, frameIndex](uint32_t begin, uint32_t end, uint32_t)
+            {
+                for (uint32_t c = begin; c < end; ++c)
+                    recordCascade(frameIndex, c);
+            });
+            addRecordTime(timer.elapsedMs(), frame);
+
+            const VkClearValue clear = { { { 1.0f, 0 } } };
+            for (uint32_t c = 0; c < kCascadeCount; ++c)
+            {
+                VkRenderPassBeginInfo beginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+                beginInfo.renderPass = m_shadowPass;
+                beginInfo.framebuffer = m_framebuffers[c];
+                beginInfo.renderArea.extent = { m_shadowSize, m_shadowSize };
+                beginInfo.clearValueCount = 1;
+                beginInfo.pClearValues = &clear;
+                m_context.profiler().begin(cmd, kCascadeZones[c]);
+                vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(cmd, 1, &m_secondaries[frameIndex][c]);
+                vkCmdEndRenderPass(cmd);
+                m_context.profiler().end(cmd);
+            }
+
+            const float clearColor[4] = { 0.55f, 0.65f, 0.8f, 1.0f };
+            ShadowConstants constants = sceneConstants();
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "scene");
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_scenePipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_sets[frameIndex], 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            vkCmdDraw(cmd, 36, instanceCount(), 0, 0);
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+    private:
+        /* Runs on a job thread, only touches the cascade's own pool */
+        void recordCascade(uint32_t frameIndex, uint32_t cascade)
+        {
+            VK_CHECK(vkResetCommandPool(m_context.device(), m_commandPools[frameIndex][cascade], 0));
+            VkCommandBuffer cmd = m_secondaries[frameIndex][cascade];
+
+            VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+            inheritance.renderPass = m_shadowPass;
+            inheritance.subpass = 0;
+            inheritance.framebuffer = m_framebuffers[cascade];
+            VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritance;
+            VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+            ShadowConstants constants = cascadeConstants(cascade);
+            m_context.setViewport(cmd, { m_shadowSize, m_shadowSize });
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowPipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_sets[frameIndex], 0, nullptr);
+            vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+            const uint32_t* casters = this->casters(cascade);
+            for (uint32_t i = 0; i < casterCount(cascade); ++i)
+                vkCmdDraw(cmd, 36, 1, 0, casters[i]);
+            VK_CHECK(vkEndCommandBuffer(cmd));
+        }
+
+        /* The depth array, a view and a framebuffer per layer and the render pass that clears a layer and leaves it for sampling */
+        void createShadowTargets()
+        {
+            VkDevice device = m_context.device();
+            VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = VK_FORMAT_D32_SFLOAT;
+            imageInfo.extent = { m_shadowSize, m_shadowSize, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = kCascadeCount;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            m_shadowMap = m_context.createImage(imageInfo, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+            VkAttachmentDescription attachment = {};
+            attachment.format = VK_FORMAT_D32_SFLOAT;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            VkAttachmentReference depthReference = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+            VkSubpassDescription subpass = {};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.pDepthStencilAttachment = &depthReference;
+
+            const VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            /* After the last frame's scene pass sampled the layer, before this frame's scene pass samples it */
+            VkSubpassDependency dependencies[2] = {};
+            dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[0].dstSubpass = 0;
+            dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[0].dstStageMask = depthStages;
+            dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependencies[1].srcSubpass = 0;
+            dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[1].srcStageMask = depthStages;
+            dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            VkRenderPassCreateInfo renderPassInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+            renderPassInfo.attachmentCount = 1;
+            renderPassInfo.pAttachments = &attachment;
+            renderPassInfo.subpassCount = 1;
+            renderPassInfo.pSubpasses = &subpass;
+            renderPassInfo.dependencyCount = 2;
+            renderPassInfo.pDependencies = dependencies;
+            VK_CHECK(vkCreateRenderPass(device, &renderPassInfo, vulkanHostAllocator(), &m_shadowPass));
+
+            for (uint32_t c = 0; c < kCascadeCount; ++c)
+            {
+                m_layerViews[c] = m_context.createImageView(m_shadowMap.image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, c, 1);
+                VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+                framebufferInfo.renderPass = m_shadowPass;
+                framebufferInfo.attachmentCount = 1;
+                framebufferInfo.pAttachments = &m_layerViews[c];
+                framebufferInfo.width = m_shadowSize;
+                framebufferInfo.height = m_shadowSize;
+                framebufferInfo.layers = 1;
+                VK_CHECK(vkCreateFramebuffer(device, &framebufferInfo, vulkanHostAllocator(), &m_framebuffers[c]));
+            }
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_LINEAR;
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            samplerInfo.compareEnable = VK_TRUE;
+            samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+            VK_CHECK(vkCreateSampler(device, &samplerInfo, vulkanHostAllocator(), &m_sampler));
+        }
+
+        /* One set per frame in flight, they differ in the cascade buffer */
+        void createDescriptors()
+        {
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+                { 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+                { 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(ShadowConstants));
+            const uint32_t frames = VulkanContext::kFramesInFlight;
+            m_descriptorPool = m_context.createDescriptorPool(frames, {
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frames },
+                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frames },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames },
+            });
+
+            for (uint32_t f = 0; f < frames; ++f)
+            {
+                m_sets[f] = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                VkDescriptorBufferInfo instances = { m_instanceBuffer.buffer, 0, VK_WHOLE_SIZE };
+                VkDescriptorBufferInfo cascades = { m_cascadeBuffers[f].buffer, 0, VK_WHOLE_SIZE };
+                VkDescriptorImageInfo shadowMap = { m_sampler, m_shadowMap.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+                VkWriteDescriptorSet writes[3];
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    writes[i] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                    writes[i].dstSet = m_sets[f];
+                    writes[i].dstBinding = i;
+                    writes[i].descriptorCount = 1;
+                }
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[0].pBufferInfo = &instances;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                writes[1].pBufferInfo = &cascades;
+                writes[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[2].pImageInfo = &shadowMap;
+                vkUpdateDescriptorSets(m_context.device(), 3, writes, 0, nullptr);
+            }
+        }
+
+        void createPipelines()
+        {
+            VkDevice device = m_context.device();
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_shadowPass;
+            desc.vertexShader = m_context.createShaderModule("shadows/shadow.vert", VK_SHADER_STAGE_VERTEX_BIT, shadowDefines());
+            desc.colorAttachmentCount = 0;
+            m_shadowPipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("shadows/scene.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("shadows/scene.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+            desc.colorAttachmentCount = 1;
+            m_scenePipeline = m_context.createGraphicsPipeline(desc);
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+        }
+
+        VulkanContext& m_context;
+        VulkanBuffer m_instanceBuffer;
+        VulkanBuffer m_cascadeBuffers[VulkanContext::kFramesInFlight];
+        VulkanImage m_shadowMap;
+        VkImageView m_layerViews[kCascadeCount] = {};
+        VkFramebuffer m_framebuffers[kCascadeCount] = {};
+        VkRenderPass m_shadowPass = VK_NULL_HANDLE;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_sets[VulkanContext::kFramesInFlight] = {};
+        VkPipeline m_shadowPipeline = VK_NULL_HANDLE;
+        VkPipeline m_scenePipeline = VK_NULL_HANDLE;
+        VkCommandPool m_commandPools[VulkanContext::kFramesInFlight][kCascadeCount] = {};
+        VkCommandBuffer m_secondaries[VulkanContext::kFramesInFlight][kCascadeCount] = {};
+    };
+}
+
+std::unique_ptr<Scenario> createShadowScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ShadowScenarioVulkan>(context, options);
+}
@@ -0,0 +1,66 @@
+#include "Specialization.h"
+
+#include <cstdio>
+#include <string>
+
+#include "Random.h"
+
+namespace
+{
+    bool parseShader(const std::string& shader)
+    {
+        if (shader == "specialized")
+            return true;
+        if (shader == "branching")
+            return false;
+        fatal("Unknown --shader '%s', expected specialized or branching", shader.c_str());
+    }
+}
+
+SpecializationScenario::SpecializationScenario(const Options& options)
+    : m_specialized(parseShader(options.getString("shader", "specialized")))
+{
+    /* The configs draw over each other, dim lights keep the sum of 128 of them readable */
+    uint32_t state = 0x5EC1A1u;
+    m_lights.resize(kSpecializationMaxLights);
+    for (SpecializationLight& light : m_lights)
+    {
+        light.positionRadius = { randomUnit(state), randomUnit(state), 0.05f + 0.1f * randomUnit(state), 0.2f + 0.3f * randomUnit(state) };
+        light.color = { 0.1f * randomUnit(state), 0.1f * randomUnit(state), 0.1f * randomUnit(state), 1.0f };
+    }
+
+    std::printf("specialization: %u configs, %s shader\n", kSpecializationConfigCount, m_specialized ? "specialized" : "branching");
+}
+
+ShaderDefines SpecializationScenario::fragmentDefines() const
+{
+    if (m_specialized)
+        return { { "SPECIALIZED", "1" } };
+    return {};
+}
+
+SpecializationDrawConstants SpecializationScenario::drawConstants(uint32_t config)
+{
+    SpecializationDrawConstants constants = {};
+    constants.rect = { -1.0f, -1.0f, 2.0f, 2.0f };
+    constants.constants = kSpecializationConfigs[config].constants;
+    return constants;
+}
+
+void SpecializationScenario::recordPipelines(double createMs, uint64_t bytes)
+{
+    m_createMs = createMs;
+    m_pipelineBytes = bytes;
+}
+
+void SpecializationScenario::report(Report& report)
+{
+    report.addText("shader", m_specialized ? "specialized" : "branching");
+    report.addValue("configs", double(kSpecializationConfigCount), "");
+    report.addValue("pipelines", double(pipelineCount()), "");
+    report.addValue("pipeline creation", m_createMs, "ms");
+    if (m_pipelineBytes)
+        report.addValue("pipeline code", double(m_pipelineBytes) / 1024.0, "KiB");
+    else
+        report.addText("pipeline code", "unavailable");
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Math.h"
+#include "Scenario.h"
+#include "ShaderSource.h"
+
+/* Specialization constants of shaders/specialization, constant_id is the member index */
+struct SpecializationConstants
+{
+    uint32_t lightCount;
+    uint32_t sampleCount;
+    /* Lights per iteration of the light loop */
+    uint32_t unroll;
+};
+
+static_assert(sizeof(SpecializationConstants) == 3 * sizeof(uint32_t), "constant i has to be the i-th word");
+
+/* One point of the sweep, `name` doubles as the GPU profiler zone */
+struct SpecializationConfig
+{
+    const char* name;
+    SpecializationConstants constants;
+};
+
+constexpr uint32_t kSpecializationMaxLights = 128;
+constexpr uint32_t kSpecializationMaxSamples = 16;
+
+constexpr SpecializationConfig kSpecializationConfigs[] = {
+    { "lights 8", { 8, 1, 1 } },
+    { "lights 32", { 32, 1, 1 } },
+    { "lights 128", { 128, 1, 1 } },
+    { "lights 32 unroll 4", { 32, 1, 4 } },
+    { "lights 128 unroll 4", { 128, 1, 4 } },
+    { "lights 128 unroll 8", { 128, 1, 8 } },
+    { "lights 32 samples 4", { 32, 4, 1 } },
+    { "lights 32 samples 4 unroll 4", { 32, 4, 4 } },
+};
+
+constexpr uint32_t kSpecializationConfigCount = uint32_t(sizeof(kSpecializationConfigs) / sizeof(kSpecializationConfigs[0]));
+
+constexpr bool specializationConfigsValid()
+{
+    for (const SpecializationConfig& config : kSpecializationConfigs)
+    {
+        const SpecializationConstants& constants = config.constants;
+        if (constants.lightCount == 0 || constants.lightCount > kSpecializationMaxLights)
+            return false;
+        if (constants.sampleCount == 0 || constants.sampleCount > kSpecializationMaxSamples)
+            return false;
+        if (constants.unroll == 0 || constants.unroll > constants.lightCount)
+            return false;
+    }
+    return true;
+}
+
+static_assert(specializationConfigsValid(), "kSpecializationConfigs is out of the range the shader supports");
+
+/* Push constants of shaders/specialization, same layout as DrawConstants in specialization.glsl */
+struct SpecializationDrawConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    SpecializationConstants constants;
+    uint32_t padding;
+};
+
+/* Same layout as Light in lighting.frag */
+struct SpecializationLight
+{
+    /* xyz position in uv space above the plane, w radius */
+    Vec4 positionRadius;
+    Vec4 color;
+};
+
+/*
+ * Backend independent part of the specialization scenario: every frame shades one full screen
+ * quad per entry of kSpecializationConfigs, each in its own GPU profiler zone. --shader
+ * specialized (default) builds one pipeline per config with the config's values as
+ * specialization constants, --shader branching one pipeline for all that reads the same
+ * values from push constants and loops over them at runtime. Comparing the two runs shows
+ * what the runtime branching costs, the report shows what the extra pipelines cost to create
+ * and keep.
+ */
+class SpecializationScenario : public Scenario
+{
+public:
+    SpecializationScenario(const Options& options);
+
+    void report(Report& report) override;
+
+protected:
+    /* Defines of lighting.frag */
+    ShaderDefines fragmentDefines() const;
+    uint32_t pipelineCount() const { return m_specialized ? kSpecializationConfigCount : 1; }
+    uint32_t pipelineIndex(uint32_t config) const { return m_specialized ? config : 0; }
+    static SpecializationDrawConstants drawConstants(uint32_t config);
+    /* `bytes` is the size of the compiled code the backend could measure, 0 if none */
+    void recordPipelines(double createMs, uint64_t bytes);
+
+    bool m_specialized;
+    std::vector<SpecializationLight> m_lights;
+
+private:
+    double m_createMs = 0.0;
+    uint64_t m_pipelineBytes = 0;
+};
+
+std::unique_ptr<Scenario> createSpecializationScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createSpecializationScenarioVulkan(VulkanContext& context, const Options& options);
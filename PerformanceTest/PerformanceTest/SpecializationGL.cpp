@@ -0,0 +1,91 @@
+#include "Specialization.h"
+
+#include <algorithm>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    /*
+     * Both variants go through SPIR-V, so the only difference is what glSpecializeShader gets:
+     * the config's constants for --shader specialized, none for the branching program. The
+     * program binary length stands in for the memory a program takes in the driver.
+     */
+    class SpecializationScenarioGL : public SpecializationScenario
+    {
+    public:
+        SpecializationScenarioGL(GLContext& context, const Options& options)
+            : SpecializationScenario(options)
+            , m_context(context)
+        {
+            Timer timer;
+            uint64_t bytes = 0;
+            bool available = true;
+            m_programs.resize(pipelineCount());
+            for (uint32_t i = 0; i < pipelineCount(); ++i)
+            {
+                const SpecializationConstants& constants = kSpecializationConfigs[i].constants;
+                const uint32_t values[] = { constants.lightCount, constants.sampleCount, constants.unroll };
+                GLuint shaders[] = {
+                    createSpecializedShader(GL_VERTEX_SHADER, "specialization/quad.vert", {}, nullptr, 0),
+                    createSpecializedShader(GL_FRAGMENT_SHADER, "specialization/lighting.frag", fragmentDefines(), values,
+                                            m_specialized ? 3 : 0),
+                };
+                m_programs[i] = linkProgram(shaders, 2, true);
+
+                GLint length = 0;
+                glGetProgramiv(m_programs[i], GL_PROGRAM_BINARY_LENGTH, &length);
+                /* A driver without binaries for a program has nothing to compare */
+                if (length <= 0)
+                    available = false;
+                bytes += uint64_t(std::max(length, 0));
+            }
+            recordPipelines(timer.elapsedMs(), available ? bytes : 0);
+
+            m_lightBuffer = createBuffer(GLsizeiptr(m_lights.size() * sizeof(SpecializationLight)), m_lights.data(), 0);
+            glCreateVertexArrays(1, &m_vertexArray);
+        }
+
+        ~SpecializationScenarioGL() override
+        {
+            for (GLuint program : m_programs)
+                glDeleteProgram(program);
+            glDeleteBuffers(1, &m_lightBuffer);
+            glDeleteVertexArrays(1, &m_vertexArray);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+
+            GLStateCache& state = m_context.state();
+            state.bindVertexArray(m_vertexArray);
+            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_lightBuffer);
+            state.setDepthTest(false);
+            state.setCullFace(false);
+            state.setBlend(false);
+            for (uint32_t config = 0; config < kSpecializationConfigCount; ++config)
+            {
+                SpecializationDrawConstants constants = drawConstants(config);
+                m_context.profiler().begin(kSpecializationConfigs[config].name);
+                state.useProgram(m_programs[pipelineIndex(config)]);
+                m_context.pushConstants(&constants, sizeof(constants));
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                m_context.profiler().end();
+            }
+        }
+
+    private:
+        GLContext& m_context;
+        std::vector<GLuint> m_programs;
+        GLuint m_lightBuffer = 0;
+        GLuint m_vertexArray = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createSpecializationScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<SpecializationScenarioGL>(context, options);
+}
@@ -0,0 +1,149 @@
+#include "Specialization.h"
+
+#include <cstddef>
+
+#include "AllocationTracker.h"
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    const VkSpecializationMapEntry kConstantEntries[] = {
+        { 0, offsetof(SpecializationConstants, lightCount), sizeof(uint32_t) },
+        { 1, offsetof(SpecializationConstants, sampleCount), sizeof(uint32_t) },
+        { 2, offsetof(SpecializationConstants, unroll), sizeof(uint32_t) },
+    };
+
+    /*
+     * --shader specialized creates one pipeline per config from the same shader module with
+     * the config as VkSpecializationInfo. The pipelines go through a pipeline cache of their
+     * own, its data size is the closest Vulkan gets to the size of the compiled code. With
+     * TRACK_ALLOCATIONS the host memory the driver allocated for them is reported as well.
+     */
+    class SpecializationScenarioVulkan : public SpecializationScenario
+    {
+    public:
+        SpecializationScenarioVulkan(VulkanContext& context, const Options& options)
+            : SpecializationScenario(options)
+            , m_context(context)
+        {
+            VkDevice device = m_context.device();
+            m_lightBuffer = m_context.createBuffer(m_lights.size() * sizeof(SpecializationLight), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_lights.data());
+            m_setLayout = m_context.createDescriptorSetLayout({
+                { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+            });
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(SpecializationDrawConstants));
+            m_descriptorPool = m_context.createDescriptorPool(1, { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 } });
+            m_set = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+
+            VkDescriptorBufferInfo lights = { m_lightBuffer.buffer, 0, VK_WHOLE_SIZE };
+            VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+            write.dstSet = m_set;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = &lights;
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+            createPipelines();
+        }
+
+        ~SpecializationScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            for (VkPipeline pipeline : m_pipelines)
+                vkDestroyPipeline(device, pipeline, vulkanHostAllocator());
+            vkDestroyPipelineCache(device, m_pipelineCache, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            m_context.destroyBuffer(m_lightBuffer);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_set, 0, nullptr);
+            for (uint32_t config = 0; config < kSpecializationConfigCount; ++config)
+            {
+                SpecializationDrawConstants constants = drawConstants(config);
+                m_context.profiler().begin(cmd, kSpecializationConfigs[config].name);
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[pipelineIndex(config)]);
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(constants), &constants);
+                vkCmdDraw(cmd, 6, 1, 0, 0);
+                m_context.profiler().end(cmd);
+            }
+            vkCmdEndRenderPass(cmd);
+        }
+
+        void report(Report& report) override
+        {
+            SpecializationScenario::report(report);
+            if (allocationTrackingEnabled())
+                report.addValue("pipeline host allocations", double(m_hostBytes) / 1024.0, "KiB");
+        }
+
+    private:
+        void createPipelines()
+        {
+            VkDevice device = m_context.device();
+            VkPipelineCacheCreateInfo cacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+            VK_CHECK(vkCreatePipelineCache(device, &cacheInfo, vulkanHostAllocator(), &m_pipelineCache));
+            size_t emptySize = 0;
+            VK_CHECK(vkGetPipelineCacheData(device, m_pipelineCache, &emptySize, nullptr));
+
+            GraphicsPipelineDesc desc;
+            desc.layout = m_pipelineLayout;
+            desc.renderPass = m_context.swapchainRenderPass();
+            desc.vertexShader = m_context.createShaderModule("specialization/quad.vert", VK_SHADER_STAGE_VERTEX_BIT);
+            desc.fragmentShader = m_context.createShaderModule("specialization/lighting.frag", VK_SHADER_STAGE_FRAGMENT_BIT, fragmentDefines());
+            desc.cullMode = VK_CULL_MODE_NONE;
+            desc.depthTest = false;
+            desc.depthWrite = false;
+
+            AllocationCounters hostStart = vulkanAllocationCounters();
+            Timer timer;
+            m_pipelines.resize(pipelineCount());
+            for (uint32_t i = 0; i < pipelineCount(); ++i)
+            {
+                VkSpecializationInfo specialization = {};
+                specialization.mapEntryCount = uint32_t(sizeof(kConstantEntries) / sizeof(kConstantEntries[0]));
+                specialization.pMapEntries = kConstantEntries;
+                specialization.dataSize = sizeof(SpecializationConstants);
+                specialization.pData = &kSpecializationConfigs[i].constants;
+                desc.fragmentSpecialization = m_specialized ? &specialization : nullptr;
+
+                GraphicsPipelineCreateInfo state(desc);
+                VK_CHECK(vkCreateGraphicsPipelines(device, m_pipelineCache, 1, &state.info, vulkanHostAllocator(), &m_pipelines[i]));
+            }
+            double createMs = timer.elapsedMs();
+            m_hostBytes = vulkanAllocationCounters().bytes - hostStart.bytes;
+
+            size_t cacheSize = 0;
+            VK_CHECK(vkGetPipelineCacheData(device, m_pipelineCache, &cacheSize, nullptr));
+            recordPipelines(createMs, cacheSize - emptySize);
+
+            vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+            vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+        }
+
+        VulkanContext& m_context;
+        VulkanBuffer m_lightBuffer;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_set = VK_NULL_HANDLE;
+        VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+        std::vector<VkPipeline> m_pipelines;
+        uint64_t m_hostBytes = 0;
+    };
+}
+
+std::unique_ptr<Scenario> createSpecializationScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<SpecializationScenarioVulkan>(context, options);
+}
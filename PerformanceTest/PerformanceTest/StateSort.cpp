@@ -0,0 +1,136 @@
+#include "StateSort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "FrameArena.h"
+#include "Random.h"
+#include "Timer.h"
+
+namespace
+{
+    bool parseOrder(const std::string& order)
+    {
+        if (order == "sorted")
+            return true;
+        if (order == "submission")
+            return false;
+        fatal("Unknown --order '%s', expected sorted or submission", order.c_str());
+    }
+
+    SortAlgorithm parseSort(const std::string& sort)
+    {
+        if (sort == "radix")
+            return SortAlgorithm::Radix;
+        if (sort == "std")
+            return SortAlgorithm::Comparison;
+        fatal("Unknown --sort '%s', expected radix or std", sort.c_str());
+    }
+}
+
+StateSortScenario::StateSortScenario(const Options& options)
+    : m_sorted(parseOrder(options.getString("order", "sorted")))
+    , m_sortAlgorithm(parseSort(options.getString("sort", "radix")))
+{
+    uint32_t count = uint32_t(options.getInt("draws", 10000));
+    m_programCount = uint32_t(options.getInt("programs", 8));
+    m_textureCount = uint32_t(options.getInt("textures", 64));
+    m_meshCount = uint32_t(options.getInt("meshes", 2));
+    if (count == 0 || m_programCount == 0 || m_programCount > 256 || m_textureCount == 0 || m_textureCount > (1u << SortKey::kMaterialBits)
+        || m_meshCount == 0 || m_meshCount > (1u << SortKey::kMeshBits))
+        fatal("--draws has to be at least 1, --programs 1 to 256, --textures 1 to 65536 and --meshes 1 to 256");
+    if (m_sortAlgorithm == SortAlgorithm::Radix && options.getBool("parallel-sort", true))
+        m_jobs = std::make_unique<JobSystem>(uint32_t(options.getInt("threads", 0)));
+
+    uint32_t side = std::max(1u, uint32_t(std::ceil(std::sqrt(double(count)))));
+    float cell = 2.0f / float(side);
+    uint32_t state = 0x2545F491u;
+    m_draws.resize(count);
+    m_generationOrder.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        StateSortDraw& draw = m_draws[i];
+        draw.constants.rect = { -1.0f + float(i % side) * cell, -1.0f + float(i / side) * cell, cell * 0.9f, cell * 0.9f };
+        draw.program = random(state) % m_programCount;
+        draw.texture = random(state) % m_textureCount;
+        draw.mesh = random(state) % m_meshCount;
+        draw.depth = float(random(state) & 0xFFFF) / float(0x10000);
+        /* A quarter of the draws is transparent */
+        draw.blend = (random(state) & 3) == 0;
+        draw.constants.color = { 1.0f, 1.0f, 1.0f, draw.blend ? 0.5f : 1.0f };
+        m_generationOrder[i] = i;
+    }
+    m_order = m_generationOrder.data();
+
+    std::printf("state-sort: %u draws over %u programs, %u textures and %u meshes, %s order", count, m_programCount, m_textureCount,
+                m_meshCount, m_sorted ? "sorted" : "submission");
+    if (m_sorted)
+        std::printf(" with %s on %u threads", sortAlgorithmName(m_sortAlgorithm), m_jobs ? m_jobs->threadCount() : 1);
+    std::printf("\n");
+}
+
+void StateSortScenario::update(const FrameInfo& frame)
+{
+    if (!m_sorted)
+        return;
+
+    /* The draw list of a real frame is rebuilt every frame, so is the sort */
+    Timer timer;
+    uint32_t count = uint32_t(m_draws.size());
+    m_queue.begin(*frame.arena, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const StateSortDraw& draw = m_draws[i];
+        m_queue.push(SortKey::make(draw.blend, draw.program, draw.texture, draw.mesh, draw.depth), i);
+    }
+    m_queue.sort(m_sortAlgorithm, m_jobs.get());
+    m_order = m_queue.draws();
+
+    if (frame.measured)
+    {
+        m_sortTimes.add(timer.elapsedMs());
+        m_sortPasses.add(double(m_queue.passCount()));
+    }
+}
+
+std::vector<uint32_t> StateSortScenario::createTexels() const
+{
+    std::vector<uint32_t> texels(size_t(m_textureCount) * kTextureSize * kTextureSize);
+    uint32_t state = 0x9E3779B9u;
+    for (uint32_t texture = 0; texture < m_textureCount; ++texture)
+    {
+        uint32_t color = random(state) | 0xFF000000u;
+        uint32_t* begin = texels.data() + size_t(texture) * kTextureSize * kTextureSize;
+        std::fill(begin, begin + kTextureSize * kTextureSize, color);
+    }
+    return texels;
+}
+
+void StateSortScenario::recordDrawLoop(double milliseconds, uint64_t issued, uint64_t skipped, bool measured)
+{
+    if (!measured)
+        return;
+    m_drawLoopTimes.add(milliseconds);
+    m_drawTimes.add(milliseconds * 1e6 / double(m_draws.size()));
+    m_issuedCalls.add(double(issued));
+    m_skippedCalls.add(double(skipped));
+}
+
+void StateSortScenario::report(Report& report)
+{
+    report.addText("draw order", m_sorted ? "sorted" : "submission");
+    report.addValue("draws", double(m_draws.size()), "");
+    if (m_sorted)
+    {
+        report.addText("sort", sortAlgorithmName(m_sortAlgorithm));
+        report.addValue("sort threads", double(m_jobs ? m_jobs->threadCount() : 1), "");
+        report.addStatistics("cpu sort", m_sortTimes, "ms");
+        if (m_sortAlgorithm == SortAlgorithm::Radix)
+            report.addStatistics("radix passes", m_sortPasses, "");
+    }
+    report.addStatistics("cpu draw loop", m_drawLoopTimes, "ms");
+    report.addStatistics("cpu time per draw", m_drawTimes, "ns");
+    report.addStatistics("state calls issued", m_issuedCalls, "");
+    report.addStatistics("state calls skipped", m_skippedCalls, "");
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Math.h"
+#include "RenderQueue.h"
+#include "Scenario.h"
+
+/* Push constants of shaders/statesort, same layout as DrawConstants in statesort.glsl */
+struct StateSortConstants
+{
+    /* xy lower left corner, zw size, in normalized device coordinates */
+    Vec4 rect;
+    Vec4 color;
+};
+
+struct StateSortDraw
+{
+    StateSortConstants constants;
+    uint32_t program;
+    uint32_t texture;
+    uint32_t mesh;
+    /* View depth in [0, 1], front to back for opaque and back to front for blended draws */
+    float depth;
+    bool blend;
+};
+
+/*
+ * Backend independent part of the state sorting scenario: --draws quads with a random
+ * program, texture, mesh and blend state each. Submitted in generation order almost every
+ * draw changes all of it. Sorted, the draws go through a RenderQueue every frame and only the
+ * first draw of every state group changes anything. The backends count the API calls they
+ * issue and skip, the OpenGL one through GLStateCache.
+ */
+class StateSortScenario : public Scenario
+{
+public:
+    StateSortScenario(const Options& options);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    static constexpr uint32_t kTextureSize = 16;
+
+    /* Meshes alternate between a quad and a triangle of the quad */
+    static uint32_t meshVertexCount(uint32_t mesh) { return mesh % 2 == 0 ? 6 : 3; }
+
+    /* 16x16 RGBA8 texels of every texture, one texture after the other */
+    std::vector<uint32_t> createTexels() const;
+    void recordDrawLoop(double milliseconds, uint64_t issued, uint64_t skipped, bool measured);
+
+    std::vector<StateSortDraw> m_draws;
+    /* Indices into m_draws in submission order, sorted ones live in the frame arena */
+    const uint32_t* m_order = nullptr;
+    uint32_t m_programCount;
+    uint32_t m_textureCount;
+    uint32_t m_meshCount;
+
+private:
+    bool m_sorted;
+    SortAlgorithm m_sortAlgorithm;
+    /* Only for the parallel radix sort */
+    std::unique_ptr<JobSystem> m_jobs;
+    RenderQueue m_queue;
+    std::vector<uint32_t> m_generationOrder;
+
+    Statistics m_sortTimes;
+    Statistics m_sortPasses;
+    Statistics m_drawLoopTimes;
+    Statistics m_drawTimes;
+    Statistics m_issuedCalls;
+    Statistics m_skippedCalls;
+};
+
+std::unique_ptr<Scenario> createStateSortScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createStateSortScenarioVulkan(VulkanContext& context, const Options& options);
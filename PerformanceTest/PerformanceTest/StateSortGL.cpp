@@ -0,0 +1,102 @@
+#include "StateSort.h"
+
+#include <string>
+
+#include "GLContext.h"
+#include "Timer.h"
+
+namespace
+{
+    class StateSortScenarioGL : public StateSortScenario
+    {
+    public:
+        StateSortScenarioGL(GLContext& context, const Options& options)
+            : StateSortScenario(options)
+            , m_context(context)
+            , m_cacheEnabled(options.getBool("state-cache", true))
+        {
+            m_programs.resize(m_programCount);
+            for (uint32_t i = 0; i < m_programCount; ++i)
+                m_programs[i] = createProgram("statesort/quad.vert", "statesort/quad.frag", { { "VARIANT", std::to_string(i) } });
+
+            std::vector<uint32_t> texels = createTexels();
+            m_textures.resize(m_textureCount);
+            glCreateTextures(GL_TEXTURE_2D, GLsizei(m_textureCount), m_textures.data());
+            for (uint32_t i = 0; i < m_textureCount; ++i)
+            {
+                glTextureStorage2D(m_textures[i], 1, GL_RGBA8, kTextureSize, kTextureSize);
+                glTextureSubImage2D(m_textures[i], 0, 0, 0, kTextureSize, kTextureSize, GL_RGBA, GL_UNSIGNED_BYTE,
+                                    texels.data() + size_t(i) * kTextureSize * kTextureSize);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTextureParameteri(m_textures[i], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            }
+
+            /* The quads come from gl_VertexID, a vertex array per mesh still costs a bind like a real one */
+            m_vertexArrays.resize(m_meshCount);
+            glCreateVertexArrays(GLsizei(m_meshCount), m_vertexArrays.data());
+        }
+
+        ~StateSortScenarioGL() override
+        {
+            for (GLuint program : m_programs)
+                glDeleteProgram(program);
+            glDeleteTextures(GLsizei(m_textures.size()), m_textures.data());
+            glDeleteVertexArrays(GLsizei(m_vertexArrays.size()), m_vertexArrays.data());
+            m_context.state().setEnabled(true);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            GLStateCache& state = m_context.state();
+            state.setEnabled(m_cacheEnabled);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, m_context.width(), m_context.height());
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            m_context.profiler().begin("draw");
+            state.resetCounters();
+            Timer timer;
+            /* Sets the whole state of every draw, the way a naive renderer does and the cache expects */
+            for (uint32_t i = 0; i < uint32_t(m_draws.size()); ++i)
+            {
+                const StateSortDraw& draw = m_draws[m_order[i]];
+                state.useProgram(m_programs[draw.program]);
+                state.bindVertexArray(m_vertexArrays[draw.mesh]);
+                state.bindTextureUnit(0, m_textures[draw.texture]);
+                state.setDepthTest(false);
+                state.setCullFace(false);
+                state.setBlend(draw.blend);
+                if (draw.blend)
+                    state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                m_context.pushConstants(&draw.constants, sizeof(draw.constants));
+                glDrawArrays(GL_TRIANGLES, 0, GLsizei(meshVertexCount(draw.mesh)));
+            }
+            double time = timer.elapsedMs();
+            m_context.profiler().end();
+
+            const GLStateCache::Counters& counters = state.counters();
+            recordDrawLoop(time, counters.issued, counters.skipped, frame.measured);
+            state.setBlend(false);
+        }
+
+        void report(Report& report) override
+        {
+            report.addText("state cache", m_cacheEnabled ? "on" : "off");
+            StateSortScenario::report(report);
+        }
+
+    private:
+        GLContext& m_context;
+        bool m_cacheEnabled;
+        std::vector<GLuint> m_programs;
+        std::vector<GLuint> m_textures;
+        std::vector<GLuint> m_vertexArrays;
+    };
+}
+
+std::unique_ptr<Scenario> createStateSortScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<StateSortScenarioGL>(context, options);
+}
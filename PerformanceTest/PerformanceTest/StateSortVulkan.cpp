@@ -0,0 +1,173 @@
+#include "StateSort.h"
+
+#include <string>
+
+#include "Timer.h"
+#include "VulkanContext.h"
+
+namespace
+{
+    class StateSortScenarioVulkan : public StateSortScenario
+    {
+    public:
+        StateSortScenarioVulkan(VulkanContext& context, const Options& options)
+            : StateSortScenario(options)
+            , m_context(context)
+        {
+            createTextures();
+            createDescriptors();
+            createPipelines();
+        }
+
+        ~StateSortScenarioVulkan() override
+        {
+            VkDevice device = m_context.device();
+            m_context.waitIdle();
+
+            for (VkPipeline pipeline : m_pipelines)
+                vkDestroyPipeline(device, pipeline, vulkanHostAllocator());
+            vkDestroyPipelineLayout(device, m_pipelineLayout, vulkanHostAllocator());
+            vkDestroyDescriptorSetLayout(device, m_setLayout, vulkanHostAllocator());
+            vkDestroyDescriptorPool(device, m_descriptorPool, vulkanHostAllocator());
+            vkDestroySampler(device, m_sampler, vulkanHostAllocator());
+            for (VulkanImage& texture : m_textures)
+                m_context.destroyImage(texture);
+        }
+
+        void render(const FrameInfo& frame) override
+        {
+            VkCommandBuffer cmd = m_context.commandBuffer();
+            const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context.beginSwapchainPass(cmd, clearColor);
+            m_context.profiler().begin(cmd, "draw");
+
+            /* Command buffers do not filter redundant binds, the renderer compares against the last bound state itself */
+            uint64_t issued = 0;
+            uint64_t skipped = 0;
+            VkPipeline boundPipeline = VK_NULL_HANDLE;
+            VkDescriptorSet boundSet = VK_NULL_HANDLE;
+            Timer timer;
+            for (uint32_t i = 0; i < uint32_t(m_draws.size()); ++i)
+            {
+                const StateSortDraw& draw = m_draws[m_order[i]];
+                VkPipeline pipeline = m_pipelines[draw.program * 2 + (draw.blend ? 1 : 0)];
+                if (pipeline != boundPipeline)
+                {
+                    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                    boundPipeline = pipeline;
+                    ++issued;
+                }
+                else
+                    ++skipped;
+
+                VkDescriptorSet set = m_sets[draw.texture];
+                if (set != boundSet)
+                {
+                    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &set, 0, nullptr);
+                    boundSet = set;
+                    ++issued;
+                }
+                else
+                    ++skipped;
+
+                vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, sizeof(draw.constants), &draw.constants);
+                vkCmdDraw(cmd, meshVertexCount(draw.mesh), 1, 0, 0);
+            }
+            recordDrawLoop(timer.elapsedMs(), issued, skipped, frame.measured);
+
+            m_context.profiler().end(cmd);
+            vkCmdEndRenderPass(cmd);
+        }
+
+    private:
+        void createTextures()
+        {
+            std::vector<uint32_t> texels = createTexels();
+            VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            info.imageType = VK_IMAGE_TYPE_2D;
+            info.format = VK_FORMAT_R8G8B8A8_UNORM;
+            info.extent = { kTextureSize, kTextureSize, 1 };
+            info.mipLevels = 1;
+            info.arrayLayers = 1;
+            info.samples = VK_SAMPLE_COUNT_1_BIT;
+            info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+            m_textures.resize(m_textureCount);
+            for (uint32_t i = 0; i < m_textureCount; ++i)
+            {
+                m_textures[i] = m_context.createImage(info, VK_IMAGE_ASPECT_COLOR_BIT);
+                m_context.uploadImage(m_textures[i], texels.data() + size_t(i) * kTextureSize * kTextureSize,
+                                      VkDeviceSize(kTextureSize) * kTextureSize * sizeof(uint32_t));
+            }
+
+            VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+            samplerInfo.magFilter = VK_FILTER_NEAREST;
+            samplerInfo.minFilter = VK_FILTER_NEAREST;
+            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            VK_CHECK(vkCreateSampler(m_context.device(), &samplerInfo, vulkanHostAllocator(), &m_sampler));
+        }
+
+        void createDescriptors()
+        {
+            m_setLayout = m_context.createDescriptorSetLayout({ { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr } });
+            m_descriptorPool = m_context.createDescriptorPool(m_textureCount, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_textureCount } });
+            m_sets.resize(m_textureCount);
+            for (uint32_t i = 0; i < m_textureCount; ++i)
+            {
+                m_sets[i] = m_context.allocateDescriptorSet(m_descriptorPool, m_setLayout);
+                VkDescriptorImageInfo image = { m_sampler, m_textures[i].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+                VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+                write.dstSet = m_sets[i];
+                write.dstBinding = 0;
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                write.pImageInfo = &image;
+                vkUpdateDescriptorSets(m_context.device(), 1, &write, 0, nullptr);
+            }
+        }
+
+        /* An opaque and a blended pipeline per program, blend state is baked into Vulkan pipelines */
+        void createPipelines()
+        {
+            m_pipelineLayout = m_context.createPipelineLayout({ m_setLayout }, sizeof(StateSortConstants));
+            VkDevice device = m_context.device();
+            for (uint32_t program = 0; program < m_programCount; ++program)
+            {
+                ShaderDefines defines = { { "VARIANT", std::to_string(program) } };
+                GraphicsPipelineDesc desc;
+                desc.layout = m_pipelineLayout;
+                desc.renderPass = m_context.swapchainRenderPass();
+                desc.vertexShader = m_context.createShaderModule("statesort/quad.vert", VK_SHADER_STAGE_VERTEX_BIT, defines);
+                desc.fragmentShader = m_context.createShaderModule("statesort/quad.frag", VK_SHADER_STAGE_FRAGMENT_BIT, defines);
+                desc.cullMode = VK_CULL_MODE_NONE;
+                desc.depthTest = false;
+                desc.depthWrite = false;
+                m_pipelines.push_back(m_context.createGraphicsPipeline(desc));
+                desc.alphaBlend = true;
+                m_pipelines.push_back(m_context.createGraphicsPipeline(desc));
+
+                vkDestroyShaderModule(device, desc.vertexShader, vulkanHostAllocator());
+                vkDestroyShaderModule(device, desc.fragmentShader, vulkanHostAllocator());
+            }
+        }
+
+        VulkanContext& m_context;
+        std::vector<VulkanImage> m_textures;
+        VkSampler m_sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> m_sets;
+        VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+        /* Indexed by program * 2 + blend */
+        std::vector<VkPipeline> m_pipelines;
+    };
+}
+
+std::unique_ptr<Scenario> createStateSortScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<StateSortScenarioVulkan>(context, options);
+}
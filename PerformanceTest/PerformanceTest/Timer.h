@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GLFW/glfw3.h"
+
+/* CPU timer on top of the GLFW high resolution counter */
+class Timer
+{
+public:
+    Timer()
+        : m_start(glfwGetTimerValue())
+    {
+    }
+
+    void reset() { m_start = glfwGetTimerValue(); }
+
+    double elapsedMs() const
+    {
+        return double(glfwGetTimerValue() - m_start) * 1000.0 / double(glfwGetTimerFrequency());
+    }
+
+private:
+    uint64_t m_start;
+};
@@ -0,0 +1,148 @@
+#include "TransformScenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "ClearOnlyScenario.h"
+#include "Random.h"
+#include "Timer.h"
+
+namespace
+{
+    /* Above this difference to the scalar reference the selected kernels are considered broken */
+    const float kSelfCheckTolerance = 1e-3f;
+}
+
+TransformScenario::TransformScenario(const Options& options, uint32_t width, uint32_t height)
+    : m_kernels(selectMathKernels(options.getString("math-kernels", "auto")))
+    , m_jobs(uint32_t(options.getInt("threads", 0)))
+    , m_aspect(float(width) / float(height))
+{
+    uint32_t count = uint32_t(options.getInt("instances", 100000));
+    uint32_t fanout = uint32_t(options.getInt("fanout", 8));
+    if (count == 0 || fanout == 0)
+        fatal("--instances and --fanout have to be at least 1");
+
+    m_selfCheckError = verifyMathKernels(m_kernels);
+    if (m_selfCheckError > kSelfCheckTolerance)
+        fatal("The %s math kernels differ from the scalar reference by %g", m_kernels.name, double(m_selfCheckError));
+
+    /* Roots, their children and grandchildren, each parent has `fanout` children */
+    uint32_t roots = std::max(1u, count / (1 + fanout + fanout * fanout));
+    uint32_t children = std::min(count - roots, roots * fanout);
+    m_levelBegin = { 0, roots, roots + children, count };
+
+    uint32_t state = 0x2545F491u;
+    auto random = [&state](float low, float high)
+    {
+        return low + (high - low) * random01(state);
+    };
+
+    m_transforms.resize(count);
+    m_axes.resize(count);
+    m_speeds.resize(count);
+    m_parents.resize(count);
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(roots))));
+    for (uint32_t level = 0; level < 3; ++level)
+    {
+        for (uint32_t i = m_levelBegin[level]; i < m_levelBegin[level + 1]; ++i)
+        {
+            uint32_t local = i - m_levelBegin[level];
+            Vec3 position = level == 0 ? Vec3{ float(local % side) * 4.0f, 0.0f, float(local / side) * 4.0f }
+                                       : Vec3{ random(-1.5f, 1.5f), random(0.5f, 1.5f), random(-1.5f, 1.5f) };
+            float scale = level == 0 ? 1.0f : 0.5f;
+            m_axes[i] = normalize({ random(-0.3f, 0.3f), 1.0f, random(-0.3f, 0.3f) });
+            m_speeds[i] = random(-2.0f, 2.0f);
+            m_transforms.set(i, position, axisAngle(m_axes[i], 0.0f), { scale, scale, scale });
+
+            uint32_t parentLevelSize = level == 0 ? 0 : m_levelBegin[level] - m_levelBegin[level - 1];
+            m_parents[i] = level == 0 ? -1 : int32_t(m_levelBegin[level - 1] + std::min(local / fanout, parentLevelSize - 1));
+        }
+    }
+
+    m_local.resize(count);
+    m_world.resize(count);
+    m_modelViewProj.resize(count);
+
+    std::printf("transforms: %u nodes (%u roots, fanout %u), %s kernels on %u threads, self check error %g\n", count, roots, fanout,
+                m_kernels.name, m_jobs.threadCount(), double(m_selfCheckError));
+}
+
+void TransformScenario::update(const FrameInfo& frame)
+{
+    uint32_t count = m_transforms.size();
+    float time = float(frame.index) / 60.0f;
+
+    Timer animateTimer;
+    m_jobs.parallelFor(count, kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            Quat rotation = axisAngle(m_axes[i], time * m_speeds[i]);
+            m_transforms.rotationX[i] = rotation.x;
+            m_transforms.rotationY[i] = rotation.y;
+            m_transforms.rotationZ[i] = rotation.z;
+            m_transforms.rotationW[i] = rotation.w;
+        }
+    });
+    double animateTime = animateTimer.elapsedMs();
+
+    uint32_t side = uint32_t(std::ceil(std::sqrt(double(m_levelBegin[1]))));
+    float extent = float(side) * 4.0f;
+    Mat4 viewProj = perspective(1.0f, m_aspect, 0.5f, extent * 3.0f)
+                  * lookAt({ -extent * 0.25f, extent * 0.5f, -extent * 0.25f }, { extent * 0.5f, 0.0f, extent * 0.5f }, { 0.0f, 1.0f, 0.0f });
+
+    Timer transformTimer;
+    m_jobs.parallelFor(count, kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        m_kernels.composeTransforms(m_transforms, m_local, begin, end);
+    });
+
+    /* Roots are their own world matrix, every deeper level waits for the one above */
+    for (int e = 0; e < 16; ++e)
+        std::copy(m_local.m[e].begin(), m_local.m[e].begin() + m_levelBegin[1], m_world.m[e].begin());
+    for (size_t level = 1; level + 1 < m_levelBegin.size(); ++level)
+    {
+        uint32_t levelBegin = m_levelBegin[level];
+        m_jobs.parallelFor(m_levelBegin[level + 1] - levelBegin, kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            m_kernels.updateHierarchy(m_local, m_parents.data(), m_world, levelBegin + begin, levelBegin + end);
+        });
+    }
+
+    m_jobs.parallelFor(count, kBatchSize, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        m_kernels.multiplyUniform(viewProj, m_world, m_modelViewProj, begin, end);
+    });
+    double transformTime = transformTimer.elapsedMs();
+
+    if (frame.measured)
+    {
+        m_animateTimes.add(animateTime);
+        m_transformTimes.add(transformTime);
+        m_transformRates.add(double(count) / (transformTime * 1000.0 * double(m_jobs.threadCount())));
+    }
+}
+
+void TransformScenario::report(Report& report)
+{
+    report.addText("math kernels", m_kernels.name);
+    char selfCheck[32];
+    std::snprintf(selfCheck, sizeof(selfCheck), "%g", double(m_selfCheckError));
+    report.addText("math self check error", selfCheck);
+    report.addValue("cpu threads", double(m_jobs.threadCount()), "");
+    report.addStatistics("cpu animate", m_animateTimes, "ms");
+    report.addStatistics("cpu transforms", m_transformTimes, "ms");
+    report.addStatistics("transform rate/thread", m_transformRates, "M/s");
+}
+
+std::unique_ptr<Scenario> createTransformScenarioGL(GLContext& context, const Options& options)
+{
+    return std::make_unique<ClearOnlyScenarioGL<TransformScenario>>(context, options);
+}
+
+std::unique_ptr<Scenario> createTransformScenarioVulkan(VulkanContext& context, const Options& options)
+{
+    return std::make_unique<ClearOnlyScenarioVulkan<TransformScenario>>(context, options);
+}
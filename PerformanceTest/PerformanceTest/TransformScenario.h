@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MathBatch.h"
+#include "Scenario.h"
+
+/*
+ * CPU transform workload of a production frame: every frame the nodes of a three level
+ * hierarchy are animated, their local matrices composed from translation, rotation and scale,
+ * propagated to world space and multiplied with the view projection. The GPU only clears, the
+ * interesting numbers are the CPU times in the report.
+ */
+class TransformScenario : public Scenario
+{
+public:
+    static constexpr uint32_t kBatchSize = 4096;
+
+    TransformScenario(const Options& options, uint32_t width, uint32_t height);
+
+    void update(const FrameInfo& frame) override;
+    void report(Report& report) override;
+
+protected:
+    /* Model view projection of every node, ready for upload */
+    Mat4Batch m_modelViewProj;
+
+private:
+    const MathKernels& m_kernels;
+    JobSystem m_jobs;
+    float m_aspect;
+    float m_selfCheckError;
+
+    TransformBatch m_transforms;
+    std::vector<Vec3> m_axes;
+    std::vector<float> m_speeds;
+    std::vector<int32_t> m_parents;
+    /* Nodes are sorted by depth, level i covers [m_levelBegin[i], m_levelBegin[i + 1]) */
+    std::vector<uint32_t> m_levelBegin;
+    Mat4Batch m_local;
+    Mat4Batch m_world;
+
+    Statistics m_animateTimes;
+    Statistics m_transformTimes;
+    /* Million matrices per second and thread */
+    Statistics m_transformRates;
+};
+
+std::unique_ptr<Scenario> createTransformScenarioGL(GLContext& context, const Options& options);
+std::unique_ptr<Scenario> createTransformScenarioVulkan(VulkanContext& context, const Options& options);
@@ -0,0 +1,1135 @@
+#define VMA_IMPLEMENTATION
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <shaderc/shaderc.hpp>
+
+namespace
+{
+#ifdef _DEBUG
+    const char* kValidationLayer = "VK_LAYER_KHRONOS_validation";
+
+    VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type,
+                                                 const VkDebugUtilsMessengerCallbackDataEXT* data, void* user)
+    {
+        if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+            std::fprintf(stderr, "Vulkan: %s\n", data->pMessage);
+        return VK_FALSE;
+    }
+#endif
+
+    shaderc_shader_kind shaderKind(VkShaderStageFlagBits stage)
+    {
+        switch (stage)
+        {
+        case VK_SHADER_STAGE_VERTEX_BIT: return shaderc_vertex_shader;
+        case VK_SHADER_STAGE_FRAGMENT_BIT: return shaderc_fragment_shader;
+        case VK_SHADER_STAGE_COMPUTE_BIT: return shaderc_compute_shader;
+        case VK_SHADER_STAGE_GEOMETRY_BIT: return shaderc_geometry_shader;
+        default: fatal("Unsupported shader stage %d", int(stage));
+        }
+    }
+
+    VkPresentModeKHR parsePresentMode(const std::string& mode)
+    {
+        if (mode == "immediate")
+            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        if (mode == "mailbox")
+            return VK_PRESENT_MODE_MAILBOX_KHR;
+        if (mode == "fifo")
+            return VK_PRESENT_MODE_FIFO_KHR;
+        if (mode == "fifo-relaxed")
+            return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        fatal("Unknown --present-mode '%s', expected immediate, mailbox, fifo or fifo-relaxed", mode.c_str());
+    }
+
+    const char* presentModeName(VkPresentModeKHR mode)
+    {
+        switch (mode)
+        {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+        default: return "other";
+        }
+    }
+}
+
+GraphicsPipelineCreateInfo::GraphicsPipelineCreateInfo(const GraphicsPipelineDesc& desc)
+{
+    stages[stageCount].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[stageCount].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[stageCount].module = desc.vertexShader;
+    stages[stageCount++].pName = "main";
+    if (desc.fragmentShader)
+    {
+        stages[stageCount].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stages[stageCount].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        stages[stageCount].module = desc.fragmentShader;
+        stages[stageCount].pName = "main";
+        stages[stageCount++].pSpecializationInfo = desc.fragmentSpecialization;
+    }
+
+    vertexInput.vertexBindingDescriptionCount = uint32_t(desc.vertexBindings.size());
+    vertexInput.pVertexBindingDescriptions = desc.vertexBindings.data();
+    vertexInput.vertexAttributeDescriptionCount = uint32_t(desc.vertexAttributes.size());
+    vertexInput.pVertexAttributeDescriptions = desc.vertexAttributes.data();
+
+    inputAssembly.topology = desc.topology;
+
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = desc.cullMode;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    multisample.rasterizationSamples = desc.samples;
+
+    depthStencil.depthTestEnable = desc.depthTest;
+    depthStencil.depthWriteEnable = desc.depthWrite;
+    depthStencil.depthCompareOp = desc.depthCompare;
+
+    blendAttachments.resize(desc.colorAttachmentCount);
+    for (VkPipelineColorBlendAttachmentState& attachment : blendAttachments)
+    {
+        attachment = {};
+        attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        if (desc.alphaBlend)
+        {
+            attachment.blendEnable = VK_TRUE;
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.colorBlendOp = VK_BLEND_OP_ADD;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+        }
+    }
+    colorBlend.attachmentCount = desc.colorAttachmentCount;
+    colorBlend.pAttachments = blendAttachments.data();
+
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamicStates;
+
+    info.stageCount = stageCount;
+    info.pStages = stages;
+    info.pVertexInputState = &vertexInput;
+    info.pInputAssemblyState = &inputAssembly;
+    info.pViewportState = &viewport;
+    info.pRasterizationState = &rasterization;
+    info.pMultisampleState = &multisample;
+    info.pDepthStencilState = &depthStencil;
+    info.pColorBlendState = &colorBlend;
+    info.pDynamicState = &dynamic;
+    info.layout = desc.layout;
+    info.renderPass = desc.renderPass;
+    info.subpass = desc.subpass;
+}
+
+void cmdMemoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void cmdImageBarrier(VkCommandBuffer cmd, VkImage image, VkImageAspectFlags aspect,
+                     VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkImageLayout oldLayout,
+                     VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = { aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VulkanProfiler::VulkanProfiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t frameCount)
+    : m_device(device)
+    , m_timestampPeriodMs(double(properties.limits.timestampPeriod) * 1e-6)
+    , m_frames(frameCount)
+{
+    VkQueryPoolCreateInfo info = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount = frameCount * kMaxZones * 2;
+    VK_CHECK(vkCreateQueryPool(device, &info, vulkanHostAllocator(), &m_pool));
+}
+
+VulkanProfiler::~VulkanProfiler()
+{
+    vkDestroyQueryPool(m_device, m_pool, vulkanHostAllocator());
+}
+
+void VulkanProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slot, const FrameInfo& frame)
+{
+    FrameQueries& queries = m_frames[slot];
+    uint32_t firstQuery = slot * kMaxZones * 2;
+    if (queries.recordCount > 0)
+    {
+        uint64_t timestamps[kMaxZones * 2];
+        VK_CHECK(vkGetQueryPoolResults(m_device, m_pool, firstQuery, queries.recordCount * 2, sizeof(timestamps), timestamps,
+                                       sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+        if (queries.measured)
+            for (uint32_t i = 0; i < queries.recordCount; ++i)
+            {
+                const ZoneRecord& record = queries.records[i];
+                uint64_t ticks = timestamps[record.query + 1] - timestamps[record.query];
+                m_zoneTimes[record.zone].add(double(ticks) * m_timestampPeriodMs);
+            }
+    }
+
+    vkCmdResetQueryPool(cmd, m_pool, firstQuery, kMaxZones * 2);
+    queries.recordCount = 0;
+    queries.measured = frame.measured;
+    m_current = slot;
+}
+
+void VulkanProfiler::begin(VkCommandBuffer cmd, const char* zone)
+{
+    FrameQueries& queries = m_frames[m_current];
+    if (m_open != UINT32_MAX || queries.recordCount == kMaxZones)
+        fatal("VulkanProfiler: zones can not be nested and are limited to %u per frame", kMaxZones);
+
+    m_open = queries.recordCount++;
+    queries.records[m_open] = { zoneIndex(zone), m_open * 2 };
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool, m_current * kMaxZones * 2 + m_open * 2);
+}
+
+void VulkanProfiler::end(VkCommandBuffer cmd)
+{
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, m_current * kMaxZones * 2 + m_open * 2 + 1);
+    m_open = UINT32_MAX;
+}
+
+void VulkanProfiler::report(Report& report) const
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        report.addStatistics(std::string("gpu ") + m_zoneNames[i], m_zoneTimes[i], "ms");
+}
+
+const Statistics* VulkanProfiler::zoneTimes(const char* zone) const
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        if (m_zoneNames[i] == zone || std::strcmp(m_zoneNames[i], zone) == 0)
+            return m_zoneTimes[i].count() ? &m_zoneTimes[i] : nullptr;
+    return nullptr;
+}
+
+uint32_t VulkanProfiler::zoneIndex(const char* zone)
+{
+    for (uint32_t i = 0; i < m_zoneCount; ++i)
+        if (m_zoneNames[i] == zone || std::strcmp(m_zoneNames[i], zone) == 0)
+            return i;
+
+    if (m_zoneCount == kMaxZones)
+        fatal("VulkanProfiler: too many distinct zones");
+    m_zoneNames[m_zoneCount] = zone;
+    return m_zoneCount++;
+}
+
+VulkanUniformRing::VulkanUniformRing(VulkanContext& context, VkDeviceSize segmentSize, uint32_t segmentCount)
+    : m_context(context)
+    , m_segmentSize(segmentSize)
+    , m_alignment(std::max<VkDeviceSize>(1, context.properties().limits.minUniformBufferOffsetAlignment))
+{
+    m_buffer = context.createBuffer(segmentSize * segmentCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+                                    VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+}
+
+VulkanUniformRing::~VulkanUniformRing()
+{
+    m_context.destroyBuffer(m_buffer);
+}
+
+void VulkanUniformRing::beginFrame(uint32_t slot)
+{
+    m_segmentBegin = VkDeviceSize(slot) * m_segmentSize;
+    m_head = m_segmentBegin;
+}
+
+void VulkanUniformRing::endFrame()
+{
+    if (m_head > m_segmentBegin)
+        VK_CHECK(vmaFlushAllocation(m_context.allocator(), m_buffer.allocation, m_segmentBegin, m_head - m_segmentBegin));
+}
+
+VulkanUniformAllocation VulkanUniformRing::allocate(VkDeviceSize size)
+{
+    VkDeviceSize offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    if (offset + size > m_segmentBegin + m_segmentSize)
+        fatal("Uniform ring overflow, a frame needs more than %llu bytes", (unsigned long long)m_segmentSize);
+    m_head = offset + size;
+    return { static_cast<uint8_t*>(m_buffer.mapped) + offset, uint32_t(offset) };
+}
+
+VulkanContext::VulkanContext(GLFWwindow* window, const Options& options)
+    : m_window(window)
+    , m_presentMode(parsePresentMode(options.getString("present-mode", "fifo")))
+    , m_requestedImageCount(uint32_t(options.getInt("swapchain-images", 0)))
+    , m_latency("present done")
+{
+    createInstance();
+    VK_CHECK(glfwCreateWindowSurface(m_instance, window, vulkanHostAllocator(), &m_surface));
+    pickPhysicalDevice();
+    createDevice();
+    if (!m_extensions.presentWait)
+    {
+        std::printf("VulkanContext: VK_KHR_present_wait is not supported, latency ends when the frame is done on the GPU\n");
+        m_latency = FrameLatency("frame done on the gpu");
+    }
+
+    uint32_t modeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &modeCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(modeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &modeCount, modes.data());
+    if (std::find(modes.begin(), modes.end(), m_presentMode) == modes.end())
+    {
+        /* FIFO is the one mode every surface has to support */
+        std::printf("VulkanContext: present mode %s is not supported, falling back to fifo\n", presentModeName(m_presentMode));
+        m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    VmaAllocatorCreateInfo allocatorInfo = {};
+    allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+    allocatorInfo.instance = m_instance;
+    allocatorInfo.physicalDevice = m_physicalDevice;
+    allocatorInfo.device = m_device;
+    allocatorInfo.pAllocationCallbacks = vulkanHostAllocator();
+    VK_CHECK(vmaCreateAllocator(&allocatorInfo, &m_allocator));
+
+    for (Frame& frame : m_frames)
+    {
+        VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = m_queueFamily;
+        VK_CHECK(vkCreateCommandPool(m_device, &poolInfo, vulkanHostAllocator(), &frame.commandPool));
+
+        VkCommandBufferAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        allocateInfo.commandPool = frame.commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+        VK_CHECK(vkAllocateCommandBuffers(m_device, &allocateInfo, &frame.commandBuffer));
+
+        VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VK_CHECK(vkCreateFence(m_device, &fenceInfo, vulkanHostAllocator(), &frame.fence));
+
+        VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        VK_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, vulkanHostAllocator(), &frame.imageAvailable));
+    }
+
+    VkCommandPoolCreateInfo uploadPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    uploadPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    uploadPoolInfo.queueFamilyIndex = m_queueFamily;
+    VK_CHECK(vkCreateCommandPool(m_device, &uploadPoolInfo, vulkanHostAllocator(), &m_uploadPool));
+
+    createSwapchain();
+    m_profiler = std::make_unique<VulkanProfiler>(m_device, m_properties, kFramesInFlight);
+    m_uniformRing = std::make_unique<VulkanUniformRing>(*this, kUniformRingSize, kFramesInFlight);
+}
+
+VulkanContext::~VulkanContext()
+{
+    vkDeviceWaitIdle(m_device);
+
+    m_uniformRing.reset();
+    m_profiler.reset();
+    destroySwapchain();
+    vkDestroyRenderPass(m_device, m_renderPass, vulkanHostAllocator());
+    vkDestroyCommandPool(m_device, m_uploadPool, vulkanHostAllocator());
+    for (Frame& frame : m_frames)
+    {
+        vkDestroyCommandPool(m_device, frame.commandPool, vulkanHostAllocator());
+        vkDestroyFence(m_device, frame.fence, vulkanHostAllocator());
+        vkDestroySemaphore(m_device, frame.imageAvailable, vulkanHostAllocator());
+    }
+
+    vmaDestroyAllocator(m_allocator);
+    vkDestroyDevice(m_device, vulkanHostAllocator());
+    vkDestroySurfaceKHR(m_instance, m_surface, vulkanHostAllocator());
+#ifdef _DEBUG
+    if (m_debugMessenger)
+    {
+        auto destroyMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT"));
+        destroyMessenger(m_instance, m_debugMessenger, vulkanHostAllocator());
+    }
+#endif
+    vkDestroyInstance(m_instance, vulkanHostAllocator());
+}
+
+void VulkanContext::createInstance()
+{
+    VkApplicationInfo appInfo = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    appInfo.pApplicationName = "PerformanceTest";
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    uint32_t glfwExtensionCount = 0;
+    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    if (!glfwExtensions)
+        fatal("GLFW did not find a Vulkan loader");
+    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+
+    VkInstanceCreateInfo info = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    info.pApplicationInfo = &appInfo;
+
+#ifdef _DEBUG
+    uint32_t layerCount = 0;
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    std::vector<VkLayerProperties> layers(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+    bool validation = std::any_of(layers.begin(), layers.end(), [](const VkLayerProperties& layer) { return std::strcmp(layer.layerName, kValidationLayer) == 0; });
+    if (validation)
+    {
+        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        info.enabledLayerCount = 1;
+        info.ppEnabledLayerNames = &kValidationLayer;
+    }
+#endif
+
+    info.enabledExtensionCount = uint32_t(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
+    VK_CHECK(vkCreateInstance(&info, vulkanHostAllocator(), &m_instance));
+
+#ifdef _DEBUG
+    if (validation)
+    {
+        VkDebugUtilsMessengerCreateInfoEXT messengerInfo = { VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT };
+        messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        messengerInfo.pfnUserCallback = debugCallback;
+        auto createMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT"));
+        VK_CHECK(createMessenger(m_instance, &messengerInfo, vulkanHostAllocator(), &m_debugMessenger));
+    }
+#endif
+}
+
+void VulkanContext::pickPhysicalDevice()
+{
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_instance, &deviceCount, devices.data());
+
+    int bestScore = -1;
+    for (VkPhysicalDevice device : devices)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_2)
+            continue;
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+
+        /* A single queue for graphics, compute and present, the same model OpenGL exposes */
+        for (uint32_t family = 0; family < familyCount; ++family)
+        {
+            VkBool32 present = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, family, m_surface, &present);
+            VkQueueFlags required = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+            if (!present || (families[family].queueFlags & required) != required || families[family].timestampValidBits == 0)
+                continue;
+
+            int score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 2 : properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 1 : 0;
+            if (score > bestScore)
+            {
+                bestScore = score;
+                m_physicalDevice = device;
+                m_queueFamily = family;
+                m_properties = properties;
+            }
+            break;
+        }
+    }
+
+    if (!m_physicalDevice)
+        fatal("No Vulkan 1.2 device with a graphics, compute and present queue found");
+}
+
+void VulkanContext::createDevice()
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> available(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, available.data());
+    auto hasExtension = [&](const char* name)
+    {
+        return std::any_of(available.begin(), available.end(), [&](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, name) == 0; });
+    };
+    bool pipelineLibraryExtensions = hasExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) && hasExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    bool presentWaitExtensions = hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    bool synchronization2Extension = hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supportedLibrary = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+    VkPhysicalDevicePresentIdFeaturesKHR supportedPresentId = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR supportedPresentWait = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    VkPhysicalDeviceSynchronization2Features supportedSynchronization2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES };
+    VkPhysicalDeviceVulkan12Features supported12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    if (pipelineLibraryExtensions)
+    {
+        supportedLibrary.pNext = supported12.pNext;
+        supported12.pNext = &supportedLibrary;
+    }
+    if (presentWaitExtensions)
+    {
+        supportedPresentWait.pNext = &supportedPresentId;
+        supportedPresentId.pNext = supported12.pNext;
+        supported12.pNext = &supportedPresentWait;
+    }
+    if (synchronization2Extension)
+    {
+        supportedSynchronization2.pNext = supported12.pNext;
+        supported12.pNext = &supportedSynchronization2;
+    }
+    VkPhysicalDeviceFeatures2 supported2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    supported2.pNext = &supported12;
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supported2);
+    const VkPhysicalDeviceFeatures& supported = supported2.features;
+
+    /* Descriptor indexing for the bindless materials, only the parts the shaders use */
+    bool descriptorIndexing = supported12.descriptorIndexing && supported12.descriptorBindingSampledImageUpdateAfterBind
+                           && supported12.descriptorBindingPartiallyBound && supported.shaderSampledImageArrayDynamicIndexing;
+    m_vulkan12Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    m_vulkan12Features.descriptorIndexing = descriptorIndexing;
+    m_vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = descriptorIndexing;
+    m_vulkan12Features.descriptorBindingPartiallyBound = descriptorIndexing;
+
+    VkPhysicalDeviceFeatures2 features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    features.pNext = &m_vulkan12Features;
+    features.features.multiDrawIndirect = supported.multiDrawIndirect;
+    features.features.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+    features.features.shaderSampledImageArrayDynamicIndexing = descriptorIndexing;
+    /* Storage images in formats like r11g11b10f for the MSAA compute resolve */
+    features.features.shaderStorageImageExtendedFormats = supported.shaderStorageImageExtendedFormats;
+    m_features = features.features;
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+    queueInfo.queueFamilyIndex = m_queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    std::vector<const char*> extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    m_extensions.pushDescriptor = hasExtension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    if (m_extensions.pushDescriptor)
+        extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+
+    /* Pipeline libraries for VulkanPipelineCache, which falls back to whole pipelines without them */
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT };
+    m_extensions.graphicsPipelineLibrary = pipelineLibraryExtensions && supportedLibrary.graphicsPipelineLibrary;
+    if (m_extensions.graphicsPipelineLibrary)
+    {
+        extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        libraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+        libraryFeatures.pNext = m_vulkan12Features.pNext;
+        m_vulkan12Features.pNext = &libraryFeatures;
+    }
+
+    /* Present ids and waiting on them for the latency estimate, see FrameLatency */
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    m_extensions.presentWait = presentWaitExtensions && supportedPresentId.presentId && supportedPresentWait.presentWait;
+    if (m_extensions.presentWait)
+    {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        presentIdFeatures.presentId = VK_TRUE;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        presentWaitFeatures.pNext = &presentIdFeatures;
+        presentIdFeatures.pNext = m_vulkan12Features.pNext;
+        m_vulkan12Features.pNext = &presentWaitFeatures;
+    }
+
+    /* Barriers with 64 bit stage and access masks for RenderGraph, which falls back to vkCmdPipelineBarrier without them */
+    VkPhysicalDeviceSynchronization2Features synchronization2Features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES };
+    m_extensions.synchronization2 = synchronization2Extension && supportedSynchronization2.synchronization2;
+    if (m_extensions.synchronization2)
+    {
+        extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        synchronization2Features.synchronization2 = VK_TRUE;
+        synchronization2Features.pNext = m_vulkan12Features.pNext;
+        m_vulkan12Features.pNext = &synchronization2Features;
+    }
+
+    VkDeviceCreateInfo info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    info.pNext = &features;
+    info.queueCreateInfoCount = 1;
+    info.pQueueCreateInfos = &queueInfo;
+    info.enabledExtensionCount = uint32_t(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
+    VK_CHECK(vkCreateDevice(m_physicalDevice, &info, vulkanHostAllocator(), &m_device));
+    vkGetDeviceQueue(m_device, m_queueFamily, 0, &m_queue);
+    m_vulkan12Features.pNext = nullptr;
+
+    if (m_extensions.pushDescriptor)
+        m_extensions.cmdPushDescriptorSetKHR = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(vkGetDeviceProcAddr(m_device, "vkCmdPushDescriptorSetKHR"));
+    if (m_extensions.presentWait)
+        m_extensions.waitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR"));
+    if (m_extensions.synchronization2)
+        m_extensions.cmdPipelineBarrier2KHR = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier2KHR"));
+}
+
+void VulkanContext::createSwapchain()
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physicalDevice, m_surface, &capabilities));
+
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(m_physicalDevice, m_surface, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(m_physicalDevice, m_surface, &formatCount, formats.data());
+
+    /* UNORM like the default OpenGL framebuffer, so both backends write the same bytes */
+    VkSurfaceFormatKHR surfaceFormat = formats[0];
+    for (const VkSurfaceFormatKHR& format : formats)
+        if (format.format == VK_FORMAT_B8G8R8A8_UNORM || format.format == VK_FORMAT_R8G8B8A8_UNORM)
+        {
+            surfaceFormat = format;
+            break;
+        }
+
+    if (capabilities.currentExtent.width != UINT32_MAX)
+        m_swapchainExtent = capabilities.currentExtent;
+    else
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(m_window, &width, &height);
+        m_swapchainExtent.width = std::clamp(uint32_t(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        m_swapchainExtent.height = std::clamp(uint32_t(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
+
+    uint32_t imageCount = m_requestedImageCount ? m_requestedImageCount : capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0)
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    if (m_requestedImageCount && imageCount != m_requestedImageCount)
+    {
+        std::printf("VulkanContext: %u swapchain images are not supported, using %u\n", m_requestedImageCount, imageCount);
+        m_requestedImageCount = imageCount;
+    }
+
+    VkSwapchainCreateInfoKHR info = { VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR };
+    info.surface = m_surface;
+    info.minImageCount = imageCount;
+    info.imageFormat = surfaceFormat.format;
+    info.imageColorSpace = surfaceFormat.colorSpace;
+    info.imageExtent = m_swapchainExtent;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    info.presentMode = m_presentMode;
+    info.clipped = VK_TRUE;
+    VK_CHECK(vkCreateSwapchainKHR(m_device, &info, vulkanHostAllocator(), &m_swapchain));
+    m_swapchainFormat = surfaceFormat.format;
+
+    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
+    m_swapchainImages.resize(imageCount);
+    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, m_swapchainImages.data());
+
+    VkImageCreateInfo depthInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    depthInfo.imageType = VK_IMAGE_TYPE_2D;
+    depthInfo.format = m_depthFormat;
+    depthInfo.extent = { m_swapchainExtent.width, m_swapchainExtent.height, 1 };
+    depthInfo.mipLevels = 1;
+    depthInfo.arrayLayers = 1;
+    depthInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    depthInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    m_depthImage = createImage(depthInfo, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    if (!m_renderPass)
+    {
+        VkAttachmentDescription attachments[2] = {};
+        attachments[0].format = m_swapchainFormat;
+        attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        attachments[1].format = m_depthFormat;
+        attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+        subpass.pDepthStencilAttachment = &depthReference;
+
+        /* Orders the layout transitions after the image acquire and the previous frame's depth writes */
+        VkSubpassDependency dependency = {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.dstStageMask = dependency.srcStageMask;
+        dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+        renderPassInfo.attachmentCount = 2;
+        renderPassInfo.pAttachments = attachments;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+        VK_CHECK(vkCreateRenderPass(m_device, &renderPassInfo, vulkanHostAllocator(), &m_renderPass));
+    }
+
+    for (VkImage image : m_swapchainImages)
+    {
+        VkImageView view = createImageView(image, VK_IMAGE_VIEW_TYPE_2D, m_swapchainFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 1);
+        m_swapchainViews.push_back(view);
+
+        VkImageView attachments[] = { view, m_depthImage.view };
+        VkFramebufferCreateInfo framebufferInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        framebufferInfo.renderPass = m_renderPass;
+        framebufferInfo.attachmentCount = 2;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = m_swapchainExtent.width;
+        framebufferInfo.height = m_swapchainExtent.height;
+        framebufferInfo.layers = 1;
+        VkFramebuffer framebuffer;
+        VK_CHECK(vkCreateFramebuffer(m_device, &framebufferInfo, vulkanHostAllocator(), &framebuffer));
+        m_framebuffers.push_back(framebuffer);
+
+        VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        VkSemaphore semaphore;
+        VK_CHECK(vkCreateSemaphore(m_device, &semaphoreInfo, vulkanHostAllocator(), &semaphore));
+        m_renderFinished.push_back(semaphore);
+    }
+}
+
+void VulkanContext::destroySwapchain()
+{
+    for (VkFramebuffer framebuffer : m_framebuffers)
+        vkDestroyFramebuffer(m_device, framebuffer, vulkanHostAllocator());
+    for (VkImageView view : m_swapchainViews)
+        vkDestroyImageView(m_device, view, vulkanHostAllocator());
+    for (VkSemaphore semaphore : m_renderFinished)
+        vkDestroySemaphore(m_device, semaphore, vulkanHostAllocator());
+    m_framebuffers.clear();
+    m_swapchainViews.clear();
+    m_renderFinished.clear();
+    destroyImage(m_depthImage);
+    vkDestroySwapchainKHR(m_device, m_swapchain, vulkanHostAllocator());
+    m_swapchain = VK_NULL_HANDLE;
+}
+
+void VulkanContext::recreateSwapchain()
+{
+    /* A minimized window has a zero sized framebuffer, wait until it is visible again */
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    while (width == 0 || height == 0)
+    {
+        glfwWaitEvents();
+        glfwGetFramebufferSize(m_window, &width, &height);
+    }
+
+    vkDeviceWaitIdle(m_device);
+    destroySwapchain();
+    createSwapchain();
+    /* Present ids belong to the old swapchain */
+    if (m_extensions.presentWait)
+        m_latency.discardPending();
+}
+
+void VulkanContext::beginFrame(const FrameInfo& frame)
+{
+    Frame& current = m_frames[m_frameIndex];
+    m_latencyFrame = m_latency.beginFrame(frame);
+    VK_CHECK(vkWaitForFences(m_device, 1, &current.fence, VK_TRUE, UINT64_MAX));
+
+    VkResult result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, current.imageAvailable, VK_NULL_HANDLE, &m_imageIndex);
+    while (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        recreateSwapchain();
+        result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, current.imageAvailable, VK_NULL_HANDLE, &m_imageIndex);
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        fatal("vkAcquireNextImageKHR failed with VkResult %d", int(result));
+
+    pollLatency();
+    VK_CHECK(vkResetFences(m_device, 1, &current.fence));
+    VK_CHECK(vkResetCommandPool(m_device, current.commandPool, 0));
+
+    VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(current.commandBuffer, &beginInfo));
+
+    m_profiler->beginFrame(current.commandBuffer, m_frameIndex, frame);
+    m_uniformRing->beginFrame(m_frameIndex);
+}
+
+void VulkanContext::endFrame()
+{
+    Frame& current = m_frames[m_frameIndex];
+    m_uniformRing->endFrame();
+    VK_CHECK(vkEndCommandBuffer(current.commandBuffer));
+
+    /* Work before the first swapchain access (culling, shadow passes, ...) may overlap the acquire */
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &current.imageAvailable;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &current.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_renderFinished[m_imageIndex];
+    VK_CHECK(vkQueueSubmit(m_queue, 1, &submitInfo, current.fence));
+
+    VkPresentInfoKHR presentInfo = { VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &m_renderFinished[m_imageIndex];
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &m_swapchain;
+    presentInfo.pImageIndices = &m_imageIndex;
+    uint64_t presentId = m_latencyFrame + 1;
+    VkPresentIdKHR presentIdInfo = { VK_STRUCTURE_TYPE_PRESENT_ID_KHR };
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+    if (m_extensions.presentWait)
+        presentInfo.pNext = &presentIdInfo;
+    VkResult result = vkQueuePresentKHR(m_queue, &presentInfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+        recreateSwapchain();
+    else if (result != VK_SUCCESS)
+        fatal("vkQueuePresentKHR failed with VkResult %d", int(result));
+    pollLatency();
+
+    m_frameIndex = (m_frameIndex + 1) % kFramesInFlight;
+}
+
+void VulkanContext::waitIdle()
+{
+    VK_CHECK(vkDeviceWaitIdle(m_device));
+}
+
+void VulkanContext::beginSwapchainPass(VkCommandBuffer cmd, const float clearColor[4])
+{
+    VkClearValue clearValues[2] = {};
+    std::memcpy(clearValues[0].color.float32, clearColor, sizeof(float) * 4);
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    info.renderPass = m_renderPass;
+    info.framebuffer = m_framebuffers[m_imageIndex];
+    info.renderArea.extent = m_swapchainExtent;
+    info.clearValueCount = 2;
+    info.pClearValues = clearValues;
+    vkCmdBeginRenderPass(cmd, &info, VK_SUBPASS_CONTENTS_INLINE);
+    setViewport(cmd, m_swapchainExtent);
+}
+
+void VulkanContext::setViewport(VkCommandBuffer cmd, VkExtent2D extent) const
+{
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = float(extent.height);
+    viewport.width = float(extent.width);
+    viewport.height = -float(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    VkRect2D scissor = { { 0, 0 }, extent };
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+
+VulkanBuffer VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags)
+{
+    VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    info.size = size;
+    info.usage = usage;
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.usage = memoryUsage;
+    allocationInfo.flags = flags;
+
+    VulkanBuffer buffer;
+    VmaAllocationInfo allocationResult;
+    VK_CHECK(vmaCreateBuffer(m_allocator, &info, &allocationInfo, &buffer.buffer, &buffer.allocation, &allocationResult));
+    buffer.mapped = allocationResult.pMappedData;
+    buffer.size = size;
+    return buffer;
+}
+
+VulkanBuffer VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data)
+{
+    VulkanBuffer buffer = createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+    VulkanBuffer staging = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO,
+                                        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    std::memcpy(staging.mapped, data, size_t(size));
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkBufferCopy region = { 0, 0, size };
+        vkCmdCopyBuffer(cmd, staging.buffer, buffer.buffer, 1, &region);
+    });
+    destroyBuffer(staging);
+    return buffer;
+}
+
+void VulkanContext::destroyBuffer(VulkanBuffer& buffer)
+{
+    if (buffer.buffer)
+        vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
+    buffer = {};
+}
+
+VulkanImage VulkanContext::createImage(const VkImageCreateInfo& info, VkImageAspectFlags aspect, VmaMemoryUsage memoryUsage)
+{
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.usage = memoryUsage;
+
+    VulkanImage image;
+    VK_CHECK(vmaCreateImage(m_allocator, &info, &allocationInfo, &image.image, &image.allocation, nullptr));
+    image.format = info.format;
+    image.extent = info.extent;
+    image.mipLevels = info.mipLevels;
+    image.arrayLayers = info.arrayLayers;
+    if (!aspect)
+        return image;
+
+    VkImageViewType viewType = info.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    image.view = createImageView(image.image, viewType, info.format, aspect, 0, info.mipLevels, 0, info.arrayLayers);
+    return image;
+}
+
+void VulkanContext::uploadImage(const VulkanImage& image, const void* data, VkDeviceSize size)
+{
+    VulkanBuffer staging = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO,
+                                        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    std::memcpy(staging.mapped, data, size_t(size));
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        cmdImageBarrier(cmd, image.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        VkBufferImageCopy region = {};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, image.arrayLayers };
+        region.imageExtent = image.extent;
+        vkCmdCopyBufferToImage(cmd, staging.buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        cmdImageBarrier(cmd, image.image, VK_IMAGE_ASPECT_COLOR_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    });
+    destroyBuffer(staging);
+}
+
+void VulkanContext::destroyImage(VulkanImage& image)
+{
+    if (image.view)
+        vkDestroyImageView(m_device, image.view, vulkanHostAllocator());
+    if (image.image)
+        vmaDestroyImage(m_allocator, image.image, image.allocation);
+    image = {};
+}
+
+VkImageView VulkanContext::createImageView(VkImage image, VkImageViewType type, VkFormat format, VkImageAspectFlags aspect,
+                                           uint32_t baseMip, uint32_t mipCount, uint32_t baseLayer, uint32_t layerCount)
+{
+    VkImageViewCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    info.image = image;
+    info.viewType = type;
+    info.format = format;
+    info.subresourceRange = { aspect, baseMip, mipCount, baseLayer, layerCount };
+
+    VkImageView view;
+    VK_CHECK(vkCreateImageView(m_device, &info, vulkanHostAllocator(), &view));
+    return view;
+}
+
+VkShaderModule VulkanContext::createShaderModule(const std::string& path, VkShaderStageFlagBits stage, const ShaderDefines& defines)
+{
+    VkShaderModuleCreateInfo info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    VkShaderModule module;
+    if (const EmbeddedShader* embedded = findEmbeddedShader(path, defines, true))
+    {
+        info.codeSize = embedded->wordCount * sizeof(uint32_t);
+        info.pCode = embedded->code;
+        VK_CHECK(vkCreateShaderModule(m_device, &info, vulkanHostAllocator(), &module));
+        return module;
+    }
+
+    std::string source = loadShaderSource(path, defines, true);
+
+    shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, shaderKind(stage), path.c_str(), options);
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+        fatal("Failed to compile '%s':\n%s", path.c_str(), result.GetErrorMessage().c_str());
+
+    std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+    info.codeSize = spirv.size() * sizeof(uint32_t);
+    info.pCode = spirv.data();
+    VK_CHECK(vkCreateShaderModule(m_device, &info, vulkanHostAllocator(), &module));
+    return module;
+}
+
+VkPipeline VulkanContext::createComputePipeline(VkPipelineLayout layout, VkShaderModule shader)
+{
+    VkComputePipelineCreateInfo info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    info.stage.module = shader;
+    info.stage.pName = "main";
+    info.layout = layout;
+
+    VkPipeline pipeline;
+    VK_CHECK(vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &info, vulkanHostAllocator(), &pipeline));
+    return pipeline;
+}
+
+VkPipeline VulkanContext::createGraphicsPipeline(const GraphicsPipelineDesc& desc)
+{
+    GraphicsPipelineCreateInfo state(desc);
+    VkPipeline pipeline;
+    VK_CHECK(vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &state.info, vulkanHostAllocator(), &pipeline));
+    return pipeline;
+}
+
+VkDescriptorSetLayout VulkanContext::createDescriptorSetLayout(std::initializer_list<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags,
+                                                               std::initializer_list<VkDescriptorBindingFlags> bindingFlags)
+{
+    if (bindingFlags.size() != 0 && bindingFlags.size() != bindings.size())
+        fatal("createDescriptorSetLayout: %zu binding flags for %zu bindings", bindingFlags.size(), bindings.size());
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+    flagsInfo.bindingCount = uint32_t(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.begin();
+
+    VkDescriptorSetLayoutCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    info.pNext = bindingFlags.size() ? &flagsInfo : nullptr;
+    info.flags = flags;
+    info.bindingCount = uint32_t(bindings.size());
+    info.pBindings = bindings.begin();
+
+    VkDescriptorSetLayout layout;
+    VK_CHECK(vkCreateDescriptorSetLayout(m_device, &info, vulkanHostAllocator(), &layout));
+    return layout;
+}
+
+VkPipelineLayout VulkanContext::createPipelineLayout(std::initializer_list<VkDescriptorSetLayout> setLayouts, uint32_t pushConstantSize)
+{
+    VkPushConstantRange range = { VK_SHADER_STAGE_ALL, 0, pushConstantSize };
+
+    VkPipelineLayoutCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    info.setLayoutCount = uint32_t(setLayouts.size());
+    info.pSetLayouts = setLayouts.begin();
+    info.pushConstantRangeCount = pushConstantSize ? 1 : 0;
+    info.pPushConstantRanges = &range;
+
+    VkPipelineLayout layout;
+    VK_CHECK(vkCreatePipelineLayout(m_device, &info, vulkanHostAllocator(), &layout));
+    return layout;
+}
+
+VkDescriptorPool VulkanContext::createDescriptorPool(uint32_t maxSets, std::initializer_list<VkDescriptorPoolSize> sizes, VkDescriptorPoolCreateFlags flags)
+{
+    VkDescriptorPoolCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    info.flags = flags;
+    info.maxSets = maxSets;
+    info.poolSizeCount = uint32_t(sizes.size());
+    info.pPoolSizes = sizes.begin();
+
+    VkDescriptorPool pool;
+    VK_CHECK(vkCreateDescriptorPool(m_device, &info, vulkanHostAllocator(), &pool));
+    return pool;
+}
+
+VkDescriptorSet VulkanContext::allocateDescriptorSet(VkDescriptorPool pool, VkDescriptorSetLayout layout)
+{
+    VkDescriptorSetAllocateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    info.descriptorPool = pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VK_CHECK(vkAllocateDescriptorSets(m_device, &info, &set));
+    return set;
+}
+
+void VulkanContext::immediateSubmit(const std::function<void(VkCommandBuffer)>& record)
+{
+    VkCommandBufferAllocateInfo allocateInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    allocateInfo.commandPool = m_uploadPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    VkCommandBuffer cmd;
+    VK_CHECK(vkAllocateCommandBuffers(m_device, &allocateInfo, &cmd));
+
+    VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+    record(cmd);
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    VkFence fence;
+    VK_CHECK(vkCreateFence(m_device, &fenceInfo, vulkanHostAllocator(), &fence));
+
+    VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+    VK_CHECK(vkQueueSubmit(m_queue, 1, &submitInfo, fence));
+    VK_CHECK(vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX));
+
+    vkDestroyFence(m_device, fence, vulkanHostAllocator());
+    vkFreeCommandBuffers(m_device, m_uploadPool, 1, &cmd);
+}
+
+void VulkanContext::report(Report& report) const
+{
+    report.addText("renderer", m_properties.deviceName);
+    report.addText("present mode", presentModeName(m_presentMode));
+    report.addValue("swapchain images", double(m_swapchainImages.size()), "");
+    m_profiler->report(report);
+    m_latency.report(report);
+}
+
+void VulkanContext::pollLatency()
+{
+    while (m_latency.pending())
+    {
+        uint64_t id = m_latency.oldest();
+        /* The frame being recorded has neither been submitted nor presented */
+        if (id == m_latencyFrame)
+            return;
+        if (m_extensions.presentWait)
+        {
+            if (m_extensions.waitForPresentKHR(m_device, m_swapchain, id + 1, 0) != VK_SUCCESS)
+                return;
+        }
+        else if (vkGetFenceStatus(m_device, m_frames[id % kFramesInFlight].fence) != VK_SUCCESS)
+            return;
+        m_latency.completeOldest();
+    }
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+#include "GLFW/glfw3.h"
+
+#include "AllocationTracker.h"
+#include "Benchmark.h"
+#include "FrameLatency.h"
+#include "ShaderSource.h"
+
+#define VK_CHECK(call)                                                                  \
+    do                                                                                  \
+    {                                                                                   \
+        VkResult vkCheckResult = (call);                                                \
+        if (vkCheckResult != VK_SUCCESS)                                                \
+            fatal("%s failed with VkResult %d (%s:%d)", #call, int(vkCheckResult), __FILE__, __LINE__); \
+    } while (false)
+
+struct VulkanBuffer
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocation allocation = nullptr;
+    /* Persistently mapped pointer for host visible buffers */
+    void* mapped = nullptr;
+    VkDeviceSize size = 0;
+};
+
+struct VulkanImage
+{
+    VkImage image = VK_NULL_HANDLE;
+    VmaAllocation allocation = nullptr;
+    /* View over all mip levels and layers */
+    VkImageView view = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent3D extent = {};
+    uint32_t mipLevels = 1;
+    uint32_t arrayLayers = 1;
+};
+
+/* Optional device extensions, enabled when the device supports them */
+struct VulkanDeviceExtensions
+{
+    bool pushDescriptor = false;
+    PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSetKHR = nullptr;
+    /* VK_EXT_graphics_pipeline_library together with VK_KHR_pipeline_library */
+    bool graphicsPipelineLibrary = false;
+    /* VK_KHR_present_wait together with VK_KHR_present_id */
+    bool presentWait = false;
+    PFN_vkWaitForPresentKHR waitForPresentKHR = nullptr;
+    /* VK_KHR_synchronization2, the device is Vulkan 1.2 so it comes as an extension */
+    bool synchronization2 = false;
+    PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2KHR = nullptr;
+};
+
+struct GraphicsPipelineDesc
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+    VkShaderModule vertexShader = VK_NULL_HANDLE;
+    VkShaderModule fragmentShader = VK_NULL_HANDLE;
+    /* Specialization constants of the fragment shader, the pointed to data has to outlive the desc */
+    const VkSpecializationInfo* fragmentSpecialization = nullptr;
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    bool depthTest = true;
+    bool depthWrite = true;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS;
+    /* Source alpha over destination on every color attachment */
+    bool alphaBlend = false;
+    uint32_t colorAttachmentCount = 1;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+/*
+ * The Vulkan create infos of a GraphicsPipelineDesc. `info` describes the complete pipeline,
+ * callers building pipeline libraries pick the parts they need. The pointers refer into the
+ * object itself, so it can neither be copied nor moved.
+ */
+struct GraphicsPipelineCreateInfo
+{
+    explicit GraphicsPipelineCreateInfo(const GraphicsPipelineDesc& desc);
+    GraphicsPipelineCreateInfo(const GraphicsPipelineCreateInfo&) = delete;
+    GraphicsPipelineCreateInfo& operator=(const GraphicsPipelineCreateInfo&) = delete;
+
+    /* Vertex stage first, the fragment stage is optional */
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    uint32_t stageCount = 0;
+    VkPipelineVertexInputStateCreateInfo vertexInput = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    VkPipelineViewportStateCreateInfo viewport = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    VkPipelineRasterizationStateCreateInfo rasterization = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    VkPipelineMultisampleStateCreateInfo multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    VkPipelineDepthStencilStateCreateInfo depthStencil = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+    VkPipelineColorBlendStateCreateInfo colorBlend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+};
+
+void cmdMemoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+void cmdImageBarrier(VkCommandBuffer cmd, VkImage image, VkImageAspectFlags aspect,
+                     VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkImageLayout oldLayout,
+                     VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkImageLayout newLayout);
+
+/* GPU timestamps with vkCmdWriteTimestamp, each frame in flight owns a range of the query pool */
+class VulkanProfiler
+{
+public:
+    static constexpr uint32_t kMaxZones = 32;
+
+    VulkanProfiler(VkDevice device, const VkPhysicalDeviceProperties& properties, uint32_t frameCount);
+    ~VulkanProfiler();
+
+    /* Called after the fence of the frame slot was waited on, the slot's results are available */
+    void beginFrame(VkCommandBuffer cmd, uint32_t slot, const FrameInfo& frame);
+    void begin(VkCommandBuffer cmd, const char* zone);
+    void end(VkCommandBuffer cmd);
+
+    void report(Report& report) const;
+    /* Measured times of a zone, nullptr before its first result */
+    const Statistics* zoneTimes(const char* zone) const;
+
+private:
+    struct ZoneRecord
+    {
+        uint32_t zone;
+        uint32_t query;
+    };
+
+    struct FrameQueries
+    {
+        ZoneRecord records[kMaxZones];
+        uint32_t recordCount = 0;
+        bool measured = false;
+    };
+
+    uint32_t zoneIndex(const char* zone);
+
+    VkDevice m_device;
+    VkQueryPool m_pool = VK_NULL_HANDLE;
+    double m_timestampPeriodMs;
+    std::vector<FrameQueries> m_frames;
+    uint32_t m_current = 0;
+    uint32_t m_open = UINT32_MAX;
+    const char* m_zoneNames[kMaxZones] = {};
+    Statistics m_zoneTimes[kMaxZones];
+    uint32_t m_zoneCount = 0;
+};
+
+class VulkanContext;
+
+struct VulkanUniformAllocation
+{
+    void* data;
+    uint32_t offset;
+};
+
+/*
+ * Per-frame uniform data suballocated from one persistently mapped buffer and bound with
+ * dynamic offsets. Every frame in flight owns a segment, it is reused after the context waited
+ * for the frame's fence.
+ */
+class VulkanUniformRing
+{
+public:
+    VulkanUniformRing(VulkanContext& context, VkDeviceSize segmentSize, uint32_t segmentCount);
+    ~VulkanUniformRing();
+
+    void beginFrame(uint32_t slot);
+    /* Flushes the frame's writes, a no-op on coherent memory */
+    void endFrame();
+
+    /* Aligned to minUniformBufferOffsetAlignment, the memory is valid until the end of the frame */
+    VulkanUniformAllocation allocate(VkDeviceSize size);
+
+    VkBuffer buffer() const { return m_buffer.buffer; }
+    VkDeviceSize alignment() const { return m_alignment; }
+    /* Bytes allocated in the current frame, including alignment padding */
+    VkDeviceSize used() const { return m_head - m_segmentBegin; }
+
+private:
+    VulkanContext& m_context;
+    VulkanBuffer m_buffer;
+    VkDeviceSize m_segmentSize;
+    VkDeviceSize m_alignment;
+    VkDeviceSize m_segmentBegin = 0;
+    VkDeviceSize m_head = 0;
+};
+
+/*
+ * Thin abstraction layer over the Vulkan boilerplate: instance, device, swapchain, frames in
+ * flight and resource helpers. Scenarios record into commandBuffer() between beginFrame() and
+ * endFrame() and have to leave the swapchain image in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, which
+ * the swapchain render pass does for them.
+ */
+class VulkanContext
+{
+public:
+    static constexpr uint32_t kFramesInFlight = 2;
+    /* Uniform ring segment of every frame in flight */
+    static constexpr VkDeviceSize kUniformRingSize = 16 * 1024 * 1024;
+
+    /*
+     * --present-mode immediate|mailbox|fifo|fifo-relaxed (default fifo) and --swapchain-images n
+     * (default 0, one more than the surface minimum), both fall back to what the surface supports
+     */
+    VulkanContext(GLFWwindow* window, const Options& options);
+    ~VulkanContext();
+
+    VulkanContext(const VulkanContext&) = delete;
+    VulkanContext& operator=(const VulkanContext&) = delete;
+
+    void beginFrame(const FrameInfo& frame);
+    void endFrame();
+    void waitIdle();
+
+    VkCommandBuffer commandBuffer() const { return m_frames[m_frameIndex].commandBuffer; }
+    /* Index of the current frame in flight, selects per frame resources */
+    uint32_t frameIndex() const { return m_frameIndex; }
+
+    VkInstance instance() const { return m_instance; }
+    VkPhysicalDevice physicalDevice() const { return m_physicalDevice; }
+    VkDevice device() const { return m_device; }
+    VkQueue queue() const { return m_queue; }
+    uint32_t queueFamily() const { return m_queueFamily; }
+    VmaAllocator allocator() const { return m_allocator; }
+    const VkPhysicalDeviceProperties& properties() const { return m_properties; }
+    /* The Vulkan 1.0 and 1.2 features enabled on the device */
+    const VkPhysicalDeviceFeatures& features() const { return m_features; }
+    const VkPhysicalDeviceVulkan12Features& vulkan12Features() const { return m_vulkan12Features; }
+    const VulkanDeviceExtensions& extensions() const { return m_extensions; }
+    VulkanProfiler& profiler() { return *m_profiler; }
+    VulkanUniformRing& uniformRing() { return *m_uniformRing; }
+    GLFWwindow* window() const { return m_window; }
+
+    VkExtent2D swapchainExtent() const { return m_swapchainExtent; }
+    VkFormat swapchainFormat() const { return m_swapchainFormat; }
+    VkImage swapchainImage() const { return m_swapchainImages[m_imageIndex]; }
+    VkFormat depthFormat() const { return m_depthFormat; }
+    /* Depth attachment of the swapchain pass, usable as a sampled image after the pass */
+    const VulkanImage& depthImage() const { return m_depthImage; }
+
+    /* Clears color and depth, the color attachment ends in PRESENT_SRC, depth in DEPTH_STENCIL_ATTACHMENT_OPTIMAL */
+    VkRenderPass swapchainRenderPass() const { return m_renderPass; }
+    void beginSwapchainPass(VkCommandBuffer cmd, const float clearColor[4]);
+    /* Sets a y-flipped viewport so clip space matches OpenGL, see perspective() */
+    void setViewport(VkCommandBuffer cmd, VkExtent2D extent) const;
+
+    VulkanBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags = 0);
+    /* Creates a device local buffer and fills it through a staging buffer */
+    VulkanBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const void* data);
+    void destroyBuffer(VulkanBuffer& buffer);
+
+    /* Also creates a view of every mip and layer, except for an `aspect` of 0 for images only transfers touch */
+    VulkanImage createImage(const VkImageCreateInfo& info, VkImageAspectFlags aspect, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO);
+    /* Fills mip 0 of every layer from tightly packed texels and leaves the image in SHADER_READ_ONLY_OPTIMAL */
+    void uploadImage(const VulkanImage& image, const void* data, VkDeviceSize size);
+    void destroyImage(VulkanImage& image);
+    VkImageView createImageView(VkImage image, VkImageViewType type, VkFormat format, VkImageAspectFlags aspect,
+                                uint32_t baseMip, uint32_t mipCount, uint32_t baseLayer = 0, uint32_t layerCount = 1);
+
+    VkShaderModule createShaderModule(const std::string& path, VkShaderStageFlagBits stage, const ShaderDefines& defines = {});
+    VkPipeline createComputePipeline(VkPipelineLayout layout, VkShaderModule shader);
+    VkPipeline createGraphicsPipeline(const GraphicsPipelineDesc& desc);
+
+    /* `bindingFlags` is empty or has one entry per binding, e.g. for descriptor indexing */
+    VkDescriptorSetLayout createDescriptorSetLayout(std::initializer_list<VkDescriptorSetLayoutBinding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0,
+                                                    std::initializer_list<VkDescriptorBindingFlags> bindingFlags = {});
+    VkPipelineLayout createPipelineLayout(std::initializer_list<VkDescriptorSetLayout> setLayouts, uint32_t pushConstantSize = 0);
+    VkDescriptorPool createDescriptorPool(uint32_t maxSets, std::initializer_list<VkDescriptorPoolSize> sizes, VkDescriptorPoolCreateFlags flags = 0);
+    VkDescriptorSet allocateDescriptorSet(VkDescriptorPool pool, VkDescriptorSetLayout layout);
+
+    /* Records commands into a one time command buffer and waits for their completion */
+    void immediateSubmit(const std::function<void(VkCommandBuffer)>& record);
+
+    void report(Report& report) const;
+
+private:
+    struct Frame
+    {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+    };
+
+    void createInstance();
+    void pickPhysicalDevice();
+    void createDevice();
+    void createSwapchain();
+    void destroySwapchain();
+    void recreateSwapchain();
+    /* Ends the pending frames that are on screen, or done on the GPU without present wait */
+    void pollLatency();
+
+    GLFWwindow* m_window;
+    VkInstance m_instance = VK_NULL_HANDLE;
+    VkDebugUtilsMessengerEXT m_debugMessenger = VK_NULL_HANDLE;
+    VkSurfaceKHR m_surface = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties m_properties = {};
+    VkPhysicalDeviceFeatures m_features = {};
+    VkPhysicalDeviceVulkan12Features m_vulkan12Features = {};
+    VulkanDeviceExtensions m_extensions;
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_queueFamily = 0;
+    VmaAllocator m_allocator = nullptr;
+
+    VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    /* 0 picks one more than the surface minimum */
+    uint32_t m_requestedImageCount = 0;
+    VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+    VkFormat m_swapchainFormat = VK_FORMAT_UNDEFINED;
+    VkExtent2D m_swapchainExtent = {};
+    std::vector<VkImage> m_swapchainImages;
+    std::vector<VkImageView> m_swapchainViews;
+    std::vector<VkFramebuffer> m_framebuffers;
+    /* Per swapchain image, the image can only be reacquired after its present consumed the semaphore */
+    std::vector<VkSemaphore> m_renderFinished;
+    VkFormat m_depthFormat = VK_FORMAT_D32_SFLOAT;
+    VulkanImage m_depthImage;
+    VkRenderPass m_renderPass = VK_NULL_HANDLE;
+
+    Frame m_frames[kFramesInFlight];
+    uint32_t m_frameIndex = 0;
+    uint32_t m_imageIndex = 0;
+    VkCommandPool m_uploadPool = VK_NULL_HANDLE;
+    std::unique_ptr<VulkanProfiler> m_profiler;
+    std::unique_ptr<VulkanUniformRing> m_uniformRing;
+    FrameLatency m_latency;
+    /* Present ids are the latency ids plus one, 0 is not a valid present id */
+    uint64_t m_latencyFrame = 0;
+};
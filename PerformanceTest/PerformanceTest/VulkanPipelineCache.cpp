@@ -0,0 +1,366 @@
+#include "VulkanPipelineCache.h"
+
+namespace
+{
+    enum LibraryPart : uint32_t
+    {
+        VertexInput,
+        PreRasterization,
+        FragmentShader,
+        FragmentOutput,
+        kLibraryPartCount
+    };
+
+    struct Hasher
+    {
+        uint64_t value = 14695981039346656037ull;
+
+        /* Only for fields without padding bytes */
+        template <typename T>
+        void add(const T& field)
+        {
+            addBytes(&field, sizeof(T));
+        }
+
+        void addBytes(const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i)
+                value = (value ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    /* Every field of GraphicsPipelineDesc belongs to at least one part */
+    uint64_t hashLibraryPart(uint32_t part, const GraphicsPipelineDesc& desc)
+    {
+        Hasher hasher;
+        hasher.add(part);
+        switch (part)
+        {
+        case VertexInput:
+            hasher.add(uint32_t(desc.vertexBindings.size()));
+            for (const VkVertexInputBindingDescription& binding : desc.vertexBindings)
+                hasher.add(binding);
+            hasher.add(uint32_t(desc.vertexAttributes.size()));
+            for (const VkVertexInputAttributeDescription& attribute : desc.vertexAttributes)
+                hasher.add(attribute);
+            hasher.add(desc.topology);
+            break;
+        case PreRasterization:
+            hasher.add(desc.layout);
+            hasher.add(desc.renderPass);
+            hasher.add(desc.subpass);
+            hasher.add(desc.vertexShader);
+            hasher.add(desc.cullMode);
+            break;
+        case FragmentShader:
+            hasher.add(desc.layout);
+            hasher.add(desc.renderPass);
+            hasher.add(desc.subpass);
+            hasher.add(desc.fragmentShader);
+            if (const VkSpecializationInfo* specialization = desc.fragmentSpecialization)
+            {
+                for (uint32_t i = 0; i < specialization->mapEntryCount; ++i)
+                    hasher.add(specialization->pMapEntries[i]);
+                hasher.addBytes(specialization->pData, specialization->dataSize);
+            }
+            hasher.add(desc.depthTest);
+            hasher.add(desc.depthWrite);
+            hasher.add(desc.depthCompare);
+            hasher.add(desc.samples);
+            break;
+        case FragmentOutput:
+            hasher.add(desc.renderPass);
+            hasher.add(desc.subpass);
+            hasher.add(desc.alphaBlend);
+            hasher.add(desc.colorAttachmentCount);
+            hasher.add(desc.samples);
+            break;
+        }
+        return hasher.value;
+    }
+}
+
+uint64_t hashGraphicsPipelineDesc(const GraphicsPipelineDesc& desc)
+{
+    Hasher hasher;
+    for (uint32_t part = 0; part < kLibraryPartCount; ++part)
+        hasher.add(hashLibraryPart(part, desc));
+    return hasher.value;
+}
+
+VulkanPipelineCache::VulkanPipelineCache(VulkanContext& context, uint32_t threadCount, bool useLibraries)
+    : m_context(context)
+    , m_useLibraries(useLibraries && threadCount > 0 && context.extensions().graphicsPipelineLibrary)
+{
+    VkPipelineCacheCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    VK_CHECK(vkCreatePipelineCache(m_context.device(), &info, vulkanHostAllocator(), &m_cache));
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_workers.emplace_back([this] { workerLoop(); });
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_queue.clear();
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+
+    VkDevice device = m_context.device();
+    for (auto& entry : m_entries)
+    {
+        vkDestroyPipeline(device, entry.second->linked.load(), vulkanHostAllocator());
+        vkDestroyPipeline(device, entry.second->optimized.load(), vulkanHostAllocator());
+    }
+    for (auto& library : m_libraries)
+        vkDestroyPipeline(device, library.second, vulkanHostAllocator());
+    vkDestroyPipelineCache(device, m_cache, vulkanHostAllocator());
+}
+
+VkPipeline VulkanPipelineCache::get(const GraphicsPipelineDesc& desc, VkPipeline fallback)
+{
+    uint64_t hash = hashGraphicsPipelineDesc(desc);
+    auto found = m_entries.find(hash);
+    if (found == m_entries.end())
+    {
+        ++m_counters.misses;
+        std::unique_ptr<Entry> entry = std::make_unique<Entry>();
+        entry->desc = desc;
+        if (const VkSpecializationInfo* specialization = desc.fragmentSpecialization)
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(specialization->pData);
+            entry->specializationEntries.assign(specialization->pMapEntries, specialization->pMapEntries + specialization->mapEntryCount);
+            entry->specializationData.assign(data, data + specialization->dataSize);
+            entry->specialization = *specialization;
+            entry->specialization.pMapEntries = entry->specializationEntries.data();
+            entry->specialization.pData = entry->specializationData.data();
+            entry->desc.fragmentSpecialization = &entry->specialization;
+        }
+        found = m_entries.emplace(hash, std::move(entry)).first;
+        request(*found->second);
+    }
+
+    Entry& entry = *found->second;
+    VkPipeline pipeline = entry.optimized.load(std::memory_order_acquire);
+    if (!pipeline)
+        pipeline = entry.linked.load(std::memory_order_acquire);
+    if (!pipeline)
+    {
+        ++m_counters.fallbacks;
+        return fallback;
+    }
+
+    if (!entry.recorded)
+    {
+        entry.recorded = true;
+        m_compileTimes.add(entry.compileMs);
+        m_latencies.add(entry.requested.elapsedMs());
+    }
+    ++m_counters.hits;
+    return pipeline;
+}
+
+void VulkanPipelineCache::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [&] { return m_pending == 0; });
+}
+
+void VulkanPipelineCache::request(Entry& entry)
+{
+    if (m_workers.empty())
+    {
+        compile(entry);
+        return;
+    }
+
+    if (m_useLibraries)
+    {
+        VkPipeline libraries[kLibraryPartCount];
+        bool complete = true;
+        for (uint32_t part = 0; part < kLibraryPartCount; ++part)
+        {
+            libraries[part] = library(part, entry.desc, false);
+            complete = complete && libraries[part] != VK_NULL_HANDLE;
+        }
+        if (complete)
+        {
+            Timer timer;
+            VkPipeline linked = link(entry.desc, libraries, false);
+            entry.compileMs = timer.elapsedMs();
+            entry.linked.store(linked, std::memory_order_release);
+            ++m_counters.fastLinks;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(&entry);
+        ++m_pending;
+    }
+    m_wake.notify_one();
+}
+
+void VulkanPipelineCache::compile(Entry& entry)
+{
+    Timer timer;
+    if (!m_useLibraries)
+    {
+        GraphicsPipelineCreateInfo state(entry.desc);
+        VkPipeline pipeline;
+        VK_CHECK(vkCreateGraphicsPipelines(m_context.device(), m_cache, 1, &state.info, vulkanHostAllocator(), &pipeline));
+        entry.compileMs = timer.elapsedMs();
+        entry.optimized.store(pipeline, std::memory_order_release);
+        return;
+    }
+
+    VkPipeline libraries[kLibraryPartCount];
+    for (uint32_t part = 0; part < kLibraryPartCount; ++part)
+        libraries[part] = library(part, entry.desc, true);
+
+    /* The render thread linked it already if all parts existed at the miss */
+    if (!entry.linked.load(std::memory_order_relaxed))
+    {
+        VkPipeline linked = link(entry.desc, libraries, false);
+        entry.compileMs = timer.elapsedMs();
+        entry.linked.store(linked, std::memory_order_release);
+    }
+    entry.optimized.store(link(entry.desc, libraries, true), std::memory_order_release);
+}
+
+void VulkanPipelineCache::workerLoop()
+{
+    for (;;)
+    {
+        Entry* entry;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_quit || !m_queue.empty(); });
+            if (m_quit)
+                return;
+            entry = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        compile(*entry);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pending;
+        }
+        m_idle.notify_all();
+    }
+}
+
+VkPipeline VulkanPipelineCache::library(uint32_t part, const GraphicsPipelineDesc& desc, bool create)
+{
+    uint64_t hash = hashLibraryPart(part, desc);
+    {
+        std::lock_guard<std::mutex> lock(m_libraryMutex);
+        auto found = m_libraries.find(hash);
+        if (found != m_libraries.end())
+            return found->second;
+    }
+    if (!create)
+        return VK_NULL_HANDLE;
+
+    /* Built outside the lock, another worker may have built the same part in the meantime */
+    VkPipeline pipeline = createLibrary(part, desc);
+    std::lock_guard<std::mutex> lock(m_libraryMutex);
+    auto inserted = m_libraries.emplace(hash, pipeline);
+    if (!inserted.second)
+        vkDestroyPipeline(m_context.device(), pipeline, vulkanHostAllocator());
+    return inserted.first->second;
+}
+
+VkPipeline VulkanPipelineCache::createLibrary(uint32_t part, const GraphicsPipelineDesc& desc)
+{
+    GraphicsPipelineCreateInfo state(desc);
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT };
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    info.pNext = &libraryInfo;
+    info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    switch (part)
+    {
+    case VertexInput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        info.pVertexInputState = &state.vertexInput;
+        info.pInputAssemblyState = &state.inputAssembly;
+        break;
+    case PreRasterization:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        info.stageCount = 1;
+        info.pStages = &state.stages[0];
+        info.pViewportState = &state.viewport;
+        info.pRasterizationState = &state.rasterization;
+        info.pDynamicState = &state.dynamic;
+        info.layout = desc.layout;
+        info.renderPass = desc.renderPass;
+        info.subpass = desc.subpass;
+        break;
+    case FragmentShader:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        info.stageCount = state.stageCount - 1;
+        info.pStages = info.stageCount ? &state.stages[1] : nullptr;
+        info.pMultisampleState = &state.multisample;
+        info.pDepthStencilState = &state.depthStencil;
+        info.layout = desc.layout;
+        info.renderPass = desc.renderPass;
+        info.subpass = desc.subpass;
+        break;
+    case FragmentOutput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        info.pMultisampleState = &state.multisample;
+        info.pColorBlendState = &state.colorBlend;
+        info.renderPass = desc.renderPass;
+        info.subpass = desc.subpass;
+        break;
+    }
+
+    VkPipeline pipeline;
+    VK_CHECK(vkCreateGraphicsPipelines(m_context.device(), m_cache, 1, &info, vulkanHostAllocator(), &pipeline));
+    return pipeline;
+}
+
+VkPipeline VulkanPipelineCache::link(const GraphicsPipelineDesc& desc, const VkPipeline* libraries, bool optimize)
+{
+    VkPipelineLibraryCreateInfoKHR linkInfo = { VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR };
+    linkInfo.libraryCount = kLibraryPartCount;
+    linkInfo.pLibraries = libraries;
+
+    VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    info.pNext = &linkInfo;
+    info.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    info.layout = desc.layout;
+
+    VkPipeline pipeline;
+    VK_CHECK(vkCreateGraphicsPipelines(m_context.device(), m_cache, 1, &info, vulkanHostAllocator(), &pipeline));
+    return pipeline;
+}
+
+void VulkanPipelineCache::report(Report& report) const
+{
+    report.addText("pipeline compile", m_workers.empty() ? "render thread" : m_useLibraries ? "workers, pipeline libraries" : "workers");
+    report.addValue("pipeline compile threads", double(m_workers.size()), "");
+    report.addValue("pipelines", double(m_entries.size()), "");
+    {
+        std::lock_guard<std::mutex> lock(m_libraryMutex);
+        report.addValue("pipeline libraries", double(m_libraries.size()), "");
+    }
+    report.addValue("pipeline misses", double(m_counters.misses), "");
+    report.addValue("pipeline fast links", double(m_counters.fastLinks), "");
+    report.addValue("pipeline fallbacks", double(m_counters.fallbacks), "");
+    report.addStatistics("pipeline compile", m_compileTimes, "ms");
+    report.addStatistics("pipeline latency", m_latencies, "ms");
+
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(m_context.device(), m_cache, &dataSize, nullptr);
+    report.addValue("pipeline cache data", double(dataSize) / 1024.0, "KiB");
+}
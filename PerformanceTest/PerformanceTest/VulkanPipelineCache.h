@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Timer.h"
+#include "VulkanContext.h"
+
+/* FNV-1a over every field of the description, shader modules, layouts and render passes by handle */
+uint64_t hashGraphicsPipelineDesc(const GraphicsPipelineDesc& desc);
+
+/*
+ * Graphics pipelines created on demand, keyed by hashGraphicsPipelineDesc(). A miss does not
+ * block the render thread: worker threads compile the pipeline into a shared VkPipelineCache
+ * and get() returns the caller's fallback until it is ready.
+ *
+ * With VK_EXT_graphics_pipeline_library the workers build the four library parts (vertex
+ * input, pre-rasterization shaders, fragment shader, fragment output) separately, link an
+ * unoptimized pipeline from them as soon as they exist and replace it with a link time optimized
+ * one afterwards. A miss whose parts were all built for earlier pipelines, e.g. a known material
+ * with a new blend state, is linked on the render thread right away, which is cheap enough to
+ * not need the fallback at all.
+ */
+class VulkanPipelineCache
+{
+public:
+    struct Counters
+    {
+        /* get() calls answered with a compiled pipeline */
+        uint64_t hits = 0;
+        /* get() calls answered with the fallback */
+        uint64_t fallbacks = 0;
+        /* Descriptions seen for the first time */
+        uint64_t misses = 0;
+        /* Misses linked from existing libraries on the render thread */
+        uint64_t fastLinks = 0;
+    };
+
+    /* threadCount 0 compiles whole pipelines on the render thread, blocking it like a plain vkCreateGraphicsPipelines */
+    VulkanPipelineCache(VulkanContext& context, uint32_t threadCount, bool useLibraries);
+    /* The pipelines must not be in use by the GPU anymore */
+    ~VulkanPipelineCache();
+
+    VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+    VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+    /* Render thread only, the shader modules and layouts of `desc` have to outlive the cache */
+    VkPipeline get(const GraphicsPipelineDesc& desc, VkPipeline fallback);
+    /* Blocks until the workers finished every requested pipeline */
+    void waitIdle();
+
+    uint32_t threadCount() const { return uint32_t(m_workers.size()); }
+    bool usesLibraries() const { return m_useLibraries; }
+    const Counters& counters() const { return m_counters; }
+
+    void report(Report& report) const;
+
+private:
+    struct Entry
+    {
+        /* The workers compile it long after get() returned, so it points at the copies below */
+        GraphicsPipelineDesc desc;
+        VkSpecializationInfo specialization = {};
+        std::vector<VkSpecializationMapEntry> specializationEntries;
+        std::vector<uint8_t> specializationData;
+        /* Linked from libraries without link time optimization, used until `optimized` is ready */
+        std::atomic<VkPipeline> linked{ VK_NULL_HANDLE };
+        std::atomic<VkPipeline> optimized{ VK_NULL_HANDLE };
+        /* Time until the first usable pipeline, written before that pipeline is published */
+        double compileMs = 0.0;
+        /* Started by the miss, read when the render thread first gets a pipeline back */
+        Timer requested;
+        bool recorded = false;
+    };
+
+    void request(Entry& entry);
+    void compile(Entry& entry);
+    void workerLoop();
+
+    /* Looks up a library part by its hash and builds it if `create` is set */
+    VkPipeline library(uint32_t part, const GraphicsPipelineDesc& desc, bool create);
+    VkPipeline createLibrary(uint32_t part, const GraphicsPipelineDesc& desc);
+    VkPipeline link(const GraphicsPipelineDesc& desc, const VkPipeline* libraries, bool optimize);
+
+    VulkanContext& m_context;
+    bool m_useLibraries;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    /* Touched by the render thread only */
+    std::unordered_map<uint64_t, std::unique_ptr<Entry>> m_entries;
+    Counters m_counters;
+    Statistics m_compileTimes;
+    Statistics m_latencies;
+
+    mutable std::mutex m_libraryMutex;
+    std::unordered_map<uint64_t, VkPipeline> m_libraries;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Entry*> m_queue;
+    uint32_t m_pending = 0;
+    bool m_quit = false;
+};
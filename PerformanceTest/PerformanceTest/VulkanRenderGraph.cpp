@@ -0,0 +1,208 @@
+#include "VulkanRenderGraph.h"
+
+#include <cstdio>
+
+namespace
+{
+    struct AccessInfo
+    {
+        VkPipelineStageFlags2 stages;
+        VkAccessFlags2 accesses;
+        /* What vkCmdPipelineBarrier knows of the accesses */
+        VkAccessFlags legacyAccesses;
+    };
+
+    /* Indexed by RenderGraphAccess */
+    const AccessInfo kAccessInfos[] = {
+        { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+          VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT },
+        { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+          VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT },
+        { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_SHADER_READ_BIT },
+        { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_SHADER_READ_BIT },
+        { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_ACCESS_SHADER_READ_BIT },
+        { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_ACCESS_SHADER_READ_BIT },
+        { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT },
+        { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT },
+    };
+    static_assert(sizeof(kAccessInfos) / sizeof(kAccessInfos[0]) == uint32_t(RenderGraphAccess::kCount), "An AccessInfo per RenderGraphAccess");
+
+    constexpr VkAccessFlags2 kWriteAccesses =
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    constexpr VkAccessFlags kLegacyWriteAccesses =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    AccessInfo accessInfo(uint32_t accesses)
+    {
+        AccessInfo info = { 0, 0, 0 };
+        for (uint32_t a = 0; a < uint32_t(RenderGraphAccess::kCount); ++a)
+            if (accesses & (1u << a))
+            {
+                info.stages |= kAccessInfos[a].stages;
+                info.accesses |= kAccessInfos[a].accesses;
+                info.legacyAccesses |= kAccessInfos[a].legacyAccesses;
+            }
+        return info;
+    }
+
+    /* The stages used here have the same bits in both versions, none is TOP_OF_PIPE as a source */
+    VkPipelineStageFlags legacyStages(VkPipelineStageFlags2 stages)
+    {
+        return stages ? VkPipelineStageFlags(stages) : VkPipelineStageFlags(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    }
+}
+
+VulkanRenderGraph::VulkanRenderGraph(VulkanContext& context, RenderTargetPooling pooling, RenderGraphBarriers barriers)
+    : RenderGraph(barriers)
+    , m_context(context)
+    , m_pool(context, pooling, true)
+{
+    if (!m_context.extensions().synchronization2)
+        std::printf("render graph: VK_KHR_synchronization2 is not supported, falling back to vkCmdPipelineBarrier\n");
+}
+
+uint32_t VulkanRenderGraph::addPass(const char* name, std::function<void(VkCommandBuffer)> callback)
+{
+    /* Drops the callbacks of the passes before the last reset() */
+    m_callbacks.resize(m_passes.size());
+    m_callbacks.push_back(std::move(callback));
+    return RenderGraph::addPass(name);
+}
+
+VkImageLayout VulkanRenderGraph::imageLayout(RenderGraphLayout layout)
+{
+    switch (layout)
+    {
+    case RenderGraphLayout::Undefined:
+        return VK_IMAGE_LAYOUT_UNDEFINED;
+    case RenderGraphLayout::ColorAttachment:
+        return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    case RenderGraphLayout::DepthAttachment:
+        return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    case RenderGraphLayout::ShaderRead:
+        return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    case RenderGraphLayout::General:
+        return VK_IMAGE_LAYOUT_GENERAL;
+    }
+    return VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+void VulkanRenderGraph::recordBarriers(VkCommandBuffer cmd, const Pass& pass)
+{
+    const bool full = m_barriers == RenderGraphBarriers::Full;
+    VkMemoryBarrier2 memory = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    VkMemoryBarrier legacyMemory = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    VkPipelineStageFlags legacySrcStages = 0;
+    VkPipelineStageFlags legacyDstStages = 0;
+    bool buffers = full;
+    if (full)
+    {
+        memory.srcStageMask = memory.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        memory.srcAccessMask = memory.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+        legacyMemory.srcAccessMask = legacyMemory.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        legacySrcStages = legacyDstStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    m_imageBarriers.clear();
+    m_legacyImageBarriers.clear();
+    for (uint32_t b = pass.firstBarrier; b < pass.firstBarrier + pass.barrierCount; ++b)
+    {
+        const Barrier& barrier = m_barrierList[b];
+        AccessInfo src = accessInfo(barrier.srcAccesses);
+        AccessInfo dst = accessInfo(barrier.dstAccesses);
+        legacySrcStages |= legacyStages(src.stages);
+        legacyDstStages |= VkPipelineStageFlags(dst.stages);
+        if (m_resources[barrier.resource].imported)
+        {
+            if (full)
+                continue;
+            buffers = true;
+            memory.srcStageMask |= src.stages;
+            memory.srcAccessMask |= src.accesses & kWriteAccesses;
+            memory.dstStageMask |= dst.stages;
+            memory.dstAccessMask |= dst.accesses;
+            legacyMemory.srcAccessMask |= src.legacyAccesses & kLegacyWriteAccesses;
+            legacyMemory.dstAccessMask |= dst.legacyAccesses;
+            continue;
+        }
+        if (full && barrier.oldLayout == barrier.newLayout)
+            continue;
+
+        const VulkanImage& texture = image(barrier.resource);
+        VkImageAspectFlags aspect = isDepthFormat(m_resources[barrier.resource].desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        VkImageMemoryBarrier2 imageBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        imageBarrier.srcStageMask = full ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT : src.stages;
+        imageBarrier.srcAccessMask = full ? VK_ACCESS_2_MEMORY_WRITE_BIT : src.accesses & kWriteAccesses;
+        imageBarrier.dstStageMask = full ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT : dst.stages;
+        imageBarrier.dstAccessMask = full ? VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT : dst.accesses;
+        imageBarrier.oldLayout = imageLayout(barrier.oldLayout);
+        imageBarrier.newLayout = imageLayout(barrier.newLayout);
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = texture.image;
+        imageBarrier.subresourceRange = { aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+        m_imageBarriers.push_back(imageBarrier);
+
+        VkImageMemoryBarrier legacyBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        legacyBarrier.srcAccessMask = full ? VkAccessFlags(VK_ACCESS_MEMORY_WRITE_BIT) : src.legacyAccesses & kLegacyWriteAccesses;
+        legacyBarrier.dstAccessMask = full ? VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT : dst.legacyAccesses;
+        legacyBarrier.oldLayout = imageBarrier.oldLayout;
+        legacyBarrier.newLayout = imageBarrier.newLayout;
+        legacyBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        legacyBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        legacyBarrier.image = texture.image;
+        legacyBarrier.subresourceRange = imageBarrier.subresourceRange;
+        m_legacyImageBarriers.push_back(legacyBarrier);
+    }
+    if (!buffers && m_imageBarriers.empty())
+        return;
+
+    if (m_context.extensions().synchronization2)
+    {
+        VkDependencyInfo dependency = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dependency.memoryBarrierCount = buffers ? 1 : 0;
+        dependency.pMemoryBarriers = &memory;
+        dependency.imageMemoryBarrierCount = uint32_t(m_imageBarriers.size());
+        dependency.pImageMemoryBarriers = m_imageBarriers.data();
+        m_context.extensions().cmdPipelineBarrier2KHR(cmd, &dependency);
+    }
+    else
+    {
+        vkCmdPipelineBarrier(cmd, legacyStages(legacySrcStages), legacyDstStages, 0, buffers ? 1 : 0, &legacyMemory, 0, nullptr,
+                             uint32_t(m_legacyImageBarriers.size()), m_legacyImageBarriers.data());
+    }
+}
+
+void VulkanRenderGraph::execute(VkCommandBuffer cmd)
+{
+    for (uint32_t p : m_order)
+    {
+        const Pass& pass = m_passes[p];
+        recordBarriers(cmd, pass);
+
+        bool attachments = !pass.ownRenderPass && (pass.colorCount > 0 || pass.depth != kNoResource);
+        if (attachments)
+        {
+            uint32_t colors[kMaxColorAttachments];
+            for (uint32_t i = 0; i < pass.colorCount; ++i)
+                colors[i] = target(pass.colors[i]);
+            uint32_t depth = pass.depth == kNoResource ? RenderTargetPool::kNoTarget : target(pass.depth);
+            m_pool.beginPass(cmd, colors, pass.colorCount, depth, pass.clearColor, loadMask(pass));
+        }
+        m_callbacks[p](cmd);
+        if (attachments)
+            m_pool.endPass(cmd);
+    }
+}
+
+void VulkanRenderGraph::report(Report& report)
+{
+    RenderGraph::report(report);
+    uint32_t calls = 0;
+    for (uint32_t p : m_order)
+        calls += m_passes[p].barrierCount > 0 || m_barriers == RenderGraphBarriers::Full ? 1 : 0;
+    report.addText("synchronization2", m_context.extensions().synchronization2 ? "supported" : "not supported");
+    report.addValue("pipeline barrier calls per frame", double(calls), "");
+}
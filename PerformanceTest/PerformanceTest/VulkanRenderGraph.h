@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "RenderGraph.h"
+#include "VulkanContext.h"
+#include "VulkanRenderTargetPool.h"
+
+/*
+ * Vulkan execution of a RenderGraph. The planned barriers of a pass become one
+ * vkCmdPipelineBarrier2KHR: an image barrier per texture, with the layout transition, and a single
+ * memory barrier for all buffers. Stages and accesses are only those of the accesses involved,
+ * the source accesses only the writes. Without VK_KHR_synchronization2 the same barriers go
+ * through vkCmdPipelineBarrier with the 32 bit masks.
+ *
+ * The pool's render passes leave layouts to the graph, attachments are in their attachment
+ * layout when the render pass begins. --barriers full waits for all commands and makes all
+ * memory visible before every pass, it still transitions the layouts.
+ */
+class VulkanRenderGraph : public RenderGraph
+{
+public:
+    VulkanRenderGraph(VulkanContext& context, RenderTargetPooling pooling, RenderGraphBarriers barriers);
+
+    /* The callback records inside the render pass of the attachments if the pass has any and no render pass of its own, with the viewport set */
+    uint32_t addPass(const char* name, std::function<void(VkCommandBuffer)> callback);
+    void execute(VkCommandBuffer cmd);
+
+    VulkanRenderTargetPool& targets() { return m_pool; }
+    const VulkanImage& image(uint32_t texture) const { return m_pool.image(target(texture)); }
+
+    /* VkImageLayout of a layout the graph plans, descriptors of sampled textures use ShaderRead */
+    static VkImageLayout imageLayout(RenderGraphLayout layout);
+
+    void report(Report& report) override;
+
+private:
+    RenderTargetPool& pool() override { return m_pool; }
+    void recordBarriers(VkCommandBuffer cmd, const Pass& pass);
+
+    VulkanContext& m_context;
+    VulkanRenderTargetPool m_pool;
+    std::vector<std::function<void(VkCommandBuffer)>> m_callbacks;
+    std::vector<VkImageMemoryBarrier2> m_imageBarriers;
+    std::vector<VkImageMemoryBarrier> m_legacyImageBarriers;
+};
@@ -0,0 +1,379 @@
+#include "VulkanRenderTargetPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+VulkanRenderTargetPool::VulkanRenderTargetPool(VulkanContext& context, RenderTargetPooling pooling, bool externalLayouts)
+    : RenderTargetPool(pooling)
+    , m_context(context)
+    , m_externalLayouts(externalLayouts)
+{
+    VkPhysicalDeviceMemoryProperties memory;
+    vkGetPhysicalDeviceMemoryProperties(m_context.physicalDevice(), &memory);
+    for (uint32_t i = 0; i < memory.memoryTypeCount; ++i)
+        if (memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+            m_lazyMemory = true;
+    if (!m_lazyMemory)
+        std::printf("render targets: lazily allocated memory is not supported, transient targets fall back to device local memory\n");
+}
+
+VulkanRenderTargetPool::~VulkanRenderTargetPool()
+{
+    release();
+    for (const RenderPass& renderPass : m_renderPasses)
+        vkDestroyRenderPass(m_context.device(), renderPass.renderPass, vulkanHostAllocator());
+}
+
+VkFormat VulkanRenderTargetPool::format(RenderTargetFormat format)
+{
+    switch (format)
+    {
+    case RenderTargetFormat::RGBA8:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    case RenderTargetFormat::RGBA16F:
+        return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case RenderTargetFormat::R11G11B10F:
+        return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+    case RenderTargetFormat::Depth32F:
+        return VK_FORMAT_D32_SFLOAT;
+    }
+    return VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+VkRenderPass VulkanRenderTargetPool::renderPass(std::initializer_list<RenderTargetDesc> colors, const RenderTargetDesc* depth)
+{
+    if (colors.size() > kMaxColors)
+        fatal("Render pass with %zu color attachments, at most %u are supported", colors.size(), kMaxColors);
+
+    AttachmentKey attachments[kMaxColors + 1];
+    uint32_t count = 0;
+    for (const RenderTargetDesc& color : colors)
+        attachments[count++] = { color.format, color.samples, color.transient, false };
+    if (depth)
+        attachments[count] = { depth->format, depth->samples, depth->transient, false };
+    return findRenderPass(attachments, uint32_t(colors.size()), depth != nullptr);
+}
+
+VkRenderPass VulkanRenderTargetPool::findRenderPass(const AttachmentKey* attachments, uint32_t colorCount, bool depth)
+{
+    uint32_t count = colorCount + (depth ? 1 : 0);
+    for (const RenderPass& renderPass : m_renderPasses)
+        if (renderPass.colorCount == colorCount && renderPass.depth == depth &&
+            std::equal(attachments, attachments + count, renderPass.attachments))
+            return renderPass.renderPass;
+
+    VkAttachmentDescription descriptions[kMaxColors + 1] = {};
+    VkAttachmentReference colorReferences[kMaxColors];
+    VkAttachmentReference depthReference = { colorCount, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const AttachmentKey& key = attachments[i];
+        bool isDepth = i == colorCount;
+        VkImageLayout attachmentLayout = isDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkAttachmentDescription& description = descriptions[i];
+        description.format = format(key.format);
+        description.samples = VkSampleCountFlagBits(key.samples);
+        description.loadOp = key.load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        description.storeOp = key.transient ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        if (m_externalLayouts)
+        {
+            description.initialLayout = attachmentLayout;
+            description.finalLayout = attachmentLayout;
+        }
+        else
+        {
+            /* A loaded attachment is where the pass before left it */
+            description.initialLayout = key.load ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+            description.finalLayout = key.transient ? attachmentLayout : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        if (!isDepth)
+            colorReferences[i] = { i, attachmentLayout };
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = colorCount;
+    subpass.pColorAttachments = colorReferences;
+    subpass.pDepthStencilAttachment = depth ? &depthReference : nullptr;
+
+    const VkPipelineStageFlags attachmentStages =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    const VkAccessFlags attachmentWrites = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    /* Earlier attachment writes and sampled reads of the same memory, aliased or from the frame before, come first */
+    VkSubpassDependency dependencies[2] = {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = attachmentStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[0].srcAccessMask = attachmentWrites;
+    dependencies[0].dstStageMask = attachmentStages;
+    dependencies[0].dstAccessMask = attachmentWrites | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    /* The results are sampled by later passes */
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = attachmentStages;
+    dependencies[1].srcAccessMask = attachmentWrites;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    info.attachmentCount = count;
+    info.pAttachments = descriptions;
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+    info.dependencyCount = m_externalLayouts ? 0 : 2;
+    info.pDependencies = dependencies;
+
+    RenderPass renderPass = {};
+    std::copy(attachments, attachments + count, renderPass.attachments);
+    renderPass.colorCount = colorCount;
+    renderPass.depth = depth;
+    VK_CHECK(vkCreateRenderPass(m_context.device(), &info, vulkanHostAllocator(), &renderPass.renderPass));
+    m_renderPasses.push_back(renderPass);
+    return renderPass.renderPass;
+}
+
+void VulkanRenderTargetPool::beginPass(VkCommandBuffer cmd, std::initializer_list<uint32_t> colors, uint32_t depth, const float clearColor[4])
+{
+    beginPass(cmd, colors.begin(), uint32_t(colors.size()), depth, clearColor, 0);
+}
+
+void VulkanRenderTargetPool::beginPass(VkCommandBuffer cmd, const uint32_t* colors, uint32_t colorCount, uint32_t depth, const float clearColor[4],
+                                       uint32_t loadMask)
+{
+    if (colorCount > kMaxColors)
+        fatal("Render pass with %u color attachments, at most %u are supported", colorCount, kMaxColors);
+
+    AttachmentKey attachments[kMaxColors + 1];
+    Framebuffer key = {};
+    VkClearValue clearValues[kMaxColors + 1] = {};
+    for (uint32_t i = 0; i < colorCount; ++i)
+    {
+        const RenderTargetDesc& target = desc(colors[i]);
+        attachments[key.viewCount] = { target.format, target.samples, target.transient, (loadMask & (1u << i)) != 0 };
+        std::memcpy(clearValues[key.viewCount].color.float32, clearColor, sizeof(float) * 4);
+        key.views[key.viewCount++] = image(colors[i]).view;
+    }
+    if (depth != kNoTarget)
+    {
+        const RenderTargetDesc& target = desc(depth);
+        attachments[key.viewCount] = { target.format, target.samples, target.transient, (loadMask & (1u << colorCount)) != 0 };
+        clearValues[key.viewCount].depthStencil = { 1.0f, 0 };
+        key.views[key.viewCount++] = image(depth).view;
+    }
+    key.renderPass = findRenderPass(attachments, colorCount, depth != kNoTarget);
+
+    const RenderTargetDesc& size = desc(colorCount > 0 ? colors[0] : depth);
+    VkExtent2D extent = { size.width, size.height };
+    for (const Framebuffer& framebuffer : m_framebuffers)
+        if (framebuffer.renderPass == key.renderPass && framebuffer.viewCount == key.viewCount &&
+            std::equal(key.views, key.views + key.viewCount, framebuffer.views))
+            key.framebuffer = framebuffer.framebuffer;
+    if (!key.framebuffer)
+    {
+        VkFramebufferCreateInfo info = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        info.renderPass = key.renderPass;
+        info.attachmentCount = key.viewCount;
+        info.pAttachments = key.views;
+        info.width = extent.width;
+        info.height = extent.height;
+        info.layers = 1;
+        VK_CHECK(vkCreateFramebuffer(m_context.device(), &info, vulkanHostAllocator(), &key.framebuffer));
+        m_framebuffers.push_back(key);
+    }
+
+    VkRenderPassBeginInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    info.renderPass = key.renderPass;
+    info.framebuffer = key.framebuffer;
+    info.renderArea.extent = extent;
+    info.clearValueCount = key.viewCount;
+    info.pClearValues = clearValues;
+    vkCmdBeginRenderPass(cmd, &info, VK_SUBPASS_CONTENTS_INLINE);
+    m_context.setViewport(cmd, extent);
+}
+
+void VulkanRenderTargetPool::endPass(VkCommandBuffer cmd)
+{
+    vkCmdEndRenderPass(cmd);
+}
+
+bool VulkanRenderTargetPool::sharesMemory(uint32_t a, uint32_t b) const
+{
+    if (m_physical[a] == m_physical[b])
+        return true;
+    if (m_pooling != RenderTargetPooling::Alias || m_images[m_physical[a]].allocation || m_images[m_physical[b]].allocation)
+        return false;
+    const MemoryRange& first = m_ranges[a];
+    const MemoryRange& second = m_ranges[b];
+    return first.block == second.block && first.offset < second.offset + second.size && second.offset < first.offset + first.size;
+}
+
+void VulkanRenderTargetPool::report(Report& report) const
+{
+    RenderTargetPool::report(report);
+    report.addText("lazily allocated memory", m_lazyMemory ? "supported" : "not supported");
+    report.addValue("render targets lazily allocated", double(m_lazyTargets), "");
+    /* Reserved, a tiler commits memory for them only where a pass could not keep them on chip */
+    report.addValue("lazily allocated attachment memory", double(m_lazyBytes) / (1024.0 * 1024.0), "MiB");
+    report.addValue("render target framebuffers", double(m_framebuffers.size()), "");
+}
+
+VkImageCreateInfo VulkanRenderTargetPool::imageInfo(const RenderTargetDesc& desc) const
+{
+    VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = format(desc.format);
+    info.extent = { desc.width, desc.height, 1 };
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VkSampleCountFlagBits(desc.samples);
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = isDepthFormat(desc.format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.usage |= desc.transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT : VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (desc.storage)
+        info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    return info;
+}
+
+void VulkanRenderTargetPool::release()
+{
+    if (m_images.empty())
+        return;
+
+    VkDevice device = m_context.device();
+    m_context.waitIdle();
+    for (const Framebuffer& framebuffer : m_framebuffers)
+        vkDestroyFramebuffer(device, framebuffer.framebuffer, vulkanHostAllocator());
+    m_framebuffers.clear();
+    for (VulkanImage& image : m_images)
+    {
+        if (image.allocation)
+        {
+            m_context.destroyImage(image);
+            continue;
+        }
+        vkDestroyImageView(device, image.view, vulkanHostAllocator());
+        vkDestroyImage(device, image.image, vulkanHostAllocator());
+    }
+    m_images.clear();
+    for (VmaAllocation block : m_blocks)
+        vmaFreeMemory(m_context.allocator(), block);
+    m_blocks.clear();
+}
+
+RenderTargetPool::Allocation VulkanRenderTargetPool::create()
+{
+    Allocation allocation;
+    VmaAllocator allocator = m_context.allocator();
+    m_lazyTargets = 0;
+    m_lazyBytes = 0;
+
+    uint32_t count = uint32_t(m_declarations.size());
+    if (m_pooling == RenderTargetPooling::Reuse)
+    {
+        count = assignPhysicalTargets(m_declarations, m_physical);
+    }
+    else
+    {
+        m_physical.resize(m_declarations.size());
+        for (uint32_t i = 0; i < m_declarations.size(); ++i)
+            m_physical[i] = i;
+    }
+    m_images.assign(count, {});
+    m_ranges.assign(m_declarations.size(), {});
+    allocation.physicalTargets = count;
+
+    /* Aliased images of the same memory type bits go into one block */
+    struct Block
+    {
+        uint32_t memoryTypeBits;
+        VkDeviceSize alignment;
+        std::vector<uint32_t> images;
+        std::vector<AliasedRange> ranges;
+    };
+    std::vector<Block> blocks;
+
+    /* Bytes of every physical image, declarations sharing one count it each for the unpooled figure */
+    std::vector<VkDeviceSize> sizes(count, 0);
+    std::vector<bool> created(count, false);
+    for (uint32_t i = 0; i < m_declarations.size(); ++i)
+    {
+        const RenderTargetDeclaration& declaration = m_declarations[i];
+        uint32_t physical = m_physical[i];
+        if (created[physical])
+        {
+            allocation.unpooledBytes += sizes[physical];
+            continue;
+        }
+        created[physical] = true;
+
+        VkImageCreateInfo info = imageInfo(declaration.desc);
+        VkImageAspectFlags aspect = isDepthFormat(declaration.desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        VulkanImage& image = m_images[physical];
+        if (lazy(declaration.desc))
+        {
+            image = m_context.createImage(info, aspect, VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED);
+            VmaAllocationInfo allocationInfo;
+            vmaGetAllocationInfo(allocator, image.allocation, &allocationInfo);
+            ++m_lazyTargets;
+            m_lazyBytes += allocationInfo.size;
+            continue;
+        }
+
+        if (m_pooling != RenderTargetPooling::Alias)
+        {
+            image = m_context.createImage(info, aspect);
+            VmaAllocationInfo allocationInfo;
+            vmaGetAllocationInfo(allocator, image.allocation, &allocationInfo);
+            sizes[physical] = allocationInfo.size;
+            allocation.bytes += allocationInfo.size;
+            allocation.unpooledBytes += allocationInfo.size;
+            continue;
+        }
+
+        VK_CHECK(vkCreateImage(m_context.device(), &info, vulkanHostAllocator(), &image.image));
+        image.format = info.format;
+        image.extent = info.extent;
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_context.device(), image.image, &requirements);
+        allocation.unpooledBytes += requirements.size;
+
+        auto block = std::find_if(blocks.begin(), blocks.end(),
+                                  [&](const Block& b) { return b.memoryTypeBits == requirements.memoryTypeBits; });
+        if (block == blocks.end())
+            block = blocks.insert(blocks.end(), Block{ requirements.memoryTypeBits, 1, {}, {} });
+        block->alignment = std::max(block->alignment, requirements.alignment);
+        block->images.push_back(physical);
+        block->ranges.push_back({ requirements.size, requirements.alignment, declaration.firstPass, declaration.lastPass });
+    }
+
+    for (const Block& block : blocks)
+    {
+        std::vector<uint64_t> offsets;
+        VkMemoryRequirements requirements = {};
+        requirements.size = packAliasedRanges(block.ranges, offsets);
+        requirements.alignment = block.alignment;
+        requirements.memoryTypeBits = block.memoryTypeBits;
+        VmaAllocationCreateInfo allocationInfo = {};
+        allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        VmaAllocation memory;
+        VK_CHECK(vmaAllocateMemory(allocator, &requirements, &allocationInfo, &memory, nullptr));
+        m_blocks.push_back(memory);
+        allocation.bytes += requirements.size;
+
+        for (size_t i = 0; i < block.images.size(); ++i)
+        {
+            m_ranges[block.images[i]] = { uint32_t(m_blocks.size() - 1), offsets[i], block.ranges[i].size };
+            VulkanImage& image = m_images[block.images[i]];
+            VK_CHECK(vmaBindImageMemory2(allocator, memory, offsets[i], image.image, nullptr));
+            VkImageAspectFlags aspect = isDepthFormat(m_declarations[block.images[i]].desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+            image.view = m_context.createImageView(image.image, VK_IMAGE_VIEW_TYPE_2D, image.format, aspect, 0, 1);
+        }
+    }
+    allocation.blocks = uint32_t(m_blocks.size());
+    return allocation;
+}
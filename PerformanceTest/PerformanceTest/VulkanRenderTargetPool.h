@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "RenderTargetPool.h"
+#include "VulkanContext.h"
+
+/*
+ * Vulkan render targets. With --pooling alias every declaration gets an image of its own, but
+ * the images are bound into shared VMA memory blocks with vmaBindImageMemory2, and targets whose
+ * lifetimes do not overlap get the same bytes (see packAliasedRanges()). Transient targets are
+ * created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and, where the device has such a memory
+ * type, allocated lazily so a tiler never backs them with memory at all.
+ *
+ * The render passes start every attachment in UNDEFINED, so an aliased image never needs the
+ * contents of the one that used the bytes before. Their external dependencies order the pass
+ * after the attachment writes and fragment shader reads of earlier passes, which covers both the
+ * aliasing hazards and the reuse across frames, and make the results visible to fragment
+ * shaders reading them later. Non-transient targets end in SHADER_READ_ONLY_OPTIMAL.
+ *
+ * With `externalLayouts` the caller owns layouts and synchronization, the way RenderGraph does:
+ * attachments stay in their attachment layout from the start to the end of the render pass and
+ * the render passes have no external dependencies.
+ */
+class VulkanRenderTargetPool : public RenderTargetPool
+{
+public:
+    VulkanRenderTargetPool(VulkanContext& context, RenderTargetPooling pooling, bool externalLayouts = false);
+    /* The GPU has to be done with the targets */
+    ~VulkanRenderTargetPool() override;
+
+    static VkFormat format(RenderTargetFormat format);
+
+    const VulkanImage& image(uint32_t handle) const { return m_images[m_physical[handle]]; }
+    /* Compatible with the passes beginPass() begins on targets of the same descriptions, created once per combination */
+    VkRenderPass renderPass(std::initializer_list<RenderTargetDesc> colors, const RenderTargetDesc* depth = nullptr);
+
+    /* Begins the render pass with cleared attachments and sets the viewport to the size of the targets */
+    void beginPass(VkCommandBuffer cmd, std::initializer_list<uint32_t> colors, uint32_t depth, const float clearColor[4]);
+    /* Bit i of `loadMask` keeps color attachment i, bit `colorCount` the depth attachment */
+    void beginPass(VkCommandBuffer cmd, const uint32_t* colors, uint32_t colorCount, uint32_t depth, const float clearColor[4], uint32_t loadMask);
+    void endPass(VkCommandBuffer cmd);
+
+    bool lazilyAllocatedMemory() const { return m_lazyMemory; }
+    bool sharesMemory(uint32_t a, uint32_t b) const override;
+
+    void report(Report& report) const override;
+
+private:
+    static constexpr uint32_t kMaxColors = 8;
+
+    struct AttachmentKey
+    {
+        RenderTargetFormat format;
+        uint32_t samples;
+        bool transient;
+        bool load;
+
+        bool operator==(const AttachmentKey& other) const
+        {
+            return format == other.format && samples == other.samples && transient == other.transient && load == other.load;
+        }
+    };
+
+    struct RenderPass
+    {
+        AttachmentKey attachments[kMaxColors + 1];
+        uint32_t colorCount;
+        bool depth;
+        VkRenderPass renderPass;
+    };
+
+    struct Framebuffer
+    {
+        VkImageView views[kMaxColors + 1];
+        uint32_t viewCount;
+        VkRenderPass renderPass;
+        VkFramebuffer framebuffer;
+    };
+
+    void release() override;
+    Allocation create() override;
+    VkRenderPass findRenderPass(const AttachmentKey* attachments, uint32_t colorCount, bool depth);
+    VkImageCreateInfo imageInfo(const RenderTargetDesc& desc) const;
+    /* Whether the target goes into its own lazily allocated memory */
+    bool lazy(const RenderTargetDesc& desc) const { return desc.transient && m_lazyMemory; }
+
+    /* Where the memory of a declaration's image is, only filled for aliased images */
+    struct MemoryRange
+    {
+        uint32_t block;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    VulkanContext& m_context;
+    bool m_externalLayouts;
+    bool m_lazyMemory = false;
+    std::vector<VulkanImage> m_images;
+    /* Physical image of every declaration */
+    std::vector<uint32_t> m_physical;
+    std::vector<MemoryRange> m_ranges;
+    /* Memory shared by the aliased images */
+    std::vector<VmaAllocation> m_blocks;
+    uint32_t m_lazyTargets = 0;
+    VkDeviceSize m_lazyBytes = 0;
+    std::vector<RenderPass> m_renderPasses;
+    std::vector<Framebuffer> m_framebuffers;
+};
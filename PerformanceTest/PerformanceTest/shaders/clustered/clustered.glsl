@@ -0,0 +1,44 @@
+// Shared declarations of the clustered lighting scenario, the layouts match Clustered.h
+
+PUSH_CONSTANTS(FrameConstants)
+{
+    // Shading: view projection, culling: view
+    mat4 matrix;
+    vec4 eye;
+    // x and y scale of the projection, near and far plane
+    vec4 projection;
+    uint lightCount;
+    uint clustersX;
+    uint clustersY;
+    uint clustersZ;
+    // Boxes per row of the grid, instance 0 is the ground
+    uint gridSide;
+} frame;
+
+struct Light
+{
+    // xyz world position, w radius
+    vec4 positionRadius;
+    vec4 color;
+};
+
+// ClusteredScenario::kMaxClusterLights, lights beyond it are dropped from the cluster
+const uint kMaxClusterLights = 256u;
+
+layout(std430, BINDING(0)) readonly buffer Lights
+{
+    Light lights[];
+};
+
+// The hit count of every cluster, which may exceed kMaxClusterLights, then kMaxClusterLights
+// light indices per cluster
+uint clusterCount()
+{
+    return frame.clustersX * frame.clustersY * frame.clustersZ;
+}
+
+// Clusters are spaced exponentially in view depth, slice z begins at near * (far / near)^(z / clustersZ)
+float sliceDepth(float slice)
+{
+    return frame.projection.z * pow(frame.projection.w / frame.projection.z, slice / float(frame.clustersZ));
+}
@@ -0,0 +1,62 @@
+#version 460
+
+// Forward shading of the box grid. With CLUSTERED a fragment loops over the lights the cull
+// pass put into its cluster, otherwise over all lights.
+
+#include "../common.glsl"
+#include "clustered.glsl"
+
+layout(std430, BINDING(1)) readonly buffer Clusters
+{
+    uint clusters[];
+};
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) flat in vec3 albedo;
+layout(location = 3) flat in vec2 material;
+layout(location = 4) in vec4 clip;
+layout(location = 0) out vec4 color;
+
+vec3 shade(vec3 n, vec3 view, Light light)
+{
+    vec3 toLight = light.positionRadius.xyz - position;
+    float radius = light.positionRadius.w;
+    float distanceSquared = dot(toLight, toLight);
+    if (distanceSquared >= radius * radius)
+        return vec3(0.0);
+
+    float lightDistance = sqrt(distanceSquared);
+    vec3 direction = toLight / lightDistance;
+    float attenuation = 1.0 - lightDistance / radius;
+    float diffuse = max(dot(n, direction), 0.0);
+    // Normalized Blinn-Phong, the exponent falls with the roughness
+    float power = exp2(11.0 - 10.0 * material.x);
+    float specular = pow(max(dot(n, normalize(direction + view)), 0.0), power) * (power + 8.0) / 25.0;
+    vec3 specularColor = mix(vec3(0.04), albedo, material.y);
+    return light.color.rgb * attenuation * attenuation * (diffuse * albedo * (1.0 - material.y) + diffuse * specular * specularColor);
+}
+
+void main()
+{
+    vec3 n = normalize(normal);
+    vec3 view = normalize(frame.eye.xyz - position);
+    vec3 lit = 0.03 * albedo;
+#if CLUSTERED
+    // Tile rows go up from the bottom like normalized device coordinates, the same as in the cull pass
+    vec2 ndc = clip.xy / clip.w;
+    uvec2 tile = min(uvec2((ndc * 0.5 + 0.5) * vec2(frame.clustersX, frame.clustersY)), uvec2(frame.clustersX - 1u, frame.clustersY - 1u));
+    // clip.w is the view depth
+    float slice = log(max(clip.w, frame.projection.z) / frame.projection.z) / log(frame.projection.w / frame.projection.z) * float(frame.clustersZ);
+    uint index = (min(uint(slice), frame.clustersZ - 1u) * frame.clustersY + tile.y) * frame.clustersX + tile.x;
+    uint first = clusterCount() + index * kMaxClusterLights;
+    uint count = min(clusters[index], kMaxClusterLights);
+    for (uint i = 0u; i < count; ++i)
+        lit += shade(n, view, lights[clusters[first + i]]);
+#else
+    for (uint i = 0u; i < frame.lightCount; ++i)
+        lit += shade(n, view, lights[i]);
+#endif
+    // Reinhard, there is no HDR target
+    color = vec4(lit / (1.0 + lit), 1.0);
+}
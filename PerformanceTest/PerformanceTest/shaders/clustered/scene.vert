@@ -0,0 +1,60 @@
+#version 460
+
+// The box grid of the deferred scenario: the 36 vertices of a box come from the vertex index,
+// its place and size from the instance index.
+
+#include "../common.glsl"
+#include "clustered.glsl"
+
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec3 normal;
+layout(location = 2) flat out vec3 albedo;
+layout(location = 3) flat out vec2 material;
+layout(location = 4) out vec4 clip;
+
+void main()
+{
+    // Face f has its normal along axis f % 3, positive for the first three
+    uint face = uint(VERTEX_INDEX) / 6u;
+    uint axis = face % 3u;
+    float side = face < 3u ? 1.0 : -1.0;
+    const vec2 corners[6] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+    vec2 corner = corners[uint(VERTEX_INDEX) % 6u];
+    vec3 n = vec3(0.0);
+    vec3 u = vec3(0.0);
+    vec3 v = vec3(0.0);
+    n[axis] = side;
+    u[(axis + 1u) % 3u] = side;
+    v[(axis + 2u) % 3u] = 1.0;
+    // Counter clockwise seen from outside: u x v points along n
+    vec3 local = n + u * corner.x + v * corner.y;
+
+    uint instance = uint(INSTANCE_INDEX);
+    uint hash = instance * 2654435761u;
+    vec3 center;
+    vec3 extents;
+    if (instance == 0u)
+    {
+        float size = float(frame.gridSide) + 2.0;
+        center = vec3(0.0, -0.5, 0.0);
+        extents = vec3(size, 0.5, size);
+        albedo = vec3(0.5);
+        material = vec2(0.8, 0.0);
+    }
+    else
+    {
+        // Two units apart, between half a unit and three units high
+        uint cell = instance - 1u;
+        float height = 0.5 + 2.5 * float(hash & 0xFFu) / 255.0;
+        vec2 grid = (vec2(cell % frame.gridSide, cell / frame.gridSide) - 0.5 * float(frame.gridSide - 1u)) * 2.0;
+        center = vec3(grid.x, 0.5 * height, grid.y);
+        extents = vec3(0.6, 0.5 * height, 0.6);
+        albedo = vec3((hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu, (hash >> 24) & 0xFFu) / 255.0 * 0.8 + 0.2;
+        material = vec2(float((hash >> 4) & 0xFu) / 15.0, float((hash >> 3) & 1u));
+    }
+
+    position = center + local * extents;
+    normal = n;
+    clip = frame.matrix * vec4(position, 1.0);
+    gl_Position = clip;
+}
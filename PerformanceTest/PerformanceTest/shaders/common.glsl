@@ -0,0 +1,24 @@
+// Shared between the OpenGL and the Vulkan backend, VULKAN is defined by the Vulkan loader
+
+#ifdef VULKAN
+#define BINDING(n) set = 0, binding = n
+#define INSTANCE_INDEX gl_InstanceIndex
+#define VERTEX_INDEX gl_VertexIndex
+#define PUSH_CONSTANTS(name) layout(push_constant) uniform name
+#else
+#define BINDING(n) binding = n
+#define INSTANCE_INDEX (gl_InstanceID + gl_BaseInstance)
+#define VERTEX_INDEX gl_VertexID
+// Emulated with a uniform buffer, see GLContext::pushConstants
+#define PUSH_CONSTANTS(name) layout(std140, binding = 15) uniform name
+#endif
+
+// Framebuffer row 0 is the bottom row in OpenGL and the top row in Vulkan
+vec2 ndcToUv(vec2 ndc)
+{
+#ifdef VULKAN
+    return vec2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);
+#else
+    return ndc * 0.5 + 0.5;
+#endif
+}
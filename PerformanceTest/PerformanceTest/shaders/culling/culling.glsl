@@ -0,0 +1,31 @@
+// Resources of the culling scenario, the layouts match GpuCulling.h
+
+struct Instance
+{
+    vec4 center;  // xyz center, w bounding sphere radius
+    vec4 extents; // xyz half extents
+};
+
+struct DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(std140, BINDING(0)) uniform CullingUniforms
+{
+    mat4 viewProj;
+    mat4 prevViewProj;
+    vec4 frustumPlanes[6];
+    vec4 pyramidSize;
+    uint instanceCount;
+    uint occlusionEnabled;
+};
+
+layout(std430, BINDING(1)) readonly buffer Instances
+{
+    Instance instances[];
+};
@@ -0,0 +1,10 @@
+#version 460
+
+layout(location = 0) in vec3 color;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    fragColor = vec4(color, 1.0);
+}
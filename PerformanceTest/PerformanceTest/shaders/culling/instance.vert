@@ -0,0 +1,27 @@
+#version 460
+
+#include "../common.glsl"
+#include "culling.glsl"
+
+layout(std430, BINDING(2)) readonly buffer VisibleIndices
+{
+    uint visibleIndices[];
+};
+
+layout(location = 0) in vec3 position;
+
+layout(location = 0) out vec3 color;
+
+void main()
+{
+    uint index = visibleIndices[INSTANCE_INDEX];
+    Instance instance = instances[index];
+
+    vec3 world = instance.center.xyz + position * instance.extents.xyz;
+    gl_Position = viewProj * vec4(world, 1.0);
+
+    // Per instance tint, darker towards the ground so the boxes stay distinguishable
+    uint hash = index * 2654435761u;
+    vec3 tint = vec3(hash & 0xFFu, (hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu) / 255.0;
+    color = (0.4 + 0.6 * tint) * (0.35 + 0.65 * (position.y * 0.5 + 0.5));
+}
@@ -0,0 +1,22 @@
+// Shared declarations of the deferred shading scenario, the layouts match Deferred.h
+
+PUSH_CONSTANTS(FrameConstants)
+{
+    // G-buffer pass: view projection, lighting: its inverse
+    mat4 matrix;
+    vec4 eye;
+    // xy screen tiles per unit of uv
+    vec4 tileScale;
+    uint lightCount;
+    uint tilesX;
+    uint tilesY;
+    // Boxes per row of the grid, instance 0 is the ground
+    uint gridSide;
+} frame;
+
+struct Light
+{
+    // xyz world position, w radius
+    vec4 positionRadius;
+    vec4 color;
+};
@@ -0,0 +1,12 @@
+#version 460
+
+#include "../common.glsl"
+
+layout(location = 0) out vec2 ndc;
+
+void main()
+{
+    // One triangle covering the screen, vertices at (-1, -1), (3, -1) and (-1, 3)
+    ndc = vec2((VERTEX_INDEX << 1) & 2, VERTEX_INDEX & 2) * 2.0 - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 460
+
+#include "../common.glsl"
+#include "deferred.glsl"
+
+layout(location = 0) in vec3 normal;
+layout(location = 1) flat in vec3 albedo;
+layout(location = 2) flat in vec2 material;
+
+// RGBA8, RGBA16F and RGBA8, the depth buffer is the fourth G-buffer target
+layout(location = 0) out vec4 albedoOut;
+layout(location = 1) out vec4 normalOut;
+layout(location = 2) out vec4 materialOut;
+
+void main()
+{
+    albedoOut = vec4(albedo, 1.0);
+    normalOut = vec4(normalize(normal), 0.0);
+    // Roughness and metalness
+    materialOut = vec4(material, 0.0, 0.0);
+}
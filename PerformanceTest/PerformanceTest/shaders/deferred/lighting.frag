@@ -0,0 +1,87 @@
+#version 460
+
+// Lights the G-buffer. Without TILED every pixel loops over all lights, with TILED only over the
+// lights the CPU binned into its screen tile. With SUBPASS the G-buffer comes from input
+// attachments of the render pass that wrote it, otherwise from textures written by the pass
+// before. SUBPASS only exists for Vulkan, OpenGL builds of the variant read textures.
+
+#include "../common.glsl"
+#include "deferred.glsl"
+
+layout(std430, BINDING(0)) readonly buffer Lights
+{
+    Light lights[];
+};
+
+// For every tile the offset of its light list in the same array and its light count, then the lists
+layout(std430, BINDING(1)) readonly buffer Tiles
+{
+    uint tiles[];
+};
+
+#if SUBPASS && defined(VULKAN)
+layout(input_attachment_index = 0, BINDING(2)) uniform subpassInput albedoInput;
+layout(input_attachment_index = 1, BINDING(3)) uniform subpassInput normalInput;
+layout(input_attachment_index = 2, BINDING(4)) uniform subpassInput materialInput;
+layout(input_attachment_index = 3, BINDING(5)) uniform subpassInput depthInput;
+#define LOAD(name) subpassLoad(name##Input)
+#else
+layout(BINDING(2)) uniform sampler2D albedoTexture;
+layout(BINDING(3)) uniform sampler2D normalTexture;
+layout(BINDING(4)) uniform sampler2D materialTexture;
+layout(BINDING(5)) uniform sampler2D depthTexture;
+#define LOAD(name) texelFetch(name##Texture, ivec2(gl_FragCoord.xy), 0)
+#endif
+
+layout(location = 0) in vec2 ndc;
+layout(location = 0) out vec4 color;
+
+vec3 shade(vec3 position, vec3 normal, vec3 view, vec3 albedo, vec2 material, Light light)
+{
+    vec3 toLight = light.positionRadius.xyz - position;
+    float radius = light.positionRadius.w;
+    float distanceSquared = dot(toLight, toLight);
+    if (distanceSquared >= radius * radius)
+        return vec3(0.0);
+
+    float lightDistance = sqrt(distanceSquared);
+    vec3 direction = toLight / lightDistance;
+    float attenuation = 1.0 - lightDistance / radius;
+    float diffuse = max(dot(normal, direction), 0.0);
+    // Normalized Blinn-Phong, the exponent falls with the roughness
+    float power = exp2(11.0 - 10.0 * material.x);
+    float specular = pow(max(dot(normal, normalize(direction + view)), 0.0), power) * (power + 8.0) / 25.0;
+    vec3 specularColor = mix(vec3(0.04), albedo, material.y);
+    return light.color.rgb * attenuation * attenuation * (diffuse * albedo * (1.0 - material.y) + diffuse * specular * specularColor);
+}
+
+void main()
+{
+    float depth = LOAD(depth).r;
+    if (depth == 1.0)
+    {
+        color = vec4(0.02, 0.02, 0.03, 1.0);
+        return;
+    }
+
+    vec4 world = frame.matrix * vec4(ndc, depth, 1.0);
+    vec3 position = world.xyz / world.w;
+    vec3 albedo = LOAD(albedo).rgb;
+    vec3 normal = normalize(LOAD(normal).xyz);
+    vec2 material = LOAD(material).xy;
+    vec3 view = normalize(frame.eye.xyz - position);
+
+    vec3 lit = 0.03 * albedo;
+#if TILED
+    uvec2 tile = min(uvec2((ndc * 0.5 + 0.5) * frame.tileScale.xy), uvec2(frame.tilesX - 1u, frame.tilesY - 1u));
+    uint index = (tile.y * frame.tilesX + tile.x) * 2u;
+    uint first = tiles[index];
+    uint count = tiles[index + 1u];
+    for (uint i = 0u; i < count; ++i)
+        lit += shade(position, normal, view, albedo, material, lights[tiles[first + i]]);
+#else
+    for (uint i = 0u; i < frame.lightCount; ++i)
+        lit += shade(position, normal, view, albedo, material, lights[i]);
+#endif
+    color = vec4(lit, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 460
+
+#include "../common.glsl"
+
+layout(BINDING(0)) uniform sampler2D lit;
+
+layout(location = 0) in vec2 ndc;
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    // The lit target has the size of the swapchain
+    vec3 hdr = texelFetch(lit, ivec2(gl_FragCoord.xy), 0).rgb;
+    // Reinhard
+    color = vec4(hdr / (1.0 + hdr), 1.0);
+}
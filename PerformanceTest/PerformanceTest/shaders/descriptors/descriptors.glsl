@@ -0,0 +1,9 @@
+// Shared declarations of the descriptor scenario, the layout matches DescriptorDrawUniforms in DescriptorStrategies.h
+
+// A range of the per-frame uniform buffer, rebound for every draw
+layout(std140, BINDING(0)) uniform DrawUniforms
+{
+    // xy lower left corner, zw size, in normalized device coordinates
+    vec4 rect;
+    vec4 color;
+} draw;
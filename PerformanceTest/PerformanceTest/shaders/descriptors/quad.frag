@@ -0,0 +1,11 @@
+#version 460
+
+#include "../common.glsl"
+#include "descriptors.glsl"
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    fragColor = draw.color;
+}
@@ -0,0 +1,25 @@
+// Per-draw constants of the draw call scenario, one of RING, PUSH or UNIFORM is defined.
+// The layout matches DrawCallConstants in DrawCalls.h.
+
+#if defined(RING)
+// A range of the per-frame uniform ring, dynamic offset or glBindBufferRange
+layout(std140, BINDING(0)) uniform DrawConstants
+{
+    vec4 rect;
+    vec4 color;
+} draw;
+#elif defined(PUSH)
+PUSH_CONSTANTS(DrawConstants)
+{
+    vec4 rect;
+    vec4 color;
+} draw;
+#else
+// Default block uniforms set with glUniform4fv, OpenGL only
+struct DrawConstants
+{
+    vec4 rect;
+    vec4 color;
+};
+uniform DrawConstants draw;
+#endif
@@ -0,0 +1,11 @@
+#version 460
+
+#include "../common.glsl"
+#include "drawcalls.glsl"
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    fragColor = draw.color;
+}
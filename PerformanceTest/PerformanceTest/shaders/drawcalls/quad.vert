@@ -0,0 +1,11 @@
+#version 460
+
+#include "../common.glsl"
+#include "drawcalls.glsl"
+
+void main()
+{
+    // Two triangles without a vertex buffer, rect is xy lower left corner and zw size in NDC
+    const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 0), vec2(1, 1), vec2(0, 1));
+    gl_Position = vec4(draw.rect.xy + corners[VERTEX_INDEX] * draw.rect.zw, 0.0, 1.0);
+}
@@ -0,0 +1,42 @@
+#version 460
+
+// One of PER_DRAW, BINDLESS or TEXTURE_ARRAY, MATERIAL_COUNT is the size of the bindless table
+#if defined(BINDLESS) && !defined(VULKAN)
+#extension GL_ARB_bindless_texture : require
+#endif
+
+#include "../common.glsl"
+#include "materials.glsl"
+
+#if defined(PER_DRAW)
+// Rebound for every draw
+layout(BINDING(0)) uniform sampler2D materialTexture;
+#elif defined(BINDLESS) && defined(VULKAN)
+// Descriptor indexing, the whole table stays bound for the frame
+layout(BINDING(0)) uniform sampler2D materialTextures[MATERIAL_COUNT];
+#elif defined(BINDLESS)
+// ARB_bindless_texture handles, samplers are 64 bit values in the buffer
+layout(std430, BINDING(1)) readonly buffer MaterialTextures
+{
+    sampler2D materialTextures[];
+};
+#elif defined(TEXTURE_ARRAY)
+// Fallback without bindless textures, every material is a layer
+layout(BINDING(0)) uniform sampler2DArray materialTextures;
+#endif
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+#if defined(PER_DRAW)
+    fragColor = texture(materialTexture, uv);
+#elif defined(BINDLESS)
+    // Dynamically uniform, every draw has a single material
+    fragColor = texture(materialTextures[draw.material], uv);
+#else
+    fragColor = texture(materialTextures, vec3(uv, float(draw.material)));
+#endif
+}
@@ -0,0 +1,8 @@
+// Shared declarations of the material scenario, the layout matches MaterialDrawConstants in BindlessMaterials.h
+
+PUSH_CONSTANTS(DrawConstants)
+{
+    // xy lower left corner, zw size, in normalized device coordinates
+    vec4 rect;
+    uint material;
+} draw;
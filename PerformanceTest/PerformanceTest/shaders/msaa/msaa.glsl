@@ -0,0 +1,9 @@
+// Shared declarations of the MSAA scenario, the layout matches Msaa.h
+
+PUSH_CONSTANTS(FrameConstants)
+{
+    // x animation phase, y aspect ratio, z brightness of the triangles
+    vec4 scene;
+    // zw texel size of the window for the present pass
+    vec4 texel;
+} frame;
@@ -0,0 +1,14 @@
+#version 460
+
+#include "../common.glsl"
+#include "msaa.glsl"
+
+layout(BINDING(0)) uniform sampler2D resolved;
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    // Bilinear scale of the resolved target to the window, float targets are clamped
+    color = vec4(min(texture(resolved, gl_FragCoord.xy * frame.texel.zw).rgb, vec3(1.0)), 1.0);
+}
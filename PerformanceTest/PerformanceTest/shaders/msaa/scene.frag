@@ -0,0 +1,12 @@
+#version 460
+
+#include "../common.glsl"
+#include "msaa.glsl"
+
+layout(location = 0) flat in vec3 color;
+layout(location = 0) out vec4 result;
+
+void main()
+{
+    result = vec4(color, 1.0);
+}
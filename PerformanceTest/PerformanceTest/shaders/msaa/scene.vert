@@ -0,0 +1,36 @@
+#version 460
+
+#include "../common.glsl"
+#include "msaa.glsl"
+
+layout(location = 0) flat out vec3 color;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float unit(uint x)
+{
+    return float(hash(x) & 0xFFFFu) / 65535.0;
+}
+
+void main()
+{
+    // Small triangles all over the target at random depths, rotating so their edges cross every
+    // pixel sooner or later. Nothing but geometry edges for the samples to tell apart
+    uint triangle = uint(VERTEX_INDEX) / 3u;
+    uint corner = uint(VERTEX_INDEX) % 3u;
+    uint seed = triangle * 8u;
+    vec2 center = vec2(unit(seed), unit(seed + 1u)) * 2.2 - 1.1;
+    float size = 0.02 + 0.1 * unit(seed + 2u);
+    float angle = frame.scene.x * (unit(seed + 3u) * 4.0 - 2.0) + float(corner) * 2.0943951;
+    vec2 offset = vec2(cos(angle), sin(angle)) * size;
+    gl_Position = vec4(center + vec2(offset.x / frame.scene.y, offset.y), 0.01 + 0.98 * unit(seed + 4u), 1.0);
+    color = vec3(unit(seed + 5u), unit(seed + 6u), unit(seed + 7u)) * frame.scene.z;
+}
@@ -0,0 +1,8 @@
+// Shared declarations of the permutation scenario, the layout matches PermutationConstants in Permutations.h
+
+PUSH_CONSTANTS(DrawConstants)
+{
+    // xy lower left corner, zw size, in normalized device coordinates
+    vec4 rect;
+    vec4 color;
+} draw;
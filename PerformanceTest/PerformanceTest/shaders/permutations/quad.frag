@@ -0,0 +1,29 @@
+#version 460
+
+// VARIANT selects the material, its constants change the generated code so every variant is a
+// real compile for the driver. FALLBACK is the flat placeholder drawn until a variant is ready.
+
+#include "../common.glsl"
+#include "permutations.glsl"
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+#ifdef FALLBACK
+    fragColor = vec4(0.5, 0.5, 0.5, draw.color.a);
+#else
+    const int iterations = 4 + VARIANT % 5;
+    const float scale = float(VARIANT % 7 + 2);
+    vec3 color = 0.5 + 0.5 * fract(vec3(VARIANT) * vec3(0.37, 0.61, 0.83));
+    vec2 p = (uv - 0.5) * scale;
+    for (int i = 0; i < iterations; ++i)
+    {
+        p = vec2(p.x * p.x - p.y * p.y, 2.0 * p.x * p.y) * 0.5 + (uv - 0.5) + 0.01 * float(VARIANT);
+        color += 0.05 * vec3(sin(p.x * float(i + 1)), cos(p.y * scale), sin(float(VARIANT) + p.x * p.y));
+    }
+    fragColor = vec4(color, draw.color.a);
+#endif
+}
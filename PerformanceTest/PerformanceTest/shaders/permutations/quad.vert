@@ -0,0 +1,14 @@
+#version 460
+
+#include "../common.glsl"
+#include "permutations.glsl"
+
+layout(location = 0) out vec2 uv;
+
+void main()
+{
+    // Two triangles without a vertex buffer
+    const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 0), vec2(1, 1), vec2(0, 1));
+    uv = corners[VERTEX_INDEX];
+    gl_Position = vec4(draw.rect.xy + uv * draw.rect.zw, 0.0, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 460
+
+#include "../common.glsl"
+
+void main()
+{
+    // One triangle covering the target, vertices at (-1, -1), (3, -1) and (-1, 3). The passes
+    // derive their coordinates from gl_FragCoord, so nothing is interpolated
+    vec2 ndc = vec2((VERTEX_INDEX << 1) & 2, VERTEX_INDEX & 2) * 2.0 - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
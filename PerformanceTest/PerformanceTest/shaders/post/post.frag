@@ -0,0 +1,12 @@
+#version 460
+
+#include "../common.glsl"
+#include "post.glsl"
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    // Framebuffer row 0 is texel row 0 of the target on both backends, the same mapping the dispatch uses
+    color = postPass(gl_FragCoord.xy * pass.texel.zw);
+}
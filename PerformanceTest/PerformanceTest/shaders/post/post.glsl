@@ -0,0 +1,141 @@
+// Shared declarations of the post processing scenario, the layout matches PostChain.h. PASS
+// selects the pass, post.frag wraps it into a full screen draw and post.comp into a dispatch.
+// Everything samples with textureLod, compute shaders have no implicit derivatives.
+
+#define PASS_SCENE 0
+#define PASS_DOWNSAMPLE 1
+#define PASS_UPSAMPLE 2
+#define PASS_TONEMAP 3
+#define PASS_FXAA 4
+#define PASS_PRESENT 5
+
+PUSH_CONSTANTS(PassConstants)
+{
+    // xy texel size of the first source, zw texel size of the target
+    vec4 texel;
+    // x bloom threshold, 0 for no threshold, y bloom intensity, z exposure
+    vec4 params;
+} pass;
+
+layout(BINDING(0)) uniform sampler2D source;
+layout(BINDING(1)) uniform sampler2D secondSource;
+
+const vec3 kLuma = vec3(0.299, 0.587, 0.114);
+
+#if PASS == PASS_SCENE
+
+vec4 postPass(vec2 uv)
+{
+    // Hard edged stripes for FXAA and a field of small spots well above the bloom threshold
+    vec2 cell = uv * vec2(48.0, 27.0);
+    vec2 local = fract(cell) - 0.5;
+    float spot = exp(-dot(local, local) * 120.0);
+    float hue = fract(sin(dot(floor(cell), vec2(12.9898, 78.233))) * 43758.5453);
+    float stripe = step(0.5, fract((uv.x * 1.7 + uv.y) * 12.0));
+    vec3 background = mix(vec3(0.05, 0.06, 0.08), vec3(0.4, 0.35, 0.3), stripe);
+    vec3 light = mix(vec3(1.0, 0.5, 0.2), vec3(0.2, 0.5, 1.0), hue);
+    return vec4(background + light * spot * 16.0, 1.0);
+}
+
+#elif PASS == PASS_DOWNSAMPLE
+
+vec3 tap(vec2 uv, vec2 offset)
+{
+    return textureLod(source, uv + offset * pass.texel.xy, 0.0).rgb;
+}
+
+vec4 postPass(vec2 uv)
+{
+    // The 13 taps of Jimenez's bloom downsample: a center box weighted 0.5 and four overlapping
+    // corner boxes weighted 0.125 each, every tap a bilinear average of four source texels
+    vec3 a = tap(uv, vec2(-2.0, -2.0));
+    vec3 b = tap(uv, vec2(0.0, -2.0));
+    vec3 c = tap(uv, vec2(2.0, -2.0));
+    vec3 d = tap(uv, vec2(-1.0, -1.0));
+    vec3 e = tap(uv, vec2(1.0, -1.0));
+    vec3 f = tap(uv, vec2(-2.0, 0.0));
+    vec3 g = tap(uv, vec2(0.0, 0.0));
+    vec3 h = tap(uv, vec2(2.0, 0.0));
+    vec3 i = tap(uv, vec2(-1.0, 1.0));
+    vec3 j = tap(uv, vec2(1.0, 1.0));
+    vec3 k = tap(uv, vec2(-2.0, 2.0));
+    vec3 l = tap(uv, vec2(0.0, 2.0));
+    vec3 m = tap(uv, vec2(2.0, 2.0));
+    vec3 color = (d + e + i + j) * 0.125 + (a + c + k + m) * 0.03125 + (b + f + h + l) * 0.0625 + g * 0.125;
+
+    // The first level keeps only what is brighter than the threshold
+    if (pass.params.x > 0.0)
+    {
+        float luma = dot(color, kLuma);
+        color *= max(luma - pass.params.x, 0.0) / max(luma, 1e-4);
+    }
+    return vec4(color, 1.0);
+}
+
+#elif PASS == PASS_UPSAMPLE
+
+vec4 postPass(vec2 uv)
+{
+    // 3x3 tent over the smaller level, added to the downsample of this level
+    vec2 t = pass.texel.xy;
+    vec3 sum = textureLod(source, uv, 0.0).rgb * 4.0;
+    sum += (textureLod(source, uv + vec2(-t.x, 0.0), 0.0).rgb + textureLod(source, uv + vec2(t.x, 0.0), 0.0).rgb +
+            textureLod(source, uv + vec2(0.0, -t.y), 0.0).rgb + textureLod(source, uv + vec2(0.0, t.y), 0.0).rgb) * 2.0;
+    sum += textureLod(source, uv + vec2(-t.x, -t.y), 0.0).rgb + textureLod(source, uv + vec2(t.x, -t.y), 0.0).rgb +
+           textureLod(source, uv + vec2(-t.x, t.y), 0.0).rgb + textureLod(source, uv + vec2(t.x, t.y), 0.0).rgb;
+    return vec4(textureLod(secondSource, uv, 0.0).rgb + sum * (1.0 / 16.0), 1.0);
+}
+
+#elif PASS == PASS_TONEMAP
+
+vec4 postPass(vec2 uv)
+{
+    vec3 hdr = textureLod(source, uv, 0.0).rgb + textureLod(secondSource, uv, 0.0).rgb * pass.params.y;
+    hdr *= pass.params.z;
+    // Narkowicz's fit of the ACES filmic curve, then gamma for the RGBA8 target
+    vec3 mapped = clamp((hdr * (2.51 * hdr + 0.03)) / (hdr * (2.43 * hdr + 0.59) + 0.14), 0.0, 1.0);
+    vec3 display = pow(mapped, vec3(1.0 / 2.2));
+    // FXAA reads the luma from alpha
+    return vec4(display, dot(display, kLuma));
+}
+
+#elif PASS == PASS_FXAA
+
+const float kReduceMin = 1.0 / 128.0;
+const float kReduceMul = 1.0 / 8.0;
+const float kSpanMax = 8.0;
+
+vec4 postPass(vec2 uv)
+{
+    // The compact FXAA: the luma gradient of the four diagonal neighbours gives the edge
+    // direction, two and four taps along it are blended, the wider blend only if it stays
+    // within the local luma range
+    float lumaNW = textureLodOffset(source, uv, 0.0, ivec2(-1, -1)).a;
+    float lumaNE = textureLodOffset(source, uv, 0.0, ivec2(1, -1)).a;
+    float lumaSW = textureLodOffset(source, uv, 0.0, ivec2(-1, 1)).a;
+    float lumaSE = textureLodOffset(source, uv, 0.0, ivec2(1, 1)).a;
+    vec4 center = textureLod(source, uv, 0.0);
+    float lumaMin = min(center.a, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(center.a, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * kReduceMul), kReduceMin);
+    float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + reduce);
+    direction = clamp(direction * scale, -kSpanMax, kSpanMax) * pass.texel.xy;
+
+    vec3 twoTaps = 0.5 * (textureLod(source, uv + direction * (1.0 / 3.0 - 0.5), 0.0).rgb +
+                          textureLod(source, uv + direction * (2.0 / 3.0 - 0.5), 0.0).rgb);
+    vec3 fourTaps = twoTaps * 0.5 + 0.25 * (textureLod(source, uv - direction * 0.5, 0.0).rgb + textureLod(source, uv + direction * 0.5, 0.0).rgb);
+    float lumaFourTaps = dot(fourTaps, kLuma);
+    return vec4(lumaFourTaps < lumaMin || lumaFourTaps > lumaMax ? twoTaps : fourTaps, center.a);
+}
+
+#elif PASS == PASS_PRESENT
+
+vec4 postPass(vec2 uv)
+{
+    // Bilinear scale of the chain's resolution to the window
+    return vec4(textureLod(source, uv, 0.0).rgb, 1.0);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#version 460
+
+#include "../common.glsl"
+#include "rendertargets.glsl"
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    vec3 scene = texture(source, uv).rgb;
+    vec3 glow = texture(secondSource, uv).rgb;
+    vec3 hdr = scene + glow;
+    // Reinhard, the composite target is RGBA8
+    color = vec4(hdr / (1.0 + hdr), 1.0);
+}
@@ -0,0 +1,15 @@
+#version 460
+
+#include "../common.glsl"
+#include "rendertargets.glsl"
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    // Four bilinear taps average a 4x4 footprint of the source
+    vec2 offset = pass.params.xy;
+    color = 0.25 * (texture(source, uv + vec2(-offset.x, -offset.y)) + texture(source, uv + vec2(offset.x, -offset.y)) +
+                    texture(source, uv + vec2(-offset.x, offset.y)) + texture(source, uv + vec2(offset.x, offset.y)));
+}
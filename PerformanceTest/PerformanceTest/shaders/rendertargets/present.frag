@@ -0,0 +1,12 @@
+#version 460
+
+#include "../common.glsl"
+#include "rendertargets.glsl"
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    color = texture(source, uv);
+}
@@ -0,0 +1,16 @@
+#version 460
+
+#include "../common.glsl"
+#include "rendertargets.glsl"
+
+layout(location = 0) out vec2 uv;
+
+void main()
+{
+    // Two triangles without a vertex buffer
+    const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 0), vec2(1, 1), vec2(0, 1));
+    vec2 position = pass.rect.xy + corners[VERTEX_INDEX] * pass.rect.zw;
+    // Where the quad covers the target, sources drawn the same way line up
+    uv = ndcToUv(position);
+    gl_Position = vec4(position, pass.params.w, 1.0);
+}
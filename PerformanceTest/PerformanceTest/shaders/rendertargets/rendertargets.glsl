@@ -0,0 +1,12 @@
+// Shared declarations of the render target scenario, the layout matches RenderTargets.h
+
+PUSH_CONSTANTS(PassConstants)
+{
+    // xy lower left corner, zw size, in normalized device coordinates
+    vec4 rect;
+    // Scene quads: rgb color, w depth. Filters: xy texel size of the source
+    vec4 params;
+} pass;
+
+layout(BINDING(0)) uniform sampler2D source;
+layout(BINDING(1)) uniform sampler2D secondSource;
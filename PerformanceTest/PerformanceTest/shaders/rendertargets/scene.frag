@@ -0,0 +1,14 @@
+#version 460
+
+#include "../common.glsl"
+#include "rendertargets.glsl"
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec4 color;
+
+void main()
+{
+    // Bright stripes so the filter chain has something to spread
+    float stripes = step(0.9, fract((uv.x + uv.y) * 24.0));
+    color = vec4(pass.params.rgb * (0.25 + 4.0 * stripes), 1.0);
+}
@@ -0,0 +1,38 @@
+#version 460
+
+// Sun light with the shadow of the first cascade that reaches the fragment's view depth, one
+// hardware compare tap. Beyond the last cascade everything is lit.
+
+#include "../common.glsl"
+#include "shadows.glsl"
+
+layout(BINDING(2)) uniform sampler2DArrayShadow shadowMap;
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) flat in vec3 albedo;
+layout(location = 3) in float viewDepth;
+layout(location = 0) out vec4 color;
+
+float shadow(vec3 n)
+{
+    uint cascade = 0u;
+    while (cascade < 4u && viewDepth > cascades.splits[cascade])
+        ++cascade;
+    if (cascade == 4u)
+        return 1.0;
+
+    // Pushed along the normal by a bit more for the larger texels of far cascades
+    vec4 clip = cascades.cascadeViewProj[cascade] * vec4(position + n * (0.02 * float(cascade + 1u)), 1.0);
+    vec3 ndc = clip.xyz / clip.w;
+    return texture(shadowMap, vec4(ndcToUv(ndc.xy), float(cascade), ndc.z - 0.0005));
+}
+
+void main()
+{
+    vec3 n = normalize(normal);
+    float diffuse = max(dot(n, -frame.lightDirection.xyz), 0.0);
+    if (diffuse > 0.0)
+        diffuse *= shadow(n);
+    color = vec4(albedo * (0.15 + 0.85 * diffuse), 1.0);
+}
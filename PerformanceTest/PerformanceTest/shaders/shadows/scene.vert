@@ -0,0 +1,22 @@
+#version 460
+
+#include "../common.glsl"
+#include "shadows.glsl"
+
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec3 normal;
+layout(location = 2) flat out vec3 albedo;
+layout(location = 3) out float viewDepth;
+
+void main()
+{
+    uint instance = uint(INSTANCE_INDEX);
+    uint hash = instance * 2654435761u;
+    Instance box = instances[instance];
+    vec3 local = boxVertex(uint(VERTEX_INDEX), normal);
+    position = box.center.xyz + local * box.extents.xyz;
+    albedo = instance == 0u ? vec3(0.5) : vec3((hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu, (hash >> 24) & 0xFFu) / 255.0 * 0.8 + 0.2;
+    gl_Position = frame.viewProj * vec4(position, 1.0);
+    // w of a perspective projection is the view depth
+    viewDepth = gl_Position.w;
+}
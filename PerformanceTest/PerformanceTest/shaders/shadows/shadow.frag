@@ -0,0 +1,8 @@
+#version 460
+
+// Depth only, the shadow passes have no color attachments. OpenGL programs need a fragment stage,
+// the Vulkan shadow pipeline is created without one
+
+void main()
+{
+}
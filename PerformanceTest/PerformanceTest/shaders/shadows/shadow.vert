@@ -0,0 +1,28 @@
+#version 460
+
+// Depth only pass into the cascades. Without LAYERED a pass renders the cascade in the push
+// constants. With LAYERED (OpenGL only) one pass renders all of them: the instance index is
+// instance * 4 + cascade and the vertex shader picks the layer.
+
+#if LAYERED
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
+#include "../common.glsl"
+#include "shadows.glsl"
+
+void main()
+{
+#if LAYERED
+    uint instance = uint(INSTANCE_INDEX) / 4u;
+    uint cascade = uint(INSTANCE_INDEX) % 4u;
+    gl_Layer = int(cascade);
+#else
+    uint instance = uint(INSTANCE_INDEX);
+    uint cascade = frame.cascade;
+#endif
+    vec3 normal;
+    vec3 local = boxVertex(uint(VERTEX_INDEX), normal);
+    Instance box = instances[instance];
+    gl_Position = cascades.cascadeViewProj[cascade] * vec4(box.center.xyz + local * box.extents.xyz, 1.0);
+}
@@ -0,0 +1,47 @@
+// Shared declarations of the shadow scenario, the layouts match Shadows.h
+
+PUSH_CONSTANTS(FrameConstants)
+{
+    mat4 viewProj;
+    vec4 eye;
+    // xyz direction the light travels in
+    vec4 lightDirection;
+    // Cascade a shadow pass renders, unused with LAYERED
+    uint cascade;
+} frame;
+
+struct Instance
+{
+    vec4 center;
+    vec4 extents;
+};
+
+layout(std430, BINDING(0)) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(std140, BINDING(1)) uniform Cascades
+{
+    mat4 cascadeViewProj[4];
+    // View depth where each cascade ends
+    vec4 splits;
+} cascades;
+
+// Vertex `index` of 36 of the unit box, counter clockwise seen from outside
+vec3 boxVertex(uint index, out vec3 normal)
+{
+    // Face f has its normal along axis f % 3, positive for the first three
+    uint face = index / 6u;
+    uint axis = face % 3u;
+    float side = face < 3u ? 1.0 : -1.0;
+    const vec2 corners[6] = vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+    vec2 corner = corners[index % 6u];
+    vec3 u = vec3(0.0);
+    vec3 v = vec3(0.0);
+    normal = vec3(0.0);
+    normal[axis] = side;
+    u[(axis + 1u) % 3u] = side;
+    v[(axis + 2u) % 3u] = 1.0;
+    return normal + u * corner.x + v * corner.y;
+}
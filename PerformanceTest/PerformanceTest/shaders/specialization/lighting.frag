@@ -0,0 +1,58 @@
+#version 460
+
+// Point lights over a bumpy plane, supersampled with SAMPLE_COUNT positions per pixel. With
+// SPECIALIZED the loop bounds are constants the driver folds and unrolls, without it they are
+// push constants and every loop is a runtime branch.
+
+#include "../common.glsl"
+#include "specialization.glsl"
+
+struct Light
+{
+    // xyz position in uv space above the plane, w radius
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(std430, BINDING(0)) readonly buffer Lights
+{
+    Light lights[];
+};
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+vec3 shade(vec3 position, vec3 normal, Light light)
+{
+    vec3 toLight = light.positionRadius.xyz - position;
+    float lightDistance = length(toLight);
+    vec3 direction = toLight / lightDistance;
+    float attenuation = max(1.0 - lightDistance / light.positionRadius.w, 0.0);
+    float diffuse = max(dot(normal, direction), 0.0);
+    float specular = pow(max(dot(normal, normalize(direction + vec3(0.0, 0.0, 1.0))), 0.0), 32.0);
+    return light.color.rgb * (diffuse + specular) * attenuation * attenuation;
+}
+
+void main()
+{
+    vec2 pixel = fwidth(uv);
+    vec3 color = vec3(0.0);
+    for (uint s = 0u; s < SAMPLE_COUNT; ++s)
+    {
+        // Rows of four samples inside the pixel
+        vec2 offset = (vec2(s % 4u, s / 4u) + 0.5) / vec2(4.0, float((SAMPLE_COUNT + 3u) / 4u)) - 0.5;
+        vec2 p = uv + offset * pixel;
+        vec3 position = vec3(p, 0.0);
+        vec3 normal = normalize(vec3(0.2 * sin(p.x * 60.0), 0.2 * cos(p.y * 60.0), 1.0));
+
+        // UNROLL lights per iteration, the second loop takes the rest of LIGHT_COUNT
+        uint i = 0u;
+        for (; i + UNROLL <= LIGHT_COUNT; i += UNROLL)
+            for (uint u = 0u; u < UNROLL; ++u)
+                color += shade(position, normal, lights[i + u]);
+        for (; i < LIGHT_COUNT; ++i)
+            color += shade(position, normal, lights[i]);
+    }
+    fragColor = vec4(color / float(SAMPLE_COUNT), 1.0);
+}
@@ -0,0 +1,22 @@
+// Shared declarations of the specialization scenario, the layouts match Specialization.h
+
+PUSH_CONSTANTS(DrawConstants)
+{
+    // xy lower left corner, zw size, in normalized device coordinates
+    vec4 rect;
+    // Runtime values of the constants below, only read without SPECIALIZED
+    uint lightCount;
+    uint sampleCount;
+    uint unroll;
+} draw;
+
+#ifdef SPECIALIZED
+// Set per pipeline, constant_id is the member index in SpecializationConstants
+layout(constant_id = 0) const uint LIGHT_COUNT = 1;
+layout(constant_id = 1) const uint SAMPLE_COUNT = 1;
+layout(constant_id = 2) const uint UNROLL = 1;
+#else
+#define LIGHT_COUNT draw.lightCount
+#define SAMPLE_COUNT draw.sampleCount
+#define UNROLL draw.unroll
+#endif
@@ -0,0 +1,18 @@
+#version 460
+
+// VARIANT makes every program distinct, so a program change is a real change for the driver
+
+#include "../common.glsl"
+#include "statesort.glsl"
+
+layout(BINDING(0)) uniform sampler2D albedo;
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    vec3 tint = 0.5 + 0.5 * fract(vec3(VARIANT) * vec3(0.37, 0.61, 0.83));
+    fragColor = texture(albedo, uv) * draw.color * vec4(tint, 1.0);
+}